@@ -6,6 +6,7 @@
 #define CNN_HELPER_CXX
 
 #include "CNNHelper.h"
+#include "Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -17,31 +18,14 @@ namespace stoppingcosmicmuonselection {
 
   }
 
-  // Get the score for a given hit.
-  float CNNHelper::GetHitMichelScore(const anab::MVAReader<recob::Hit,4> &hitResults, const art::Ptr<recob::Hit> &hit)  {
-
-    // Get CNN output for this hit.
-    std::array<float,4> cnn_out = hitResults.getOutput(hit);
-    // Get index of Michel output.
-    size_t michelIndex = hitResults.getIndex("michel");
-    // Get score.
-    float score = cnn_out[michelIndex];
-
-    return score;
-
-  }
-
   // Get the number of michel hits according to a threshold.
-  size_t CNNHelper::GetNumbMichelHits(const anab::MVAReader<recob::Hit,4> &hitResults, const artPtrHitVec &hits, float threshold) {
+  size_t CNNHelper::GetNumbMichelHits(const CNNScoreTable &cnnScores, const hitIndexVec &hits, float threshold) {
 
     size_t counter = 0;
 
     // Loop over hits.
-    for (size_t i = 0; i < hits.size(); i++) {
-
-      float score = GetHitMichelScore(hitResults, hits[i]);
-
-      if (score > threshold) counter++;
+    for (const uint32_t &hit : hits) {
+      if (cnnScores.MichelScore(hit) > threshold) counter++;
     }
 
     return counter;
@@ -49,85 +33,74 @@ namespace stoppingcosmicmuonselection {
   }
 
   // Get the vector of scores.
-  std::vector<double> CNNHelper::GetScoreVector(const anab::MVAReader<recob::Hit,4> &hitResults, const artPtrHitVec &hits) {
+  std::vector<double> CNNHelper::GetScoreVector(const CNNScoreTable &cnnScores, const hitIndexVec &hits) {
 
-    std::vector<double> scores;
-    scores.clear();
+    std::vector<double> scores(hits.size());
 
-    for (size_t i = 0; i < hits.size(); i++) {
-
-      // Get hit score.
-      double score = GetHitMichelScore(hitResults, hits[i]);
-
-      // Store score.
-      scores.push_back(score);
-    }
+    for (size_t i = 0; i < hits.size(); i++)
+      scores[i] = cnnScores.MichelScore(hits[i]);
 
     return scores;
 
   }
 
   // Remove hits with score above a threshold and return the remaining in a vector.
-  const artPtrHitVec CNNHelper::RemoveMichelHits(const anab::MVAReader<recob::Hit,4> &hitResults, const artPtrHitVec &hits, const double &thr) {
-
-    artPtrHitVec result;
-    result.clear();
-
-    for (size_t i = 0; i < hits.size(); i++) {
+  const hitIndexVec CNNHelper::RemoveMichelHits(const CNNScoreTable &cnnScores, const hitIndexVec &hits, const double &thr) {
 
-      // Get hit score.
-      double score = GetHitMichelScore(hitResults, hits[i]);
+    hitIndexVec result;
 
-      if (score <= thr)
-        result.push_back(hits[i]);
+    for (const uint32_t &hit : hits) {
+      if (cnnScores.MichelScore(hit) <= thr)
+        result.push_back(hit);
     }
 
-    if (result.size() == 0) std::cout << "CNNHelper.cxx: " << "CNNHelper::RemoveMichelHits is returning an empty vector" << std::endl;
+    if (result.size() == 0) STOPPING_MUON_LOG_DEBUG(kLogCNN) << "CNNHelper.cxx: " << "CNNHelper::RemoveMichelHits is returning an empty vector";
 
     return result;
   }
 
   // Fill the 2D graph of hits in the plane according to the score from the CNN.
   void CNNHelper::FillHitScoreGraph2D(TGraph2D *graph,
-                                    const anab::MVAReader<recob::Hit,4> &hitResults,
-                                    const artPtrHitVec &hits) {
+                                    const CNNScoreTable &cnnScores,
+                                    const HitCache &hitCache,
+                                    const hitIndexVec &hits) {
     graph->Set(0);
 
     for (size_t i = 0; i < hits.size(); i++) {
-      const art::Ptr<recob::Hit> &hitp = hits[i];
-      if (!hitp->WireID().isValid) continue;
-      double hitPeakTime = hitp->PeakTime();
-      unsigned int wireID = geoHelper.GetWireNumb(hitp);
-      double score = GetHitMichelScore(hitResults,hitp);
+      const uint32_t &hit = hits[i];
+      if (!hitCache.IsValid(hit)) continue;
+      double hitPeakTime = hitCache.PeakTime(hit);
+      unsigned int wireID = hitCache.GlobalWire(hit);
+      double score = cnnScores.MichelScore(hit);
       graph->SetPoint(i,wireID,hitPeakTime,score);
     }
   }
 
   // Fill the 2D image of hits in the plane according to the score from the CNN.
   void CNNHelper::FillHitScoreImage(TProfile2D *image,
-                                    const anab::MVAReader<recob::Hit,4> &hitResults,
-                                    const artPtrHitVec &hits) {
+                                    const CNNScoreTable &cnnScores,
+                                    const HitCache &hitCache,
+                                    const hitIndexVec &hits) {
     image->Reset();
 
-    for (const art::Ptr<recob::Hit> &hitp : hits) {
-      if (!hitp->WireID().isValid) continue;
-      double hitPeakTime = hitp->PeakTime();
-      unsigned int wireID = geoHelper.GetWireNumb(hitp);
-      double score = GetHitMichelScore(hitResults,hitp);
+    for (const uint32_t &hit : hits) {
+      if (!hitCache.IsValid(hit)) continue;
+      double hitPeakTime = hitCache.PeakTime(hit);
+      unsigned int wireID = hitCache.GlobalWire(hit);
+      double score = cnnScores.MichelScore(hit);
       image->Fill(wireID,hitPeakTime,score);
     }
   }
 
   // Fill 1D histogram with the score for a given vector.
-  void CNNHelper::FillScoreDistribution(TH1D *h, const anab::MVAReader<recob::Hit,4> &hitResults, const artPtrHitVec &hits) {
+  void CNNHelper::FillScoreDistribution(TH1D *h, const CNNScoreTable &cnnScores, const hitIndexVec &hits) {
 
     h->Reset();
 
     if (hits.size() == 0) return;
 
-    for (const art::Ptr<recob::Hit> &hitp : hits) {
-      double score = GetHitMichelScore(hitResults, hitp);
-      h->Fill(score);
+    for (const uint32_t &hit : hits) {
+      h->Fill(cnnScores.MichelScore(hit));
     }
     return;
   }
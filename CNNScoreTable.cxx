@@ -0,0 +1,33 @@
+/***
+  Class containing a per-event table of the CNN Michel score of the hits.
+
+*/
+#ifndef CNN_SCORE_TABLE_CXX
+#define CNN_SCORE_TABLE_CXX
+
+#include "CNNScoreTable.h"
+
+namespace stoppingcosmicmuonselection {
+
+  CNNScoreTable::CNNScoreTable() {
+
+  }
+
+  CNNScoreTable::~CNNScoreTable() {
+
+  }
+
+  // Fill the table reading the CNN output once for all the hits of the event.
+  void CNNScoreTable::Set(art::Event const &evt, const std::string &nnetTag, const HitCache &hitCache) {
+    anab::MVAReader<recob::Hit,4> hitResults(evt, nnetTag);
+    // Get index of Michel output.
+    const size_t michelIndex = hitResults.getIndex("michel");
+
+    _michelScore.resize(hitCache.Size());
+    for (size_t i = 0; i < hitCache.Size(); i++)
+      _michelScore[i] = hitResults.getOutput(hitCache.GetPtr(i))[michelIndex];
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
@@ -0,0 +1,39 @@
+/***
+  Class containing a per-event table of the CNN Michel score of the hits.
+  Scores are indexed by the position of the hit in the event hit table.
+
+*/
+#ifndef CNN_SCORE_TABLE_H
+#define CNN_SCORE_TABLE_H
+
+#include "art/Framework/Principal/Event.h"
+#include "lardataobj/RecoBase/Hit.h"
+#include "lardata/ArtDataHelper/MVAReader.h"
+
+#include "DataTypes.h"
+#include "HitCache.h"
+
+namespace stoppingcosmicmuonselection {
+
+  class CNNScoreTable {
+
+  public:
+    CNNScoreTable();
+    ~CNNScoreTable();
+
+    // Fill the table reading the CNN output once for all the hits of the event.
+    void Set(art::Event const &evt, const std::string &nnetTag, const HitCache &hitCache);
+
+    // Get the Michel score of a hit.
+    float MichelScore(const uint32_t &hit) const { return _michelScore[hit]; }
+
+    // Number of hits in the table.
+    size_t Size() const { return _michelScore.size(); }
+
+  private:
+    std::vector<float> _michelScore;
+
+  };
+}
+
+#endif
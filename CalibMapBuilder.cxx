@@ -0,0 +1,208 @@
+/***
+  Class containing the builder of the X and YZ dQ/dx calibration maps.
+
+*/
+#ifndef CALIB_MAP_BUILDER_CXX
+#define CALIB_MAP_BUILDER_CXX
+
+#include <algorithm>
+#include <cmath>
+#include "cetlib_except/exception.h"
+#include "TDirectory.h"
+#include "TFile.h"
+#include "TH1D.h"
+#include "TH2D.h"
+#include "TTree.h"
+
+#include "CalibMapBuilder.h"
+
+namespace stoppingcosmicmuonselection {
+
+  namespace {
+    // Names of the maps read by CalibrationHelper (collection plane).
+    const char *MAP_NAME_X = "dqdx_X_correction_hist_2";
+    const char *MAP_NAME_YZ_NEGATIVE = "correction_dqdx_ZvsY_negativeX_hist_2";
+    const char *MAP_NAME_YZ_POSITIVE = "correction_dqdx_ZvsY_positiveX_hist_2";
+    const char *DIGEST_TREE_NAME = "digests";
+
+    // Check that a map of an input file has the binning of the builder.
+    bool IsSameAxis(const TAxis *axis, const size_t &nBins, const double &min, const double &max) {
+      return (size_t)axis->GetNbins() == nBins && std::abs(axis->GetXmin()-min) < 1e-6 && std::abs(axis->GetXmax()-max) < 1e-6;
+    }
+  }
+
+  CalibMapBuilder::CalibMapBuilder() {
+  }
+
+  CalibMapBuilder::~CalibMapBuilder() {
+  }
+
+  // Read parameters from FHICL file
+  void CalibMapBuilder::reconfigure(fhicl::ParameterSet const &p) {
+    _nBinsX = p.get<size_t>("nBinsX", 144);
+    _minX = p.get<double>("minX", -360.);
+    _maxX = p.get<double>("maxX", 360.);
+    _nBinsY = p.get<size_t>("nBinsY", 120);
+    _minY = p.get<double>("minY", 0.);
+    _maxY = p.get<double>("maxY", 600.);
+    _nBinsZ = p.get<size_t>("nBinsZ", 139);
+    _minZ = p.get<double>("minZ", 0.);
+    _maxZ = p.get<double>("maxZ", 695.);
+    _compression = p.get<double>("compression", 50.);
+    _minEntries = p.get<double>("minEntries", 10.);
+    _minResRange = p.get<double>("minResRange", 60.);
+    _useYZCorrectionForX = p.get<bool>("useYZCorrectionForX", false);
+    _fileNameX = p.get<std::string>("fileNameX", "Xcalo_built.root");
+    _fileNameYZ = p.get<std::string>("fileNameYZ", "YZcalo_built.root");
+
+    _digests[kMapX].assign(_nBinsX, QuantileDigest(_compression));
+    _digests[kMapYZNegative].assign(_nBinsZ*_nBinsY, QuantileDigest(_compression));
+    _digests[kMapYZPositive].assign(_nBinsZ*_nBinsY, QuantileDigest(_compression));
+    _digests[kMapGlobalX].assign(1, QuantileDigest(_compression));
+    _digests[kMapGlobalYZ].assign(1, QuantileDigest(_compression));
+  }
+
+  // Index of the bin of a coordinate, INV_SIZE if outside.
+  size_t CalibMapBuilder::GetBin(const double &value, const double &min, const double &max, const size_t &nBins) const {
+    if (value < min || value >= max) return INV_SIZE;
+    return std::min((size_t)((value-min)/(max-min)*nBins), nBins-1);
+  }
+
+  // Add the hits of a track. yzFactors are used for the X map if useYZCorrectionForX.
+  void CalibMapBuilder::Fill(const std::vector<double> &hit_xs, const std::vector<double> &hit_ys, const std::vector<double> &hit_zs,
+                             const std::vector<double> &dQdx, const std::vector<double> &resRange, const std::vector<double> &yzFactors) {
+    const size_t nHits = std::min({hit_xs.size(), hit_ys.size(), hit_zs.size(), dQdx.size(), resRange.size()});
+    for (size_t i = 0; i < nHits; i++) {
+      if (hit_xs[i]==INV_DBL || hit_ys[i]==INV_DBL || hit_zs[i]==INV_DBL) continue;
+      // Skip the Bragg peak and the empty hits.
+      if (resRange[i] < _minResRange || dQdx[i] <= 0) continue;
+
+      // YZ maps, split as in CalibrationHelper::GetYZCorr.
+      const size_t binY = GetBin(hit_ys[i], _minY, _maxY, _nBinsY);
+      const size_t binZ = GetBin(hit_zs[i], _minZ, _maxZ, _nBinsZ);
+      if (binY != INV_SIZE && binZ != INV_SIZE) {
+        const calibMapType type = hit_xs[i] > 0 ? kMapYZPositive : kMapYZNegative;
+        _digests[type][binZ*_nBinsY+binY].Add(dQdx[i]);
+        _digests[kMapGlobalYZ][0].Add(dQdx[i]);
+      }
+
+      // X map, after the YZ correction of the current maps if requested.
+      const size_t binX = GetBin(hit_xs[i], _minX, _maxX, _nBinsX);
+      if (binX == INV_SIZE) continue;
+      double value = dQdx[i];
+      if (_useYZCorrectionForX) {
+        if (i >= yzFactors.size() || yzFactors[i] == INV_DBL) continue;
+        value *= yzFactors[i];
+      }
+      _digests[kMapX][binX].Add(value);
+      _digests[kMapGlobalX][0].Add(value);
+    }
+  }
+
+  // Correction factor of a bin: median of all the hits over median of the bin.
+  double CalibMapBuilder::GetFactor(const calibMapType &type, const size_t &bin, const double &globalMedian) {
+    QuantileDigest &digest = _digests[type][bin];
+    if (digest.GetTotalWeight() < _minEntries || globalMedian <= 0) return 1.;
+    const double median = digest.Median();
+    return median > 0 ? globalMedian/median : 1.;
+  }
+
+  // Write the digests of some map types to the current directory.
+  void CalibMapBuilder::WriteDigests(const std::vector<calibMapType> &types) {
+    int type, bin;
+    std::vector<double> means, weights;
+    TTree *tree = new TTree(DIGEST_TREE_NAME, "dQ/dx digests of the calibration maps");
+    tree->Branch("type", &type);
+    tree->Branch("bin", &bin);
+    tree->Branch("means", &means);
+    tree->Branch("weights", &weights);
+
+    for (auto const &t : types) {
+      for (size_t b = 0; b < _digests[t].size(); b++) {
+        if (_digests[t][b].GetTotalWeight() == 0) continue;
+        means.clear();
+        weights.clear();
+        for (auto const &c : _digests[t][b].GetCentroids()) {
+          means.push_back(c.mean);
+          weights.push_back(c.weight);
+        }
+        type = t;
+        bin = b;
+        tree->Fill();
+      }
+    }
+  }
+
+  // Write the maps and the digests to the X and YZ files.
+  void CalibMapBuilder::Write() {
+    // Keep the current directory (the TFileService one in an art job).
+    TDirectory::TContext directoryContext;
+    const double globalMedianX = _digests[kMapGlobalX][0].Median();
+    const double globalMedianYZ = _digests[kMapGlobalYZ][0].Median();
+
+    TFile fileX(_fileNameX.c_str(), "RECREATE");
+    if (fileX.IsZombie())
+      throw cet::exception("CalibMapBuilder.cxx") << "Cannot create " << _fileNameX << ".";
+    TH1D *h_x = new TH1D(MAP_NAME_X, "dQ/dx X correction;X (cm);factor", _nBinsX, _minX, _maxX);
+    for (size_t binX = 0; binX < _nBinsX; binX++)
+      h_x->SetBinContent(binX+1, GetFactor(kMapX, binX, globalMedianX));
+    WriteDigests({kMapX, kMapGlobalX});
+    fileX.Write();
+    fileX.Close();
+
+    TFile fileYZ(_fileNameYZ.c_str(), "RECREATE");
+    if (fileYZ.IsZombie())
+      throw cet::exception("CalibMapBuilder.cxx") << "Cannot create " << _fileNameYZ << ".";
+    // Z on the X axis, as read by CalibrationHelper::GetYZCorr.
+    TH2D *h_yz_neg = new TH2D(MAP_NAME_YZ_NEGATIVE, "dQ/dx YZ correction, X < 0;Z (cm);Y (cm)", _nBinsZ, _minZ, _maxZ, _nBinsY, _minY, _maxY);
+    TH2D *h_yz_pos = new TH2D(MAP_NAME_YZ_POSITIVE, "dQ/dx YZ correction, X > 0;Z (cm);Y (cm)", _nBinsZ, _minZ, _maxZ, _nBinsY, _minY, _maxY);
+    for (size_t binZ = 0; binZ < _nBinsZ; binZ++) {
+      for (size_t binY = 0; binY < _nBinsY; binY++) {
+        h_yz_neg->SetBinContent(binZ+1, binY+1, GetFactor(kMapYZNegative, binZ*_nBinsY+binY, globalMedianYZ));
+        h_yz_pos->SetBinContent(binZ+1, binY+1, GetFactor(kMapYZPositive, binZ*_nBinsY+binY, globalMedianYZ));
+      }
+    }
+    WriteDigests({kMapYZNegative, kMapYZPositive, kMapGlobalYZ});
+    fileYZ.Write();
+    fileYZ.Close();
+  }
+
+  // Add the digests stored in a file written by Write.
+  void CalibMapBuilder::Read(const std::string &filename) {
+    TDirectory::TContext directoryContext;
+    TFile file(filename.c_str());
+    if (file.IsZombie())
+      throw cet::exception("CalibMapBuilder.cxx") << "Cannot open " << filename << ".";
+
+    // The bins of the digests are only meaningful with the same binning.
+    TH1D *h_x = (TH1D*)file.Get(MAP_NAME_X);
+    if (h_x && !IsSameAxis(h_x->GetXaxis(), _nBinsX, _minX, _maxX))
+      throw cet::exception("CalibMapBuilder.cxx") << filename << ": X binning differs from the configuration.";
+    TH2D *h_yz = (TH2D*)file.Get(MAP_NAME_YZ_NEGATIVE);
+    if (h_yz && (!IsSameAxis(h_yz->GetXaxis(), _nBinsZ, _minZ, _maxZ) || !IsSameAxis(h_yz->GetYaxis(), _nBinsY, _minY, _maxY)))
+      throw cet::exception("CalibMapBuilder.cxx") << filename << ": YZ binning differs from the configuration.";
+
+    TTree *tree = (TTree*)file.Get(DIGEST_TREE_NAME);
+    if (!tree)
+      throw cet::exception("CalibMapBuilder.cxx") << filename << " has no " << DIGEST_TREE_NAME << " tree.";
+    int type, bin;
+    std::vector<double> *means = 0x0, *weights = 0x0;
+    tree->SetBranchAddress("type", &type);
+    tree->SetBranchAddress("bin", &bin);
+    tree->SetBranchAddress("means", &means);
+    tree->SetBranchAddress("weights", &weights);
+    for (Long64_t entry = 0; entry < tree->GetEntries(); entry++) {
+      tree->GetEntry(entry);
+      if (type < 0 || type >= kNumbMapTypes || bin < 0 || (size_t)bin >= _digests[type].size())
+        throw cet::exception("CalibMapBuilder.cxx") << filename << ": digest " << type << ", bin " << bin << " out of range.";
+      // The extreme points of a digest read back are its extreme centroids.
+      for (size_t c = 0; c < means->size(); c++)
+        _digests[type][bin].Add((*means)[c], (*weights)[c]);
+    }
+    delete means;
+    delete weights;
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
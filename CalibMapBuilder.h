@@ -0,0 +1,79 @@
+/***
+  Class containing the builder of the X and YZ dQ/dx calibration maps.
+  The median dQ/dx of each X bin and of each YZ cell (per drift side) is
+  accumulated with streaming quantile digests, so the maps are made in the
+  art job without writing the hits out. The maps are written in the format
+  read by CalibrationHelper, with the digests next to them so the outputs of
+  several jobs can be merged (see CalibMaps/merge_calib_maps.cc).
+  It only depends on ROOT and FHiCL.
+
+*/
+#ifndef CALIB_MAP_BUILDER_H
+#define CALIB_MAP_BUILDER_H
+
+#include <array>
+#include <string>
+#include <vector>
+#include "fhiclcpp/ParameterSet.h"
+
+#include "QuantileDigest.h"
+
+namespace stoppingcosmicmuonselection {
+
+  // Digests of the maps, as stored in the output files.
+  enum calibMapType {
+    kMapX = 0,        // X bins
+    kMapYZNegative,   // YZ cells, X < 0
+    kMapYZPositive,   // YZ cells, X > 0
+    kMapGlobalX,      // all the hits of the X map
+    kMapGlobalYZ,     // all the hits of the YZ maps
+    kNumbMapTypes
+  };
+
+  class CalibMapBuilder {
+
+  public:
+    CalibMapBuilder();
+    ~CalibMapBuilder();
+
+    // Read parameters from FHICL file
+    void reconfigure(fhicl::ParameterSet const &p);
+
+    // Add the hits of a track. yzFactors are used for the X map if useYZCorrectionForX.
+    void Fill(const std::vector<double> &hit_xs, const std::vector<double> &hit_ys, const std::vector<double> &hit_zs,
+              const std::vector<double> &dQdx, const std::vector<double> &resRange, const std::vector<double> &yzFactors);
+
+    // Add the digests stored in a file written by Write.
+    void Read(const std::string &filename);
+
+    // Write the maps and the digests to the X and YZ files.
+    void Write();
+
+    // Get the number of hits in the YZ maps.
+    double GetNumbHits() const { return _digests[kMapGlobalYZ].empty() ? 0. : _digests[kMapGlobalYZ][0].GetTotalWeight(); }
+
+  private:
+    // Parameters
+    size_t _nBinsX, _nBinsY, _nBinsZ;
+    double _minX, _maxX, _minY, _maxY, _minZ, _maxZ;
+    double _compression;
+    double _minEntries;
+    double _minResRange;
+    bool _useYZCorrectionForX;
+    std::string _fileNameX, _fileNameYZ;
+
+    // Digests of each map type, one per bin (cell index is iZ*_nBinsY+iY for YZ).
+    std::array<std::vector<QuantileDigest>,kNumbMapTypes> _digests;
+
+    // Index of the bin of a coordinate, INV_SIZE if outside.
+    size_t GetBin(const double &value, const double &min, const double &max, const size_t &nBins) const;
+
+    // Correction factor of a bin: median of all the hits over median of the bin.
+    double GetFactor(const calibMapType &type, const size_t &bin, const double &globalMedian);
+
+    // Write the digests of some map types to the current directory.
+    void WriteDigests(const std::vector<calibMapType> &types);
+  };
+}
+
+#endif
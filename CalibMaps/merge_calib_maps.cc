@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////
+// Program:     merge_calib_maps
+// File:        merge_calib_maps.cc
+//
+// Merge the X and YZ dQ/dx calibration maps written by CalibMapBuilder
+// in several jobs, without art. The digests stored next to the maps
+// are added and the maps are made again from the merged medians.
+////////////////////////////////////////////////////////////////////////
+#include "cetlib/filepath_maker.h"
+#include "cetlib_except/exception.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/make_ParameterSet.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "protoduneana/StoppingMuonSelection/CalibMapBuilder.h"
+
+using namespace stoppingcosmicmuonselection;
+
+namespace {
+
+  void print_usage() {
+    std::cout << "Usage: merge_calib_maps -c <config.fcl> <calib.root> [<calib.root> ...]" << std::endl;
+  }
+
+}
+
+int main(int argc, char **argv) {
+
+  // Read the command line.
+  std::string configFile;
+  std::vector<std::string> inputFiles;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      print_usage();
+      return 0;
+    }
+    if (arg == "-c" && i+1 < argc)
+      configFile = argv[++i];
+    else
+      inputFiles.push_back(arg);
+  }
+  if (configFile.empty() || inputFiles.empty()) {
+    print_usage();
+    return 1;
+  }
+
+  try {
+    // Read the configuration.
+    fhicl::ParameterSet pset;
+    cet::filepath_lookup maker("FHICL_FILE_PATH");
+    fhicl::make_ParameterSet(configFile, maker, pset);
+    const fhicl::ParameterSet p = pset.get<fhicl::ParameterSet>("mergeCalibMaps");
+
+    CalibMapBuilder builder;
+    builder.reconfigure(p.get<fhicl::ParameterSet>("CalibMapBuilder"));
+    for (auto const &inputFile : inputFiles)
+      builder.Read(inputFile);
+    std::cout << "Merged " << inputFiles.size() << " files, " << builder.GetNumbHits() << " hits in the YZ maps." << std::endl;
+    builder.Write();
+  }
+  catch (cet::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -6,6 +6,7 @@
 #define CALIBRATION_HELPER_CXX
 
 #include "CalibrationHelper.h"
+#include "Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -17,11 +18,10 @@ namespace stoppingcosmicmuonselection {
   }
 
   // Get the histos.
-  void CalibrationHelper::Set(art::Event const &evt) {
-    auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-    auto const detprop = art::ServiceHandle<detinfo::DetectorPropertiesService>()->DataFor(evt, clockData);
-    sceHelper = new SceHelper(detprop);
-    drift_velocity = detprop.DriftVelocity()*1e-3;
+  void CalibrationHelper::Set(art::Event const &evt, const EventContext &context) {
+    STOPPING_MUON_SCOPED_TIMER("CalibrationHelper::Set");
+    sceHelper = new SceHelper(context);
+    drift_velocity = context.DriftVelocity();
 
     std::string filetype;
     std::string filenameX;
@@ -37,8 +37,8 @@ namespace stoppingcosmicmuonselection {
       filenameX = "Xcalo_r" + std::to_string(runNumber) + ".root";
       filenameYZ = "YZcalo_r" + std::to_string(runNumber) + ".root";
     }
-    std::cout << "CalibrationHelper.cxx: filenameX = " << filenameX <<std::endl;
-    std::cout << "CalibrationHelper.cxx: filenameYZ = " << filenameYZ <<std::endl;
+    STOPPING_MUON_LOG_INFO(kLogCalorimetry) << "CalibrationHelper.cxx: filenameX = " << filenameX;
+    STOPPING_MUON_LOG_INFO(kLogCalorimetry) << "CalibrationHelper.cxx: filenameYZ = " << filenameYZ;
     TFile fileX(filenameX.c_str());
     TFile fileYZ(filenameYZ.c_str());
 
@@ -48,12 +48,12 @@ namespace stoppingcosmicmuonselection {
   }
 
   // Get X correction factor.
-  double CalibrationHelper::GetXCorr(const TVector3 &hitPos) {
+  double CalibrationHelper::GetXCorr(const Point3 &hitPos) {
     return h_x->GetBinContent(h_x->FindBin(hitPos.X()));
   }
 
   // Get YZ correction factor.
-  double CalibrationHelper::GetYZCorr(const TVector3 &hitPos) {
+  double CalibrationHelper::GetYZCorr(const Point3 &hitPos) {
     double factor = INV_DBL;
 
     if (hitPos.X() > 0)
@@ -65,16 +65,17 @@ namespace stoppingcosmicmuonselection {
   }
 
   // Get both factors at the same time.
-  double CalibrationHelper::GetXYZCorr(const TVector3 &hitPos) {
+  double CalibrationHelper::GetXYZCorr(const Point3 &hitPos) {
     return GetXCorr(hitPos)*GetYZCorr(hitPos);
   }
 
   // Get vector of factors for X.
   std::vector<double> CalibrationHelper::GetXCorr_V(const std::vector<double> &hit_xs) {
+    STOPPING_MUON_SCOPED_TIMER("CalibrationHelper::GetXCorr_V");
     std::vector<double> result;
 
     for (auto const &x : hit_xs) {
-      TVector3 hitPos(x, 0, 0);
+      Point3 hitPos{x, 0, 0};
       result.push_back(GetXCorr(hitPos));
     }
 
@@ -83,63 +84,46 @@ namespace stoppingcosmicmuonselection {
 
   // Get vector of factors for YZ.
   std::vector<double> CalibrationHelper::GetYZCorr_V(const std::vector<double> &hit_xs, const std::vector<double> &hit_ys, const std::vector<double> &hit_zs) {
+    STOPPING_MUON_SCOPED_TIMER("CalibrationHelper::GetYZCorr_V");
     std::vector<double> result;
 
     for (size_t id = 0; id < hit_xs.size(); id++) {
-      TVector3 hitPos(hit_xs[id], hit_ys[id], hit_zs[id]);
+      Point3 hitPos{hit_xs[id], hit_ys[id], hit_zs[id]};
       result.push_back(GetYZCorr(hitPos));
     }
 
     return result;
   }
 
-  void CalibrationHelper::LifeTimeCorrNew(double &dQdx, const double &hitX, const art::Event &evt)  {
-    auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-    auto const detProp = art::ServiceHandle<detinfo::DetectorPropertiesService const>()->DataFor(evt);
-    double vDrift = detProp.DriftVelocity(); //cm/us
-    double xAnode = std::abs(detProp.ConvertTicksToX(trigger_offset(clockData),0,0,0));
-    std::cout << "X ANODE: " << xAnode << std::endl;
-    double fLifetime = INV_DBL;
-
-    if (evt.isRealData()) {
-      // Electron lifetime from database calibration service provider
-      art::ServiceHandle<calib::LifetimeCalibService> lifetimecalibHandler;
-      calib::LifetimeCalibService & lifetimecalibService = *lifetimecalibHandler;
-      calib::LifetimeCalib *lifetimecalib = lifetimecalibService.provider();
-      fLifetime = lifetimecalib->GetLifetime()*1000.0; // [ms]*1000.0 -> [us]
-      std::cout << "LIFETIME: " << fLifetime << std::endl;
-      //fLifetime = 17518.3; // us?
-    }
-    else {
-      fLifetime = detProp.ElectronLifetime();
-    }
+  void CalibrationHelper::LifeTimeCorrNew(double &dQdx, const double &hitX, const EventContext &context)  {
+    STOPPING_MUON_SCOPED_TIMER("CalibrationHelper::LifeTimeCorrNew");
+    double vDrift = context.DriftVelocity()*1e3; //cm/us
+    double xAnode = context.XAnode();
+    STOPPING_MUON_LOG_DEBUG(kLogCalorimetry) << "X ANODE: " << xAnode;
+    double fLifetime = context.GetCalibLifetime();
+    STOPPING_MUON_LOG_DEBUG(kLogCalorimetry) << "LIFETIME: " << fLifetime;
     dQdx = dQdx * TMath::Exp((xAnode-std::abs(hitX))/(fLifetime*vDrift));
   }
 
-  double CalibrationHelper::GetLifeTimeCorrFactor(const double &lt, const double &hitX, const art::Event &evt) {
-    
-    auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-    auto const detProp = art::ServiceHandle<detinfo::DetectorPropertiesService const>()->DataFor(evt);
-    double vDrift = detProp.DriftVelocity(); //cm/us
-    double xAnode = std::abs(detProp.ConvertTicksToX(trigger_offset(clockData),0,0,0));
-    
-    return TMath::Exp((xAnode-std::abs(hitX))/(lt * vDrift));
+  double CalibrationHelper::GetLifeTimeCorrFactor(const double &lt, const double &hitX, const EventContext &context) {
+    double vDrift = context.DriftVelocity()*1e3; //cm/us
+    return TMath::Exp((context.XAnode()-std::abs(hitX))/(lt * vDrift));
   }
 
   // Get vector of directions.
-  std::vector<TVector3> CalibrationHelper::GetHitDirVec(const std::vector<double> &hit_x, const std::vector<double> &hit_y, const std::vector<double> &hit_z) {
+  std::vector<Vec3> CalibrationHelper::GetHitDirVec(const std::vector<double> &hit_x, const std::vector<double> &hit_y, const std::vector<double> &hit_z) {
 
-    std::vector<TVector3> dirs;
+    std::vector<Vec3> dirs;
     if (hit_x[0]!=INV_DBL && hit_y[0]!=INV_DBL && hit_z[0]!=INV_DBL)
-      dirs.push_back(TVector3(hit_x[1]-hit_x[0], hit_y[1]-hit_y[0], hit_z[1]-hit_z[0]));
+      dirs.push_back(Vec3{hit_x[1]-hit_x[0], hit_y[1]-hit_y[0], hit_z[1]-hit_z[0]});
     else
-      dirs.push_back(TVector3(INV_DBL, INV_DBL, INV_DBL));
+      dirs.push_back(Vec3{INV_DBL, INV_DBL, INV_DBL});
 
     for (size_t i = 1; i < hit_x.size(); i++) {
       if (hit_x[i]==INV_DBL || hit_y[i]==INV_DBL || hit_z[i]==INV_DBL)
-        dirs.push_back(TVector3(INV_DBL, INV_DBL, INV_DBL));
+        dirs.push_back(Vec3{INV_DBL, INV_DBL, INV_DBL});
       else {
-        dirs.push_back(TVector3(hit_x[i]-hit_x[i-1], hit_y[i]-hit_y[i-1], hit_z[i]-hit_z[i-1]));
+        dirs.push_back(Vec3{hit_x[i]-hit_x[i-1], hit_y[i]-hit_y[i-1], hit_z[i]-hit_z[i-1]});
       }
     }
 
@@ -148,15 +132,15 @@ namespace stoppingcosmicmuonselection {
   }
 
   // Get vector of Fields.
-  std::vector<TVector3> CalibrationHelper::GetHitPosField(const std::vector<double> &hit_x, const std::vector<double> &hit_y, const std::vector<double> &hit_z) {
+  std::vector<Vec3> CalibrationHelper::GetHitPosField(const std::vector<double> &hit_x, const std::vector<double> &hit_y, const std::vector<double> &hit_z) {
 
-    std::vector<TVector3> fields;
+    std::vector<Vec3> fields;
 
     for (size_t i = 0; i < hit_x.size(); i++) {
       if (hit_x[i]==INV_DBL || hit_y[i]==INV_DBL || hit_z[i]==INV_DBL)
-        fields.push_back(TVector3(INV_DBL, INV_DBL, INV_DBL));
+        fields.push_back(Vec3{INV_DBL, INV_DBL, INV_DBL});
       else {
-        fields.push_back(sceHelper->GetFieldVector(TVector3(hit_x[i], hit_y[i], hit_z[i])));
+        fields.push_back(sceHelper->GetFieldVector(Point3{hit_x[i], hit_y[i], hit_z[i]}));
       }
     }
 
@@ -166,10 +150,11 @@ namespace stoppingcosmicmuonselection {
 
   // Get vector of angles phi.
   std::vector<double> CalibrationHelper::PitchFieldAngle(const std::vector<double> &hit_xs, const std::vector<double> &hit_ys, const std::vector<double> &hit_zs) {
+    STOPPING_MUON_SCOPED_TIMER("CalibrationHelper::PitchFieldAngle");
     std::vector<double> phis;
 
-    std::vector<TVector3> dirs = GetHitDirVec(hit_xs, hit_ys, hit_zs);
-    std::vector<TVector3> fields = GetHitPosField(hit_xs, hit_ys, hit_zs);
+    std::vector<Vec3> dirs = GetHitDirVec(hit_xs, hit_ys, hit_zs);
+    std::vector<Vec3> fields = GetHitPosField(hit_xs, hit_ys, hit_zs);
 
     for (size_t i = 0; i < TMath::Min(dirs.size(), fields.size()); i++) {
       if (dirs[i].X()==INV_DBL || dirs[i].Y()==INV_DBL || dirs[i].Z()==INV_DBL || fields[i].X()==INV_DBL || fields[i].Y()==INV_DBL || fields[i].Z()==INV_DBL)
@@ -184,6 +169,74 @@ namespace stoppingcosmicmuonselection {
 
   }
 
+  // Fill the calibration columns of the hits of a track in one pass.
+  void CalibrationHelper::FillCalibColumns(const std::vector<double> &hit_xs, const std::vector<double> &hit_ys, const std::vector<double> &hit_zs,
+                                           const std::vector<double> &dQdx, const double &lifetime, const EventContext &context,
+                                           calibColumns &columns) {
+    STOPPING_MUON_SCOPED_TIMER("CalibrationHelper::FillCalibColumns");
+    const size_t nHits = hit_xs.size();
+    const size_t nLifetimes = columns.lifeTimeCorr.size();
+    std::vector<double>* const singleColumns[] = {columns.phis, columns.efX, columns.efY, columns.efZ, columns.efield,
+                                                  columns.xCalibFactor, columns.yzCalibFactor, columns.dQdxCalib};
+    for (auto column : singleColumns) {
+      if (!column) continue;
+      column->clear();
+      column->reserve(nHits);
+    }
+    for (auto column : columns.lifeTimeCorr) {
+      column->clear();
+      column->reserve(nHits);
+    }
+
+    // Same as GetLifeTimeCorrFactor, with the product worked out once per hypothesis.
+    const double vDrift = context.DriftVelocity()*1e3; //cm/us
+    const double xAnode = context.XAnode();
+    arenaVector<double> ltTimesVDrift(nLifetimes, EventArena::Get().Resource());
+    for (size_t k = 0; k < nLifetimes; k++)
+      ltTimesVDrift[k] = (columns.lifetimeShifts[k]*lifetime + lifetime) * vDrift;
+
+    for (size_t i = 0; i < nHits; i++) {
+      const bool isValid = hit_xs[i]!=INV_DBL && hit_ys[i]!=INV_DBL && hit_zs[i]!=INV_DBL;
+      const Point3 hitPos{hit_xs[i], hit_ys[i], hit_zs[i]};
+
+      // Direction to the previous hit (to the next one for the first hit), as in GetHitDirVec.
+      Vec3 dir{INV_DBL, INV_DBL, INV_DBL};
+      if (i == 0) {
+        if (isValid && nHits > 1)
+          dir = Vec3{hit_xs[1]-hit_xs[0], hit_ys[1]-hit_ys[0], hit_zs[1]-hit_zs[0]};
+      }
+      else if (isValid) {
+        dir = Vec3{hit_xs[i]-hit_xs[i-1], hit_ys[i]-hit_ys[i-1], hit_zs[i]-hit_zs[i-1]};
+      }
+      const Vec3 field = isValid ? sceHelper->GetFieldVector(hitPos) : Vec3{INV_DBL, INV_DBL, INV_DBL};
+
+      if (columns.phis) {
+        if (dir.X()==INV_DBL || dir.Y()==INV_DBL || dir.Z()==INV_DBL || field.X()==INV_DBL || field.Y()==INV_DBL || field.Z()==INV_DBL)
+          columns.phis->push_back(INV_DBL);
+        else
+          columns.phis->push_back(dir.Angle(field));
+      }
+      if (columns.efX) columns.efX->push_back(field.X());
+      if (columns.efY) columns.efY->push_back(field.Y());
+      if (columns.efZ) columns.efZ->push_back(field.Z());
+      if (columns.efield) columns.efield->push_back(field.Mag());
+
+      const double xFactor = GetXCorr(Point3{hit_xs[i], 0, 0});
+      const double yzFactor = GetYZCorr(hitPos);
+      if (columns.xCalibFactor) columns.xCalibFactor->push_back(xFactor);
+      if (columns.yzCalibFactor) columns.yzCalibFactor->push_back(yzFactor);
+
+      double lifetimeFactor = 1.;
+      for (size_t k = 0; k < nLifetimes; k++) {
+        const double factor = TMath::Exp((xAnode-std::abs(hit_xs[i]))/ltTimesVDrift[k]);
+        columns.lifeTimeCorr[k]->push_back(factor);
+        if (k == 0) lifetimeFactor = factor;
+      }
+      if (columns.dQdxCalib)
+        columns.dQdxCalib->push_back(i < dQdx.size() ? dQdx[i]*xFactor*yzFactor*lifetimeFactor : INV_DBL);
+    }
+  }
+
   void CalibrationHelper::CorrectXPosition(std::vector<double> &hit_xs, const double &startX, const double &endX, const double &t0) {
 
     if (startX <= endX) {
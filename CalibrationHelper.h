@@ -23,13 +23,15 @@
 #include "dune/CalibServices/LifetimeCalibService.h"
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Principal/Handle.h"
-#include "TVector3.h"
 #include "TH1D.h"
 #include "TH2D.h"
 #include "TFile.h"
 #include "TMath.h"
 
 #include "DataTypes.h"
+#include "EventArena.h"
+#include "EventContext.h"
+#include "Instrumentation.h"
 #include "SceHelper.h"
 
 namespace stoppingcosmicmuonselection {
@@ -42,16 +44,16 @@ namespace stoppingcosmicmuonselection {
     ~CalibrationHelper();
 
     // Get the histos.
-    void Set(art::Event const &evt);
+    void Set(art::Event const &evt, const EventContext &context);
 
     // Get X correction factor.
-    double GetXCorr(const TVector3 &hitPos);
+    double GetXCorr(const Point3 &hitPos);
 
     // Get YZ correction factor.
-    double GetYZCorr(const TVector3 &hitPos);
+    double GetYZCorr(const Point3 &hitPos);
 
     // Get both factors at the same time.
-    double GetXYZCorr(const TVector3 &hitPos);
+    double GetXYZCorr(const Point3 &hitPos);
 
     // Get vector of factors for X.
     std::vector<double> GetXCorr_V(const std::vector<double> &hit_xs);
@@ -59,19 +61,24 @@ namespace stoppingcosmicmuonselection {
     // Get vector of factors for YZ.
     std::vector<double> GetYZCorr_V(const std::vector<double> &hit_xs, const std::vector<double> &hit_ys, const std::vector<double> &hit_zs);
 
-    void LifeTimeCorrNew(double &dQdx, const double &hitX, const art::Event &evt);
+    void LifeTimeCorrNew(double &dQdx, const double &hitX, const EventContext &context);
     
-    double GetLifeTimeCorrFactor(const double &lt, const double &hitX, const art::Event &evt);
+    double GetLifeTimeCorrFactor(const double &lt, const double &hitX, const EventContext &context);
      
     // Get vector of directions.
-    std::vector<TVector3> GetHitDirVec(const std::vector<double> &hit_xs, const std::vector<double> &hit_ys, const std::vector<double> &hit_zs);
+    std::vector<Vec3> GetHitDirVec(const std::vector<double> &hit_xs, const std::vector<double> &hit_ys, const std::vector<double> &hit_zs);
 
     // Get vector of Fields.
-    std::vector<TVector3> GetHitPosField(const std::vector<double> &hit_x, const std::vector<double> &hit_y, const std::vector<double> &hit_z);
+    std::vector<Vec3> GetHitPosField(const std::vector<double> &hit_x, const std::vector<double> &hit_y, const std::vector<double> &hit_z);
 
     // Get vector of angles phi.
     std::vector<double> PitchFieldAngle(const std::vector<double> &hit_xs, const std::vector<double> &hit_ys, const std::vector<double> &hit_zs);
 
+    // Fill the calibration columns of the hits of a track in one pass.
+    void FillCalibColumns(const std::vector<double> &hit_xs, const std::vector<double> &hit_ys, const std::vector<double> &hit_zs,
+                          const std::vector<double> &dQdx, const double &lifetime, const EventContext &context,
+                          calibColumns &columns);
+
     // Correct the X position for hits. Only to be used for some anode crossers.
     void CorrectXPosition(std::vector<double> &hit_xs, const double &startX, const double &endX, const double &t0);
 
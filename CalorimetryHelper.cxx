@@ -5,7 +5,10 @@
 #ifndef CALORIMETRY_HELPER_CXX
 #define CALORIMETRY_HELPER_CXX
 
+#include "cetlib_except/exception.h"
+
 #include "CalorimetryHelper.h"
+#include "Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -13,8 +16,8 @@ namespace stoppingcosmicmuonselection {
 
   }
 
-  CalorimetryHelper::CalorimetryHelper(const recob::PFParticle &thisParticle, art::Event const &evt, const int &plane) {
-    Set(thisParticle, evt, plane);
+  CalorimetryHelper::CalorimetryHelper(const recob::PFParticle &thisParticle, art::Event const &evt, const int &plane, const EventContext &context) {
+    Set(thisParticle, evt, plane, context);
   }
 
   CalorimetryHelper::~CalorimetryHelper() {
@@ -22,28 +25,39 @@ namespace stoppingcosmicmuonselection {
   }
 
   // Get the calorimetry from the PFParticle
-  void CalorimetryHelper::Set(const recob::PFParticle &thisParticle, art::Event const &evt, const int &plane) {
-    Reset();
+  void CalorimetryHelper::Set(const recob::PFParticle &thisParticle, art::Event const &evt, const int &plane, const EventContext &context) {
+    Set(GetTrackCalorimetry(thisParticle,evt), evt.isRealData(), plane, context);
+  }
 
-    auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-    auto const detprop = art::ServiceHandle<detinfo::DetectorPropertiesService>()->DataFor(evt, clockData);
+  // Get the calorimetry objects of the track of the PFParticle (all planes).
+  const std::vector<anab::Calorimetry> CalorimetryHelper::GetTrackCalorimetry(const recob::PFParticle &thisParticle, art::Event const &evt) {
+    const recob::Track &track = *(pfpUtil.GetPFParticleTrack(thisParticle,evt,fPFParticleTag,fTrackerTag));
+    return trackUtil.GetRecoTrackCalorimetry(track,evt,fTrackerTag,fCalorimetryTag);
+  }
+
+  // Set from calorimetry already read from the event. Does not access the event.
+  void CalorimetryHelper::Set(const std::vector<anab::Calorimetry> &calos,
+                              const bool &isData,
+                              const int &plane,
+                              const EventContext &context) {
+    STOPPING_MUON_SCOPED_TIMER("CalorimetryHelper::Set");
+    Reset();
 
     _plane = plane;
     bool correct_dQdx = false;
     // Set variable to see if it's data or MC (different histo scales)
-    if (evt.isRealData()) _isData = true;
-    const recob::Track &track = *(pfpUtil.GetPFParticleTrack(thisParticle,evt,fPFParticleTag,fTrackerTag));
-    _calos = trackUtil.GetRecoTrackCalorimetry(track,evt,fTrackerTag,fCalorimetryTag);
+    _isData = isData;
+    _calos = calos;
     _isCalorimetrySet = true;
 
-    if (!IsValid()) {
-      std::cout << "CalorimetryHelper.cxx: Calorimetry invalid for plane: " << plane << std::endl;
+    if (!HasPlane()) {
+      STOPPING_MUON_LOG_WARNING(kLogCalorimetry) << "CalorimetryHelper.cxx: Calorimetry invalid for plane: " << plane;
       return;
     }
 
     for (size_t itcal = 0; itcal < _calos.size(); itcal++) {
       if (!(_calos[itcal].PlaneID().isValid)) {
-        std::cout << "CalorimetryHelper.cxx: " << "plane at entry " << itcal << " not valid"<< std::endl;
+        STOPPING_MUON_LOG_WARNING(kLogCalorimetry) << "CalorimetryHelper.cxx: " << "plane at entry " << itcal << " not valid";
         continue;
       }
 
@@ -76,41 +90,49 @@ namespace stoppingcosmicmuonselection {
         const geo::Point_t HitPoint(TrackPos.X(), TrackPos.Y(), TrackPos.Z());
         geo::TPCID const & tpcid = geom->FindTPCAtPosition(HitPoint);
         if (!tpcid.isValid) {
-          std::cout << "CalorimetryHelper.cxx: " << "tpc not valid"<< std::endl;
+          STOPPING_MUON_LOG_WARNING(kLogCalorimetry) << "CalorimetryHelper.cxx: " << "tpc not valid";
           _drift_time.push_back(INV_DBL);
           _corr_factors.push_back(INV_DBL);
           continue;
         }
         int CryoID = geom->FindCryostatAtPosition(HitPoint);
-        double Ticks = detprop.ConvertXToTicks(TrackPos.X(), planeNumb, tpcid.TPC, CryoID);
-        _drift_time.push_back((Ticks - trigger_offset(clockData)) * sampling_rate(clockData)*1e-3);
-        _corr_factors.push_back(LifeTimeCorr(Ticks, 0, sampling_rate(clockData)*1e-3, trigger_offset(clockData),detprop.ElectronLifetime()));
+        double Ticks = context.XToTicks(TrackPos.X(), planeNumb, tpcid.TPC, CryoID);
+        _drift_time.push_back((Ticks - context.TriggerOffset()) * context.SamplingRate()*1e-3);
+        _corr_factors.push_back(LifeTimeCorr(Ticks, 0, context.SamplingRate()*1e-3, context.TriggerOffset(), context.ElectronLifetime()));
       }
     }
+    STOPPING_MUON_COUNT("CalorimetryHelper::Set hits", _dqdx.size());
     OrderResRange();
+    _isValid = _dqdx.size() > 0;
   }
 
-  // Check if the calorimetry is valid
+  // Check if the calorimetry is valid: the plane is there and has hits.
   bool CalorimetryHelper::IsValid() {
+    return _isValid;
+  }
 
-    _isValid = false;
-    // Check that the size is not zero.
-    if (_calos.size() == 0) _isValid = false;
-    // If it's zero the loop is ignored
+  // Check if there is a calorimetry object for the plane.
+  bool CalorimetryHelper::HasPlane() {
+
+    bool hasPlane = false;
+    // If there is no calorimetry the loop is ignored
     for (size_t itcal = 0; itcal < _calos.size(); itcal++) {
       if (!(_calos[itcal].PlaneID().isValid)) continue;
       int planeNumb = _calos[itcal].PlaneID().Plane;
       if (_plane == planeNumb) {
-        _isValid = true;
+        hasPlane = true;
         break;
       }
     }
-    return _isValid;
+    return hasPlane;
 
   }
 
   // Order the residual range with respect to the track direction
   void CalorimetryHelper::OrderResRange() {
+    _resrange_ord.clear();
+    // Nothing to order on a plane without hits.
+    if (_resrange.empty() || _hity.size() != _resrange.size()) return;
     std::vector<double> res_vect;
       for (size_t i = 0; i < _resrange.size();i++) {
         res_vect.push_back(_resrange[i]);
@@ -217,49 +239,23 @@ namespace stoppingcosmicmuonselection {
     return correction;
   }
 
-  void CalorimetryHelper::LifeTimeCorrNew(std::vector<double> &dQdx, const std::vector<double> &hitX, const art::Event &evt) {
-    auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-    auto const detProp = art::ServiceHandle<detinfo::DetectorPropertiesService const>()->DataFor(evt);
-    double vDrift = detProp.DriftVelocity(); //cm/us
-    double xAnode = std::abs(detProp.ConvertTicksToX(trigger_offset(clockData),0,0,0));
-    std::cout << "X ANODE: " << xAnode << std::endl;
-    double fLifetime = INV_DBL;
-
-    if (evt.isRealData()) {
-      // Electron lifetime from database calibration service provider
-      art::ServiceHandle<calib::LifetimeCalibService> lifetimecalibHandler;
-      calib::LifetimeCalibService & lifetimecalibService = *lifetimecalibHandler;
-      calib::LifetimeCalib *lifetimecalib = lifetimecalibService.provider();
-      fLifetime = lifetimecalib->GetLifetime()*1000.0; // [ms]*1000.0 -> [us]
-      std::cout << "LIFETIME: " << fLifetime << std::endl;
-    }
-    else {
-      fLifetime = detProp.ElectronLifetime();
-    }
+  void CalorimetryHelper::LifeTimeCorrNew(std::vector<double> &dQdx, const std::vector<double> &hitX, const EventContext &context) {
+    double vDrift = context.DriftVelocity()*1e3; //cm/us
+    double xAnode = context.XAnode();
+    STOPPING_MUON_LOG_DEBUG(kLogCalorimetry) << "X ANODE: " << xAnode;
+    double fLifetime = context.GetCalibLifetime();
+    STOPPING_MUON_LOG_DEBUG(kLogCalorimetry) << "LIFETIME: " << fLifetime;
     for (size_t i=0;i<dQdx.size();i++) {
       dQdx[i] = dQdx[i] * TMath::Exp((xAnode-std::abs(hitX[i]))/(fLifetime*vDrift));
     }
   }
   
-  void CalorimetryHelper::LifeTimeCorrNew(double &dQdx, const double &hitX, const art::Event &evt)  {
-    auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-    auto const detProp = art::ServiceHandle<detinfo::DetectorPropertiesService const>()->DataFor(evt);
-    double vDrift = detProp.DriftVelocity(); //cm/us
-    double xAnode = std::abs(detProp.ConvertTicksToX(trigger_offset(clockData),0,0,0));
-    std::cout << "X ANODE: " << xAnode << std::endl;
-    double fLifetime = INV_DBL;
-
-    if (evt.isRealData()) {
-      // Electron lifetime from database calibration service provider
-      art::ServiceHandle<calib::LifetimeCalibService> lifetimecalibHandler;
-      calib::LifetimeCalibService & lifetimecalibService = *lifetimecalibHandler;
-      calib::LifetimeCalib *lifetimecalib = lifetimecalibService.provider();
-      fLifetime = lifetimecalib->GetLifetime()*1000.0; // [ms]*1000.0 -> [us]
-      std::cout << "LIFETIME: " << fLifetime << std::endl;
-    }
-    else {
-      fLifetime = detProp.ElectronLifetime();
-    }
+  void CalorimetryHelper::LifeTimeCorrNew(double &dQdx, const double &hitX, const EventContext &context)  {
+    double vDrift = context.DriftVelocity()*1e3; //cm/us
+    double xAnode = context.XAnode();
+    STOPPING_MUON_LOG_DEBUG(kLogCalorimetry) << "X ANODE: " << xAnode;
+    double fLifetime = context.GetCalibLifetime();
+    STOPPING_MUON_LOG_DEBUG(kLogCalorimetry) << "LIFETIME: " << fLifetime;
     dQdx = dQdx * TMath::Exp((xAnode-std::abs(hitX))/(fLifetime*vDrift));
   }
 
@@ -331,6 +327,22 @@ namespace stoppingcosmicmuonselection {
     }
   }
 
+  // Expected (MPV) dEdx of each hit, from the MC or from LandauVav with the hit pitch.
+  void CalorimetryHelper::FillExpecteddEdx(const std::vector<double> &resRange, const std::vector<double> &trackPitch,
+                                           std::vector<double> &expecteddEdx, const bool &fromMC, const double &LArdensity) {
+    if (!fromMC && trackPitch.size() != resRange.size())
+      throw cet::exception("CalorimetryHelper.cxx") << "Track pitch and residual range sizes differ: "
+                                                    << trackPitch.size() << " vs " << resRange.size();
+    expecteddEdx.clear();
+    for (size_t it = 0; it < resRange.size(); it++) {
+      double rex = resRange[it];
+      if (fromMC)
+        expecteddEdx.push_back(truedEdxHelper.GetMCdEdx(rex));
+      else
+        expecteddEdx.push_back(truedEdxHelper.LandauVav(rex, trackPitch[it], LArdensity));
+    }
+  }
+
   // Set the parameters from the FHICL file
   void CalorimetryHelper::reconfigure(fhicl::ParameterSet const &p) {
     fTrackerTag = p.get<std::string>("TrackerTag");
@@ -18,16 +18,18 @@
 #include "larcore/Geometry/Geometry.h"
 #include "larcorealg/Geometry/TPCGeo.h"
 #include "larcorealg/Geometry/GeometryCore.h"
+#include "lardata/DetectorInfoServices/DetectorClocksService.h"
 #include "lardata/DetectorInfoServices/DetectorPropertiesService.h"
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Principal/Handle.h"
 #include "dune/Calib/LifetimeCalib.h"
 #include "dune/CalibServices/LifetimeCalibService.h"
-#include "TVector3.h"
 #include "TH2D.h"
 #include "TMath.h"
 
 #include "DataTypes.h"
+#include "EventContext.h"
+#include "Instrumentation.h"
 #include "TruedEdxHelper.h"
 
 namespace stoppingcosmicmuonselection {
@@ -36,15 +38,27 @@ namespace stoppingcosmicmuonselection {
 
   public:
     CalorimetryHelper();
-    CalorimetryHelper(const recob::PFParticle &thisParticle, art::Event const &evt, const int &plane);
+    CalorimetryHelper(const recob::PFParticle &thisParticle, art::Event const &evt, const int &plane, const EventContext &context);
     ~CalorimetryHelper();
 
     // Get the calorimetry from the PFParticle
-    void Set(const recob::PFParticle &thisParticle, art::Event const &evt, const int &plane);
+    void Set(const recob::PFParticle &thisParticle, art::Event const &evt, const int &plane, const EventContext &context);
 
-    // Check if the calorimetry is valid
+    // Get the calorimetry objects of the track of the PFParticle (all planes).
+    const std::vector<anab::Calorimetry> GetTrackCalorimetry(const recob::PFParticle &thisParticle, art::Event const &evt);
+
+    // Set from calorimetry already read from the event. Does not access the event.
+    void Set(const std::vector<anab::Calorimetry> &calos,
+             const bool &isData,
+             const int &plane,
+             const EventContext &context);
+
+    // Check if the calorimetry is valid: the plane is there and has hits.
     bool IsValid();
 
+    // Check if there is a calorimetry object for the plane.
+    bool HasPlane();
+
     // Order the residual range with respect to the track direction
     void OrderResRange();
 
@@ -77,8 +91,8 @@ namespace stoppingcosmicmuonselection {
 
     // Get the lifetime correction
     double LifeTimeCorr(double &ticks, const double &T0, const double &samplingRate, const double &triggerOffset, const double &electronLifetime);
-    void LifeTimeCorrNew(std::vector<double> &dQdx, const std::vector<double> &hitX, const art::Event &evt);
-    void LifeTimeCorrNew(double &dQdx, const double &hitX, const art::Event &evt);
+    void LifeTimeCorrNew(std::vector<double> &dQdx, const std::vector<double> &hitX, const EventContext &context);
+    void LifeTimeCorrNew(double &dQdx, const double &hitX, const EventContext &context);
     // Fill 2D histo of dQdx vs residual range for hits in a given plane
     void FillHisto_dQdxVsRR(TH2D *h_dQdxVsRR);
     void FillHisto_dQdxVsRR(TH2D *h_dQdxVsRR, const double &tp_min, const double &tp_max);
@@ -93,6 +107,10 @@ namespace stoppingcosmicmuonselection {
     // Fill 2D histo for dQdx/dEdx with lifetime correction. dEdx taken from LandauVav.
     void FillHisto_dQdEVsRR_LTCorr_LV(TH2D *h_dQdEVsRR, const double &tp_min, const double &tp_max, const double &LArdensity);
 
+    // Expected (MPV) dEdx of each hit, from the MC or from LandauVav with the hit pitch.
+    void FillExpecteddEdx(const std::vector<double> &resRange, const std::vector<double> &trackPitch,
+                          std::vector<double> &expecteddEdx, const bool &fromMC, const double &LArdensity);
+
     // Set the parameters from the FHICL file
     void reconfigure(fhicl::ParameterSet const &p);
 
@@ -0,0 +1,51 @@
+/***
+  Class containing the stopping muon candidates of an event.
+
+*/
+#ifndef CANDIDATE_TABLE_CXX
+#define CANDIDATE_TABLE_CXX
+
+#include "CandidateTable.h"
+
+namespace stoppingcosmicmuonselection {
+
+  CandidateTable::CandidateTable() {
+
+  }
+
+  CandidateTable::~CandidateTable() {
+
+  }
+
+  // Fill the table with the candidates of the event. Their PFParticles must be those of pfparticleTag.
+  void CandidateTable::Set(art::Event const &evt, const std::string &candidateTag, const std::string &pfparticleTag) {
+    _candidates.clear();
+    _pfparticles.clear();
+    _tracks.clear();
+
+    auto const candidateHandle = evt.getValidHandle<std::vector<StoppingMuonCandidate>>(candidateTag);
+    auto const pfparticleHandle = evt.getValidHandle<std::vector<recob::PFParticle>>(pfparticleTag);
+    const art::FindOneP<recob::PFParticle> findPFParticle(candidateHandle, evt, candidateTag);
+    const art::FindOneP<recob::Track> findTrack(candidateHandle, evt, candidateTag);
+
+    const size_t nCandidates = candidateHandle->size();
+    _candidates.reserve(nCandidates);
+    _pfparticles.reserve(nCandidates);
+    _tracks.reserve(nCandidates);
+    for (size_t c = 0; c < nCandidates; c++) {
+      const art::Ptr<recob::PFParticle> &pfparticlep = findPFParticle.at(c);
+      const art::Ptr<recob::Track> &trackp = findTrack.at(c);
+      if (pfparticlep.isNull() || trackp.isNull()) continue;
+      // The modules index the PFParticles of pfparticleTag with the key.
+      if (pfparticlep.id() != pfparticleHandle.id())
+        throw cet::exception("CandidateTable.cxx") << "The candidates of " << candidateTag
+                                                   << " do not point to the PFParticles of " << pfparticleTag << ".";
+      _candidates.push_back((*candidateHandle)[c]);
+      _pfparticles.push_back(pfparticlep);
+      _tracks.push_back(trackp);
+    }
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
@@ -0,0 +1,51 @@
+/***
+  Class containing the stopping muon candidates of an event.
+  Reads the StoppingMuonCandidate product of StoppingMuonProducer with
+  its PFParticle and track, so that the analyzers can study the selected
+  tracks without running the selection again.
+
+*/
+#ifndef CANDIDATE_TABLE_H
+#define CANDIDATE_TABLE_H
+
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "canvas/Persistency/Common/FindOneP.h"
+#include "canvas/Persistency/Common/Ptr.h"
+#include "cetlib_except/exception.h"
+#include "lardataobj/RecoBase/PFParticle.h"
+#include "lardataobj/RecoBase/Track.h"
+
+#include <string>
+#include <vector>
+
+#include "StoppingMuonCandidate.h"
+
+namespace stoppingcosmicmuonselection {
+
+  class CandidateTable {
+
+  public:
+    CandidateTable();
+    ~CandidateTable();
+
+    // Fill the table with the candidates of the event. Their PFParticles must be those of pfparticleTag.
+    void Set(art::Event const &evt, const std::string &candidateTag, const std::string &pfparticleTag);
+
+    // Number of candidates in the event.
+    size_t Size() const { return _candidates.size(); }
+
+    // Candidate, and its PFParticle and track, for a given index.
+    const StoppingMuonCandidate &GetCandidate(const size_t &index)        const { return _candidates[index]; }
+    const art::Ptr<recob::PFParticle> &GetPFParticle(const size_t &index) const { return _pfparticles[index]; }
+    const art::Ptr<recob::Track> &GetTrack(const size_t &index)           const { return _tracks[index]; }
+
+  private:
+    std::vector<StoppingMuonCandidate> _candidates;
+    std::vector<art::Ptr<recob::PFParticle>> _pfparticles;
+    std::vector<art::Ptr<recob::Track>> _tracks;
+
+  };
+}
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef CONSTANTS_H
+#define CONSTANTS_H
+
+#include <cstddef>
+
+namespace stoppingcosmicmuonselection {
+
+  constexpr int INV_INT = -999;
+  constexpr size_t INV_SIZE = 9999999;
+  constexpr double INV_DBL = -9999999;
+
+}
+
+#endif
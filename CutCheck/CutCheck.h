@@ -20,6 +20,16 @@
 
 #include "StoppingMuonSelection/DataTypes.h"
 #include "StoppingMuonSelection/GeometryHelper.h"
+#include "StoppingMuonSelection/HitCache.h"
+#include "StoppingMuonSelection/TruthHitCache.h"
+#include "StoppingMuonSelection/TruthMatchTable.h"
+#include "StoppingMuonSelection/TrackIDIndex.h"
+#include "StoppingMuonSelection/EventArena.h"
+#include "StoppingMuonSelection/EventContext.h"
+#include "StoppingMuonSelection/EventTablesGuard.h"
+#include "StoppingMuonSelection/TruthProvider.h"
+#include "StoppingMuonSelection/Instrumentation.h"
+#include "StoppingMuonSelection/Logging.h"
 #include "StoppingMuonSelection/CutCheck/CutCheckHelper.h"
 
 namespace stoppingcosmicmuonselection {
@@ -51,6 +61,10 @@ private:
 
   CutCheckHelper           cutCheckHelper; // need configuration
   GeometryHelper           geoHelper;
+  HitCache                 hitCache;
+  TruthHitCache            truthCache;
+  TruthMatchTable          truthTable;
+  TrackIDIndex             trackIDIndex;
 
   // Parameters form FHICL File
   double _trackPitch;
@@ -58,6 +72,7 @@ private:
   bool _selectAC, _selectCC;
   bool _runCathodeSimple;
   std::string fPFParticleTag, fTrackerTag, fSpacePointTag;
+  std::string fHitTag, fSimChannelTag;
 
   // Dummy histo to count events.
   TH1D *h_events;
@@ -179,14 +194,27 @@ void CutCheck::beginJob()
 
 void CutCheck::endJob()
 {
-  mf::LogVerbatim("CutCheck") << "CutCheck finished job";
+  STOPPING_MUON_LOG_INFO(kLogModules) << "CutCheck finished job";
+  // Time per stage, only filled when compiled with STOPPING_MUON_INSTRUMENTATION.
+  if (Instrumentation::IsEnabled()) {
+    // Written by the first module of the job only.
+    if (Instrumentation::Get().ClaimWrite()) {
+      art::ServiceHandle<art::TFileService> tfs;
+      Instrumentation::Get().Write(tfs->make<TTree>("Instrumentation","Instrumentation"));
+    }
+    Instrumentation::Get().Print();
+  }
 }
 
 void CutCheck::reconfigure(fhicl::ParameterSet const& p)
 {
+  Logger::Get().reconfigure(p.get<fhicl::ParameterSet>("Logging", fhicl::ParameterSet()));
+  TruthProvider::Get().reconfigure(p);
   fTrackerTag = p.get<std::string>("TrackerTag");
   fPFParticleTag = p.get<std::string>("PFParticleTag");
   fSpacePointTag = p.get<std::string>("SpacePointTag");
+  fHitTag = p.get<std::string>("HitTag", "hitpdune");
+  fSimChannelTag = p.get<std::string>("SimChannelTag", "tpcrawdecoder:simpleSC");
   _selectAC = p.get<bool>("selectAC", true);
   _selectCC = p.get<bool>("selectCC", true);
   _runCathodeSimple = p.get<bool>("runCathodeSimple", false);
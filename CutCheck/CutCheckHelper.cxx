@@ -17,10 +17,9 @@ namespace stoppingcosmicmuonselection {
 
   // Apply cuts ignoring the specified one.
   void CutCheckHelper::ApplyCutsCathode(TH1 *histo, TH1 *histo_signal, const std::string &excludeCut,
-                                        art::Event const &evt, const std::vector<recob::PFParticle> &particles,
-                                        const std::vector<recob::SpacePoint> &spacePoints) {
+                                        art::Event const &evt, const std::vector<recob::PFParticle> &particles) {
 
-    std::cout << "\tApplying cuts excluding " << excludeCut << std::endl;
+    STOPPING_MUON_LOG_DEBUG(kLogModules) << "\tApplying cuts excluding " << excludeCut;
 
     for (unsigned int p = 0; p < particles.size(); p++) {
 
@@ -42,20 +41,20 @@ namespace stoppingcosmicmuonselection {
 
       // if (excludeCut=="distanceFiducialVolumeX") {
       //   std::cout << "Is it a True Stopping Muon? " << selectorAlg.IsTrueParticleACathodeCrossingStoppingMuon(evt, thisParticle) << std::endl;
-      //   const TVector3 &trueStartPoint = selectorAlg.GetTrackProperties().trueStartPoint;
-      //   const TVector3 &trueEndPoint = selectorAlg.GetTrackProperties().trueEndPoint;
+      //   const Point3 &trueStartPoint = selectorAlg.GetTrackProperties().trueStartPoint;
+      //   const Point3 &trueEndPoint = selectorAlg.GetTrackProperties().trueEndPoint;
       //   std::cout << "X: " << trueStartPoint.X() << " Y: " << trueStartPoint.Y() << " Z: " << trueStartPoint.Z() << std::endl;
       //   std::cout << "X: " << trueEndPoint.X() << " Y: " << trueEndPoint.Y() << " Z: " << trueEndPoint.Z() << std::endl;
       // }
       // Run the selection.
       if (!selectorAlg.NMinus1Cathode(excludeCut, evt, thisParticle)) continue;
-      std::cout << "Selection passed. TrackID: " << selectorAlg.GetTrackProperties().trackID << std::endl;
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "Selection passed. TrackID: " << selectorAlg.GetTrackProperties().trackID;
       // Check space points.
       const recob::Track &track = selectorAlg.GetTrackFromPFParticle(evt,thisParticle);
-      if (!spAlg.IsGoodTrack(track,spacePoints,selectorAlg.GetTrackProperties())) continue;
+      if (!spAlg.IsGoodTrack(track,selectorAlg.GetTrackProperties())) continue;
 
-      const TVector3 &recoStartPoint = selectorAlg.GetTrackProperties().recoStartPoint;
-      const TVector3 &recoEndPoint = selectorAlg.GetTrackProperties().recoEndPoint;
+      const Point3 &recoStartPoint = selectorAlg.GetTrackProperties().recoStartPoint;
+      const Point3 &recoEndPoint = selectorAlg.GetTrackProperties().recoEndPoint;
       const double &minHitPeakTime = selectorAlg.GetTrackProperties().minHitPeakTime;
       const double &maxHitPeakTime = selectorAlg.GetTrackProperties().maxHitPeakTime;
 
@@ -104,7 +103,7 @@ namespace stoppingcosmicmuonselection {
       if (excludeCut == "complete") {
         double _trackPitch = 0.75;
         double _trackPitchTolerance = 0.1;
-        caloHelper.Set(thisParticle,evt,2);
+        caloHelper.Set(thisParticle,evt,2,selectorAlg.GetEventContext(evt));
         if (caloHelper.IsValid()) {
           caloHelper.FillHisto_dQdxVsRR((TH2D *)histo);
           caloHelper.FillHisto_dQdxVsRR((TH2D *)histo_signal,_trackPitch-_trackPitchTolerance,_trackPitch+_trackPitchTolerance);
@@ -119,7 +118,7 @@ namespace stoppingcosmicmuonselection {
   void CutCheckHelper::ApplyCutsCathodeSimple(TH1 *histo, TH1 *histo_signal, const std::string &excludeCut,
                                         art::Event const &evt, const std::vector<recob::PFParticle> &particles) {
 
-    std::cout << "\tApplying cuts excluding " << excludeCut << std::endl;
+    STOPPING_MUON_LOG_DEBUG(kLogModules) << "\tApplying cuts excluding " << excludeCut;
 
     for (unsigned int p = 0; p < particles.size(); p++) {
 
@@ -142,8 +141,8 @@ namespace stoppingcosmicmuonselection {
       // Run the selection.
       if (!selectorAlg.NMinus1CathodeSimple(excludeCut, evt, thisParticle)) continue;
 
-      const TVector3 &recoStartPoint = selectorAlg.GetTrackProperties().recoStartPoint;
-      const TVector3 &recoEndPoint = selectorAlg.GetTrackProperties().recoEndPoint;
+      const Point3 &recoStartPoint = selectorAlg.GetTrackProperties().recoStartPoint;
+      const Point3 &recoEndPoint = selectorAlg.GetTrackProperties().recoEndPoint;
       const double &minHitPeakTime = selectorAlg.GetTrackProperties().minHitPeakTime;
       const double &maxHitPeakTime = selectorAlg.GetTrackProperties().maxHitPeakTime;
 
@@ -192,7 +191,7 @@ namespace stoppingcosmicmuonselection {
       if (excludeCut == "complete") {
         double _trackPitch = 0.75;
         double _trackPitchTolerance = 0.1;
-        caloHelper.Set(thisParticle,evt,2);
+        caloHelper.Set(thisParticle,evt,2,selectorAlg.GetEventContext(evt));
         if (caloHelper.IsValid()) {
           caloHelper.FillHisto_dQdxVsRR((TH2D *)histo);
           caloHelper.FillHisto_dQdxVsRR((TH2D *)histo_signal,_trackPitch-_trackPitchTolerance,_trackPitch+_trackPitchTolerance);
@@ -206,10 +205,9 @@ namespace stoppingcosmicmuonselection {
   // Apply cuts ignoring the specified one.
   void CutCheckHelper::ApplyCutsAnode(TH1 *histo, TH1 *histo_signal,
                                       const std::string &excludeCut, art::Event const &evt,
-                                      const std::vector<recob::PFParticle> &particles,
-                                      const std::vector<recob::SpacePoint> &spacePoints) {
+                                      const std::vector<recob::PFParticle> &particles) {
 
-    std::cout << "\tApplying cuts excluding " << excludeCut << std::endl;
+    STOPPING_MUON_LOG_DEBUG(kLogModules) << "\tApplying cuts excluding " << excludeCut;
 
     for (unsigned int p = 0; p < particles.size(); p++) {
 
@@ -243,10 +241,10 @@ namespace stoppingcosmicmuonselection {
 
       // Check space points.
       const recob::Track &track = selectorAlg.GetTrackFromPFParticle(evt,thisParticle);
-      if (!spAlg.IsGoodTrack(track,spacePoints,selectorAlg.GetTrackProperties())) continue;
+      if (!spAlg.IsGoodTrack(track,selectorAlg.GetTrackProperties())) continue;
 
-      const TVector3 &recoStartPoint = selectorAlg.GetTrackProperties().recoStartPoint;
-      const TVector3 &recoEndPoint = selectorAlg.GetTrackProperties().recoEndPoint;
+      const Point3 &recoStartPoint = selectorAlg.GetTrackProperties().recoStartPoint;
+      const Point3 &recoEndPoint = selectorAlg.GetTrackProperties().recoEndPoint;
       const double &minHitPeakTime = selectorAlg.GetTrackProperties().minHitPeakTime;
       const double &maxHitPeakTime = selectorAlg.GetTrackProperties().maxHitPeakTime;
       const bool &isFabioTagged = selectorAlg.GetTrackProperties().isAnodeCrosserMine;
@@ -320,7 +318,7 @@ namespace stoppingcosmicmuonselection {
       if (excludeCut == "complete") {
         double _trackPitch = 0.75;
         double _trackPitchTolerance = 0.1;
-        caloHelper.Set(thisParticle,evt,2);
+        caloHelper.Set(thisParticle,evt,2,selectorAlg.GetEventContext(evt));
         caloHelper.FillHisto_dQdxVsRR((TH2D *)histo);
         caloHelper.FillHisto_dQdxVsRR((TH2D *)histo_signal,_trackPitch-_trackPitchTolerance,_trackPitch+_trackPitchTolerance);
       }
@@ -339,7 +337,7 @@ namespace stoppingcosmicmuonselection {
                                     TH1D *h_minHitPeakTimePriori, TH1D *h_minHitPeakTime_signalPriori,
                                     TH1D *h_maxHitPeakTimePriori, TH1D *h_maxHitPeakTime_signalPriori) {
 
-    std::cout << "\tFill distributions for true cathode crossing muons..." << std::endl;
+    STOPPING_MUON_LOG_DEBUG(kLogModules) << "\tFill distributions for true cathode crossing muons...";
 
     for (unsigned int p = 0; p < particles.size(); p++) {
 
@@ -361,8 +359,8 @@ namespace stoppingcosmicmuonselection {
 
       // Run the selection but just to fill the track properties.
       selectorAlg.IsStoppingCathodeCrosser(evt, thisParticle);
-      const TVector3 &recoStartPoint = selectorAlg.GetTrackProperties().recoStartPoint;
-      const TVector3 &recoEndPoint = selectorAlg.GetTrackProperties().recoEndPoint;
+      const Point3 &recoStartPoint = selectorAlg.GetTrackProperties().recoStartPoint;
+      const Point3 &recoEndPoint = selectorAlg.GetTrackProperties().recoEndPoint;
       // Skip if track is not "cathode crossing" - like
       if ( (selectorAlg.GetTrackProperties().trackT0 == INV_DBL) || (recoStartPoint.X()*recoEndPoint.X())>0) continue;
       const double &minHitPeakTime = selectorAlg.GetTrackProperties().minHitPeakTime;
@@ -400,7 +398,7 @@ namespace stoppingcosmicmuonselection {
                                   TH1D *h_minHitPeakTimePriori, TH1D *h_minHitPeakTime_signalPriori,
                                   TH1D *h_maxHitPeakTimePriori, TH1D *h_maxHitPeakTime_signalPriori) {
 
-    std::cout << "\tFill distributions for true anode crossing muons..." << std::endl;
+    STOPPING_MUON_LOG_DEBUG(kLogModules) << "\tFill distributions for true anode crossing muons...";
 
     for (unsigned int p = 0; p < particles.size(); p++) {
 
@@ -422,8 +420,8 @@ namespace stoppingcosmicmuonselection {
 
       // Run the selection but just to fill the track properties.
       selectorAlg.IsStoppingAnodeCrosser(evt, thisParticle);
-      const TVector3 &recoStartPoint = selectorAlg.GetTrackProperties().recoStartPoint;
-      const TVector3 &recoEndPoint = selectorAlg.GetTrackProperties().recoEndPoint;
+      const Point3 &recoStartPoint = selectorAlg.GetTrackProperties().recoStartPoint;
+      const Point3 &recoEndPoint = selectorAlg.GetTrackProperties().recoEndPoint;
       const double &minHitPeakTime = selectorAlg.GetTrackProperties().minHitPeakTime;
       const double &maxHitPeakTime = selectorAlg.GetTrackProperties().maxHitPeakTime;
 
@@ -445,6 +443,26 @@ namespace stoppingcosmicmuonselection {
     }
   }
 
+  // Use a per-event truth matching table in the selector.
+  void CutCheckHelper::SetTruthMatchTable(const TruthMatchTable *truthTable) {
+    selectorAlg.SetTruthMatchTable(truthTable);
+  }
+
+  // Use a per-event track index in the selector.
+  void CutCheckHelper::SetTrackIDIndex(const TrackIDIndex *trackIDIndex) {
+    selectorAlg.SetTrackIDIndex(trackIDIndex);
+  }
+
+  // Use a per-event context in the selector.
+  void CutCheckHelper::SetEventContext(const EventContext *eventContext) {
+    selectorAlg.SetEventContext(eventContext);
+  }
+
+  // Fill the space point grid for this event.
+  void CutCheckHelper::SetSpacePoints(const std::vector<recob::SpacePoint> &spacePoints) {
+    spAlg.SetSpacePoints(spacePoints);
+  }
+
   // Configure the selector.
   void CutCheckHelper::reconfigure(fhicl::ParameterSet const &p) {
 
@@ -20,13 +20,10 @@
 #include "larsim/Simulation/LArVoxelData.h"
 #include "larsim/Simulation/LArVoxelList.h"
 #include "larsim/Simulation/SimListUtils.h"
-#include "larsim/MCCheater/BackTrackerService.h"
-#include "larsim/MCCheater/ParticleInventoryService.h"
 #include "nusimdata/SimulationBase/MCParticle.h"
 #include "nusimdata/SimulationBase/MCTruth.h"
 #include "lardata/DetectorInfoServices/DetectorPropertiesService.h"
 
-#include "TVector3.h"
 #include "TH1.h"
 #include "TH2.h"
 
@@ -35,6 +32,10 @@
 #include "StoppingMuonSelection/CalorimetryHelper.h"
 #include "StoppingMuonSelection/StoppingMuonSelectionAlg.h"
 #include "StoppingMuonSelection/SpacePointAlg.h"
+#include "StoppingMuonSelection/TruthMatchTable.h"
+#include "StoppingMuonSelection/TrackIDIndex.h"
+#include "StoppingMuonSelection/EventContext.h"
+#include "StoppingMuonSelection/Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -47,8 +48,7 @@ namespace stoppingcosmicmuonselection {
     // Apply cuts ignoring the specified one.
     void ApplyCutsCathode(TH1 *histo, TH1 *histo_signal,
                           const std::string &excludeCut,
-                          art::Event const &evt, const std::vector<recob::PFParticle> &particles,
-                          const std::vector<recob::SpacePoint> &spacePoints);
+                          art::Event const &evt, const std::vector<recob::PFParticle> &particles);
 
     // Apply cuts ignoring the specified one.
     void ApplyCutsCathodeSimple(TH1 *histo, TH1 *histo_signal,
@@ -58,8 +58,7 @@ namespace stoppingcosmicmuonselection {
     // Apply cuts ignoring the specified one.
     void ApplyCutsAnode(TH1 *histo, TH1 *histo_signal,
                         const std::string &excludeCut,
-                        art::Event const &evt, const std::vector<recob::PFParticle> &particles,
-                        const std::vector<recob::SpacePoint> &spacePoints);
+                        art::Event const &evt, const std::vector<recob::PFParticle> &particles);
 
     // Fill distribution for every track and for true cathode crossing tracks.
     void FillTruthDistributionCathode(art::Event const &evt, const std::vector<recob::PFParticle> &particles,
@@ -81,6 +80,18 @@ namespace stoppingcosmicmuonselection {
                                     TH1D *h_minHitPeakTimePriori, TH1D *h_minHitPeakTime_signalPriori,
                                     TH1D *h_maxHitPeakTimePriori, TH1D *h_maxHitPeakTime_signalPriori);
 
+    // Use a per-event truth matching table in the selector.
+    void SetTruthMatchTable(const TruthMatchTable *truthTable);
+
+    // Use a per-event track index in the selector.
+    void SetTrackIDIndex(const TrackIDIndex *trackIDIndex);
+
+    // Use a per-event context in the selector.
+    void SetEventContext(const EventContext *eventContext);
+
+    // Fill the space point grid for this event.
+    void SetSpacePoints(const std::vector<recob::SpacePoint> &spacePoints);
+
     // Configure the selector.
     void reconfigure(fhicl::ParameterSet const &p);
 
@@ -11,9 +11,8 @@ namespace stoppingcosmicmuonselection {
   void CutCheck::analyze(art::Event const &evt)
   {
     evNumber = evt.id().event();
-    std::cout << "CutCheck_module is on event: " << evNumber << std::endl;
-    mf::LogVerbatim("CutCheck") << "CutCheck module on event " << evNumber;
-    std::cout << "Is this data? " << evt.isRealData() << std::endl;
+    STOPPING_MUON_LOG_INFO(kLogModules) << "CutCheck module on event " << evNumber;
+    STOPPING_MUON_LOG_DEBUG(kLogModules) << "Is this data? " << evt.isRealData();
     // Get handles
     // trackHandle is art::ValidHandle<std::vector<recob::Track>>
     art::Handle<std::vector<recob::PFParticle>> pfparticleHandle; // to use with getByLabel to check it's valid
@@ -22,24 +21,45 @@ namespace stoppingcosmicmuonselection {
     if (!pfparticleHandle.isValid()) return;
     auto const &recoParticles = *pfparticleHandle;
     auto const spacePointHandle = evt.getValidHandle<std::vector<recob::SpacePoint>>(fSpacePointTag);
-    const std::vector<recob::SpacePoint> spacePoints = *spacePointHandle;
+    cutCheckHelper.SetSpacePoints(*spacePointHandle);
+
+    // Free the temporaries of the previous event.
+    EventArena::NewEvent();
+    // Reject MC events in a data-only job, before any truth access.
+    TruthProvider::Get().CheckEvent(evt);
+    // Clock and detector properties of this event, for all the helpers.
+    const EventContext context(evt);
+    cutCheckHelper.SetEventContext(&context);
+    // Clear the pointers to the tables and context when the event ends, also on exceptions.
+    const EventTablesGuard<CutCheckHelper> tablesGuard(cutCheckHelper);
+
+    // Match all the PFParticles to the truth once, the cuts below loop
+    // over the particles many times.
+    if (!evt.isRealData()) {
+      hitCache.Set(evt, fHitTag);
+      truthCache.Set(evt, fSimChannelTag, hitCache, context);
+      truthTable.Set(evt, fPFParticleTag, hitCache, truthCache);
+    }
+    cutCheckHelper.SetTruthMatchTable(&truthTable);
+    // Track index shared by all the cut loops.
+    trackIDIndex.Set(evt, fTrackerTag);
+    cutCheckHelper.SetTrackIDIndex(&trackIDIndex);
 
     if (_selectCC) {
-      std::cout << "Analysing cathode-crossers... ";
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "Analysing cathode-crossers... "
+                                           << (_runCathodeSimple ? "the simplified way." : "the traditional way.");
       if (!_runCathodeSimple) {
-        std::cout << "the traditional way." << std::endl;
-        cutCheckHelper.ApplyCutsCathode(h_startX, h_startX_signal, "thicknessStartVolume", evt, recoParticles, spacePoints);
-    	  cutCheckHelper.ApplyCutsCathode(h_startY, h_startY_signal, "thicknessStartVolume", evt, recoParticles, spacePoints);
-    	  cutCheckHelper.ApplyCutsCathode(h_startZ, h_startZ_signal, "thicknessStartVolume", evt, recoParticles, spacePoints);
-        cutCheckHelper.ApplyCutsCathode(h_minHitPeakTime, h_minHitPeakTime_signal, "cutMinHitPeakTime", evt, recoParticles, spacePoints);
-        cutCheckHelper.ApplyCutsCathode(h_maxHitPeakTime, h_maxHitPeakTime_signal, "cutMaxHitPeakTime", evt, recoParticles, spacePoints);
-    	  cutCheckHelper.ApplyCutsCathode(h_endX, h_endX_signal, "distanceFiducialVolumeX", evt, recoParticles, spacePoints);
-    	  cutCheckHelper.ApplyCutsCathode(h_endY, h_endY_signal, "distanceFiducialVolumeY", evt, recoParticles, spacePoints);
-    	  cutCheckHelper.ApplyCutsCathode(h_endZ, h_endZ_signal, "distanceFiducialVolumeZ", evt, recoParticles, spacePoints);
-        cutCheckHelper.ApplyCutsCathode(h_dQdxVsRR, h_dQdxVsRR_TP, "complete", evt, recoParticles, spacePoints);
+        cutCheckHelper.ApplyCutsCathode(h_startX, h_startX_signal, "thicknessStartVolume", evt, recoParticles);
+    	  cutCheckHelper.ApplyCutsCathode(h_startY, h_startY_signal, "thicknessStartVolume", evt, recoParticles);
+    	  cutCheckHelper.ApplyCutsCathode(h_startZ, h_startZ_signal, "thicknessStartVolume", evt, recoParticles);
+        cutCheckHelper.ApplyCutsCathode(h_minHitPeakTime, h_minHitPeakTime_signal, "cutMinHitPeakTime", evt, recoParticles);
+        cutCheckHelper.ApplyCutsCathode(h_maxHitPeakTime, h_maxHitPeakTime_signal, "cutMaxHitPeakTime", evt, recoParticles);
+    	  cutCheckHelper.ApplyCutsCathode(h_endX, h_endX_signal, "distanceFiducialVolumeX", evt, recoParticles);
+    	  cutCheckHelper.ApplyCutsCathode(h_endY, h_endY_signal, "distanceFiducialVolumeY", evt, recoParticles);
+    	  cutCheckHelper.ApplyCutsCathode(h_endZ, h_endZ_signal, "distanceFiducialVolumeZ", evt, recoParticles);
+        cutCheckHelper.ApplyCutsCathode(h_dQdxVsRR, h_dQdxVsRR_TP, "complete", evt, recoParticles);
       }
       else {
-        std::cout << "the simplified way." << std::endl;
         cutCheckHelper.ApplyCutsCathodeSimple(h_startX, h_startX_signal, "thicknessStartVolume", evt, recoParticles);
     	  cutCheckHelper.ApplyCutsCathodeSimple(h_startY, h_startY_signal, "thicknessStartVolume", evt, recoParticles);
     	  cutCheckHelper.ApplyCutsCathodeSimple(h_startZ, h_startZ_signal, "thicknessStartVolume", evt, recoParticles);
@@ -63,20 +83,20 @@ namespace stoppingcosmicmuonselection {
 
     }
     else if (_selectAC) {
-      std::cout << "Analysing anode-crossers..." << std::endl;
-      cutCheckHelper.ApplyCutsAnode(h_startY, h_startY_signal, "offsetYStartPoint", evt, recoParticles, spacePoints);
-    	cutCheckHelper.ApplyCutsAnode(h_startZ, h_startZ_signal, "offsetZStartPoint", evt, recoParticles, spacePoints);
-      cutCheckHelper.ApplyCutsAnode(h_minHitPeakTime, h_minHitPeakTime_signal, "cutMinHitPeakTime", evt, recoParticles, spacePoints);
-      cutCheckHelper.ApplyCutsAnode(h_maxHitPeakTime, h_maxHitPeakTime_signal, "cutMaxHitPeakTime", evt, recoParticles, spacePoints);
-    	cutCheckHelper.ApplyCutsAnode(h_endX, h_endX_signal, "distanceFiducialVolumeX", evt, recoParticles, spacePoints);
-    	cutCheckHelper.ApplyCutsAnode(h_endY, h_endY_signal, "distanceFiducialVolumeY", evt, recoParticles, spacePoints);
-    	cutCheckHelper.ApplyCutsAnode(h_endZ, h_endZ_signal, "distanceFiducialVolumeZ", evt, recoParticles, spacePoints);
-      cutCheckHelper.ApplyCutsAnode(h_dQdxVsRR, h_dQdxVsRR_TP, "complete", evt, recoParticles, spacePoints);
-      cutCheckHelper.ApplyCutsAnode(h_endX_Fabio, h_endX_signal_Fabio, "distanceFiducialVolumeXFabio", evt, recoParticles, spacePoints);
-      cutCheckHelper.ApplyCutsAnode(h_endX_Pandora, h_endX_signal_Pandora, "distanceFiducialVolumeXPandora", evt, recoParticles, spacePoints);
-      cutCheckHelper.ApplyCutsAnode(h_theta_xz, h_theta_xz_signal, "endX_anglexz", evt, recoParticles, spacePoints);
-      cutCheckHelper.ApplyCutsAnode(h_theta_yz, h_theta_yz_signal, "endX_angleyz", evt, recoParticles, spacePoints);
-      cutCheckHelper.ApplyCutsAnode(h_length, h_length_signal, "endX_length", evt, recoParticles, spacePoints);
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "Analysing anode-crossers...";
+      cutCheckHelper.ApplyCutsAnode(h_startY, h_startY_signal, "offsetYStartPoint", evt, recoParticles);
+    	cutCheckHelper.ApplyCutsAnode(h_startZ, h_startZ_signal, "offsetZStartPoint", evt, recoParticles);
+      cutCheckHelper.ApplyCutsAnode(h_minHitPeakTime, h_minHitPeakTime_signal, "cutMinHitPeakTime", evt, recoParticles);
+      cutCheckHelper.ApplyCutsAnode(h_maxHitPeakTime, h_maxHitPeakTime_signal, "cutMaxHitPeakTime", evt, recoParticles);
+    	cutCheckHelper.ApplyCutsAnode(h_endX, h_endX_signal, "distanceFiducialVolumeX", evt, recoParticles);
+    	cutCheckHelper.ApplyCutsAnode(h_endY, h_endY_signal, "distanceFiducialVolumeY", evt, recoParticles);
+    	cutCheckHelper.ApplyCutsAnode(h_endZ, h_endZ_signal, "distanceFiducialVolumeZ", evt, recoParticles);
+      cutCheckHelper.ApplyCutsAnode(h_dQdxVsRR, h_dQdxVsRR_TP, "complete", evt, recoParticles);
+      cutCheckHelper.ApplyCutsAnode(h_endX_Fabio, h_endX_signal_Fabio, "distanceFiducialVolumeXFabio", evt, recoParticles);
+      cutCheckHelper.ApplyCutsAnode(h_endX_Pandora, h_endX_signal_Pandora, "distanceFiducialVolumeXPandora", evt, recoParticles);
+      cutCheckHelper.ApplyCutsAnode(h_theta_xz, h_theta_xz_signal, "endX_anglexz", evt, recoParticles);
+      cutCheckHelper.ApplyCutsAnode(h_theta_yz, h_theta_yz_signal, "endX_angleyz", evt, recoParticles);
+      cutCheckHelper.ApplyCutsAnode(h_length, h_length_signal, "endX_length", evt, recoParticles);
 
       cutCheckHelper.FillTruthDistributionAnode(evt, recoParticles,
                                                   h_startYPriori, h_startY_signalPriori,
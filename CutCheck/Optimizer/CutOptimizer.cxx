@@ -0,0 +1,406 @@
+/***
+  Class containing a grid scan of the selection thresholds.
+  Every record is binned once in each scanned threshold, then the grid is
+  integrated with prefix sums: each grid point costs one lookup.
+
+*/
+#ifndef CUT_OPTIMIZER_CXX
+#define CUT_OPTIMIZER_CXX
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "cetlib_except/exception.h"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_reduce.h"
+#include "tbb/task_arena.h"
+
+#include "CutOptimizer.h"
+
+namespace stoppingcosmicmuonselection {
+
+  namespace {
+
+    const double INF = std::numeric_limits<double>::infinity();
+
+    // Margins of a track to the scanned cuts. They follow the predicates of SelectionCuts.
+    double track_length(const trackFeatures &f, const selectionConstants &, const double &) {
+      return f.trackLength;
+    }
+
+    double min_hit_peak_time(const trackFeatures &f, const selectionConstants &, const double &) {
+      return f.minHitPeakTime;
+    }
+
+    double max_hit_peak_time(const trackFeatures &f, const selectionConstants &, const double &) {
+      return f.maxHitPeakTime;
+    }
+
+    // Distance of a point to the faces of the active volume, negative outside.
+    double fiducial_margin(const double *av, const double &x, const double &y, const double &z) {
+      return std::min({x-av[0], av[1]-x, y-av[2], av[3]-y, z-av[4], av[5]-z});
+    }
+
+    double end_fiducial_margin(const trackFeatures &f, const selectionConstants &c, const double &) {
+      return fiducial_margin(c.activeBounds, f.endX, f.endY, f.endZ);
+    }
+
+    double shifted_end_fiducial_margin(const trackFeatures &f, const selectionConstants &c, const double &shiftX) {
+      return fiducial_margin(c.activeBounds, f.endX+shiftX, f.endY, f.endZ);
+    }
+
+    // Thinnest slice of the active volume containing the start point, INF if none.
+    double start_slice_thickness(const trackFeatures &f, const selectionConstants &c, const double &) {
+      const double *av = c.activeBounds;
+      double thickness = INF;
+      if (f.startY <= av[3]) thickness = std::min(thickness, av[3]-f.startY);
+      if (f.startX >= av[0]) thickness = std::min(thickness, f.startX-av[0]);
+      if (f.startX <= av[1]) thickness = std::min(thickness, av[1]-f.startX);
+      if (f.startZ >= av[4]) thickness = std::min(thickness, f.startZ-av[4]);
+      if (f.startZ <= av[5]) thickness = std::min(thickness, av[5]-f.startZ);
+      return thickness;
+    }
+
+    double start_y_margin(const trackFeatures &f, const selectionConstants &c, const double &) {
+      return std::min(f.startY-c.activeBounds[2], c.activeBounds[3]-f.startY);
+    }
+
+    double start_z_margin(const trackFeatures &f, const selectionConstants &c, const double &) {
+      return std::min(f.startZ-c.activeBounds[4], c.activeBounds[5]-f.startZ);
+    }
+
+    // Distance in Z to the closest APA boundary.
+    double apa_distance(const double *av, const double &z) {
+      return std::min(std::abs(z-av[5]/3.), std::abs(z-av[5]*2/3.));
+    }
+
+    double end_apa_distance(const trackFeatures &f, const selectionConstants &c, const double &) {
+      return apa_distance(c.activeBounds, f.endZ);
+    }
+
+    double start_end_apa_distance(const trackFeatures &f, const selectionConstants &c, const double &) {
+      return std::min(apa_distance(c.activeBounds, f.startZ), apa_distance(c.activeBounds, f.endZ));
+    }
+
+    // Closest neighbour that is aligned enough to be a broken track, INF if none.
+    double neighbour_distance(const trackFeatures &f, const bool &onlyHigher) {
+      double distance = INF;
+      for (const brokenTrackNeighbour &neighbour : f.neighbours) {
+        if (onlyHigher && !neighbour.isHigher) continue;
+        if (neighbour.absCosAlpha > MIN_COS_ALPHA_CLOSE_TRACKS)
+          distance = std::min(distance, neighbour.distHigherLower);
+      }
+      return distance;
+    }
+
+    double higher_neighbour_distance(const trackFeatures &f, const selectionConstants &, const double &) {
+      return neighbour_distance(f, true);
+    }
+
+    double any_neighbour_distance(const trackFeatures &f, const selectionConstants &, const double &) {
+      return neighbour_distance(f, false);
+    }
+
+    // Cuts that can be scanned.
+    struct scannableCut {
+      const char *name;
+      bool isCC;
+      double selectionCuts::*cut;
+      cutPassType passType;
+      cutMargin margin;
+    };
+
+    const std::vector<scannableCut> SCANNABLE_CUTS = {
+      {"length_cutoff_CC",            true,  &selectionCuts::length_cutoff_CC,            kPassIfValueAboveOrEqual, track_length},
+      {"offsetFiducialBounds_CC",     true,  &selectionCuts::offsetFiducialBounds_CC,     kPassIfValueAboveOrEqual, end_fiducial_margin},
+      {"thicknessStartVolume_CC",     true,  &selectionCuts::thicknessStartVolume_CC,     kPassIfValueBelowOrEqual, start_slice_thickness},
+      {"cutMinHitPeakTime_CC",        true,  &selectionCuts::cutMinHitPeakTime_CC,        kPassIfValueAbove,        min_hit_peak_time},
+      {"cutMaxHitPeakTime_CC",        true,  &selectionCuts::cutMaxHitPeakTime_CC,        kPassIfValueBelow,        max_hit_peak_time},
+      {"cutContourAPA_CC",            true,  &selectionCuts::cutContourAPA_CC,            kPassIfValueAbove,        end_apa_distance},
+      {"radiusBrokenTracksSearch_CC", true,  &selectionCuts::radiusBrokenTracksSearch_CC, kPassIfValueAboveOrEqual, higher_neighbour_distance},
+      {"length_cutoff_AC",            false, &selectionCuts::length_cutoff_AC,            kPassIfValueAboveOrEqual, track_length},
+      {"offsetYStartPoint_AC",        false, &selectionCuts::offsetYStartPoint_AC,        kPassIfValueAboveOrEqual, start_y_margin},
+      {"offsetZStartPoint_AC",        false, &selectionCuts::offsetZStartPoint_AC,        kPassIfValueAboveOrEqual, start_z_margin},
+      {"cutMinHitPeakTime_AC",        false, &selectionCuts::cutMinHitPeakTime_AC,        kPassIfValueAbove,        min_hit_peak_time},
+      {"cutMaxHitPeakTime_AC",        false, &selectionCuts::cutMaxHitPeakTime_AC,        kPassIfValueBelow,        max_hit_peak_time},
+      {"cutContourAPA_AC",            false, &selectionCuts::cutContourAPA_AC,            kPassIfValueAbove,        start_end_apa_distance},
+      {"radiusBrokenTracksSearch_AC", false, &selectionCuts::radiusBrokenTracksSearch_AC, kPassIfValueAboveOrEqual, any_neighbour_distance},
+      {"offsetFiducialBounds_AC",     false, &selectionCuts::offsetFiducialBounds_AC,     kPassIfValueAboveOrEqual, shifted_end_fiducial_margin}
+    };
+
+    // Check if a margin passes a threshold.
+    bool passes(const cutPassType &passType, const double &margin, const double &threshold) {
+      switch (passType) {
+        case kPassIfValueAboveOrEqual: return margin >= threshold;
+        case kPassIfValueAbove:        return margin > threshold;
+        case kPassIfValueBelow:        return margin < threshold;
+        case kPassIfValueBelowOrEqual: return margin <= threshold;
+      }
+      return false;
+    }
+
+    // Threshold that never rejects a track.
+    double open_threshold(const cutPassType &passType) {
+      return (passType == kPassIfValueAboveOrEqual || passType == kPassIfValueAbove) ? -INF : INF;
+    }
+
+  }
+
+  CutOptimizer::CutOptimizer() {
+
+  }
+
+  CutOptimizer::~CutOptimizer() {
+
+  }
+
+  // Check whether a record is used.
+  bool CutOptimizer::IsUsed(const trackFeatures &f) const {
+    if (f.isRealData) return false;
+    return (!_requireTrueCosmic || f.isTrueCosmic);
+  }
+
+  // Check whether a record is signal.
+  bool CutOptimizer::IsSignal(const trackFeatures &f) const {
+    return _selectCC ? f.isTrueCathodeCrosser : f.isTrueAnodeCrosser;
+  }
+
+  // Apply the cuts of the selected crosser type. Return the first failed cut.
+  size_t CutOptimizer::ApplyCuts(const trackFeatures &f, const selectionCuts &cuts,
+                                 const selectionConstants &constants, double &shiftX) const {
+    shiftX = 0.;
+    if (_selectCC) return apply_cathode_crosser_cuts(f,cuts,constants);
+    double t0 = INV_DBL;
+    return apply_anode_crosser_cuts(f,cuts,constants,t0,shiftX);
+  }
+
+  // Get the flat index of the tightest grid point where the record passes.
+  size_t CutOptimizer::GetCell(const trackFeatures &f, const selectionConstants &constants) const {
+    // The cuts that are not scanned are applied once.
+    double shiftX = 0.;
+    if (ApplyCuts(f,_openCuts,constants,shiftX) != kPassedAllCuts) return _nGridPoints;
+
+    size_t cell = 0;
+    for (size_t d = 0; d < _dimensions.size(); d++) {
+      const scanDimension &dim = _dimensions[d];
+      const double margin = dim.margin(f,constants,shiftX);
+      // The values go from the tightest to the loosest: the failed ones come first.
+      const auto firstPassed = std::partition_point(dim.values.begin(), dim.values.end(),
+                                                    [&](const double &value) { return !passes(dim.passType,margin,value); });
+      const size_t index = firstPassed - dim.values.begin();
+      if (index == dim.values.size()) return _nGridPoints;
+      cell += index*_strides[d];
+    }
+    return cell;
+  }
+
+  // Integrate the counts along every dimension.
+  void CutOptimizer::IntegrateGrid() {
+    for (size_t d = 0; d < _dimensions.size(); d++) {
+      const size_t n = _dimensions[d].values.size();
+      const size_t stride = _strides[d];
+      tbb::parallel_for(size_t(0), _nGridPoints/n, [&](const size_t &line) {
+        const size_t first = (line/stride)*stride*n + line%stride;
+        for (size_t j = 1; j < n; j++) {
+          const size_t cell = first + j*stride;
+          _nSelected[cell] += _nSelected[cell-stride];
+          _nSignalSelected[cell] += _nSignalSelected[cell-stride];
+        }
+      });
+    }
+  }
+
+  // Fill the grid with the records.
+  void CutOptimizer::Fill(const std::vector<trackFeatures> &records, const selectionConstants &constants) {
+    _nTracks = 0;
+    _nSignal = 0;
+    std::fill(_nSelected.begin(), _nSelected.end(), 0);
+    std::fill(_nSignalSelected.begin(), _nSignalSelected.end(), 0);
+
+    tbb::task_arena arena(_numberThreads);
+    arena.execute([&]() {
+      std::vector<size_t> cells(records.size(), _nGridPoints);
+      tbb::parallel_for(size_t(0), records.size(), [&](const size_t &i) {
+        if (IsUsed(records[i])) cells[i] = GetCell(records[i],constants);
+      });
+
+      for (size_t i = 0; i < records.size(); i++) {
+        if (!IsUsed(records[i])) continue;
+        const bool isSignal = IsSignal(records[i]);
+        _nTracks++;
+        if (isSignal) _nSignal++;
+        if (cells[i] == _nGridPoints) continue;
+        _nSelected[cells[i]]++;
+        if (isSignal) _nSignalSelected[cells[i]]++;
+      }
+
+      IntegrateGrid();
+    });
+  }
+
+  // Get the counts of a grid point.
+  gridPoint CutOptimizer::GetGridPoint(const size_t &index) const {
+    gridPoint point;
+    point.index = index;
+    point.nSelected = _nSelected[index];
+    point.nSignalSelected = _nSignalSelected[index];
+    point.efficiency = _nSignal > 0 ? point.nSignalSelected/double(_nSignal) : 0.;
+    point.purity = point.nSelected > 0 ? point.nSignalSelected/double(point.nSelected) : 0.;
+    return point;
+  }
+
+  // Get the cuts of a grid point.
+  selectionCuts CutOptimizer::GetCuts(const size_t &index) const {
+    selectionCuts cuts = _baseCuts;
+    for (size_t d = 0; d < _dimensions.size(); d++) {
+      const scanDimension &dim = _dimensions[d];
+      cuts.*(dim.cut) = dim.values[(index/_strides[d])%dim.values.size()];
+    }
+    return cuts;
+  }
+
+  // Get the points that no other point beats in both efficiency and purity.
+  std::vector<gridPoint> CutOptimizer::GetParetoFront() const {
+    // For each number of selected signal tracks keep the point selecting the fewest tracks.
+    typedef std::vector<size_t> bestPointVec;
+    auto keepBest = [this](bestPointVec &best, const size_t &index) {
+      const size_t nSignalSelected = _nSignalSelected[index];
+      size_t &current = best[nSignalSelected];
+      if (current == _nGridPoints
+          || _nSelected[index] < _nSelected[current]
+          || (_nSelected[index] == _nSelected[current] && index < current))
+        current = index;
+    };
+
+    tbb::task_arena arena(_numberThreads);
+    const bestPointVec best = arena.execute([&]() {
+      return tbb::parallel_reduce(
+        tbb::blocked_range<size_t>(0, _nGridPoints), bestPointVec(_nSignal+1, _nGridPoints),
+        [&](const tbb::blocked_range<size_t> &range, bestPointVec partial) {
+          for (size_t i = range.begin(); i != range.end(); i++)
+            if (_nSignalSelected[i] > 0) keepBest(partial, i);
+          return partial;
+        },
+        [&](bestPointVec a, const bestPointVec &b) {
+          for (const size_t &index : b)
+            if (index != _nGridPoints) keepBest(a, index);
+          return a;
+        });
+    });
+
+    // Walk down in efficiency and keep the points improving the purity.
+    std::vector<gridPoint> front;
+    double bestPurity = -1.;
+    for (size_t nSignalSelected = _nSignal; nSignalSelected > 0; nSignalSelected--) {
+      if (best[nSignalSelected] == _nGridPoints) continue;
+      const gridPoint point = GetGridPoint(best[nSignalSelected]);
+      if (point.purity <= bestPurity) continue;
+      bestPurity = point.purity;
+      front.push_back(point);
+    }
+    return front;
+  }
+
+  // Count the tracks passing a set of cuts with the selection predicates.
+  gridPoint CutOptimizer::CountCuts(const selectionCuts &cuts,
+                                    const std::vector<trackFeatures> &records,
+                                    const selectionConstants &constants) const {
+    typedef std::pair<size_t,size_t> countPair;  // selected, signal selected
+    tbb::task_arena arena(_numberThreads);
+    const countPair counts = arena.execute([&]() {
+      return tbb::parallel_reduce(
+        tbb::blocked_range<size_t>(0, records.size()), countPair(0,0),
+        [&](const tbb::blocked_range<size_t> &range, countPair partial) {
+          double shiftX = 0.;
+          for (size_t i = range.begin(); i != range.end(); i++) {
+            if (!IsUsed(records[i])) continue;
+            if (ApplyCuts(records[i],cuts,constants,shiftX) != kPassedAllCuts) continue;
+            partial.first++;
+            if (IsSignal(records[i])) partial.second++;
+          }
+          return partial;
+        },
+        [](const countPair &a, const countPair &b) { return countPair(a.first+b.first, a.second+b.second); });
+    });
+
+    gridPoint point;
+    point.index = _nGridPoints;
+    point.nSelected = counts.first;
+    point.nSignalSelected = counts.second;
+    point.efficiency = _nSignal > 0 ? point.nSignalSelected/double(_nSignal) : 0.;
+    point.purity = point.nSelected > 0 ? point.nSignalSelected/double(point.nSelected) : 0.;
+    return point;
+  }
+
+  // Configure the scan.
+  void CutOptimizer::reconfigure(fhicl::ParameterSet const &p) {
+    _selectCC = p.get<bool>("selectCC", true);
+    _requireTrueCosmic = p.get<bool>("requireTrueCosmic", true);
+    _numberThreads = p.get<int>("numberThreads", 1);
+    _maxGridPoints = p.get<size_t>("maxGridPoints", 50000000);
+    _baseCuts = get_selection_cuts(p.get<fhicl::ParameterSet>("baseCuts"));
+    _openCuts = _baseCuts;
+
+    _dimensions.clear();
+    for (const fhicl::ParameterSet &scan : p.get<std::vector<fhicl::ParameterSet>>("scan")) {
+      const std::string cutName = scan.get<std::string>("cut");
+      auto scannable = std::find_if(SCANNABLE_CUTS.begin(), SCANNABLE_CUTS.end(),
+                                    [&](const scannableCut &c) { return cutName == c.name; });
+      if (scannable == SCANNABLE_CUTS.end())
+        throw cet::exception("CutOptimizer.cxx") << "Cut " << cutName << " cannot be scanned.";
+      if (scannable->isCC != _selectCC)
+        throw cet::exception("CutOptimizer.cxx") << "Cut " << cutName << " does not belong to the "
+                                                 << (_selectCC ? "cathode" : "anode") << " crosser selection.";
+      for (const scanDimension &dim : _dimensions)
+        if (dim.cutName == cutName)
+          throw cet::exception("CutOptimizer.cxx") << "Cut " << cutName << " is scanned twice.";
+
+      scanDimension dim;
+      dim.cutName = cutName;
+      dim.cut = scannable->cut;
+      dim.passType = scannable->passType;
+      dim.margin = scannable->margin;
+      if (scan.has_key("values")) {
+        dim.values = scan.get<std::vector<double>>("values");
+      }
+      else {
+        const double min = scan.get<double>("min");
+        const double max = scan.get<double>("max");
+        const size_t numbValues = scan.get<size_t>("numbValues");
+        for (size_t i = 0; i < numbValues; i++)
+          dim.values.push_back(numbValues > 1 ? min + i*(max-min)/(numbValues-1) : min);
+      }
+      if (dim.values.empty())
+        throw cet::exception("CutOptimizer.cxx") << "No values to scan for cut " << cutName << ".";
+
+      // Order the values from the tightest to the loosest.
+      std::sort(dim.values.begin(), dim.values.end());
+      dim.values.erase(std::unique(dim.values.begin(), dim.values.end()), dim.values.end());
+      if (dim.passType == kPassIfValueAboveOrEqual || dim.passType == kPassIfValueAbove)
+        std::reverse(dim.values.begin(), dim.values.end());
+
+      _openCuts.*(dim.cut) = open_threshold(dim.passType);
+      _dimensions.push_back(dim);
+    }
+    if (_dimensions.empty())
+      throw cet::exception("CutOptimizer.cxx") << "No cut to scan.";
+
+    // The last dimension runs fastest.
+    _strides.assign(_dimensions.size(), 1);
+    _nGridPoints = 1;
+    for (size_t d = _dimensions.size(); d-- > 0;) {
+      _strides[d] = _nGridPoints;
+      _nGridPoints *= _dimensions[d].values.size();
+      if (_nGridPoints > _maxGridPoints)
+        throw cet::exception("CutOptimizer.cxx") << "The grid has more than maxGridPoints ("
+                                                 << _maxGridPoints << ") points.";
+    }
+    _nSelected.assign(_nGridPoints, 0);
+    _nSignalSelected.assign(_nGridPoints, 0);
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
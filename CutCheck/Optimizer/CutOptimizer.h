@@ -0,0 +1,125 @@
+/***
+  Class containing a grid scan of the selection thresholds.
+  Every record is binned once in each scanned threshold, then the grid is
+  integrated with prefix sums: each grid point costs one lookup.
+
+*/
+#ifndef CUT_OPTIMIZER_H
+#define CUT_OPTIMIZER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "fhiclcpp/ParameterSet.h"
+
+#include "StoppingMuonSelection/SelectionCuts.h"
+#include "StoppingMuonSelection/TrackFeatures.h"
+
+namespace stoppingcosmicmuonselection {
+
+  // How a track passes a threshold, in terms of its margin to the cut.
+  enum cutPassType {
+    kPassIfValueAboveOrEqual = 0,
+    kPassIfValueAbove,
+    kPassIfValueBelow,
+    kPassIfValueBelowOrEqual
+  };
+
+  // Margin of a track to a cut: the quantity compared with the threshold.
+  typedef double (*cutMargin)(const trackFeatures &f, const selectionConstants &constants, const double &shiftX);
+
+  // One scanned threshold of the selection.
+  struct scanDimension {
+    std::string cutName;
+    double selectionCuts::*cut;
+    cutPassType passType;
+    cutMargin margin;
+    std::vector<double> values;  // ordered from the tightest to the loosest
+  };
+
+  // Counts for one point of the grid.
+  struct gridPoint {
+    size_t index;  // flat index in the grid
+    size_t nSelected;
+    size_t nSignalSelected;
+    double efficiency;
+    double purity;
+  };
+
+  class CutOptimizer {
+
+  public:
+    CutOptimizer();
+    ~CutOptimizer();
+
+    // Fill the grid with the records. Real data records are skipped.
+    void Fill(const std::vector<trackFeatures> &records, const selectionConstants &constants);
+
+    // Number of points of the grid.
+    size_t GetNumbGridPoints() const { return _nGridPoints; }
+
+    // Number of signal tracks before any cut.
+    size_t GetNumbSignal() const { return _nSignal; }
+
+    // Number of tracks before any cut.
+    size_t GetNumbTracks() const { return _nTracks; }
+
+    // Get the scanned thresholds.
+    const std::vector<scanDimension> &GetScanDimensions() const { return _dimensions; }
+
+    // Get the counts of a grid point.
+    gridPoint GetGridPoint(const size_t &index) const;
+
+    // Get the cuts of a grid point.
+    selectionCuts GetCuts(const size_t &index) const;
+
+    // Get the points that no other point beats in both efficiency and purity,
+    // in decreasing order of efficiency.
+    std::vector<gridPoint> GetParetoFront() const;
+
+    // Count the tracks passing a set of cuts with the selection predicates, without the grid.
+    gridPoint CountCuts(const selectionCuts &cuts,
+                        const std::vector<trackFeatures> &records,
+                        const selectionConstants &constants) const;
+
+    // Get the base cuts.
+    const selectionCuts &GetBaseCuts() const { return _baseCuts; }
+
+    // Configure the scan.
+    void reconfigure(fhicl::ParameterSet const &p);
+
+  private:
+    // Check whether a record is used and whether it is signal.
+    bool IsUsed(const trackFeatures &f) const;
+    bool IsSignal(const trackFeatures &f) const;
+
+    // Apply the cuts of the selected crosser type. Return the first failed cut.
+    size_t ApplyCuts(const trackFeatures &f, const selectionCuts &cuts,
+                     const selectionConstants &constants, double &shiftX) const;
+
+    // Get the flat index of the tightest grid point where the record passes.
+    // The number of grid points if it does not pass anywhere.
+    size_t GetCell(const trackFeatures &f, const selectionConstants &constants) const;
+
+    // Integrate the counts along every dimension.
+    void IntegrateGrid();
+
+    bool _selectCC;
+    bool _requireTrueCosmic;
+    size_t _maxGridPoints;
+    int _numberThreads;
+    selectionCuts _baseCuts;
+    selectionCuts _openCuts;  // base cuts with the scanned thresholds open
+    std::vector<scanDimension> _dimensions;
+    std::vector<size_t> _strides;
+    size_t _nGridPoints = 0;
+
+    size_t _nTracks = 0;
+    size_t _nSignal = 0;
+    std::vector<uint32_t> _nSelected;
+    std::vector<uint32_t> _nSignalSelected;
+
+  };
+}
+
+#endif
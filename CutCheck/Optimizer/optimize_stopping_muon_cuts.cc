@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////
+// Program:     optimize_stopping_muon_cuts
+// File:        optimize_stopping_muon_cuts.cc
+//
+// Scan a grid of selection thresholds over the feature records written
+// by SelectionStudyProd4 (dumpFeatures: true) and print the
+// efficiency/purity Pareto front.
+////////////////////////////////////////////////////////////////////////
+#include "cetlib/filepath_maker.h"
+#include "cetlib_except/exception.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/make_ParameterSet.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "StoppingMuonSelection/CutCheck/Optimizer/CutOptimizer.h"
+
+using namespace stoppingcosmicmuonselection;
+
+namespace {
+
+  // Print the counts of a point and its scanned thresholds.
+  void print_point(const gridPoint &point, const selectionCuts &cuts,
+                   const std::vector<scanDimension> &dimensions) {
+    std::cout << "efficiency: " << point.efficiency << " purity: " << point.purity
+              << " (" << point.nSignalSelected << " of " << point.nSelected << ")";
+    for (const scanDimension &dim : dimensions)
+      std::cout << " " << dim.cutName << ": " << cuts.*(dim.cut);
+    std::cout << std::endl;
+  }
+
+  void print_usage() {
+    std::cout << "Usage: optimize_stopping_muon_cuts -c <config.fcl> <features.root> [<features.root> ...]" << std::endl;
+  }
+
+}
+
+int main(int argc, char **argv) {
+
+  // Read the command line.
+  std::string configFile;
+  std::vector<std::string> inputFiles;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      print_usage();
+      return 0;
+    }
+    if (arg == "-c" && i+1 < argc)
+      configFile = argv[++i];
+    else
+      inputFiles.push_back(arg);
+  }
+  if (configFile.empty() || inputFiles.empty()) {
+    print_usage();
+    return 1;
+  }
+
+  try {
+    // Read the configuration.
+    fhicl::ParameterSet pset;
+    cet::filepath_lookup maker("FHICL_FILE_PATH");
+    fhicl::make_ParameterSet(configFile, maker, pset);
+    const fhicl::ParameterSet p = pset.get<fhicl::ParameterSet>("cutOptimizer");
+    const std::string treeDirectory = p.get<std::string>("treeDirectory", "fabioana");
+    const bool checkParetoFront = p.get<bool>("checkParetoFront", true);
+    CutOptimizer optimizer;
+    optimizer.reconfigure(p);
+    std::cout << "Number of grid points: " << optimizer.GetNumbGridPoints() << std::endl;
+
+    // Load all the records in memory: ROOT I/O stays on this thread.
+    selectionConstants constants;
+    std::vector<trackFeatures> records;
+    read_track_features(inputFiles, treeDirectory, constants, records);
+    std::cout << "Read " << records.size() << " records from " << inputFiles.size() << " files." << std::endl;
+
+    // Neighbours below the stored threshold were dropped when writing the records.
+    const selectionCuts &baseCuts = optimizer.GetBaseCuts();
+    const double minCosAlpha = std::min({MIN_COS_ALPHA_CLOSE_TRACKS, baseCuts.cutCosAngleBrokenTracks_CC, baseCuts.cutCosAngleBrokenTracks_AC});
+    if (minCosAlpha < constants.minCosAlphaNeighbours)
+      std::cout << "Warning: cutCosAngleBrokenTracks is below " << constants.minCosAlphaNeighbours
+                << ", the broken track cut is approximate." << std::endl;
+
+    optimizer.Fill(records, constants);
+    std::cout << "Number of tracks: " << optimizer.GetNumbTracks()
+              << " signal: " << optimizer.GetNumbSignal() << std::endl;
+
+    std::cout << "**************************" << std::endl;
+    std::cout << "Base cuts" << std::endl;
+    print_point(optimizer.CountCuts(baseCuts, records, constants), baseCuts, optimizer.GetScanDimensions());
+
+    const std::vector<gridPoint> front = optimizer.GetParetoFront();
+    std::cout << "**************************" << std::endl;
+    std::cout << "Pareto front (" << front.size() << " points)" << std::endl;
+    for (const gridPoint &point : front) {
+      const selectionCuts cuts = optimizer.GetCuts(point.index);
+      print_point(point, cuts, optimizer.GetScanDimensions());
+      if (!checkParetoFront) continue;
+      // The grid uses the margins to the cuts: compare with the selection itself.
+      const gridPoint check = optimizer.CountCuts(cuts, records, constants);
+      if (check.nSelected != point.nSelected || check.nSignalSelected != point.nSignalSelected)
+        std::cout << "  Warning: the selection gives " << check.nSignalSelected << " of " << check.nSelected << std::endl;
+    }
+  }
+  catch (cet::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
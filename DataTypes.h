@@ -4,22 +4,22 @@
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Principal/Handle.h"
 #include "lardataobj/RecoBase/Hit.h"
-#include "TVector3.h"
+#include "Point3.h"
 
-namespace stoppingcosmicmuonselection {
+#include "Constants.h"
 
-  constexpr int INV_INT = -999;
-  constexpr size_t INV_SIZE = 9999999;
-  constexpr double INV_DBL = -9999999;
+namespace stoppingcosmicmuonselection {
 
   typedef std::vector<art::Ptr<recob::Hit>> artPtrHitVec;
+  // Indices of hits in the event hit collection (see HitCache).
+  typedef std::vector<uint32_t> hitIndexVec;
 
   struct trackProperties {
     // Reconstructed information
     size_t evNumber;
     double trackT0;
-    TVector3 recoStartPoint;
-    TVector3 recoEndPoint;
+    Point3 recoStartPoint;
+    Point3 recoEndPoint;
     double theta_xz, theta_yz;
     double minHitPeakTime, maxHitPeakTime;
     double trackLength;
@@ -32,8 +32,8 @@ namespace stoppingcosmicmuonselection {
 
     // Truth information
     int pdg;
-    TVector3 trueStartPoint;
-    TVector3 trueEndPoint;
+    Point3 trueStartPoint;
+    Point3 trueEndPoint;
     double trueStartT, trueEndT;
     double trueTrackID;
 
@@ -60,6 +60,80 @@ namespace stoppingcosmicmuonselection {
     }
   };
 
+  // Results for the hits and the calorimetry of a track on one plane.
+  struct planeRecord {
+    int plane;
+    size_t nHits;
+    hitIndexVec orderedHits;
+    std::vector<double> wireIDs;
+    std::vector<double> Qs;
+    std::vector<double> Dqds;
+    std::vector<double> QsSmooth;
+    std::vector<double> DqdsSmooth;
+    std::vector<double> localLinearity;
+    bool isCaloValid;
+    std::vector<double> dQdx;
+    std::vector<double> resRange;
+    std::vector<double> trackPitch;
+
+    void Reset() {
+      plane = INV_INT;
+      nHits = 0;
+      orderedHits.clear();
+      wireIDs.clear();
+      Qs.clear();
+      Dqds.clear();
+      QsSmooth.clear();
+      DqdsSmooth.clear();
+      localLinearity.clear();
+      isCaloValid = false;
+      dQdx.clear();
+      resRange.clear();
+      trackPitch.clear();
+    }
+  };
+
+  // Calibration columns of the hits of a track, filled in one pass by
+  // CalibrationHelper::FillCalibColumns. The columns point to the TTree
+  // buffers of the module; a null column is not filled.
+  struct calibColumns {
+    std::vector<double> *phis = 0x0;           // angle between pitch and field
+    std::vector<double> *efX = 0x0, *efY = 0x0, *efZ = 0x0;
+    std::vector<double> *efield = 0x0;         // field magnitude
+    std::vector<double> *xCalibFactor = 0x0;
+    std::vector<double> *yzCalibFactor = 0x0;
+    std::vector<double> *dQdxCalib = 0x0;      // dQdx times the X, YZ and first lifetime factors
+    // Lifetime hypotheses, as relative shifts of the lifetime (0 is the nominal one),
+    // and the column of correction factors for each.
+    std::vector<double> lifetimeShifts;
+    std::vector<std::vector<double>*> lifeTimeCorr;
+
+    // Add a lifetime hypothesis.
+    void AddLifetime(const double &shift, std::vector<double> *column) {
+      lifetimeShifts.push_back(shift);
+      lifeTimeCorr.push_back(column);
+    }
+  };
+
+  // Result of the Michel tagging on the ordered hits of a plane.
+  struct michelTagResult {
+    bool hasMichel;        // true if any hit is removed
+    size_t cutIndex;       // ordered hit where the Michel starts (number of hits if none)
+    size_t nHitsNoMichel;  // hits kept before the cut
+    size_t nHitsAboveThr;  // hits above the score threshold
+    double meanScore;      // mean score of the ordered hits
+    double maxScore;       // max score of the ordered hits
+
+    void Reset() {
+      hasMichel = false;
+      cutIndex = INV_SIZE;
+      nHitsNoMichel = 0;
+      nHitsAboveThr = 0;
+      meanScore = INV_DBL;
+      maxScore = INV_DBL;
+    }
+  };
+
 }
 
 #endif
@@ -0,0 +1,82 @@
+/***
+  Class containing the per-event arena for the temporary containers.
+
+*/
+#ifndef EVENT_ARENA_CXX
+#define EVENT_ARENA_CXX
+
+#include <algorithm>
+
+#include "EventArena.h"
+#include "Instrumentation.h"
+#include "Logging.h"
+
+namespace stoppingcosmicmuonselection {
+
+  namespace {
+    // First buffer and largest buffer of an arena.
+    constexpr size_t INITIAL_BUFFER_SIZE = 1 << 16;
+    constexpr size_t MAX_BUFFER_SIZE = 1 << 26;
+  }
+
+  void *CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    _nAllocations++;
+    _allocatedBytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void CountingResource::do_deallocate(void *p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  std::atomic<uint64_t> EventArena::_currentEvent(0);
+
+  EventArena::EventArena() :
+    _event(_currentEvent), _buffer(new char[INITIAL_BUFFER_SIZE]), _bufferSize(INITIAL_BUFFER_SIZE), _nAllocations(0) {
+    _monotonic.emplace(_buffer.get(), _bufferSize, &_upstream);
+  }
+
+  // Arena of the calling thread.
+  EventArena &EventArena::Get() {
+    thread_local EventArena arena;
+    return arena;
+  }
+
+  // Start a new event.
+  void EventArena::NewEvent() {
+    _currentEvent++;
+  }
+
+  // Get the resource for the containers of this event.
+  std::pmr::memory_resource *EventArena::Resource() {
+    if (_event != _currentEvent) Reset();
+    return this;
+  }
+
+  // Free the previous event, growing the buffer if it was too small.
+  void EventArena::Reset() {
+    STOPPING_MUON_COUNT("EventArena::Allocations", _nAllocations);
+    STOPPING_MUON_COUNT("EventArena::UpstreamAllocations", _upstream.GetNumbAllocations());
+    STOPPING_MUON_LOG_DEBUG(kLogInstrumentation) << "EventArena.cxx: " << _nAllocations << " allocations, "
+                                                 << _upstream.GetNumbAllocations() << " from malloc, buffer of "
+                                                 << _bufferSize << " bytes.";
+    const size_t neededSize = std::min(_bufferSize + _upstream.GetAllocatedBytes(), MAX_BUFFER_SIZE);
+    _monotonic.reset();
+    if (neededSize > _bufferSize) {
+      _buffer.reset(new char[neededSize]);
+      _bufferSize = neededSize;
+    }
+    _monotonic.emplace(_buffer.get(), _bufferSize, &_upstream);
+    _upstream.ResetCounters();
+    _nAllocations = 0;
+    _event = _currentEvent;
+  }
+
+  void *EventArena::do_allocate(size_t bytes, size_t alignment) {
+    _nAllocations++;
+    return _monotonic->allocate(bytes, alignment);
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
@@ -0,0 +1,93 @@
+/***
+  Class containing the per-event arena for the temporary containers of the
+  selection and calorimetry. Allocations are carved out of a monotonic
+  buffer and freed all at once at the next event. The buffer grows to the
+  largest event seen, so that steady-state events do not call malloc.
+  There is one arena per thread, so the tasks of TrackPlanesAlg do not share
+  it. Only use it for containers that do not outlive the event.
+
+*/
+#ifndef EVENT_ARENA_H
+#define EVENT_ARENA_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+namespace stoppingcosmicmuonselection {
+
+  // Containers allocated in the arena.
+  template <class T>
+  using arenaVector = std::pmr::vector<T>;
+  template <class K, class V>
+  using arenaMap = std::pmr::map<K,V>;
+
+  // Upstream of the arena: counts the calls to malloc.
+  class CountingResource : public std::pmr::memory_resource {
+
+  public:
+    uint64_t GetNumbAllocations() const { return _nAllocations; }
+    uint64_t GetAllocatedBytes() const { return _allocatedBytes; }
+    void ResetCounters() { _nAllocations = 0; _allocatedBytes = 0; }
+
+  private:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    uint64_t _nAllocations = 0;
+    uint64_t _allocatedBytes = 0;
+
+  };
+
+  class EventArena : public std::pmr::memory_resource {
+
+  public:
+    // Arena of the calling thread.
+    static EventArena &Get();
+
+    // Start a new event: every arena is reset on its next use.
+    static void NewEvent();
+
+    // Get the resource for the containers of this event.
+    std::pmr::memory_resource *Resource();
+
+    // Counters of the current event.
+    uint64_t GetNumbAllocations() const { return _nAllocations; }
+    uint64_t GetNumbUpstreamAllocations() const { return _upstream.GetNumbAllocations(); }
+    size_t GetBufferSize() const { return _bufferSize; }
+
+    EventArena(EventArena const &) = delete;
+    EventArena & operator = (EventArena const &) = delete;
+
+  private:
+    EventArena();
+
+    // Free the previous event, growing the buffer if it was too small.
+    void Reset();
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    static std::atomic<uint64_t> _currentEvent;
+    uint64_t _event;
+
+    CountingResource _upstream;
+    std::unique_ptr<char[]> _buffer;
+    size_t _bufferSize;
+    std::optional<std::pmr::monotonic_buffer_resource> _monotonic;
+    uint64_t _nAllocations;
+
+  };
+
+  // Empty vector in the arena of the calling thread.
+  template <class T>
+  arenaVector<T> make_arena_vector() { return arenaVector<T>(EventArena::Get().Resource()); }
+}
+
+#endif
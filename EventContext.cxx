@@ -0,0 +1,91 @@
+/***
+  Class containing the per-event detector clock and properties snapshots.
+
+*/
+#ifndef EVENT_CONTEXT_CXX
+#define EVENT_CONTEXT_CXX
+
+#include "dune/Calib/LifetimeCalib.h"
+#include "dune/CalibServices/LifetimeCalibService.h"
+
+#include "EventContext.h"
+
+namespace stoppingcosmicmuonselection {
+
+  // Fetch the clock and detector properties of the event.
+  EventContext::EventContext(art::Event const &evt) :
+    _clockData(art::ServiceHandle<detinfo::DetectorClocksService const>()->DataFor(evt)),
+    _detProp(art::ServiceHandle<detinfo::DetectorPropertiesService const>()->DataFor(evt, _clockData)) {
+    _eventID = evt.id();
+    _isRealData = evt.isRealData();
+    _driftVelocity = _detProp.DriftVelocity()*1e-3;
+    _samplingRate = detinfo::sampling_rate(_clockData);
+    _triggerOffset = detinfo::trigger_offset(_clockData);
+    _efield = _detProp.Efield();
+    _electronLifetime = _detProp.ElectronLifetime();
+
+    // The conversion is linear in the ticks: two points per plane are enough.
+    const geo::GeometryCore *geom = lar::providerFrom<geo::Geometry>();
+    _nTPCs = geom->MaxTPCs();
+    _nPlanes = geom->MaxPlanes();
+    _xAtTickZero.assign(geom->Ncryostats()*_nTPCs*_nPlanes, INV_DBL);
+    _xPerTick.assign(_xAtTickZero.size(), INV_DBL);
+    for (geo::PlaneID const &planeID : geom->IteratePlaneIDs()) {
+      const size_t entry = GetPlaneEntry(planeID.Plane, planeID.TPC, planeID.Cryostat);
+      _xAtTickZero[entry] = _detProp.ConvertTicksToX(0., planeID.Plane, planeID.TPC, planeID.Cryostat);
+      _xPerTick[entry] = _detProp.ConvertTicksToX(1., planeID.Plane, planeID.TPC, planeID.Cryostat) - _xAtTickZero[entry];
+    }
+    _xAnode = std::abs(TicksToX(_triggerOffset, 0, 0, 0));
+  }
+
+  EventContext::~EventContext() {
+
+  }
+
+  // Check if the context was built for this event.
+  bool EventContext::IsFor(art::Event const &evt) const {
+    // The full ID: the event numbers start again in each subrun.
+    return _eventID == evt.id();
+  }
+
+  // Electron lifetime used for the corrections. Read on first use.
+  double EventContext::GetCalibLifetime() const {
+    if (_calibLifetime != INV_DBL) return _calibLifetime;
+    if (_isRealData) {
+      // Electron lifetime from database calibration service provider
+      art::ServiceHandle<calib::LifetimeCalibService> lifetimecalibHandler;
+      calib::LifetimeCalib *lifetimecalib = lifetimecalibHandler->provider();
+      _calibLifetime = lifetimecalib->GetLifetime()*1000.0; // [ms]*1000.0 -> [us]
+    }
+    else {
+      _calibLifetime = _electronLifetime;
+    }
+    return _calibLifetime;
+  }
+
+  // Entry of a plane in the tick <-> x tables.
+  size_t EventContext::GetPlaneEntry(const unsigned int &plane, const unsigned int &tpc, const unsigned int &cryostat) const {
+    if (plane >= _nPlanes || tpc >= _nTPCs) return INV_SIZE;
+    const size_t entry = (size_t(cryostat)*_nTPCs + tpc)*_nPlanes + plane;
+    return entry < _xPerTick.size() ? entry : INV_SIZE;
+  }
+
+  // Same as detinfo::DetectorPropertiesData::ConvertTicksToX.
+  double EventContext::TicksToX(const double &ticks, const unsigned int &plane, const unsigned int &tpc, const unsigned int &cryostat) const {
+    const size_t entry = GetPlaneEntry(plane, tpc, cryostat);
+    if (entry == INV_SIZE || _xPerTick[entry] == INV_DBL)
+      return _detProp.ConvertTicksToX(ticks, plane, tpc, cryostat);
+    return _xAtTickZero[entry] + _xPerTick[entry]*ticks;
+  }
+
+  // Same as detinfo::DetectorPropertiesData::ConvertXToTicks.
+  double EventContext::XToTicks(const double &x, const unsigned int &plane, const unsigned int &tpc, const unsigned int &cryostat) const {
+    const size_t entry = GetPlaneEntry(plane, tpc, cryostat);
+    if (entry == INV_SIZE || _xPerTick[entry] == INV_DBL)
+      return _detProp.ConvertXToTicks(x, plane, tpc, cryostat);
+    return (x - _xAtTickZero[entry])/_xPerTick[entry];
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
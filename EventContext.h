@@ -0,0 +1,86 @@
+/***
+  Class containing the per-event detector clock and properties snapshots.
+  Built once in the analyze()/produce() of the modules and passed to the
+  helpers, so that they do not call the services themselves. The derived
+  constants and the tick <-> x conversion are worked out in the constructor.
+
+*/
+#ifndef EVENT_CONTEXT_H
+#define EVENT_CONTEXT_H
+
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Services/Registry/ServiceHandle.h"
+#include "larcore/Geometry/Geometry.h"
+#include "larcorealg/Geometry/GeometryCore.h"
+#include "lardata/DetectorInfoServices/DetectorClocksService.h"
+#include "lardata/DetectorInfoServices/DetectorPropertiesService.h"
+
+#include "DataTypes.h"
+
+namespace stoppingcosmicmuonselection {
+
+  class EventContext {
+
+  public:
+    // Fetch the clock and detector properties of the event.
+    explicit EventContext(art::Event const &evt);
+    ~EventContext();
+
+    // Check if the context was built for this event.
+    bool IsFor(art::Event const &evt) const;
+
+    // Snapshots, for the LArSoft functions that need them.
+    detinfo::DetectorClocksData const &ClockData() const { return _clockData; }
+    detinfo::DetectorPropertiesData const &DetProp() const { return _detProp; }
+
+    bool IsRealData()         const { return _isRealData; }
+    // Drift velocity in cm/ns.
+    double DriftVelocity()    const { return _driftVelocity; }
+    // Sampling rate in ns per tick.
+    double SamplingRate()     const { return _samplingRate; }
+    // Trigger offset in ticks.
+    double TriggerOffset()    const { return _triggerOffset; }
+    // Drift coordinate |x| of the anodes, in cm.
+    double XAnode()           const { return _xAnode; }
+    // Electric field in kV/cm.
+    double Efield()           const { return _efield; }
+    // Electron lifetime from the detector properties, in us.
+    double ElectronLifetime() const { return _electronLifetime; }
+
+    // Electron lifetime used for the corrections, in us: the calibration
+    // database for data, the detector properties for MC. Read on first use.
+    double GetCalibLifetime() const;
+
+    // Same as detinfo::DetectorPropertiesData::ConvertTicksToX.
+    double TicksToX(const double &ticks, const unsigned int &plane, const unsigned int &tpc, const unsigned int &cryostat) const;
+
+    // Same as detinfo::DetectorPropertiesData::ConvertXToTicks.
+    double XToTicks(const double &x, const unsigned int &plane, const unsigned int &tpc, const unsigned int &cryostat) const;
+
+  private:
+    // Entry of a plane in the tick <-> x tables (INV_SIZE if not there).
+    size_t GetPlaneEntry(const unsigned int &plane, const unsigned int &tpc, const unsigned int &cryostat) const;
+
+    detinfo::DetectorClocksData _clockData;
+    detinfo::DetectorPropertiesData _detProp;
+
+    art::EventID _eventID;
+    bool _isRealData;
+    double _driftVelocity;
+    double _samplingRate;
+    double _triggerOffset;
+    double _xAnode;
+    double _efield;
+    double _electronLifetime;
+    mutable double _calibLifetime = INV_DBL;
+
+    // x = _xAtTickZero + _xPerTick*ticks, one entry per plane.
+    unsigned int _nTPCs = 0;
+    unsigned int _nPlanes = 0;
+    std::vector<double> _xAtTickZero;
+    std::vector<double> _xPerTick;
+
+  };
+}
+
+#endif
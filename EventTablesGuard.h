@@ -0,0 +1,36 @@
+/***
+  Class clearing the per-event tables and context set on a selector.
+  StoppingMuonSelectionAlg and CutCheckHelper keep pointers to tables and
+  to a context that live for one event in the module. Declared right after
+  they are set, the guard resets the pointers when analyze()/produce()
+  ends, also when an exception leaves it.
+
+*/
+#ifndef EVENT_TABLES_GUARD_H
+#define EVENT_TABLES_GUARD_H
+
+namespace stoppingcosmicmuonselection {
+
+  template <class T>
+  class EventTablesGuard {
+
+  public:
+    explicit EventTablesGuard(T &user) : _user(user) {}
+
+    // Do not keep pointers to the tables and context once they go out of scope.
+    ~EventTablesGuard() {
+      _user.SetTruthMatchTable(0x0);
+      _user.SetTrackIDIndex(0x0);
+      _user.SetEventContext(0x0);
+    }
+
+    EventTablesGuard(EventTablesGuard const &) = delete;
+    EventTablesGuard & operator = (EventTablesGuard const &) = delete;
+
+  private:
+    T &_user;
+
+  };
+}
+
+#endif
@@ -2,6 +2,7 @@
 #ifndef FIX_CALO_H
 #define FIX_CALO_H
 #include <math.h>
+#include <algorithm>
 #include <string>
 
 #include "larcoreobj/SimpleTypesAndConstants/PhysicalConstants.h"
@@ -27,6 +28,10 @@
 #include "larevt/SpaceChargeServices/SpaceChargeService.h"
 
 #include "protoduneana/StoppingMuonSelection/CalibrationHelper.h"
+#include "protoduneana/StoppingMuonSelection/EventArena.h"
+#include "protoduneana/StoppingMuonSelection/EventContext.h"
+#include "protoduneana/StoppingMuonSelection/Instrumentation.h"
+#include "protoduneana/StoppingMuonSelection/TrackIDIndex.h"
 // ROOT includes
 #include <TF1.h>
 #include <TGraph.h>
@@ -52,19 +57,21 @@ namespace stoppingcosmicmuonselection {
     FixCalo();
     ~FixCalo();
 
-    const std::vector<std::vector<double>> GetRightCalo(const art::Event& evt, const double &T0, const recob::Track &track);
-    void GetPitch(detinfo::DetectorPropertiesData const& detprop,
+    const std::vector<std::vector<double>> GetRightCalo(const art::Event& evt, const EventContext &context, const double &T0, const recob::Track &track, const TrackIDIndex &trackIDIndex);
+    void GetPitch(const EventContext &context,
                                 art::Ptr<recob::Hit> const& hit,
-                                std::vector<double> const& trkx,
-                                std::vector<double> const& trky,
-                                std::vector<double> const& trkz,
-                                std::vector<double> const& trkw,
-                                std::vector<double> const& trkx0,
+                                arenaVector<double> const& trkx,
+                                arenaVector<double> const& trky,
+                                arenaVector<double> const& trkz,
+                                arenaVector<double> const& trkw,
+                                arenaVector<double> const& trkx0,
                                 double* xyz3d,
                                 double& pitch,
                                 double TickT0);
   private:
     CalibrationHelper calibHelper;
+    // Distance and index of the space points, reused for each hit.
+    std::vector<std::pair<double, size_t>> _sptDistances;
 
   };
 
@@ -72,10 +79,13 @@ namespace stoppingcosmicmuonselection {
   FixCalo::~FixCalo() {}
 
   //------------------------------------------------------------------------------------//
-  const std::vector<std::vector<double>> FixCalo::GetRightCalo(const art::Event& evt, const double &T0, const recob::Track &track)
+  const std::vector<std::vector<double>> FixCalo::GetRightCalo(const art::Event& evt, const EventContext &context, const double &T0, const recob::Track &track, const TrackIDIndex &trackIDIndex)
   {
+    STOPPING_MUON_SCOPED_TIMER("FixCalo::GetRightCalo");
     std::vector<std::vector<double>> to_be_returned;
-    std::vector<double> XX, YY, ZZ;
+    // Work buffers, in the event arena.
+    std::pmr::memory_resource *arena = EventArena::Get().Resource();
+    arenaVector<double> XX(arena), YY(arena), ZZ(arena);
 
     std::string fTrackModuleLabel = "pandoraTrack";
     std::string fSpacePointModuleLabel = "pandora";
@@ -84,24 +94,22 @@ namespace stoppingcosmicmuonselection {
     bool fFlipTrack_dQdx = false;
     //bool fNotOnTrackZcut = false;
     int fnsps;
-    std::vector<int>    fwire;
-    std::vector<double> ftime;
-    std::vector<double> fstime;
-    std::vector<double> fetime;
-    std::vector<double> fMIPs;
-    std::vector<double> fdQdx;
-    std::vector<double> fdEdx;
-    std::vector<double> fResRng;
-    std::vector<double> fpitch;
-    std::vector<TVector3> fXYZ;
-    std::vector<size_t> fHitIndex;
-
-    auto const clock_data = art::ServiceHandle<detinfo::DetectorClocksService const>()->DataFor(evt);
-    auto const detprop =
-      art::ServiceHandle<detinfo::DetectorPropertiesService const>()->DataFor(evt, clock_data);
+    arenaVector<int>    fwire(arena);
+    arenaVector<double> ftime(arena);
+    arenaVector<double> fstime(arena);
+    arenaVector<double> fetime(arena);
+    arenaVector<double> fMIPs(arena);
+    arenaVector<double> fdQdx(arena);
+    arenaVector<double> fdEdx(arena);
+    arenaVector<double> fResRng(arena);
+    arenaVector<double> fpitch(arena);
+    arenaVector<TVector3> fXYZ(arena);
+    arenaVector<size_t> fHitIndex(arena);
+
+    auto const &detprop = context.DetProp();
     auto const* sce = lar::providerFrom<spacecharge::SpaceChargeService>();
 
-    double drift_velocity = detprop.DriftVelocity()*1e-3; // cm/ns
+    double drift_velocity = context.DriftVelocity(); // cm/ns
     art::Handle<std::vector<recob::Track>> trackListHandle;
     std::vector<art::Ptr<recob::Track>> tracklist;
     if (evt.getByLabel(fTrackModuleLabel, trackListHandle))
@@ -123,8 +131,9 @@ namespace stoppingcosmicmuonselection {
       fTrackModuleLabel); //this has more information about hit-track association, only available in PMA for now
 
 
-    for (size_t trkIter = 0; trkIter < tracklist.size(); ++trkIter) {
-      if (tracklist[trkIter]->ID()!=track.ID()) continue;
+    // Look up the track instead of scanning the track list.
+    const size_t trkIter = trackIDIndex.GetIndex(track);
+    if (trkIter < tracklist.size()) {
       decltype(auto) larEnd = tracklist[trkIter]->Trajectory().End();
 
       // Some variables for the hit
@@ -139,9 +148,9 @@ namespace stoppingcosmicmuonselection {
 
       std::vector<art::Ptr<recob::Hit>> allHits = fmht.at(trkIter);
       double TickT0 =0;
-      TickT0 = T0 / sampling_rate(clock_data);
+      TickT0 = T0 / context.SamplingRate();
 
-      std::vector<std::vector<unsigned int>> hits(nplanes);
+      arenaVector<arenaVector<unsigned int>> hits(nplanes, arena);
 
       art::FindManyP<recob::SpacePoint> fmspts(allHits, evt, fSpacePointModuleLabel);
       for (size_t ah = 0; ah < allHits.size(); ++ah) {
@@ -166,11 +175,11 @@ namespace stoppingcosmicmuonselection {
 
         float Kin_En = 0.;
         float Trk_Length = 0.;
-        std::vector<double> vdEdx;
-        std::vector<double> vresRange;
-        std::vector<double> vdQdx;
-        std::vector<double> deadwire; //residual range for dead wires
-        std::vector<TVector3> vXYZ;
+        arenaVector<double> vdEdx(arena);
+        arenaVector<double> vresRange(arena);
+        arenaVector<double> vdQdx(arena);
+        arenaVector<double> deadwire(arena); //residual range for dead wires
+        arenaVector<TVector3> vXYZ(arena);
 
         // Require at least 2 hits in this view
         if (hits[ipl].size() < 2) {
@@ -193,10 +202,10 @@ namespace stoppingcosmicmuonselection {
         double USChg = 0;
         double DSChg = 0;
         // temp array holding distance betweeen space points
-        std::vector<double> spdelta;
+        arenaVector<double> spdelta(arena);
         fnsps = 0; // number of space points
-        std::vector<double> ChargeBeg;
-        std::stack<double> ChargeEnd;
+        arenaVector<double> ChargeBeg(arena);
+        std::stack<double, arenaVector<double>> ChargeEnd(arena);
 
         // find track pitch
         double fTrkPitch = 0;
@@ -249,11 +258,11 @@ namespace stoppingcosmicmuonselection {
         double xx = 0., yy = 0., zz = 0.;
 
         //save track 3d points
-        std::vector<double> trkx;
-        std::vector<double> trky;
-        std::vector<double> trkz;
-        std::vector<double> trkw;
-        std::vector<double> trkx0;
+        arenaVector<double> trkx(arena);
+        arenaVector<double> trky(arena);
+        arenaVector<double> trkz(arena);
+        arenaVector<double> trkw(arena);
+        arenaVector<double> trkx0(arena);
         for (size_t i = 0; i < hits[ipl].size(); ++i) {
           //Get space points associated with the hit
           std::vector<art::Ptr<recob::SpacePoint>> sptv = fmspts.at(hits[ipl][i]);
@@ -261,17 +270,17 @@ namespace stoppingcosmicmuonselection {
 
             double t = allHits[hits[ipl][i]]->PeakTime() -
                        TickT0; // Want T0 here? Otherwise ticks to x is wrong?
-            double x = detprop.ConvertTicksToX(t,
-                                                allHits[hits[ipl][i]]->WireID().Plane,
-                                                allHits[hits[ipl][i]]->WireID().TPC,
-                                                allHits[hits[ipl][i]]->WireID().Cryostat);
+            double x = context.TicksToX(t,
+                                        allHits[hits[ipl][i]]->WireID().Plane,
+                                        allHits[hits[ipl][i]]->WireID().TPC,
+                                        allHits[hits[ipl][i]]->WireID().Cryostat);
             double w = allHits[hits[ipl][i]]->WireID().Wire;
             if (TickT0) {
               trkx.push_back(sptv[j]->XYZ()[0] -
-                             detprop.ConvertTicksToX(TickT0,
-                                                      allHits[hits[ipl][i]]->WireID().Plane,
-                                                      allHits[hits[ipl][i]]->WireID().TPC,
-                                                      allHits[hits[ipl][i]]->WireID().Cryostat));
+                             context.TicksToX(TickT0,
+                                              allHits[hits[ipl][i]]->WireID().Plane,
+                                              allHits[hits[ipl][i]]->WireID().TPC,
+                                              allHits[hits[ipl][i]]->WireID().Cryostat));
             }
             else {
               trkx.push_back(sptv[j]->XYZ()[0]);
@@ -381,7 +390,7 @@ namespace stoppingcosmicmuonselection {
             }
           }
           else
-            GetPitch(detprop,
+            GetPitch(context,
                      allHits[hits[ipl][ihit]],
                      trkx,
                      trky,
@@ -598,31 +607,33 @@ namespace stoppingcosmicmuonselection {
             }
           }
         }
-        to_be_returned.push_back(vdQdx);
-        to_be_returned.push_back(vresRange);
-        to_be_returned.push_back(fpitch);
-        to_be_returned.push_back(XX);
-        to_be_returned.push_back(YY);
-        to_be_returned.push_back(ZZ);
-        to_be_returned.push_back(vdEdx);
+        to_be_returned.reserve(7);
+        to_be_returned.emplace_back(vdQdx.begin(), vdQdx.end());
+        to_be_returned.emplace_back(vresRange.begin(), vresRange.end());
+        to_be_returned.emplace_back(fpitch.begin(), fpitch.end());
+        to_be_returned.emplace_back(XX.begin(), XX.end());
+        to_be_returned.emplace_back(YY.begin(), YY.end());
+        to_be_returned.emplace_back(ZZ.begin(), ZZ.end());
+        to_be_returned.emplace_back(vdEdx.begin(), vdEdx.end());
 
       } //end looping over planes
-    }   //end looping over tracks
+    }   //end of the selected track
 
     return to_be_returned;
   }
 
-  void FixCalo::GetPitch(detinfo::DetectorPropertiesData const& detprop,
+  void FixCalo::GetPitch(const EventContext &context,
                               art::Ptr<recob::Hit> const& hit,
-                              std::vector<double> const& trkx,
-                              std::vector<double> const& trky,
-                              std::vector<double> const& trkz,
-                              std::vector<double> const& trkw,
-                              std::vector<double> const& trkx0,
+                              arenaVector<double> const& trkx,
+                              arenaVector<double> const& trky,
+                              arenaVector<double> const& trkz,
+                              arenaVector<double> const& trkw,
+                              arenaVector<double> const& trkx0,
                               double* xyz3d,
                               double& pitch,
                               double TickT0)
   {
+    STOPPING_MUON_SCOPED_TIMER("FixCalo::GetPitch");
     // Get 3d coordinates and track pitch for each hit
     // Find 5 nearest space points and determine xyz and curvature->track pitch
 
@@ -631,43 +642,44 @@ namespace stoppingcosmicmuonselection {
     auto const* sce = lar::providerFrom<spacecharge::SpaceChargeService>();
 
     //save distance to each spacepoint sorted by distance
-    std::map<double, size_t> sptmap;
-    //save the sign of distance
-    std::map<size_t, int> sptsignmap;
+    _sptDistances.clear();
 
     double wire_pitch = geom->WirePitch(0);
 
     double t0 = hit->PeakTime() - TickT0;
     double x0 =
-      detprop.ConvertTicksToX(t0, hit->WireID().Plane, hit->WireID().TPC, hit->WireID().Cryostat);
+      context.TicksToX(t0, hit->WireID().Plane, hit->WireID().TPC, hit->WireID().Cryostat);
     double w0 = hit->WireID().Wire;
 
     for (size_t i = 0; i < trkx.size(); ++i) {
       double distance = cet::sum_of_squares((trkw[i] - w0) * wire_pitch, trkx0[i] - x0);
       if (distance > 0) distance = sqrt(distance);
-      sptmap.insert(std::pair<double, size_t>(distance, i));
-      if (w0 - trkw[i] > 0)
-        sptsignmap.emplace(i, 1);
-      else
-        sptsignmap.emplace(i, -1);
+      _sptDistances.emplace_back(distance, i);
     }
-
-    //x,y,z vs distance
-    std::vector<double> vx;
-    std::vector<double> vy;
-    std::vector<double> vz;
-    std::vector<double> vs;
+    // Same order as a map on the distance: for equal distances keep the first space point.
+    std::sort(_sptDistances.begin(), _sptDistances.end());
+    _sptDistances.erase(std::unique(_sptDistances.begin(), _sptDistances.end(),
+                                    [](const std::pair<double, size_t> &a, const std::pair<double, size_t> &b) {
+                                      return a.first == b.first;
+                                    }),
+                        _sptDistances.end());
+
+    //x,y,z vs distance, for the 5 nearest points
+    double vx[5];
+    double vy[5];
+    double vz[5];
+    double vs[5];
 
     double kx = 0, ky = 0, kz = 0;
 
     int np = 0;
-    for (auto isp = sptmap.begin(); isp != sptmap.end(); isp++) {
+    for (auto isp = _sptDistances.begin(); isp != _sptDistances.end(); isp++) {
       double xyz[3];
       xyz[0] = trkx[isp->second];
       xyz[1] = trky[isp->second];
       xyz[2] = trkz[isp->second];
 
-      double distancesign = sptsignmap[isp->second];
+      double distancesign = (w0 - trkw[isp->second] > 0) ? 1 : -1;
       if (np == 0 && isp->first > 30) { // hit not on track
         xyz3d[0] = std::numeric_limits<double>::lowest();
         xyz3d[1] = std::numeric_limits<double>::lowest();
@@ -676,10 +688,10 @@ namespace stoppingcosmicmuonselection {
         return;
       }
       if (np < 5) {
-        vx.push_back(xyz[0]);
-        vy.push_back(xyz[1]);
-        vz.push_back(xyz[2]);
-        vs.push_back(isp->first * distancesign);
+        vx[np] = xyz[0];
+        vy[np] = xyz[1];
+        vz[np] = xyz[2];
+        vs[np] = isp->first * distancesign;
       }
       else {
         break;
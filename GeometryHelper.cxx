@@ -6,6 +6,7 @@
 #define GEOMETRY_HELPER_CXX
 
 #include "GeometryHelper.h"
+#include "Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -58,12 +59,12 @@ namespace stoppingcosmicmuonselection {
   // Print active volume
   void GeometryHelper::PrintActiveVolumeBounds() {
     auto const &bounds = GetActiveVolumeBounds();
-    std::cout << "***************************************" << std::endl;
-    std::cout << "Active volume bounds:" << std::endl;
-    std::cout << "X: " << bounds[0] << " - " << bounds[1] << std::endl;
-    std::cout << "Y: " << bounds[2] << " - " << bounds[3] << std::endl;
-    std::cout << "Z: " << bounds[4] << " - " << bounds[5] << std::endl;
-    std::cout << "***************************************" << std::endl;
+    STOPPING_MUON_LOG_INFO(kLogGeometry) << "***************************************";
+    STOPPING_MUON_LOG_INFO(kLogGeometry) << "Active volume bounds:";
+    STOPPING_MUON_LOG_INFO(kLogGeometry) << "X: " << bounds[0] << " - " << bounds[1];
+    STOPPING_MUON_LOG_INFO(kLogGeometry) << "Y: " << bounds[2] << " - " << bounds[3];
+    STOPPING_MUON_LOG_INFO(kLogGeometry) << "Z: " << bounds[4] << " - " << bounds[5];
+    STOPPING_MUON_LOG_INFO(kLogGeometry) << "***************************************";
   }
 
   // Set fiducial bounds offset from active volume bounds
@@ -78,7 +79,7 @@ namespace stoppingcosmicmuonselection {
     if (!_isActiveBoundsInitialised)
       InitActiveVolumeBounds();
     if (!_isFiducialBoundOffsetSet)
-      std::cerr << "Returning WRONG fiducial volume." << std::endl;
+      STOPPING_MUON_LOG_WARNING(kLogGeometry) << "Returning WRONG fiducial volume.";
     for (int i=0;i<6;i++) {
       if (i%2==0) _fiducialBounds[i]=_activeBounds[i]+_fiducialBoundOffset;
       else _fiducialBounds[i]=_activeBounds[i]-_fiducialBoundOffset;
@@ -90,14 +91,14 @@ namespace stoppingcosmicmuonselection {
   // Get fiducial volume
   double *GeometryHelper::GetFiducialVolumeBounds() {
     if (!_isFiducialBoundOffsetSet)
-      std::cerr << "Returning fiducial bound vector NOT initialised." << std::endl;
+      STOPPING_MUON_LOG_WARNING(kLogGeometry) << "Returning fiducial bound vector NOT initialised.";
     if (!_isFiducialBoundsInitialised)
       InitFiducialVolumeBounds();
     return _fiducialBounds;
   }
 
   // Check if a point is contained in a general volume
-  bool GeometryHelper::IsPointInVolume(double *v, TVector3 const &Point) {
+  bool GeometryHelper::IsPointInVolume(double *v, Point3 const &Point) {
     return (Point.X() >= v[0] && Point.X() <= v[1]
             && Point.Y() >= v[2] && Point.Y() <= v[3]
             && Point.Z() >= v[4] && Point.Z() <= v[5]);
@@ -105,7 +106,7 @@ namespace stoppingcosmicmuonselection {
 
   // Check if a point is contained in a general volume
   bool GeometryHelper::IsPointInVolume(double *v, double *Point) {
-    const TVector3 point_V(Point[0],Point[1],Point[2]);
+    const Point3 point_V{Point[0],Point[1],Point[2]};
     return IsPointInVolume(v, point_V);
   }
 
@@ -117,9 +118,9 @@ namespace stoppingcosmicmuonselection {
   }
 
   // Check if a point is contained in a slice from the active volume
-  bool GeometryHelper::IsPointInSlice(TVector3 const &Point) {
+  bool GeometryHelper::IsPointInSlice(Point3 const &Point) {
     if (!_isThicknessSet)
-      std::cerr << "Thickness is not set." << std::endl;
+      STOPPING_MUON_LOG_WARNING(kLogGeometry) << "Thickness is not set.";
     if (!_isActiveBoundsInitialised)
       InitActiveVolumeBounds();
     return (   (Point.Y()>=(_activeBounds[3]-_thicknessStartVolume) && Point.Y()<=_activeBounds[3])
@@ -131,12 +132,12 @@ namespace stoppingcosmicmuonselection {
 
   // Check if a point is contained in a slice from the active volume
   bool GeometryHelper::IsPointInSlice(double *Point) {
-    const TVector3 point_V(Point[0],Point[1],Point[2]);
+    const Point3 point_V{Point[0],Point[1],Point[2]};
     return IsPointInSlice(point_V);
   }
 
   // Check if the YZ projection of a point is contained in an area in the YZ face of the fiducial volume.
-  bool GeometryHelper::IsPointYZProjectionInArea(TVector3 const &p, double const &offsetYStartPoint, double const &offsetZStartPoint) {
+  bool GeometryHelper::IsPointYZProjectionInArea(Point3 const &p, double const &offsetYStartPoint, double const &offsetZStartPoint) {
     if (!_isActiveBoundsInitialised)
       InitActiveVolumeBounds();
     return ( (p.Y()>=(_activeBounds[2]+offsetYStartPoint)) &&
@@ -180,7 +181,7 @@ namespace stoppingcosmicmuonselection {
     if (nWiresBR == nWiresBL)
       nWires = nWiresBL;
     else
-      std::cout << "Two sides don't have same number of wires. Returning invalid number." << std::endl;
+      STOPPING_MUON_LOG_WARNING(kLogGeometry) << "Two sides don't have same number of wires. Returning invalid number.";
     return nWires;
   }
 
@@ -257,7 +258,7 @@ namespace stoppingcosmicmuonselection {
   }
 
   // Return TPC index given a point.
-  unsigned int GeometryHelper::GetTPCFromPosition(const TVector3 &pos) {
+  unsigned int GeometryHelper::GetTPCFromPosition(const Point3 &pos) {
     geo::Point_t point{pos.X(), pos.Y(), pos.Z()};
     unsigned int tpcIndex;
     // Get geo TPCID.
@@ -8,7 +8,6 @@
 #include "larcore/Geometry/Geometry.h"
 #include "larcorealg/Geometry/TPCGeo.h"
 #include "larcorealg/Geometry/GeometryCore.h"
-#include "TVector3.h"
 #include "TMath.h"
 
 #include "DataTypes.h"
@@ -40,18 +39,18 @@ namespace stoppingcosmicmuonselection {
     double *GetFiducialVolumeBounds();
 
     // Check if a point is contained in a general volume
-    bool IsPointInVolume(double *v, TVector3 const &Point);
+    bool IsPointInVolume(double *v, Point3 const &Point);
     bool IsPointInVolume(double *v, double *Point);
 
     // Set the thickness for the slice around the active Volume
     void SetThicknessStartVolume(const double &thickness);
 
     // Check if a point is contained in a slice from the active volume
-    bool IsPointInSlice(TVector3 const &Point);
+    bool IsPointInSlice(Point3 const &Point);
     bool IsPointInSlice(double *Point);
 
     // Check if the YZ projection of a point is contained in an area in the YZ face of the fiducial volume.
-    bool IsPointYZProjectionInArea(TVector3 const &p, double const &offsetYStartPoint, double const &offsetZStartPoint);
+    bool IsPointYZProjectionInArea(Point3 const &p, double const &offsetYStartPoint, double const &offsetZStartPoint);
 
     // Get the APA boundaries (simple version)
     double *GetAPABoundaries();
@@ -76,7 +75,7 @@ namespace stoppingcosmicmuonselection {
     bool IsTPCOnCryoSide(const unsigned int &hit_tpcid);
 
     // Return TPC index given a point.
-    unsigned int GetTPCFromPosition(const TVector3 &pos);
+    unsigned int GetTPCFromPosition(const Point3 &pos);
 
     // Arrays with TPC number info
     const unsigned int tpcIndecesBL[3] = {2,6,10};
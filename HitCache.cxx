@@ -0,0 +1,135 @@
+/***
+  Class containing a per-event table of hit quantities.
+
+*/
+#ifndef HIT_CACHE_CXX
+#define HIT_CACHE_CXX
+
+#include "HitCache.h"
+
+namespace stoppingcosmicmuonselection {
+
+  HitCache::HitCache() {
+
+  }
+
+  HitCache::~HitCache() {
+
+  }
+
+  // Fill the table with all the hits of the event.
+  void HitCache::Set(art::Event const &evt, const std::string &hitTag) {
+    auto const hitHandle = evt.getValidHandle<std::vector<recob::Hit>>(hitTag);
+    const std::vector<recob::Hit> &hits = *hitHandle;
+    const size_t nHits = hits.size();
+
+    _productID = hitHandle.id();
+    _ptrs.clear();
+    art::fill_ptr_vector(_ptrs, hitHandle);
+
+    _peakTime.resize(nHits);
+    _integral.resize(nHits);
+    _amplitude.resize(nHits);
+    _rms.resize(nHits);
+    _driftX.assign(nHits, INV_DBL);
+    _plane.resize(nHits);
+    _tpc.resize(nHits);
+    _cryostat.resize(nHits);
+    _wire.resize(nHits);
+    _globalWire.resize(nHits);
+    _channel.resize(nHits);
+
+    for (size_t i = 0; i < nHits; i++) {
+      const recob::Hit &hit = hits[i];
+      const geo::WireID &wireID = hit.WireID();
+      _peakTime[i] = hit.PeakTime();
+      _integral[i] = hit.Integral();
+      _amplitude[i] = hit.PeakAmplitude();
+      _rms[i] = hit.RMS();
+      _channel[i] = hit.Channel();
+      if (!wireID.isValid) {
+        _plane[i] = _tpc[i] = _cryostat[i] = _wire[i] = INV_INT;
+        _globalWire[i] = -INV_INT;
+        continue;
+      }
+      _plane[i] = wireID.Plane;
+      _tpc[i] = wireID.TPC;
+      _cryostat[i] = wireID.Cryostat;
+      _wire[i] = wireID.Wire;
+      _globalWire[i] = wireID.Wire + GetWireOffset(wireID.TPC, wireID.Plane);
+    }
+  }
+
+  // Get the index of a hit in the table.
+  uint32_t HitCache::GetIndex(const art::Ptr<recob::Hit> &hitp) const {
+    if (hitp.id() != _productID)
+      throw cet::exception("HitCache.cxx") << "HitCache::GetIndex(): hit does not belong to the cached hit collection.";
+    return hitp.key();
+  }
+
+  // Get the indices for a vector of hits.
+  hitIndexVec HitCache::GetIndexVec(const artPtrHitVec &hits) const {
+    hitIndexVec indices;
+    indices.reserve(hits.size());
+    for (auto const &hitp : hits)
+      indices.push_back(GetIndex(hitp));
+    return indices;
+  }
+
+  // Get the art::Ptr vector for a vector of indices.
+  artPtrHitVec HitCache::GetPtrVec(const hitIndexVec &indices) const {
+    artPtrHitVec hits;
+    hits.reserve(indices.size());
+    for (auto const &i : indices)
+      hits.push_back(_ptrs[i]);
+    return hits;
+  }
+
+  // Get the subset of indices on a given plane (same order as the input).
+  hitIndexVec HitCache::GetHitsOnAPlane(const size_t &planeNumb, const hitIndexVec &indices) const {
+    hitIndexVec hitsOnPlane;
+    GetHitsOnAPlane(planeNumb, indices, hitsOnPlane);
+    return hitsOnPlane;
+  }
+
+  // Same, filling a given vector (keeps its capacity).
+  void HitCache::GetHitsOnAPlane(const size_t &planeNumb, const hitIndexVec &indices, hitIndexVec &hitsOnPlane) const {
+    hitsOnPlane.clear();
+    hitsOnPlane.reserve(indices.size());
+    for (auto const &i : indices) {
+      if (_plane[i] != (int)planeNumb) continue;
+      hitsOnPlane.push_back(i);
+    }
+  }
+
+  // Work out the drift X of the given hits for a given T0.
+  void HitCache::SetDriftX(const hitIndexVec &indices,
+                           const double &t0,
+                           const EventContext &context) {
+    double tickT0 = t0 / context.SamplingRate();
+    for (auto const &i : indices) {
+      if (!IsValid(i)) continue;
+      _driftX[i] = context.TicksToX(_peakTime[i]-tickT0, _plane[i], _tpc[i], _cryostat[i]);
+    }
+  }
+
+  // Wire offset for a TPC and plane. Filled once per job.
+  uint32_t HitCache::GetWireOffset(const unsigned int &tpc, const unsigned int &plane) {
+    if (_wireOffsets.empty()) {
+      _nPlanes = geom->MaxPlanes();
+      const unsigned int nTPCs = geom->MaxTPCs();
+      _wireOffsets.resize(nTPCs*_nPlanes);
+      for (unsigned int t = 0; t < nTPCs; t++) {
+        for (unsigned int p = 0; p < _nPlanes; p++)
+          _wireOffsets[t*_nPlanes+p] = geoHelper.GetWireOffset(t, p);
+      }
+    }
+    const size_t entry = tpc*_nPlanes+plane;
+    if (entry >= _wireOffsets.size())
+      return geoHelper.GetWireOffset(tpc, plane);
+    return _wireOffsets[entry];
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
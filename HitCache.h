@@ -0,0 +1,101 @@
+/***
+  Class containing a per-event table of hit quantities.
+  Columns are indexed by the position of the hit in the event hit collection.
+
+*/
+#ifndef HIT_CACHE_H
+#define HIT_CACHE_H
+
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "canvas/Persistency/Common/Ptr.h"
+#include "canvas/Persistency/Provenance/ProductID.h"
+#include "cetlib_except/exception.h"
+#include "lardataobj/RecoBase/Hit.h"
+#include "larcore/Geometry/Geometry.h"
+#include "larcorealg/Geometry/GeometryCore.h"
+
+#include "DataTypes.h"
+#include "EventContext.h"
+#include "GeometryHelper.h"
+
+namespace stoppingcosmicmuonselection {
+
+  class HitCache {
+
+  public:
+    HitCache();
+    ~HitCache();
+
+    // Fill the table with all the hits of the event.
+    void Set(art::Event const &evt, const std::string &hitTag);
+
+    // Number of hits in the table.
+    size_t Size() const { return _ptrs.size(); }
+
+    // Get the index of a hit in the table.
+    uint32_t GetIndex(const art::Ptr<recob::Hit> &hitp) const;
+
+    // Get the indices for a vector of hits.
+    hitIndexVec GetIndexVec(const artPtrHitVec &hits) const;
+
+    // Get the art::Ptr for a given index.
+    const art::Ptr<recob::Hit> &GetPtr(const uint32_t &index) const { return _ptrs[index]; }
+
+    // Get the art::Ptr vector for a vector of indices.
+    artPtrHitVec GetPtrVec(const hitIndexVec &indices) const;
+
+    // Get the subset of indices on a given plane (same order as the input).
+    hitIndexVec GetHitsOnAPlane(const size_t &planeNumb, const hitIndexVec &indices) const;
+    // Same, filling a given vector (keeps its capacity).
+    void GetHitsOnAPlane(const size_t &planeNumb, const hitIndexVec &indices, hitIndexVec &hitsOnPlane) const;
+
+    // Work out the drift X of the given hits for a given T0.
+    void SetDriftX(const hitIndexVec &indices,
+                   const double &t0,
+                   const EventContext &context);
+
+    // Column accessors.
+    float PeakTime(const uint32_t &i)   const { return _peakTime[i]; }
+    float Integral(const uint32_t &i)   const { return _integral[i]; }
+    float Amplitude(const uint32_t &i)  const { return _amplitude[i]; }
+    float RMS(const uint32_t &i)        const { return _rms[i]; }
+    float DriftX(const uint32_t &i)     const { return _driftX[i]; }
+    int   Plane(const uint32_t &i)      const { return _plane[i]; }
+    int   TPC(const uint32_t &i)        const { return _tpc[i]; }
+    int   Cryostat(const uint32_t &i)   const { return _cryostat[i]; }
+    int   Wire(const uint32_t &i)       const { return _wire[i]; }
+    uint32_t GlobalWire(const uint32_t &i) const { return _globalWire[i]; }
+    raw::ChannelID_t Channel(const uint32_t &i) const { return _channel[i]; }
+    bool  IsValid(const uint32_t &i)    const { return _plane[i] >= 0; }
+
+  private:
+    // Wire offset for a TPC and plane. Filled once per job.
+    uint32_t GetWireOffset(const unsigned int &tpc, const unsigned int &plane);
+
+    art::ProductID _productID;
+    std::vector<art::Ptr<recob::Hit>> _ptrs;
+
+    std::vector<float> _peakTime;
+    std::vector<float> _integral;
+    std::vector<float> _amplitude;
+    std::vector<float> _rms;
+    std::vector<float> _driftX;
+    std::vector<int> _plane;
+    std::vector<int> _tpc;
+    std::vector<int> _cryostat;
+    std::vector<int> _wire;
+    std::vector<uint32_t> _globalWire;
+    std::vector<raw::ChannelID_t> _channel;
+
+    // Lookup table tpc*nPlanes+plane -> wire offset.
+    std::vector<uint32_t> _wireOffsets;
+    unsigned int _nPlanes = 0;
+
+    GeometryHelper geoHelper;
+    const geo::GeometryCore *geom = &*(art::ServiceHandle<geo::Geometry>());
+
+  };
+}
+
+#endif
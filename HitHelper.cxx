@@ -6,6 +6,7 @@
 #define HIT_HELPER_CXX
 
 #include "HitHelper.h"
+#include "Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -17,17 +18,6 @@ namespace stoppingcosmicmuonselection {
 
   }
 
-  // Get the track index of a track object
-  size_t HitHelper::GetTrackIndex(const recob::Track &track,
-                                  const std::vector<art::Ptr<recob::Track>> &tracklist) {
-    if (tracklist.size() == 0) return INV_INT;
-    for (size_t trackIter = 0; trackIter < tracklist.size(); trackIter++) {
-      if (tracklist[trackIter]->ID() == track.ID())
-        return trackIter;
-    }
-    return INV_INT;
-  }
-
   // Get the vector of art::Ptr to hit for the given track
   const artPtrHitVec HitHelper::GetArtPtrToHitVect(const art::FindManyP<recob::Hit> &fmht,
                                                    const size_t &trackIndex) {
@@ -46,170 +36,108 @@ namespace stoppingcosmicmuonselection {
     return hitsOnPlane;
   }
 
-  // Get XYZ position for that hit
-  TVector3 HitHelper::GetHitXYZ(const art::Ptr<recob::Hit> &hitp,
-                                art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                                const std::vector<art::Ptr<recob::Track>> &tracklist,
-                                const size_t &trackIndex) {
-
-    TVector3 hitLoc(INV_DBL,INV_DBL,INV_DBL);
-    if (!fmthm.isValid()) {
-      std::cout << "HitHelper.cxx: " << "HitHelper::GetHitXYZ is returning an invalid vector the association to TrackHitMeta is invalid." << std::endl;
-      return hitLoc;
-    }
-
-    const artPtrHitVec vhit = fmthm.at(trackIndex);
-    const std::vector<const recob::TrackHitMeta*> vmeta = fmthm.data(trackIndex);
-    // iterate on meta data
-    for (size_t ii=0;ii<vhit.size();++ii) {
-      if (vhit[ii].key() != hitp.key())
-        continue;
-      if (vmeta[ii]->Index() == std::numeric_limits<int>::max()) {
-        continue;
-      }
-      if (vmeta[ii]->Index()>=tracklist[trackIndex]->NumberTrajectoryPoints()){
-        throw cet::exception("HitHelper.cxx") << "Requested track trajectory index "<<vmeta[ii]->Index()<<" exceeds the total number of trajectory points "<<tracklist[trackIndex]->NumberTrajectoryPoints()<<" for track index "<<trackIndex<<". Something is wrong";
-      }
-      if (!tracklist[trackIndex]->HasValidPoint(vmeta[ii]->Index())){
-        std::cout << "HitHelper.cxx -> HitHelper::GetHitXYZ(): Track doesn't have a valid point." << std::endl;
-        continue;
-      }
-      hitLoc = tracklist[trackIndex]->LocationAtPoint<TVector3>(vmeta[ii]->Index());
-    } // iteration on metadata
-
-    return hitLoc;
-  }
-
   // Get index of the closest hit to a given point on the given track.
-  const size_t HitHelper::GetIndexClosestHitToPoint(const TVector3 &point,
-                                                    const artPtrHitVec &hits,
-                                                    art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                                                    const std::vector<art::Ptr<recob::Track>> &tracklist,
-                                                    const size_t &trackIndex) {
+  const size_t HitHelper::GetIndexClosestHitToPoint(const Point3 &point,
+                                                    const hitIndexVec &hits,
+                                                    const HitCache &hitCache,
+                                                    const TrackHitTable &trackHitTable) {
     // guard
     if (hits.size()==0) {
-      std::cout << "HitHelper class: Hit vector of size 0. Returning invalid hit index." << std::endl;
+      STOPPING_MUON_LOG_WARNING(kLogHits) << "HitHelper class: Hit vector of size 0. Returning invalid hit index.";
       return 1;
     }
-    std::vector<double> distanceVec;
-    for (auto const &hitp : hits) {
-      const TVector3 &hitLoc = GetHitXYZ(hitp,fmthm,tracklist,trackIndex);
-      distanceVec.push_back((hitLoc - point).Mag());
-    }
-    auto it_min_element = std::min_element(distanceVec.begin(),distanceVec.end());
-    size_t hitIndex = it_min_element - distanceVec.begin();
-    std::cout << "Closest hit to point: " << std::endl << "\tWireID: "
-              << geoHelper.GetWireNumb(hits[hitIndex])
-              << "\tTime: " << hits[hitIndex]->PeakTime() << std::endl;
+    size_t hitIndex = trackHitTable.GetIndexClosestHitToPoint(point,hits);
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "Closest hit to point: " << "\n\tWireID: "
+                                      << hitCache.GlobalWire(hits[hitIndex])
+                                      << "\tTime: " << hitCache.PeakTime(hits[hitIndex]);
     return hitIndex;
   }
 
   // Get the closest hit to a given point on the given track.
-  art::Ptr<recob::Hit> HitHelper::GetClosestHitToPoint(const TVector3 &point,
-                                                       const artPtrHitVec &hits,
-                                                       art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                                                       const std::vector<art::Ptr<recob::Track>> &tracklist,
-                                                       const size_t &trackIndex) {
-    size_t hitIndex = GetIndexClosestHitToPoint(point, hits, fmthm, tracklist, trackIndex);
+  uint32_t HitHelper::GetClosestHitToPoint(const Point3 &point,
+                                           const hitIndexVec &hits,
+                                           const HitCache &hitCache,
+                                           const TrackHitTable &trackHitTable) {
+    size_t hitIndex = GetIndexClosestHitToPoint(point, hits, hitCache, trackHitTable);
     return hits.at(hitIndex);
   }
 
   // Check if a hit has high electron contribution at a certain distance from the end point
-  bool HitHelper::IsHitMichelLike(const art::Ptr<recob::Hit> &hitp,
-                                  const TVector3 &recoEndPoint,
-                                  art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                                  const std::vector<art::Ptr<recob::Track>> &tracklist,
-                                  const size_t &trackIndex,
-                                  detinfo::DetectorClocksData const& clockData) {
-    for (const sim::TrackIDE &tIDE : bt_serv->HitToTrackIDEs(clockData, *hitp)) {
-      // check if there is a contribution from an electron.
-      if (TMath::Abs(pi_serv->TrackIdToParticle_P(tIDE.trackID)->PdgCode())==11) {
-        TVector3 hitLoc = GetHitXYZ(hitp,fmthm,tracklist,trackIndex);
-        if (hitLoc == TVector3(INV_DBL,INV_DBL,INV_DBL)) continue;
-        if (tIDE.energyFrac>_electronEnergyFractionToCallMichelHits
-            && (hitLoc-recoEndPoint).Mag()<_maxDistanceToCallMichelHits)
-          return true;
-      }
-    }
-    return false;
+  bool HitHelper::IsHitMichelLike(const TruthHitCache &truthCache,
+                                  const TrackHitTable &trackHitTable,
+                                  const uint32_t &hit,
+                                  const Point3 &recoEndPoint) {
+    // check if any electron contributes above the threshold.
+    if (!truthCache.HasElectronAboveFraction(hit,_electronEnergyFractionToCallMichelHits))
+      return false;
+    if (!trackHitTable.HasPosition(hit)) return false;
+    return trackHitTable.GetDistanceToPoint(hit,recoEndPoint)<_maxDistanceToCallMichelHits;
   }
 
   // Get subvector of michel-like hits.
-  artPtrHitVec HitHelper::GetMichelLikeHits(const artPtrHitVec &hits,
-                                            const TVector3 &recoEndPoint,
-                                            art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                                            const std::vector<art::Ptr<recob::Track>> &tracklist,
-                                            const size_t &trackIndex,
-                                            detinfo::DetectorClocksData const & clockData) {
- 
-    std::vector<art::Ptr<recob::Hit>> result;
-    result.clear();
- 
-    for (const art::Ptr<recob::Hit> &hitp : hits) {
-      if (!IsHitMichelLike(hitp,recoEndPoint,fmthm,tracklist,trackIndex,clockData))
+  hitIndexVec HitHelper::GetMichelLikeHits(const TruthHitCache &truthCache,
+                                           const TrackHitTable &trackHitTable,
+                                           const hitIndexVec &hits,
+                                           const Point3 &recoEndPoint) {
+
+    hitIndexVec result;
+
+    for (const uint32_t &hit : hits) {
+      if (!IsHitMichelLike(truthCache,trackHitTable,hit,recoEndPoint))
         continue;
-      result.push_back(hitp);
+      result.push_back(hit);
     }
- 
+
     if (result.size() == 0)
-    std::cout << "HitHelper.cxx: " << "HitHelper::GetMichelLikeHits " << "is returning an empty vector." << std::endl;
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "HitHelper.cxx: " << "HitHelper::GetMichelLikeHits " << "is returning an empty vector.";
     return result;
   }
 
   // Get subvector of muon-like hits.
-  artPtrHitVec HitHelper::GetMuonLikeHits(const artPtrHitVec &hits,
-                                          const TVector3 &recoEndPoint,
-                                          art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                                          const std::vector<art::Ptr<recob::Track>> &tracklist,
-                                          const size_t &trackIndex,
-                                          detinfo::DetectorClocksData const& clockData) {
- 
-    std::vector<art::Ptr<recob::Hit>> result;
-    result.clear();
-  //
-    for (const art::Ptr<recob::Hit> &hitp : hits) {
-      if (IsHitMichelLike(hitp,recoEndPoint,fmthm,tracklist,trackIndex,clockData))
+  hitIndexVec HitHelper::GetMuonLikeHits(const TruthHitCache &truthCache,
+                                         const TrackHitTable &trackHitTable,
+                                         const hitIndexVec &hits,
+                                         const Point3 &recoEndPoint) {
+
+    hitIndexVec result;
+
+    for (const uint32_t &hit : hits) {
+      if (IsHitMichelLike(truthCache,trackHitTable,hit,recoEndPoint))
         continue;
-      result.push_back(hitp);
+      result.push_back(hit);
     }
-  //
+
     if (result.size() == 0)
-      std::cout << "HitHelper.cxx: " << "HitHelper::GetMuonlLikeHits " << "is returning an empty vector." << std::endl;
+      STOPPING_MUON_LOG_DEBUG(kLogHits) << "HitHelper.cxx: " << "HitHelper::GetMuonlLikeHits " << "is returning an empty vector.";
     return result;
-   }
+  }
 
   // Fill the TGraph2D for the images.
   void HitHelper::FillTrackGraph2D(TGraph2D *graph,
-                                   const artPtrHitVec &trackHits,
-                                   const TVector3 &recoEndPoint,
+                                   HitCache &hitCache,
+                                   const TruthHitCache &truthCache,
+                                   const hitIndexVec &trackHits,
+                                   const Point3 &recoEndPoint,
                                    const size_t &planeNumber,
                                    const double &t0,
-                                   detinfo::DetectorClocksData const& clockData,
-                                   detinfo::DetectorPropertiesData const& detProp) {
+                                   const EventContext &context) {
     graph->Set(0);
     const geo::GeometryCore *geom = lar::providerFrom<geo::Geometry>();
     const geo::Point_t EndPoint(recoEndPoint.X(), recoEndPoint.Y(), recoEndPoint.Z());
     geo::TPCID const & tpcid = geom->FindTPCAtPosition(EndPoint);
     if (!tpcid.isValid) {
-      std::cout << "Track End Point is in invalid TPC. Return empty Graph." << std::endl;
+      STOPPING_MUON_LOG_WARNING(kLogHits) << "Track End Point is in invalid TPC. Return empty Graph.";
       return;
     }
-   for (size_t i = 0; i < trackHits.size(); i++) {
-      const art::Ptr<recob::Hit> &hitp = trackHits[i];
-      // Get only hit in the collection plane
-      if (!hitp->WireID().isValid) continue;
-      if (hitp->WireID().Plane != planeNumber) continue;
-      double hitPeakTime = hitp->PeakTime();
-      double tickT0 = t0 / sampling_rate(clockData);
-      double x = detProp.ConvertTicksToX(hitPeakTime-tickT0, hitp->WireID().Plane, hitp->WireID().TPC,hitp->WireID().Cryostat);
-      double electron_perc = 0;
-      for(const sim::TrackIDE& ide : bt_serv->HitToTrackIDEs(clockData,*hitp)) {
-        if (TMath::Abs(pi_serv->TrackIdToParticle_P(ide.trackID)->PdgCode())==11) {//contribution from electron
-          electron_perc += ide.energyFrac;
-          //std::cout << "Electron perc: " << electron_perc << std::endl;
-        }
-      }
-      size_t wireEff = geoHelper.GetWireNumb(hitp);
+    // Get only hit in the collection plane
+    const hitIndexVec &hitsOnPlane = hitCache.GetHitsOnAPlane(planeNumber, trackHits);
+    hitCache.SetDriftX(hitsOnPlane, t0, context);
+    for (size_t i = 0; i < hitsOnPlane.size(); i++) {
+      const uint32_t &hit = hitsOnPlane[i];
+      double x = hitCache.DriftX(hit);
+      //contribution from electron
+      double electron_perc = truthCache.ElectronFraction(hit);
+      size_t wireEff = hitCache.GlobalWire(hit);
       graph->SetPoint(i,wireEff,x,electron_perc);
     }
     return;
@@ -218,7 +146,7 @@ namespace stoppingcosmicmuonselection {
   // Get a TProfile2D filled with hit peak times and wire number
   // void HitHelper::FillTrackHitPicture(TProfile2D* image,
   //                                    const artPtrHitVec &trackHits,
-  //                                    const TVector3 &recoEndPoint,
+  //                                    const Point3 &recoEndPoint,
   //                                    const size_t &planeNumber) {
   //   image->Reset();
   //   const geo::GeometryCore *geom = lar::providerFrom<geo::Geometry>();
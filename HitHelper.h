@@ -9,8 +9,6 @@
 #include "protoduneana/protoduneana/Utilities/ProtoDUNETrackUtils.h"
 #include "protoduneana/protoduneana/Utilities/ProtoDUNEPFParticleUtils.h"
 #include "fhiclcpp/ParameterSet.h"
-#include "larsim/MCCheater/BackTrackerService.h"
-#include "larsim/MCCheater/ParticleInventoryService.h"
 #include "lardataobj/RecoBase/Hit.h"
 #include "lardataobj/RecoBase/Track.h"
 #include "lardataobj/RecoBase/PFParticle.h"
@@ -21,9 +19,6 @@
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Principal/Handle.h"
 #include "canvas/Persistency/Common/FindManyP.h"
-#include "lardata/DetectorInfoServices/DetectorClocksService.h"
-#include "lardata/DetectorInfoServices/DetectorPropertiesService.h"
-#include "TVector3.h"
 #include "TH2D.h"
 #include "TProfile2D.h"
 #include "TMath.h"
@@ -31,6 +26,9 @@
 
 #include "DataTypes.h"
 #include "GeometryHelper.h"
+#include "HitCache.h"
+#include "TruthHitCache.h"
+#include "TrackHitTable.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -40,9 +38,6 @@ namespace stoppingcosmicmuonselection {
     HitHelper();
     ~HitHelper();
 
-    // Get the track index of a track object
-    size_t GetTrackIndex(const recob::Track &track, const std::vector<art::Ptr<recob::Track>> &tracklist);
-
     // Get the vector of art::Ptr to hit for the given track
     const artPtrHitVec GetArtPtrToHitVect(const art::FindManyP<recob::Hit> &fmht,
                                           const size_t &trackIndex);
@@ -51,63 +46,50 @@ namespace stoppingcosmicmuonselection {
     artPtrHitVec GetHitsOnAPlane(const size_t &planeNumb,
                                  const artPtrHitVec &allHits);
 
-    // Get XYZ position for that hit
-    TVector3 GetHitXYZ(const art::Ptr<recob::Hit> &hitp,
-                       art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                       const std::vector<art::Ptr<recob::Track>> &tracklist,
-                       const size_t &trackIndex);
-
     // Get index of the closest hit to a given point on the given track.
-    const size_t GetIndexClosestHitToPoint(const TVector3 &point,
-                                           const artPtrHitVec &hits,
-                                           art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                                           const std::vector<art::Ptr<recob::Track>> &tracklist,
-                                           const size_t &trackIndex);
+    const size_t GetIndexClosestHitToPoint(const Point3 &point,
+                                           const hitIndexVec &hits,
+                                           const HitCache &hitCache,
+                                           const TrackHitTable &trackHitTable);
 
     // Get the closest hit to a given point on the given track.
-    art::Ptr<recob::Hit> GetClosestHitToPoint(const TVector3 &point,
-                                              const artPtrHitVec &hits,
-                                              art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                                              const std::vector<art::Ptr<recob::Track>> &tracklist,
-                                              const size_t &trackIndex);
+    uint32_t GetClosestHitToPoint(const Point3 &point,
+                                  const hitIndexVec &hits,
+                                  const HitCache &hitCache,
+                                  const TrackHitTable &trackHitTable);
 
     // Check if a hit has high electron contribution at a certain distance from the end point
-    bool IsHitMichelLike(const art::Ptr<recob::Hit> &hitp,
-                         const TVector3 &recoEndPoint,
-                         art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                         const std::vector<art::Ptr<recob::Track>> &tracklist,
-                         const size_t &trackIndex,
-                         detinfo::DetectorClocksData const& clockData);
+    bool IsHitMichelLike(const TruthHitCache &truthCache,
+                         const TrackHitTable &trackHitTable,
+                         const uint32_t &hit,
+                         const Point3 &recoEndPoint);
 
     // Get subvector of michel-like hits.
-    artPtrHitVec GetMichelLikeHits(const artPtrHitVec &hits,
-                                   const TVector3 &recoEndPoint,
-                                   art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                                   const std::vector<art::Ptr<recob::Track>> &tracklist,
-                                   const size_t &trackIndex,
-                                   detinfo::DetectorClocksData const& clockData);
+    hitIndexVec GetMichelLikeHits(const TruthHitCache &truthCache,
+                                  const TrackHitTable &trackHitTable,
+                                  const hitIndexVec &hits,
+                                  const Point3 &recoEndPoint);
 
-    // Get subvector of michel-like hits.
-    artPtrHitVec GetMuonLikeHits(const artPtrHitVec &hits,
-                                 const TVector3 &recoEndPoint,
-                                 art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
-                                 const std::vector<art::Ptr<recob::Track>> &tracklist,
-                                 const size_t &trackIndex,
-                                 detinfo::DetectorClocksData const& clockData);
+    // Get subvector of muon-like hits.
+    hitIndexVec GetMuonLikeHits(const TruthHitCache &truthCache,
+                                const TrackHitTable &trackHitTable,
+                                const hitIndexVec &hits,
+                                const Point3 &recoEndPoint);
 
     // Fill the TGraph2D for the images.
     void FillTrackGraph2D(TGraph2D *graph,
-                          const artPtrHitVec &trackHits,
-                          const TVector3 &recoEndPoint,
+                          HitCache &hitCache,
+                          const TruthHitCache &truthCache,
+                          const hitIndexVec &trackHits,
+                          const Point3 &recoEndPoint,
                           const size_t &planeNumber,
                           const double &t0,
-                          detinfo::DetectorClocksData const& clockData,
-                          detinfo::DetectorPropertiesData const& detProp); 
+                          const EventContext &context);
 
     // Get a TProfile2D filled with hit peak times and wire number
     // void FillTrackHitPicture(TProfile2D* image,
     //                          const artPtrHitVec &trackHits,
-    //                          const TVector3 &recoEndPoint,
+    //                          const Point3 &recoEndPoint,
     //                          const size_t &planeNumber);
 
     // Initialise the image for a series of hit for a given plane
@@ -124,11 +106,6 @@ namespace stoppingcosmicmuonselection {
     double _electronEnergyFractionToCallMichelHits;
     double _maxDistanceToCallMichelHits;
 
-    // Declare handle for particle inventory service
-    art::ServiceHandle<cheat::ParticleInventoryService> pi_serv;
-    // Declare handle for backtracker
-    art::ServiceHandle<cheat::BackTrackerService> bt_serv;
-
     // Geometry helper.
     GeometryHelper geoHelper;
 
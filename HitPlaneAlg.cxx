@@ -6,48 +6,69 @@
 #define HIT_PLANE_ALG_CXX
 
 #include "HitPlaneAlg.h"
+#include "Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
-  HitPlaneAlg::HitPlaneAlg(const artPtrHitVec &trackHits,
-                           const size_t &start_index,
-                           const size_t &planeNumber,
-                           const double &t0,
-                           detinfo::DetectorClocksData const& ClockData,
-                           detinfo::DetectorPropertiesData const& Detprop) :
-                           _trackHits(trackHits),
-                           _start_index(start_index),
-                           _planeNumber(planeNumber),
-                           _t0(t0),
-                           clockData(ClockData),
-                           detprop(Detprop) {
-    _hitsOnPlane = hitHelper.GetHitsOnAPlane(_planeNumber,_trackHits);
-    if (DEBUG) std::cout << "HitPlaneAlg.cxx: " << std::endl;
-    if (DEBUG) std::cout << "\tSize of hits on plane before ordering: " << _hitsOnPlane.size() << std::endl;
-    OrderHitVec();
-    if (DEBUG) std::cout << "\tOrdered HitList Size: " << _hitsOnPlane.size()
-              << std::endl << "\tWireID list size: " << _effectiveWireID.size() << std::endl;
-    if (_effectiveWireID.size() != _hitsOnPlane.size())
-      throw cet::exception("HitPlaneAlg.cxx") << "Hit vector and wire ID vector have different size.";
-    //HitSmoother();
+  HitPlaneAlg::HitPlaneAlg() {
+
   }
 
   HitPlaneAlg::~HitPlaneAlg() {
 
   }
 
+  // Order the hits of a track on a plane.
+  const hitIndexVec &HitPlaneAlg::Process(HitCache &hitCache,
+                                          const hitIndexVec &trackHits,
+                                          const size_t &start_index,
+                                          const size_t &planeNumber,
+                                          const double &t0,
+                                          const EventContext &context,
+                                          const TrackHitTable *trackHitTable) {
+    _hitCache = &hitCache;
+    _start_index = start_index;
+    _planeNumber = planeNumber;
+    _t0 = t0;
+    _context = &context;
+    _trackHitTable = trackHitTable;
+    // Keep the capacity of the previous track.
+    _hitPeakTime.clear();
+    _effectiveWireID.clear();
+    _distances.clear();
+    _areHitOrdered = false;
+    _isMichelTagged = false;
+    _isLinearityCalculated = false;
+
+    hitCache.GetHitsOnAPlane(_planeNumber,trackHits,_hitsOnPlane);
+    // Drift X at the track T0, worked out once per hit.
+    hitCache.SetDriftX(_hitsOnPlane,_t0,context);
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "HitPlaneAlg.cxx: " << "\n"
+                                      << "\tSize of hits on plane before ordering: " << _hitsOnPlane.size();
+    STOPPING_MUON_COUNT("HitPlaneAlg::OrderedHits", _hitsOnPlane.size());
+    if (_trackHitTable) OrderHitVecByTrajectory();
+    else OrderHitVec();
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "\tOrdered HitList Size: " << _hitsOnPlane.size()
+                                      << "\n\tWireID list size: " << _effectiveWireID.size();
+    if (_effectiveWireID.size() != _hitsOnPlane.size())
+      throw cet::exception("HitPlaneAlg.cxx") << "Hit vector and wire ID vector have different size.";
+    //HitSmoother();
+    return _hitsOnPlane;
+  }
+
   // Order hits based on their 2D (wire-time) position.
   void HitPlaneAlg::OrderHitVec() {
-    std::cout << "\tOrdering hit vector..." << std::endl;
-    artPtrHitVec newVector;
+    STOPPING_MUON_SCOPED_TIMER("HitPlaneAlg::OrderHitVec");
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "\tOrdering hit vector...";
+    const HitCache &cache = *_hitCache;
+    hitIndexVec &newVector = _hitsScratch;
+    newVector.clear();
     newVector.reserve(_hitsOnPlane.size());
     newVector.push_back(_hitsOnPlane.at(_start_index));
-    const auto &starthit = _hitsOnPlane.at(_start_index);
-    _effectiveWireID.push_back(geoHelper.GetWireNumb(starthit));
+    const uint32_t starthit = _hitsOnPlane.at(_start_index);
+    _effectiveWireID.push_back(cache.GlobalWire(starthit));
     _hitsOnPlane.erase(_hitsOnPlane.begin() + _start_index);
 
-    double tickT0 = _t0 / detinfo::sampling_rate(clockData);
-
     //double maxAllowedDistance = 50;
     int maxWireDistance = 10;
     double slope_threshold = 2;
@@ -61,19 +82,15 @@ namespace stoppingcosmicmuonselection {
       min_dist = DBL_MAX;
       min_index = -1;
 
+      // For previous hit.
+      const double x1 = cache.DriftX(newVector.back());
+      const int wireNumb1 = cache.GlobalWire(newVector.back());
+
       for (size_t i = 0; i < _hitsOnPlane.size(); i++) {
-        // For previous hit.
-        double hitPeakTime = newVector.back()->PeakTime();
-        double x1 = detprop.ConvertTicksToX(hitPeakTime-tickT0, newVector.back()->WireID().Plane, newVector.back()->WireID().TPC,newVector.back()->WireID().Cryostat);
-        size_t wireNumb1 = geoHelper.GetWireNumb(newVector.back());
-        TVector3 pt1(x1,wireNumb1,0);
         // For current hit.
-        double hitPeakTime2 = _hitsOnPlane.at(i)->PeakTime();
-        size_t wireNumb2 = geoHelper.GetWireNumb(_hitsOnPlane.at(i));
-        double x2 = detprop.ConvertTicksToX(hitPeakTime2-tickT0,_hitsOnPlane[i]->WireID().Plane,_hitsOnPlane[i]->WireID().TPC,_hitsOnPlane[i]->WireID().Cryostat);
-        TVector3 pt2(x2,wireNumb2,0);
-        double dist = (pt1-pt2).Mag();
-        int wire_dist = TMath::Abs((int)wireNumb1 - (int)wireNumb2);
+        const double dx = x1 - cache.DriftX(_hitsOnPlane[i]);
+        const int wire_dist = TMath::Abs(wireNumb1 - (int)cache.GlobalWire(_hitsOnPlane[i]));
+        const double dist = std::sqrt(dx*dx + (double)wire_dist*wire_dist);
         if (dist < min_dist) {
           min_index = i;
           min_dist = dist;
@@ -81,40 +98,40 @@ namespace stoppingcosmicmuonselection {
         }
       }
 
-      auto const &hit = _hitsOnPlane.at(min_index);
+      const uint32_t hit = _hitsOnPlane.at(min_index);
+      const size_t wireHit = cache.GlobalWire(hit);
 
-      if (DEBUG) {
-      std::cout << "Numb of hits filled so far: " << newVector.size() << std::endl;
-      std::cout << geoHelper.GetWireNumb(hit) << " " << hit->PeakTime() << std::endl;
-      std::cout << "dist: " << min_dist << " wire dist: " << min_wire_dist << std::endl;
-      }
+      STOPPING_MUON_LOG_DEBUG(kLogHits) << "Numb of hits filled so far: " << newVector.size() << "\n"
+                                        << wireHit << " " << cache.PeakTime(hit) << "\n"
+                                        << "dist: " << min_dist << " wire dist: " << min_wire_dist;
 
       if (min_wire_dist < maxWireDistance)  {
-        //std::cout << geoHelper.GetWireNumb(hit) << " " << hit->PeakTime() << std::endl;
         newVector.push_back(hit);
-        _hitPeakTime.push_back(hit->PeakTime());
-        _effectiveWireID.push_back(geoHelper.GetWireNumb(hit));
+        _hitPeakTime.push_back(cache.PeakTime(hit));
+        _effectiveWireID.push_back(wireHit);
       }
       else if (newVector.size() > 5) {
-        if (DEBUG) std::cout << "\t\tThe hit is too far away." << std::endl;
+        STOPPING_MUON_LOG_DEBUG(kLogHits) << "\t\tThe hit is too far away.";
         // Calculate previous slope.
         auto iter = newVector.end();
-        auto hit_2 = *(--iter);
-        auto hit_1 = *(iter-5);
-        double previous_slope = (hit_2->PeakTime()-hit_1->PeakTime()) / (geoHelper.GetWireNumb(hit_2)-geoHelper.GetWireNumb(hit_1));
-        if (DEBUG) std::cout << "\t\tPrevious slope: " << previous_slope << std::endl;
+        const uint32_t hit_2 = *(--iter);
+        const uint32_t hit_1 = *(iter-5);
+        const size_t wireHit_1 = cache.GlobalWire(hit_1);
+        const size_t wireHit_2 = cache.GlobalWire(hit_2);
+        double previous_slope = (cache.PeakTime(hit_2)-cache.PeakTime(hit_1)) / (wireHit_2-wireHit_1);
+        STOPPING_MUON_LOG_DEBUG(kLogHits) << "\t\tPrevious slope: " << previous_slope;
         // Calculate next slope.
-        double new_slope = ((hit->PeakTime()-hit_2->PeakTime()) / (geoHelper.GetWireNumb(hit)-geoHelper.GetWireNumb(hit_2)));
-        if (DEBUG) std::cout << "\t\tCurrent slope: " << new_slope << std::endl;
+        double new_slope = ((cache.PeakTime(hit)-cache.PeakTime(hit_2)) / (wireHit-wireHit_2));
+        STOPPING_MUON_LOG_DEBUG(kLogHits) << "\t\tCurrent slope: " << new_slope;
         // Check the next hit will be in a consecutive wire
         bool progressive_order = false;
-        if (geoHelper.GetWireNumb(hit_1) < geoHelper.GetWireNumb(hit_2)) {
-          if (geoHelper.GetWireNumb(hit) > geoHelper.GetWireNumb(hit_2)) {
+        if (wireHit_1 < wireHit_2) {
+          if (wireHit > wireHit_2) {
             progressive_order = true;
           }
         }
-        if (geoHelper.GetWireNumb(hit_2) < geoHelper.GetWireNumb(hit_1)) {
-          if (geoHelper.GetWireNumb(hit) < geoHelper.GetWireNumb(hit_2)) {
+        if (wireHit_2 < wireHit_1) {
+          if (wireHit < wireHit_2) {
             progressive_order = true;
           }
         }
@@ -125,10 +142,10 @@ namespace stoppingcosmicmuonselection {
         if (TMath::Abs(new_slope - previous_slope) < slope_threshold &&
             min_wire_dist < maxWireDistance + 100 &&
             progressive_order) {
-          std::cout << "\t\tOk, adding hit." << std::endl;
+          STOPPING_MUON_LOG_DEBUG(kLogHits) << "\t\tOk, adding hit.";
           newVector.push_back(hit);
-          _hitPeakTime.push_back(hit->PeakTime());
-          _effectiveWireID.push_back(geoHelper.GetWireNumb(hit));
+          _hitPeakTime.push_back(cache.PeakTime(hit));
+          _effectiveWireID.push_back(wireHit);
         }
       }
 
@@ -138,7 +155,100 @@ namespace stoppingcosmicmuonselection {
     }
     _areHitOrdered = true;
     std::swap(_hitsOnPlane, newVector);
-    if (DEBUG) std::cout << "\tHit vector ordered. " << "Number of hits: " << _hitsOnPlane.size() << std::endl;
+    _isMichelTagged = false;
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "\tHit vector ordered. " << "Number of hits: " << _hitsOnPlane.size();
+    return;
+  }
+
+  // Order hits based on the trajectory point index of the track.
+  void HitPlaneAlg::OrderHitVecByTrajectory() {
+    STOPPING_MUON_SCOPED_TIMER("HitPlaneAlg::OrderHitVecByTrajectory");
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "\tOrdering hit vector by trajectory index...";
+    const HitCache &cache = *_hitCache;
+    const TrackHitTable &table = *_trackHitTable;
+    const uint32_t starthit = _hitsOnPlane.at(_start_index);
+
+    // Hits without a trajectory point cannot be placed.
+    arenaVector<uint32_t> sortedHits(EventArena::Get().Resource());
+    sortedHits.reserve(_hitsOnPlane.size());
+    for (const uint32_t &hit : _hitsOnPlane) {
+      if (hit == starthit) continue;
+      if (table.HasPosition(hit)) sortedHits.push_back(hit);
+    }
+    std::stable_sort(sortedHits.begin(), sortedHits.end(),
+                     [&table](const uint32_t &a, const uint32_t &b) {
+                       return table.GetTrajectoryIndex(a) < table.GetTrajectoryIndex(b);
+                     });
+    // Walk away from the start hit.
+    if (sortedHits.size() > 1 && table.HasPosition(starthit)) {
+      const int startTraj = table.GetTrajectoryIndex(starthit);
+      if (std::abs(startTraj - table.GetTrajectoryIndex(sortedHits.back())) <
+          std::abs(startTraj - table.GetTrajectoryIndex(sortedHits.front())))
+        std::reverse(sortedHits.begin(), sortedHits.end());
+    }
+
+    // Hits in trajectory order, from the start hit if it has a position. If it has not, the step
+    // from it to chain[0] cannot be measured: chain[0] counts as after a gap, and is dropped if
+    // the next step is a gap too. Its wire-x distance to the start hit is still stored.
+    arenaVector<uint32_t> chain(EventArena::Get().Resource());
+    chain.reserve(sortedHits.size()+1);
+    if (table.HasPosition(starthit)) chain.push_back(starthit);
+    chain.insert(chain.end(), sortedHits.begin(), sortedHits.end());
+
+    // Distance between consecutive hits, and the typical step per trajectory point.
+    // A step is a gap if it is much longer than the typical one for its number of points.
+    const double gapFactor = 10.;
+    arenaVector<double> steps(EventArena::Get().Resource());
+    arenaVector<int> stepPoints(EventArena::Get().Resource());
+    arenaVector<double> stepsPerPoint(EventArena::Get().Resource());
+    steps.reserve(chain.size());
+    stepPoints.reserve(chain.size());
+    stepsPerPoint.reserve(chain.size());
+    for (size_t k = 1; k < chain.size(); k++) {
+      stepPoints.push_back(std::max(std::abs(table.GetTrajectoryIndex(chain[k]) - table.GetTrajectoryIndex(chain[k-1])), 1));
+      steps.push_back(table.GetDistanceToPoint(chain[k],table.GetHitXYZ(chain[k-1])));
+      stepsPerPoint.push_back(steps.back()/stepPoints.back());
+    }
+    double medianStep = 0.;
+    if (!stepsPerPoint.empty()) {
+      std::nth_element(stepsPerPoint.begin(), stepsPerPoint.begin()+stepsPerPoint.size()/2, stepsPerPoint.end());
+      medianStep = stepsPerPoint[stepsPerPoint.size()/2];
+    }
+    // Gap between chain[k-1] and chain[k]. No gap if the typical step is not known.
+    auto isGap = [&](const size_t &k) {
+      return medianStep > 0 && steps[k-1] > gapFactor*medianStep*stepPoints[k-1];
+    };
+
+    hitIndexVec &newVector = _hitsScratch;
+    newVector.clear();
+    newVector.reserve(_hitsOnPlane.size());
+    newVector.push_back(starthit);
+    _effectiveWireID.push_back(cache.GlobalWire(starthit));
+
+    for (size_t k = (chain.size() > sortedHits.size() ? 1 : 0); k < chain.size(); k++) {
+      const uint32_t hit = chain[k];
+      // Skip a hit isolated by a gap on both sides. After a single gap (dead region,
+      // broken track) the following hits are close to each other and are kept.
+      const bool gapBefore = k == 0 || isGap(k);
+      const bool gapAfter = k+1 == chain.size() || isGap(k+1);
+      if (chain.size() > 1 && gapBefore && gapAfter) {
+        STOPPING_MUON_LOG_DEBUG(kLogHits) << "\t\tThe hit is isolated along the trajectory.";
+        continue;
+      }
+      // Distance in the wire-x plane, as for the geometric ordering.
+      const uint32_t previous = newVector.back();
+      const double dx = cache.DriftX(previous) - cache.DriftX(hit);
+      const int wire_dist = TMath::Abs((int)cache.GlobalWire(previous) - (int)cache.GlobalWire(hit));
+      _distances.push_back(std::sqrt(dx*dx + (double)wire_dist*wire_dist));
+      newVector.push_back(hit);
+      _hitPeakTime.push_back(cache.PeakTime(hit));
+      _effectiveWireID.push_back(cache.GlobalWire(hit));
+    }
+
+    _areHitOrdered = true;
+    std::swap(_hitsOnPlane, newVector);
+    _isMichelTagged = false;
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "\tHit vector ordered. " << "Number of hits: " << _hitsOnPlane.size();
     return;
   }
 
@@ -146,27 +256,25 @@ namespace stoppingcosmicmuonselection {
   void HitPlaneAlg::HitSmoother() {
     if (!_areHitOrdered)
       OrderHitVec();
-    std::cout << "\tSmoothing hits..." << std::endl;
-    artPtrHitVec newVector;
-    std::vector<double> newVector_wire;
-    std::vector<double> meanVec;
-    std::vector<double> wireVec;
+    STOPPING_MUON_SCOPED_TIMER("HitPlaneAlg::HitSmoother");
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "\tSmoothing hits...";
+    hitIndexVec &newVector = _hitsScratch;
+    std::vector<double> &newVector_wire = _wireScratch;
+    newVector.clear();
+    newVector_wire.clear();
+    arenaVector<double> meanVec(EventArena::Get().Resource());
     if (_effectiveWireID.size()<=2) return;
     for (const auto &bunch : get_neighbors(_effectiveWireID, 2)) {
-      for (const auto &wire : bunch) {
-        wireVec.push_back(wire);
-      }
-      meanVec.push_back(mean(wireVec));
-      wireVec.clear();
+      meanVec.push_back(mean(bunch));
     }
     newVector.push_back(_hitsOnPlane.at(0));
     newVector.push_back(_hitsOnPlane.at(1));
     newVector_wire.push_back(_effectiveWireID.at(0));
     newVector_wire.push_back(_effectiveWireID.at(1));
-    std::cout << "\t\tGot wire mean..." << std::endl;
-    std::cout << "\t\tWireid size: " << _effectiveWireID.size() << std::endl;
-    std::cout << "\t\thitsOnPlane size: " << _hitsOnPlane.size() << std::endl;
-    std::cout << "\t\tmeanVec size: " << meanVec.size() << std::endl;
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "\t\tGot wire mean...";
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "\t\tWireid size: " << _effectiveWireID.size();
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "\t\thitsOnPlane size: " << _hitsOnPlane.size();
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "\t\tmeanVec size: " << meanVec.size();
 
     for (size_t i = 2; i < meanVec.size()-1; i++) {
       if (std::abs(meanVec.at(i-1) - meanVec.at(i)) < 1        &&
@@ -174,7 +282,7 @@ namespace stoppingcosmicmuonselection {
           std::abs(meanVec.at(i)   - meanVec.at(i+1)) < 1      &&
           _effectiveWireID.at(i) !=  _effectiveWireID.at(i+1) ) {
         //std::cout << "\t\tIn the if" << std::endl;
-        if (_hitsOnPlane.at(i)->Integral() > _hitsOnPlane.at(i+1)->Integral()) {
+        if (_hitCache->Integral(_hitsOnPlane.at(i)) > _hitCache->Integral(_hitsOnPlane.at(i+1))) {
           newVector.push_back(_hitsOnPlane.at(i));
           newVector_wire.push_back(_effectiveWireID.at(i));
         }
@@ -190,15 +298,23 @@ namespace stoppingcosmicmuonselection {
         newVector_wire.push_back(_effectiveWireID.at(i));
       }
     }
-    std::cout << "\tSmoothing ok." << std::endl;
+    STOPPING_MUON_LOG_DEBUG(kLogHits) << "\tSmoothing ok.";
     newVector.push_back(_hitsOnPlane.at(_hitsOnPlane.size()-1));
     newVector_wire.push_back(_effectiveWireID.at(_hitsOnPlane.size()-1));
     std::swap(newVector, _hitsOnPlane);
     std::swap(newVector_wire, _effectiveWireID);
+    _isMichelTagged = false;
   }
 
   // Get the ordered hit vector.
   const artPtrHitVec HitPlaneAlg::GetOrderedHitVec() {
+    if (!_areHitOrdered)
+      OrderHitVec();
+    return _hitCache->GetPtrVec(_hitsOnPlane);
+  }
+
+  // Get the ordered hit indices in the event hit table.
+  const hitIndexVec &HitPlaneAlg::GetOrderedHitIndex() {
     if (!_areHitOrdered)
       OrderHitVec();
     return _hitsOnPlane;
@@ -218,7 +334,7 @@ namespace stoppingcosmicmuonselection {
     std::vector<double> Qs;
     //std::cout << "Calculating hit Qs..." << std::endl;
     for (size_t i = 0; i < _hitsOnPlane.size()-1; i++)
-      Qs.push_back(_hitsOnPlane[i]->Integral());
+      Qs.push_back(_hitCache->Integral(_hitsOnPlane[i]));
     return Qs;
   }
 
@@ -226,29 +342,33 @@ namespace stoppingcosmicmuonselection {
   const std::vector<double> HitPlaneAlg::GetOrderedDqds() {
     if (!_areHitOrdered)
       OrderHitVec();
+    const HitCache &cache = *_hitCache;
     std::vector<double> dQds;
+    dQds.reserve(_hitsOnPlane.size());
     double ds = 1.;
+    const double wirePitch = geoHelper.GetWirePitch(_planeNumber);
     //std::cout << "Calculating dQds..." << std::endl;
     for (size_t i = 0; i < _hitsOnPlane.size()-1; i++) {
-      auto const &hit = _hitsOnPlane[i];
-      auto const &nextHit = _hitsOnPlane[i+1];
-      double XThisPoint = detprop.ConvertTicksToX(hit->PeakTime(),hit->WireID().Plane,hit->WireID().TPC,hit->WireID().Cryostat);
-      double XNextPoint = detprop.ConvertTicksToX(nextHit->PeakTime(),nextHit->WireID().Plane,nextHit->WireID().TPC,nextHit->WireID().Cryostat);
+      const uint32_t hit = _hitsOnPlane[i];
+      const uint32_t nextHit = _hitsOnPlane[i+1];
+      double XThisPoint = _context->TicksToX(cache.PeakTime(hit),cache.Plane(hit),cache.TPC(hit),cache.Cryostat(hit));
+      double XNextPoint = _context->TicksToX(cache.PeakTime(nextHit),cache.Plane(nextHit),cache.TPC(nextHit),cache.Cryostat(nextHit));
 
-      TVector3 thisPoint(_effectiveWireID[i]*geoHelper.GetWirePitch(_planeNumber), XThisPoint, 0);
-      TVector3 nextPoint(_effectiveWireID[i+1]*geoHelper.GetWirePitch(_planeNumber), XNextPoint, 0);
+      Point3 thisPoint{_effectiveWireID[i]*wirePitch, XThisPoint, 0};
+      Point3 nextPoint{_effectiveWireID[i+1]*wirePitch, XNextPoint, 0};
 
       ds = (thisPoint - nextPoint).Mag();
-      dQds.push_back(hit->Integral() / ds);
+      dQds.push_back(cache.Integral(hit) / ds);
     }
     // Need final point.
-    dQds.push_back(_hitsOnPlane.at(_hitsOnPlane.size()-1)->Integral() / ds);
+    dQds.push_back(cache.Integral(_hitsOnPlane.at(_hitsOnPlane.size()-1)) / ds);
     //std::cout << "Dqds vector for this track calculated." << std::endl;
     return dQds;
   }
 
   // Define smoother.
   const std::vector<double> HitPlaneAlg::Smoother(const std::vector<double> &object, const size_t &Nneighbors) {
+    STOPPING_MUON_SCOPED_TIMER("HitPlaneAlg::Smoother");
     std::vector<double> result;
     result.reserve(object.size());
     for (const auto &neighbors : get_neighbors(object,Nneighbors)) {
@@ -260,12 +380,14 @@ namespace stoppingcosmicmuonselection {
 
   // Calculate local linearity.
   const std::vector<double> HitPlaneAlg::CalculateLocalLinearity(const size_t &Nneighbors) {
+    STOPPING_MUON_SCOPED_TIMER("HitPlaneAlg::CalculateLocalLinearity");
     std::vector<double> linearity;
-    std::vector<double> time, wire;
+    std::pmr::memory_resource *arena = EventArena::Get().Resource();
+    arenaVector<double> time(arena), wire(arena);
     for (const auto &hits : get_neighbors(_hitsOnPlane,Nneighbors)) {
       for (const auto &hit : hits) {
-        time.push_back(hit->PeakTime());
-        wire.push_back(geoHelper.GetWireNumb(hit));
+        time.push_back(_hitCache->PeakTime(hit));
+        wire.push_back(_hitCache->GlobalWire(hit));
       }
       double covariance = cov(time,wire);
       double stdevTime = stdev(time);
@@ -280,57 +402,95 @@ namespace stoppingcosmicmuonselection {
     return linearity;
   }
 
-  // Return distances.
+  // Return distances, one per ordered hit after the start hit.
   const std::vector<double> HitPlaneAlg::GetDistances() {
     return _distances;
   }
 
-  // Cut Michel Electrons
-  const artPtrHitVec HitPlaneAlg::GetHitVecNoMichel(const anab::MVAReader<recob::Hit,4> &hitResults, const double &thr, const double &thr_mean) {
+  // Tag the Michel hits in one pass over the ordered hits.
+  const michelTagResult &HitPlaneAlg::TagMichelHits(const CNNScoreTable &cnnScores, const double &thr, const double &thr_mean) {
 
     if (!_areHitOrdered) {
       OrderHitVec();
       HitSmoother();
     }
 
-    artPtrHitVec newVector;
+    // Same thresholds as the last call: nothing changed.
+    if (_isMichelTagged && thr == _michelTagThr && thr_mean == _michelTagThrMean)
+      return _michelTag;
+
+    _michelTag.Reset();
+    _michelTag.cutIndex = _hitsOnPlane.size();
+    bool isCut = false;
+    double sumScore = 0., maxScore = -DBL_MAX;
 
     // Define alias for short.
-    const artPtrHitVec &hits = _hitsOnPlane;
+    const hitIndexVec &hits = _hitsOnPlane;
 
     for (size_t i = 0; i < hits.size(); i++) {
 
-      const double &score = cnnHelper.GetHitMichelScore(hitResults,hits[i]);
-      // Store the hit and continue if the score is below threshold.
+      const double score = cnnScores.MichelScore(hits[i]);
+      sumScore += score;
+      if (score > maxScore) maxScore = score;
+      if (score > thr) _michelTag.nHitsAboveThr++;
+      if (isCut) continue;
+
+      // Keep the hit and continue if the score is below threshold.
       if (score <= thr) {
-        newVector.push_back(hits[i]);
+        _michelTag.nHitsNoMichel++;
         continue;
       }
 
-      std::vector<double> scoreNextFive;
+      // Mean score of the next five hits.
+      double sumNextFive = 0.;
+      size_t nNextFive = 0;
       for (size_t j = i+1; (j<=i+5) && (j<hits.size()); j++) {
-        const double &score2 = cnnHelper.GetHitMichelScore(hitResults,hits[j]);
-        scoreNextFive.push_back(score2);
+        sumNextFive += cnnScores.MichelScore(hits[j]);
+        nNextFive++;
       }
 
-      if (mean(scoreNextFive) > thr_mean)
-        return newVector;
+      if (nNextFive > 0 && sumNextFive/nNextFive > thr_mean) {
+        _michelTag.cutIndex = i;
+        isCut = true;
+      }
+    }
+
+    _michelTag.hasMichel = _michelTag.nHitsNoMichel != hits.size();
+    if (hits.size() > 0) {
+      _michelTag.meanScore = sumScore / hits.size();
+      _michelTag.maxScore = maxScore;
+    }
+
+    _isMichelTagged = true;
+    _michelTagThr = thr;
+    _michelTagThrMean = thr_mean;
+    return _michelTag;
+  }
+
+  // Cut Michel Electrons (indices in the event hit table).
+  const hitIndexVec HitPlaneAlg::GetHitIndexNoMichel(const CNNScoreTable &cnnScores, const double &thr, const double &thr_mean) {
 
+    const michelTagResult &tag = TagMichelHits(cnnScores,thr,thr_mean);
+
+    hitIndexVec newVector;
+    newVector.reserve(tag.nHitsNoMichel);
+    for (size_t i = 0; i < tag.cutIndex; i++) {
+      if (cnnScores.MichelScore(_hitsOnPlane[i]) <= thr)
+        newVector.push_back(_hitsOnPlane[i]);
     }
 
     return newVector;
 
   }
 
-  // Check if there are michel hits.
-  bool HitPlaneAlg::AreThereMichelHits(const anab::MVAReader<recob::Hit,4> &hitResults, const double &thr, const double &thr_mean) {
-
-    const artPtrHitVec hitsNoMichel = GetHitVecNoMichel(hitResults,thr,thr_mean);
+  // Cut Michel Electrons
+  const artPtrHitVec HitPlaneAlg::GetHitVecNoMichel(const CNNScoreTable &cnnScores, const double &thr, const double &thr_mean) {
+    return _hitCache->GetPtrVec(GetHitIndexNoMichel(cnnScores,thr,thr_mean));
+  }
 
-    if (hitsNoMichel.size() == _hitsOnPlane.size())
-      return false;
-    else
-      return true;
+  // Check if there are michel hits.
+  bool HitPlaneAlg::AreThereMichelHits(const CNNScoreTable &cnnScores, const double &thr, const double &thr_mean) {
+    return TagMichelHits(cnnScores,thr,thr_mean).hasMichel;
   }
 
 } // end of namespace stoppingcosmicmuonselection
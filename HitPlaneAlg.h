@@ -1,20 +1,23 @@
 /***
   Class containing useful algorithms for hit on a plane.
+  Create it once per module and call Process for each track: the buffers
+  are kept from one track to the next.
 
 */
 #ifndef HIT_PLANE_ALG_H
 #define HIT_PLANE_ALG_H
 
-#include "TVector3.h"
 #include "TMath.h"
 #include "TGraphErrors.h"
-#include "lardata/DetectorInfoServices/DetectorClocksService.h"
-#include "lardata/DetectorInfoServices/DetectorPropertiesService.h"
 
 #include "DataTypes.h"
+#include "EventContext.h"
+#include "Instrumentation.h"
 #include "HitHelper.h"
+#include "HitCache.h"
+#include "TrackHitTable.h"
 #include "GeometryHelper.h"
-#include "CNNHelper.h"
+#include "CNNScoreTable.h"
 #include "Tools.h"
 
 namespace stoppingcosmicmuonselection {
@@ -22,18 +25,29 @@ namespace stoppingcosmicmuonselection {
   class HitPlaneAlg {
 
   public:
-    HitPlaneAlg(const artPtrHitVec &trackHits, const size_t &start_index, const size_t &planeNumber, const double &_t0, detinfo::DetectorClocksData const &ClockData, detinfo::DetectorPropertiesData const &Detprop);
+    HitPlaneAlg();
     ~HitPlaneAlg();
 
+    // Order the hits of a track on a plane. If a track hit table is given, the hits
+    // are ordered by trajectory point index. Returns the ordered hit indices, valid
+    // until the next call. The other getters refer to the same track.
+    const hitIndexVec &Process(HitCache &hitCache, const hitIndexVec &trackHits, const size_t &start_index, const size_t &planeNumber, const double &t0, const EventContext &context, const TrackHitTable *trackHitTable = 0x0);
+
     // Order hits based on their 2D (wire-time) position.
     void OrderHitVec();
 
+    // Order hits based on the trajectory point index of the track.
+    void OrderHitVecByTrajectory();
+
     // Smooth hits.
     void HitSmoother();
 
     // Get the ordered hit vector.
     const artPtrHitVec GetOrderedHitVec();
 
+    // Get the ordered hit indices in the event hit table.
+    const hitIndexVec &GetOrderedHitIndex();
+
     // Get the ordered wire number.
     const std::vector<double> GetOrderedWireNumb();
 
@@ -49,38 +63,49 @@ namespace stoppingcosmicmuonselection {
     // Calculate local linearity.
     const std::vector<double> CalculateLocalLinearity(const size_t &Nneighbors);
 
-    // Return distances.
+    // Return distances, one per ordered hit after the start hit (to the previous one). The geometric
+    // ordering keeps all the hits of the plane, the trajectory ordering drops the hits without a
+    // trajectory point and the isolated ones, so there are fewer entries.
     const std::vector<double> GetDistances();
 
+    // Tag the Michel hits in one pass over the ordered hits.
+    const michelTagResult &TagMichelHits(const CNNScoreTable &cnnScores, const double &thr, const double &thr_mean);
+
+    // Cut Michel Electrons (indices in the event hit table).
+    const hitIndexVec GetHitIndexNoMichel(const CNNScoreTable &cnnScores, const double &thr, const double &thr_mean);
+
     // Cut Michel Electrons
-    const artPtrHitVec GetHitVecNoMichel(const anab::MVAReader<recob::Hit,4> &hitResults, const double &thr, const double &thr_mean);
+    const artPtrHitVec GetHitVecNoMichel(const CNNScoreTable &cnnScores, const double &thr, const double &thr_mean);
 
     // Check if there are michel hits.
-    bool AreThereMichelHits(const anab::MVAReader<recob::Hit,4> &hitResults, const double &thr, const double &thr_mean);
+    bool AreThereMichelHits(const CNNScoreTable &cnnScores, const double &thr, const double &thr_mean);
 
   private:
-    const artPtrHitVec &_trackHits;
-    const size_t &_start_index;
-    const size_t &_planeNumber;
-    const double &_t0;
-
-    detinfo::DetectorClocksData const &clockData;
-    detinfo::DetectorPropertiesData const &detprop;
-
-    artPtrHitVec _hitsOnPlane;
+    // Inputs of the current track.
+    HitCache *_hitCache = 0x0;
+    size_t _start_index = 0;
+    size_t _planeNumber = 0;
+    double _t0 = 0.;
+    const TrackHitTable *_trackHitTable = 0x0;
+    const EventContext *_context = 0x0;
+
+    hitIndexVec _hitsOnPlane;
     std::vector<double> _hitPeakTime;
     std::vector<double> _effectiveWireID;
     std::vector<double> _distances;
+    // Scratch buffers for the ordering and the smoothing, swapped with the above.
+    hitIndexVec _hitsScratch;
+    std::vector<double> _wireScratch;
 
     bool _areHitOrdered = false;
+    // Last Michel tagging and its thresholds.
+    michelTagResult _michelTag;
+    bool _isMichelTagged = false;
+    double _michelTagThr = INV_DBL, _michelTagThrMean = INV_DBL;
     bool _isLinearityCalculated = false;
 
     // Helpers.
     GeometryHelper geoHelper;
-    HitHelper      hitHelper;
-    CNNHelper      cnnHelper;
-
-    const bool DEBUG = false;
   };
 }
 
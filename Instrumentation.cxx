@@ -0,0 +1,137 @@
+/***
+  Class containing scoped timers and counters for the hot paths of the
+  selection and calorimetry chain.
+
+*/
+#ifndef INSTRUMENTATION_CXX
+#define INSTRUMENTATION_CXX
+
+#include <iomanip>
+#include <sstream>
+
+#include "Instrumentation.h"
+#include "Logging.h"
+
+namespace stoppingcosmicmuonselection {
+
+  InstrumentationStage::InstrumentationStage(const std::string &name) :
+    _name(name), _nCalls(0), _totalTime(0), _count(0) {
+    for (auto &bin : _timeBins) bin = 0;
+  }
+
+  InstrumentationStage::~InstrumentationStage() {
+
+  }
+
+  // Bin of a duration: below 4 ns one bin per ns, then four bins per power of two.
+  size_t InstrumentationStage::GetTimeBin(const uint64_t &ns) {
+    if (ns < 4) return ns;
+    const size_t exponent = 63 - __builtin_clzll(ns);
+    const size_t mantissa = (ns >> (exponent-2)) & 3;
+    return 4*(exponent-1) + mantissa;
+  }
+
+  // Lowest duration of a bin.
+  double InstrumentationStage::GetTimeBinLowEdge(const size_t &bin) {
+    if (bin < 4) return bin;
+    const size_t exponent = bin/4 + 1;
+    return double(4 + bin%4) * double(uint64_t(1) << (exponent-2));
+  }
+
+  // Add the duration of one call.
+  void InstrumentationStage::AddTime(const uint64_t &ns) {
+    _nCalls++;
+    _totalTime += ns;
+    _timeBins[GetTimeBin(ns)]++;
+  }
+
+  // Approximate percentile of the call durations, in ns.
+  double InstrumentationStage::GetPercentile(const double &fraction) const {
+    const uint64_t nCalls = _nCalls;
+    if (nCalls == 0) return 0.;
+    const double target = fraction*nCalls;
+    uint64_t cumulative = 0;
+    for (size_t bin = 0; bin < NUMB_TIME_BINS; bin++) {
+      const uint64_t content = _timeBins[bin];
+      if (content == 0 || cumulative + content < target) {
+        cumulative += content;
+        continue;
+      }
+      // Interpolate inside the bin.
+      const double low = GetTimeBinLowEdge(bin);
+      const double high = (bin+1 < NUMB_TIME_BINS) ? GetTimeBinLowEdge(bin+1) : low;
+      return low + (high-low)*(target-cumulative)/content;
+    }
+    return GetTimeBinLowEdge(NUMB_TIME_BINS-1);
+  }
+
+  Instrumentation &Instrumentation::Get() {
+    static Instrumentation instrumentation;
+    return instrumentation;
+  }
+
+  // Get a stage, created on first use.
+  InstrumentationStage *Instrumentation::GetStage(const std::string &name) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unique_ptr<InstrumentationStage> &stage = _stages[name];
+    if (!stage) stage.reset(new InstrumentationStage(name));
+    return stage.get();
+  }
+
+  // Print the totals, percentiles and counts of every stage. Only the first call of the job prints.
+  void Instrumentation::Print() {
+    // Every module prints in its endJob: the first one has all the stages already.
+    if (_isPrinted.exchange(true)) return;
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::ostringstream table;
+    table << "Instrumentation.cxx: time per stage (ms) and counters" << std::endl;
+    table << std::left << std::setw(45) << "stage" << std::right
+          << std::setw(12) << "calls" << std::setw(12) << "total"
+          << std::setw(12) << "p50" << std::setw(12) << "p90" << std::setw(12) << "p99"
+          << std::setw(14) << "count" << std::endl;
+    for (auto const &el : _stages) {
+      const InstrumentationStage &stage = *el.second;
+      table << std::left << std::setw(45) << stage.GetName() << std::right
+            << std::setw(12) << stage.GetNumbCalls()
+            << std::setw(12) << stage.GetTotalTime()*1e-6
+            << std::setw(12) << stage.GetPercentile(0.5)*1e-6
+            << std::setw(12) << stage.GetPercentile(0.9)*1e-6
+            << std::setw(12) << stage.GetPercentile(0.99)*1e-6
+            << std::setw(14) << stage.GetCount() << std::endl;
+    }
+    STOPPING_MUON_LOG_INFO(kLogInstrumentation) << table.str();
+  }
+
+  // Write one entry per stage.
+  void Instrumentation::Write(TTree *tree) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::string name;
+    ULong64_t nCalls, count;
+    double totalTime, meanTime, p50, p90, p99;
+    tree->Branch("stage", &name);
+    tree->Branch("nCalls", &nCalls, "nCalls/l");
+    tree->Branch("totalTime", &totalTime, "totalTime/D");
+    tree->Branch("meanTime", &meanTime, "meanTime/D");
+    tree->Branch("p50", &p50, "p50/D");
+    tree->Branch("p90", &p90, "p90/D");
+    tree->Branch("p99", &p99, "p99/D");
+    tree->Branch("count", &count, "count/l");
+    for (auto const &el : _stages) {
+      const InstrumentationStage &stage = *el.second;
+      // Times in ms.
+      name = stage.GetName();
+      nCalls = stage.GetNumbCalls();
+      totalTime = stage.GetTotalTime()*1e-6;
+      meanTime = nCalls > 0 ? totalTime/nCalls : 0.;
+      p50 = stage.GetPercentile(0.5)*1e-6;
+      p90 = stage.GetPercentile(0.9)*1e-6;
+      p99 = stage.GetPercentile(0.99)*1e-6;
+      count = stage.GetCount();
+      tree->Fill();
+    }
+    tree->ResetBranchAddresses();
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
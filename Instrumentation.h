@@ -0,0 +1,131 @@
+/***
+  Class containing scoped timers and counters for the hot paths of the
+  selection and calorimetry chain. They are only compiled in when
+  STOPPING_MUON_INSTRUMENTATION is defined (cmake option of the same
+  name): otherwise the macros below expand to nothing.
+
+*/
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "TTree.h"
+
+namespace stoppingcosmicmuonselection {
+
+  // Statistics of one instrumented stage. Safe to fill from many threads.
+  class InstrumentationStage {
+
+  public:
+    explicit InstrumentationStage(const std::string &name);
+    ~InstrumentationStage();
+
+    // Add the duration of one call.
+    void AddTime(const uint64_t &ns);
+
+    // Add to the counter of the stage.
+    void AddCount(const uint64_t &n) { _count += n; }
+
+    // Approximate percentile of the call durations, in ns.
+    double GetPercentile(const double &fraction) const;
+
+    const std::string &GetName() const { return _name; }
+    uint64_t GetNumbCalls() const { return _nCalls; }
+    uint64_t GetTotalTime() const { return _totalTime; }
+    uint64_t GetCount() const { return _count; }
+
+  private:
+    // Four bins per power of two: the percentiles are good to about 20%.
+    static constexpr size_t NUMB_TIME_BINS = 256;
+    static size_t GetTimeBin(const uint64_t &ns);
+    static double GetTimeBinLowEdge(const size_t &bin);
+
+    std::string _name;
+    std::atomic<uint64_t> _nCalls;
+    std::atomic<uint64_t> _totalTime;
+    std::atomic<uint64_t> _count;
+    std::array<std::atomic<uint64_t>,NUMB_TIME_BINS> _timeBins;
+
+  };
+
+  // Process-wide list of the stages.
+  class Instrumentation {
+
+  public:
+    // Check if the timers and counters are compiled in.
+    static constexpr bool IsEnabled() {
+#ifdef STOPPING_MUON_INSTRUMENTATION
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    static Instrumentation &Get();
+
+    // Get a stage, created on first use. The pointer stays valid until the end of the job.
+    InstrumentationStage *GetStage(const std::string &name);
+
+    // Print the totals, percentiles and counts of every stage. Only the first call of the job prints.
+    void Print();
+
+    // Check if the caller is the first one to write the stages: they go in one tree per job.
+    bool ClaimWrite() { return !_isWriteClaimed.exchange(true); }
+
+    // Write one entry per stage.
+    void Write(TTree *tree) const;
+
+  private:
+    Instrumentation() : _isPrinted(false), _isWriteClaimed(false) {}
+
+    std::atomic<bool> _isPrinted;
+    std::atomic<bool> _isWriteClaimed;
+    mutable std::mutex _mutex;
+    std::map<std::string,std::unique_ptr<InstrumentationStage>> _stages;
+
+  };
+
+  // Add the time spent in a scope to a stage.
+  class ScopedTimer {
+
+  public:
+    explicit ScopedTimer(InstrumentationStage *stage) :
+      _stage(stage), _start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+      _stage->AddTime(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-_start).count());
+    }
+
+    ScopedTimer(ScopedTimer const &) = delete;
+    ScopedTimer & operator = (ScopedTimer const &) = delete;
+
+  private:
+    InstrumentationStage *_stage;
+    std::chrono::steady_clock::time_point _start;
+
+  };
+}
+
+#ifdef STOPPING_MUON_INSTRUMENTATION
+#define STOPPING_MUON_CONCAT_IMPL(a,b) a##b
+#define STOPPING_MUON_CONCAT(a,b) STOPPING_MUON_CONCAT_IMPL(a,b)
+// Time the rest of the scope. The name must not change at a given call site.
+#define STOPPING_MUON_SCOPED_TIMER(name) \
+  static stoppingcosmicmuonselection::InstrumentationStage *STOPPING_MUON_CONCAT(_instrumentationStage,__LINE__) = \
+    stoppingcosmicmuonselection::Instrumentation::Get().GetStage(name); \
+  stoppingcosmicmuonselection::ScopedTimer STOPPING_MUON_CONCAT(_instrumentationTimer,__LINE__)(STOPPING_MUON_CONCAT(_instrumentationStage,__LINE__))
+// Add to a counter. The stage is looked up on every call: keep it out of the per-hit loops.
+#define STOPPING_MUON_COUNT(name,n) \
+  stoppingcosmicmuonselection::Instrumentation::Get().GetStage(name)->AddCount(n)
+#else
+#define STOPPING_MUON_SCOPED_TIMER(name) do {} while (0)
+#define STOPPING_MUON_COUNT(name,n) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,198 @@
+/***
+  Class containing the in-job measurement of the electron lifetime.
+
+*/
+#ifndef LIFETIME_ESTIMATOR_CXX
+#define LIFETIME_ESTIMATOR_CXX
+
+#include <algorithm>
+#include <cmath>
+#include "cetlib_except/exception.h"
+
+#include "LifetimeEstimator.h"
+#include "Instrumentation.h"
+#include "Logging.h"
+
+namespace stoppingcosmicmuonselection {
+
+  LifetimeEstimator::LifetimeEstimator() {
+  }
+
+  LifetimeEstimator::~LifetimeEstimator() {
+  }
+
+  // Read parameters from FHICL file
+  void LifetimeEstimator::reconfigure(fhicl::ParameterSet const &p) {
+    const std::string windowType = p.get<std::string>("windowType", "run");
+    if (windowType != "run" && windowType != "time")
+      throw cet::exception("LifetimeEstimator.cxx") << "Unknown window type " << windowType << ", use run or time.";
+    _isRunWindow = (windowType == "run");
+    _windowLength = p.get<double>("windowLength", 3600.);
+    _maxOpenWindows = p.get<size_t>("maxOpenWindows", 2);
+    _nBinsDriftTime = p.get<size_t>("nBinsDriftTime", 20);
+    _minDriftTime = p.get<double>("minDriftTime", 50.);
+    _maxDriftTime = p.get<double>("maxDriftTime", 2200.);
+    _truncLow = p.get<double>("truncLow", 0.05);
+    _truncHigh = p.get<double>("truncHigh", 0.6);
+    _minHitsPerBin = p.get<double>("minHitsPerBin", 100.);
+    _minBinsFit = p.get<size_t>("minBinsFit", 5);
+    _minResRange = p.get<double>("minResRange", 60.);
+    _useYZCorrection = p.get<bool>("useYZCorrection", true);
+    _compression = p.get<double>("compression", 50.);
+    if (_maxOpenWindows == 0 || _nBinsDriftTime == 0 || _maxDriftTime <= _minDriftTime || _truncHigh <= _truncLow)
+      throw cet::exception("LifetimeEstimator.cxx") << "Invalid window, drift time binning or truncation.";
+  }
+
+  // Create the branches of the lifetime tree. Windows are written as they close.
+  void LifetimeEstimator::Book(TTree *tree) {
+    _tree = tree;
+    _tree->Branch("run", &_treeRun, "run/i");
+    _tree->Branch("windowStart", &_treeStartTime, "windowStart/D");
+    _tree->Branch("windowEnd", &_treeEndTime, "windowEnd/D");
+    _tree->Branch("nHits", &_treeNHits, "nHits/l");
+    _tree->Branch("lifetime", &_measurement.lifetime, "lifetime/D");
+    _tree->Branch("lifetimeError", &_measurement.lifetimeError, "lifetimeError/D");
+    _tree->Branch("attenuation", &_measurement.attenuation, "attenuation/D");
+    _tree->Branch("attenuationError", &_measurement.attenuationError, "attenuationError/D");
+    _tree->Branch("chi2", &_measurement.chi2, "chi2/D");
+    _tree->Branch("ndf", &_measurement.ndf, "ndf/I");
+    _tree->Branch("binDriftTimes", &_measurement.binDriftTimes);
+    _tree->Branch("binTruncatedMeans", &_measurement.binTruncatedMeans);
+  }
+
+  // Key of the window of an event.
+  long LifetimeEstimator::GetWindowKey(const unsigned int &run, const double &eventTime) const {
+    if (_isRunWindow) return run;
+    return (long)std::floor(eventTime/_windowLength);
+  }
+
+  // Add the hits of a cathode crosser. yzFactors are applied if useYZCorrection.
+  void LifetimeEstimator::Fill(const unsigned int &run, const double &eventTime,
+                               const std::vector<double> &hit_xs, const std::vector<double> &dQdx, const std::vector<double> &resRange,
+                               const std::vector<double> &yzFactors, const EventContext &context) {
+    STOPPING_MUON_SCOPED_TIMER("LifetimeEstimator::Fill");
+    const long key = GetWindowKey(run, eventTime);
+    auto it = _windows.find(key);
+    if (it == _windows.end()) {
+      // Close the least recently used window to keep the memory fixed.
+      if (_windows.size() >= _maxOpenWindows)
+        Close(std::min_element(_windows.begin(), _windows.end(),
+                               [](const std::pair<const long,lifetimeWindow> &a, const std::pair<const long,lifetimeWindow> &b) {
+                                 return a.second.lastUsed < b.second.lastUsed; }));
+      // Events out of order, the window is written twice.
+      if (_closedKeys.count(key))
+        STOPPING_MUON_LOG_WARNING(kLogCalorimetry) << "LifetimeEstimator.cxx: window " << key << " (run " << run
+                                                   << ") reopened after being closed, increase maxOpenWindows.";
+      it = _windows.emplace(key, lifetimeWindow()).first;
+      it->second.run = run;
+      it->second.startTime = eventTime;
+      it->second.endTime = eventTime;
+      it->second.driftTimeBins.assign(_nBinsDriftTime, QuantileDigest(_compression));
+    }
+    lifetimeWindow &window = it->second;
+    window.lastUsed = ++_nFills;
+    window.startTime = std::min(window.startTime, eventTime);
+    window.endTime = std::max(window.endTime, eventTime);
+
+    // Same drift time as the lifetime correction of CalibrationHelper.
+    const double vDrift = context.DriftVelocity()*1e3; //cm/us
+    const double xAnode = context.XAnode();
+    const size_t nHits = std::min({hit_xs.size(), dQdx.size(), resRange.size()});
+    for (size_t i = 0; i < nHits; i++) {
+      if (hit_xs[i] == INV_DBL || dQdx[i] <= 0 || resRange[i] < _minResRange) continue;
+      double value = dQdx[i];
+      if (_useYZCorrection) {
+        if (i >= yzFactors.size() || yzFactors[i] == INV_DBL) continue;
+        value *= yzFactors[i];
+      }
+      const double driftTime = (xAnode - std::abs(hit_xs[i])) / vDrift;
+      if (driftTime < _minDriftTime || driftTime >= _maxDriftTime) continue;
+      const size_t bin = std::min((size_t)((driftTime-_minDriftTime)/(_maxDriftTime-_minDriftTime)*_nBinsDriftTime), _nBinsDriftTime-1);
+      window.driftTimeBins[bin].Add(value);
+      window.nHits++;
+    }
+  }
+
+  // Fit the exponential to the truncated means of a window.
+  void LifetimeEstimator::Fit(lifetimeWindow &window, lifetimeMeasurement &measurement) {
+    measurement.Reset();
+    // Straight line fit of log(truncated mean) versus drift time.
+    double sumW = 0., sumT = 0., sumY = 0., sumTT = 0., sumTY = 0.;
+    std::vector<double> logMeans, sigmas;
+    const double binWidth = (_maxDriftTime-_minDriftTime)/_nBinsDriftTime;
+    for (size_t bin = 0; bin < _nBinsDriftTime; bin++) {
+      QuantileDigest &digest = window.driftTimeBins[bin];
+      if (digest.GetTotalWeight() < _minHitsPerBin) continue;
+      const double truncatedMean = digest.TruncatedMean(_truncLow, _truncHigh);
+      if (truncatedMean <= 0) continue;
+      // Relative error of the truncated mean, from the winsorized variance (the cuts move with the sample).
+      const double rms = digest.TruncatedRMS(_truncLow, _truncHigh);
+      const double qLow = digest.Quantile(_truncLow);
+      const double qHigh = digest.Quantile(_truncHigh);
+      const double keptFraction = _truncHigh - _truncLow;
+      const double winsorizedMean = keptFraction*truncatedMean + _truncLow*qLow + (1.-_truncHigh)*qHigh;
+      const double winsorizedMean2 = keptFraction*(rms*rms + truncatedMean*truncatedMean) + _truncLow*qLow*qLow + (1.-_truncHigh)*qHigh*qHigh;
+      const double winsorizedVariance = std::max(winsorizedMean2 - winsorizedMean*winsorizedMean, 0.);
+      const double sigma = std::max(std::sqrt(winsorizedVariance/digest.GetTotalWeight()) / keptFraction / truncatedMean, 1e-6);
+      const double t = _minDriftTime + (bin+0.5)*binWidth;
+      const double y = std::log(truncatedMean);
+      const double w = 1./(sigma*sigma);
+      sumW += w;
+      sumT += w*t;
+      sumY += w*y;
+      sumTT += w*t*t;
+      sumTY += w*t*y;
+      measurement.binDriftTimes.push_back(t);
+      measurement.binTruncatedMeans.push_back(truncatedMean);
+      logMeans.push_back(y);
+      sigmas.push_back(sigma);
+    }
+    const size_t nPoints = measurement.binDriftTimes.size();
+    const double det = sumW*sumTT - sumT*sumT;
+    if (nPoints < std::max(_minBinsFit, (size_t)3) || det <= 0) return;
+
+    const double slope = (sumW*sumTY - sumT*sumY) / det;
+    const double intercept = (sumTT*sumY - sumT*sumTY) / det;
+    double chi2 = 0.;
+    for (size_t i = 0; i < nPoints; i++) {
+      const double residual = (logMeans[i] - intercept - slope*measurement.binDriftTimes[i]) / sigmas[i];
+      chi2 += residual*residual;
+    }
+    measurement.attenuation = -slope;
+    measurement.attenuationError = std::sqrt(sumW/det);
+    measurement.chi2 = chi2;
+    measurement.ndf = nPoints - 2;
+    // No lifetime if the charge does not decrease with the drift time.
+    if (slope < 0) {
+      measurement.lifetime = -1./slope;
+      measurement.lifetimeError = measurement.attenuationError/(slope*slope);
+    }
+  }
+
+  // Fit, write and forget a window.
+  void LifetimeEstimator::Close(std::map<long,lifetimeWindow>::iterator it) {
+    lifetimeWindow &window = it->second;
+    Fit(window, _measurement);
+    STOPPING_MUON_LOG_INFO(kLogCalorimetry) << "LifetimeEstimator.cxx: run " << window.run << ", times " << std::fixed
+                                            << window.startTime << "-" << window.endTime << ": " << window.nHits << " hits, lifetime "
+                                            << _measurement.lifetime << " +- " << _measurement.lifetimeError << " us, chi2/ndf "
+                                            << _measurement.chi2 << "/" << _measurement.ndf;
+    if (_tree) {
+      _treeRun = window.run;
+      _treeStartTime = window.startTime;
+      _treeEndTime = window.endTime;
+      _treeNHits = window.nHits;
+      _tree->Fill();
+    }
+    _closedKeys.insert(it->first);
+    _windows.erase(it);
+  }
+
+  // Fit and write all the open windows.
+  void LifetimeEstimator::CloseAll() {
+    while (!_windows.empty()) Close(_windows.begin());
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
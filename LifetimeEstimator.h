@@ -0,0 +1,118 @@
+/***
+  Class containing the in-job measurement of the electron lifetime.
+  The dQ/dx of the hits of cathode crossers (known T0) is accumulated in
+  drift time bins, one set of bins per time window (run or time slice).
+  When a window closes, an exponential is fitted to the truncated mean
+  dQ/dx versus drift time and the lifetime is written to a tree.
+  Each bin is a QuantileDigest, so the memory of a window is fixed.
+
+*/
+#ifndef LIFETIME_ESTIMATOR_H
+#define LIFETIME_ESTIMATOR_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "fhiclcpp/ParameterSet.h"
+#include "TTree.h"
+
+#include "Constants.h"
+#include "EventContext.h"
+#include "QuantileDigest.h"
+
+namespace stoppingcosmicmuonselection {
+
+  // Hits of one time window.
+  struct lifetimeWindow {
+    unsigned int run = 0;          // first run of the window
+    double startTime = INV_DBL;    // first event time (s)
+    double endTime = INV_DBL;      // last event time (s)
+    size_t nHits = 0;
+    uint64_t lastUsed = 0;         // fill counter at the last use
+    std::vector<QuantileDigest> driftTimeBins;
+  };
+
+  // Lifetime fitted in one time window.
+  struct lifetimeMeasurement {
+    double lifetime = INV_DBL;       // us
+    double lifetimeError = INV_DBL;  // us
+    double attenuation = INV_DBL;       // 1/lifetime, 1/us
+    double attenuationError = INV_DBL;  // 1/us
+    double chi2 = INV_DBL;
+    int ndf = INV_INT;
+    std::vector<double> binDriftTimes;    // us
+    std::vector<double> binTruncatedMeans;
+
+    void Reset() {
+      lifetime = INV_DBL;
+      lifetimeError = INV_DBL;
+      attenuation = INV_DBL;
+      attenuationError = INV_DBL;
+      chi2 = INV_DBL;
+      ndf = INV_INT;
+      binDriftTimes.clear();
+      binTruncatedMeans.clear();
+    }
+  };
+
+  class LifetimeEstimator {
+
+  public:
+    LifetimeEstimator();
+    ~LifetimeEstimator();
+
+    // Read parameters from FHICL file
+    void reconfigure(fhicl::ParameterSet const &p);
+
+    // Create the branches of the lifetime tree. Windows are written as they close.
+    void Book(TTree *tree);
+
+    // Add the hits of a cathode crosser. yzFactors are applied if useYZCorrection.
+    void Fill(const unsigned int &run, const double &eventTime,
+              const std::vector<double> &hit_xs, const std::vector<double> &dQdx, const std::vector<double> &resRange,
+              const std::vector<double> &yzFactors, const EventContext &context);
+
+    // Fit and write all the open windows.
+    void CloseAll();
+
+  private:
+    // Parameters
+    bool _isRunWindow;
+    double _windowLength;
+    size_t _maxOpenWindows;
+    size_t _nBinsDriftTime;
+    double _minDriftTime, _maxDriftTime;
+    double _truncLow, _truncHigh;
+    double _minHitsPerBin;
+    size_t _minBinsFit;
+    double _minResRange;
+    bool _useYZCorrection;
+    double _compression;
+
+    // Open windows, by run or time slice.
+    std::map<long,lifetimeWindow> _windows;
+    uint64_t _nFills = 0;
+    // Keys of the closed windows, to report the reopened ones.
+    std::set<long> _closedKeys;
+
+    // Output
+    TTree *_tree = 0x0;
+    unsigned int _treeRun;
+    double _treeStartTime, _treeEndTime;
+    uint64_t _treeNHits;
+    lifetimeMeasurement _measurement;
+
+    // Key of the window of an event.
+    long GetWindowKey(const unsigned int &run, const double &eventTime) const;
+
+    // Fit the exponential to the truncated means of a window.
+    void Fit(lifetimeWindow &window, lifetimeMeasurement &measurement);
+
+    // Fit, write and forget a window.
+    void Close(std::map<long,lifetimeWindow>::iterator it);
+  };
+}
+
+#endif
@@ -0,0 +1,94 @@
+/***
+  Class containing the leveled logging of the package, routed through messagefacility.
+
+*/
+#ifndef LOGGING_CXX
+#define LOGGING_CXX
+
+#include "cetlib_except/exception.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include "Logging.h"
+
+namespace stoppingcosmicmuonselection {
+
+  namespace {
+
+    logLevel get_log_level(const std::string &name) {
+      if (name == "debug")   return kLogDebug;
+      if (name == "info")    return kLogInfo;
+      if (name == "warning") return kLogWarning;
+      if (name == "error")   return kLogError;
+      if (name == "none")    return kLogNone;
+      throw cet::exception("Logging.cxx") << "Unknown log level " << name << ".";
+    }
+
+  }
+
+  Logger::Logger() : _maxMessagesPerSite(0), _isConfigured(false) {
+    for (auto &level : _levels) level = kLogInfo;
+  }
+
+  Logger &Logger::Get() {
+    static Logger logger;
+    return logger;
+  }
+
+  // Name of a subsystem (messagefacility category and FHiCL key).
+  const char *Logger::GetSubsystemName(const logSubsystem &subsystem) {
+    switch (subsystem) {
+      case kLogSelection:       return "Selection";
+      case kLogHits:            return "Hits";
+      case kLogCalorimetry:     return "Calorimetry";
+      case kLogGeometry:        return "Geometry";
+      case kLogSpacePoints:     return "SpacePoints";
+      case kLogTruth:           return "Truth";
+      case kLogCNN:             return "CNN";
+      case kLogTools:           return "Tools";
+      case kLogInstrumentation: return "Instrumentation";
+      case kLogModules:         return "Modules";
+      default:                  return "StoppingMuonSelection";
+    }
+  }
+
+  // Rate limit of a call site.
+  bool Logger::AcceptSite(const logSubsystem &subsystem, const char *file, const int &line) {
+    unsigned int nMessages = 0;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      nMessages = ++_messagesPerSite[std::make_pair(file,line)];
+    }
+    if (nMessages == _maxMessagesPerSite + 1)
+      mf::LogWarning(GetSubsystemName(subsystem)) << "Further messages from " << file << ":" << line << " are suppressed.";
+    return nMessages <= _maxMessagesPerSite;
+  }
+
+  // Set the levels, once per job.
+  void Logger::reconfigure(fhicl::ParameterSet const &p) {
+    // Modules without a Logging table leave the configuration to the others.
+    if (p.is_empty()) return;
+    if (_isConfigured) {
+      if (p.id() != _configurationID)
+        mf::LogWarning(GetSubsystemName(kLogModules)) << "Logging already configured by another module: ignoring a different Logging table.";
+      return;
+    }
+    _isConfigured = true;
+    _configurationID = p.id();
+    const std::string defaultLevel = p.get<std::string>("default", "info");
+    for (size_t subsystem = 0; subsystem < kNumbLogSubsystems; subsystem++)
+      _levels[subsystem] = get_log_level(p.get<std::string>(GetSubsystemName(logSubsystem(subsystem)), defaultLevel));
+    _maxMessagesPerSite = p.get<unsigned int>("maxMessagesPerSite", 0);
+  }
+
+  LogMessage::~LogMessage() {
+    const char *category = Logger::GetSubsystemName(_subsystem);
+    switch (_level) {
+      case kLogError:   mf::LogError(category) << _stream.str(); break;
+      case kLogWarning: mf::LogWarning(category) << _stream.str(); break;
+      default:          mf::LogVerbatim(category) << _stream.str(); break;
+    }
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
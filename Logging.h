@@ -0,0 +1,129 @@
+/***
+  Class containing the leveled logging of the package, routed through messagefacility.
+  Each subsystem has its own level, set from FHiCL. Messages below
+  STOPPING_MUON_LOG_MIN_LEVEL (cmake cache variable of the same name) are
+  removed at compile time, the others cost one check when their level is off.
+  Each call site prints at most maxMessagesPerSite messages.
+
+*/
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetID.h"
+
+#ifndef STOPPING_MUON_LOG_MIN_LEVEL
+#define STOPPING_MUON_LOG_MIN_LEVEL 0
+#endif
+
+namespace stoppingcosmicmuonselection {
+
+  enum logLevel {
+    kLogDebug = 0,
+    kLogInfo,
+    kLogWarning,
+    kLogError,
+    kLogNone
+  };
+
+  // Each subsystem is a messagefacility category.
+  enum logSubsystem {
+    kLogSelection = 0,    // StoppingMuonSelectionAlg
+    kLogHits,             // HitHelper, HitCache, HitPlaneAlg, TrackHitTable
+    kLogCalorimetry,      // CalorimetryHelper, CalibrationHelper, FixCalo, SceHelper
+    kLogGeometry,         // GeometryHelper
+    kLogSpacePoints,      // SpacePointAlg
+    kLogTruth,            // TruthHitCache, TruthMatchTable
+    kLogCNN,              // CNNHelper
+    kLogTools,            // Tools
+    kLogInstrumentation,  // Instrumentation
+    kLogModules,          // art modules
+    kNumbLogSubsystems
+  };
+
+  class Logger {
+
+  public:
+    static Logger &Get();
+
+    // Check if a message is printed. Counts the messages of the call site.
+    bool Accept(const logLevel &level, const logSubsystem &subsystem, const char *file, const int &line) {
+      if (level < _levels[subsystem]) return false;
+      return (_maxMessagesPerSite == 0) || AcceptSite(subsystem, file, line);
+    }
+
+    // Name of a subsystem (messagefacility category and FHiCL key).
+    static const char *GetSubsystemName(const logSubsystem &subsystem);
+
+    // Set the levels. Keys: default, one per subsystem, maxMessagesPerSite.
+    // The logger is shared by the modules: the first non-empty parameter set
+    // configures it, a different one from a later module is ignored.
+    void reconfigure(fhicl::ParameterSet const &p);
+
+  private:
+    Logger();
+
+    // Rate limit of a call site.
+    bool AcceptSite(const logSubsystem &subsystem, const char *file, const int &line);
+
+    std::array<std::atomic<int>,kNumbLogSubsystems> _levels;
+    std::atomic<unsigned int> _maxMessagesPerSite;
+    bool _isConfigured;
+    fhicl::ParameterSetID _configurationID;
+    std::mutex _mutex;
+    std::map<std::pair<const char*,int>,unsigned int> _messagesPerSite;
+
+  };
+
+  // One message, sent to messagefacility when it goes out of scope.
+  class LogMessage {
+
+  public:
+    LogMessage(const logLevel &level, const logSubsystem &subsystem) :
+      _level(level), _subsystem(subsystem) {}
+    ~LogMessage();
+
+    template <class T>
+    LogMessage &operator<<(const T &value) {
+      _stream << value;
+      return *this;
+    }
+
+    // Manipulators such as std::setprecision.
+    LogMessage &operator<<(std::ostream &(*manipulator)(std::ostream &)) {
+      _stream << manipulator;
+      return *this;
+    }
+
+  private:
+    logLevel _level;
+    logSubsystem _subsystem;
+    std::ostringstream _stream;
+
+  };
+
+  // Turns the message into void, so that the macro is a single expression.
+  struct LogMessageVoidify {
+    void operator&(const LogMessage &) {}
+  };
+}
+
+// A single expression: safe in an unbraced if/else. The stream is not
+// evaluated when the message is not printed.
+#define STOPPING_MUON_LOG(level,subsystem) \
+  !((level) >= STOPPING_MUON_LOG_MIN_LEVEL \
+    && stoppingcosmicmuonselection::Logger::Get().Accept((level),(subsystem),__FILE__,__LINE__)) ? (void)0 \
+  : stoppingcosmicmuonselection::LogMessageVoidify() & stoppingcosmicmuonselection::LogMessage((level),(subsystem))
+
+#define STOPPING_MUON_LOG_DEBUG(subsystem) STOPPING_MUON_LOG(stoppingcosmicmuonselection::kLogDebug,subsystem)
+#define STOPPING_MUON_LOG_INFO(subsystem) STOPPING_MUON_LOG(stoppingcosmicmuonselection::kLogInfo,subsystem)
+#define STOPPING_MUON_LOG_WARNING(subsystem) STOPPING_MUON_LOG(stoppingcosmicmuonselection::kLogWarning,subsystem)
+#define STOPPING_MUON_LOG_ERROR(subsystem) STOPPING_MUON_LOG(stoppingcosmicmuonselection::kLogError,subsystem)
+
+#endif
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////
+// Program:     fit_modbox
+// File:        fit_modbox.cc
+//
+// Merge the modified box cells written by ModBoxFitter in several jobs
+// and fit alpha, beta and the calibration constant, without art. The
+// cells are plain sums, so the merged fit is the one of a single job
+// running on all the inputs.
+////////////////////////////////////////////////////////////////////////
+#include "cetlib/filepath_maker.h"
+#include "cetlib_except/exception.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/make_ParameterSet.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "protoduneana/StoppingMuonSelection/ModBoxFitter.h"
+
+using namespace stoppingcosmicmuonselection;
+
+namespace {
+
+  void print_usage() {
+    std::cout << "Usage: fit_modbox -c <config.fcl> <modbox.root> [<modbox.root> ...]" << std::endl;
+  }
+
+}
+
+int main(int argc, char **argv) {
+
+  // Read the command line.
+  std::string configFile;
+  std::vector<std::string> inputFiles;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      print_usage();
+      return 0;
+    }
+    if (arg == "-c" && i+1 < argc)
+      configFile = argv[++i];
+    else
+      inputFiles.push_back(arg);
+  }
+  if (configFile.empty() || inputFiles.empty()) {
+    print_usage();
+    return 1;
+  }
+
+  try {
+    // Read the configuration.
+    fhicl::ParameterSet pset;
+    cet::filepath_lookup maker("FHICL_FILE_PATH");
+    fhicl::make_ParameterSet(configFile, maker, pset);
+    const fhicl::ParameterSet p = pset.get<fhicl::ParameterSet>("fitModBox");
+
+    ModBoxFitter fitter;
+    fitter.reconfigure(p.get<fhicl::ParameterSet>("ModBoxFitter"));
+    for (auto const &inputFile : inputFiles)
+      fitter.Read(inputFile);
+    const modBoxFitResult &result = fitter.Fit();
+    std::cout << "Merged " << inputFiles.size() << " files, " << fitter.GetNumbHits() << " hits." << std::endl;
+    std::cout << "alpha:       " << result.alpha << " +- " << result.alphaError << std::endl;
+    std::cout << "beta:        " << result.beta << " +- " << result.betaError << " (kV/cm)(g/cm2)/MeV" << std::endl;
+    std::cout << "calibConst:  " << result.calibConst << " +- " << result.calibConstError << " ADC/e" << std::endl;
+    std::cout << "correlation: " << result.correlationAlphaBeta << std::endl;
+    std::cout << "chi2/ndf:    " << result.chi2 << "/" << result.ndf << (result.converged ? "" : " (not converged)") << std::endl;
+    fitter.Write();
+  }
+  catch (cet::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,434 @@
+/***
+  Class containing the in-job fit of the modified box recombination model.
+
+*/
+#ifndef MOD_BOX_FITTER_CXX
+#define MOD_BOX_FITTER_CXX
+
+#include <cmath>
+#include <limits>
+#include "cetlib_except/exception.h"
+#include "TDirectory.h"
+#include "TFile.h"
+#include "TH2D.h"
+#include "TTree.h"
+
+#include "ModBoxFitter.h"
+
+namespace stoppingcosmicmuonselection {
+
+  namespace {
+    const char *CELL_TREE_NAME = "modBoxCells";
+    const char *FIT_TREE_NAME = "modBoxFit";
+    const char *MPV_HISTO_NAME = "h_modBoxMPV";
+
+    typedef std::array<std::array<double,3>,3> matrix3;
+
+    // Inverse of a symmetric 3x3 matrix. False if singular.
+    bool Invert(const matrix3 &m, matrix3 &inv) {
+      inv[0][0] = m[1][1]*m[2][2] - m[1][2]*m[2][1];
+      inv[0][1] = m[0][2]*m[2][1] - m[0][1]*m[2][2];
+      inv[0][2] = m[0][1]*m[1][2] - m[0][2]*m[1][1];
+      const double det = m[0][0]*inv[0][0] + m[1][0]*inv[0][1] + m[2][0]*inv[0][2];
+      if (!(std::abs(det) > 0)) return false;
+      inv[1][1] = m[0][0]*m[2][2] - m[0][2]*m[2][0];
+      inv[1][2] = m[0][2]*m[1][0] - m[0][0]*m[1][2];
+      inv[2][2] = m[0][0]*m[1][1] - m[0][1]*m[1][0];
+      inv[1][0] = inv[0][1];
+      inv[2][0] = inv[0][2];
+      inv[2][1] = inv[1][2];
+      for (auto &row : inv)
+        for (auto &x : row) x /= det;
+      return true;
+    }
+
+    // Check that the binning of an input file is the one of the fitter.
+    bool IsSameAxis(const unsigned int &nBinsFile, const double &minFile, const double &maxFile,
+                    const size_t &nBins, const double &min, const double &max) {
+      return nBinsFile == nBins && std::abs(minFile-min) < 1e-6 && std::abs(maxFile-max) < 1e-6;
+    }
+  }
+
+  ModBoxFitter::ModBoxFitter() {
+  }
+
+  ModBoxFitter::~ModBoxFitter() {
+  }
+
+  // Read parameters from FHICL file
+  void ModBoxFitter::reconfigure(fhicl::ParameterSet const &p) {
+    _nBinsdEdx = p.get<size_t>("nBinsdEdx", 40);
+    _mindEdx = p.get<double>("mindEdx", 1.5);
+    _maxdEdx = p.get<double>("maxdEdx", 9.5);
+    _nBinsEfield = p.get<size_t>("nBinsEfield", 6);
+    _minEfield = p.get<double>("minEfield", 0.35);
+    _maxEfield = p.get<double>("maxEfield", 0.65);
+    _nBinsdQdx = p.get<size_t>("nBinsdQdx", 300);
+    _mindQdx = p.get<double>("mindQdx", 0.);
+    _maxdQdx = p.get<double>("maxdQdx", 1500.);
+    _minResRange = p.get<double>("minResRange", 1.);
+    _minEntries = p.get<double>("minEntries", 200.);
+    _peakFraction = p.get<double>("peakFraction", 0.5);
+    const std::string dEdxSource = p.get<std::string>("dEdxSource", "LandauVav");
+    if (dEdxSource != "MC" && dEdxSource != "LandauVav")
+      throw cet::exception("ModBoxFitter.cxx") << "Unknown dEdx source " << dEdxSource << ", use MC or LandauVav.";
+    _useMCdEdx = (dEdxSource == "MC");
+    _LArdensity = p.get<double>("LArdensity", 1.383);
+    _Wion = p.get<double>("Wion", 23.6e-6);
+    _initialValues = {p.get<double>("alpha", 0.93), p.get<double>("beta", 0.212), p.get<double>("calibConst", -1.)};
+    _isFixed = {p.get<bool>("fixAlpha", false), p.get<bool>("fixBeta", false), p.get<bool>("fixCalibConst", false)};
+    _maxIterations = p.get<size_t>("maxIterations", 200);
+    _fileName = p.get<std::string>("fileName", "ModBoxFit.root");
+    if (_nBinsdEdx == 0 || _nBinsEfield == 0 || _nBinsdQdx < 3 || _maxdEdx <= _mindEdx || _maxEfield <= _minEfield || _maxdQdx <= _mindQdx)
+      throw cet::exception("ModBoxFitter.cxx") << "Invalid dEdx, field or dQdx binning.";
+    if (_isFixed[2] && _initialValues[2] <= 0)
+      throw cet::exception("ModBoxFitter.cxx") << "A fixed calibConst needs a positive value.";
+
+    modBoxCell empty;
+    empty.dQdxCounts.assign(_nBinsdQdx, 0.);
+    _cells.assign(_nBinsdEdx*_nBinsEfield, empty);
+    _result.Reset();
+  }
+
+  // Index of the bin of a value, INV_SIZE if outside.
+  size_t ModBoxFitter::GetBin(const double &value, const double &min, const double &max, const size_t &nBins) const {
+    if (value < min || value >= max) return INV_SIZE;
+    return std::min((size_t)((value-min)/(max-min)*nBins), nBins-1);
+  }
+
+  // Add the hits of a track. efield in kV/cm.
+  void ModBoxFitter::Fill(const std::vector<double> &dQdx, const std::vector<double> &expecteddEdx,
+                          const std::vector<double> &efield, const std::vector<double> &resRange) {
+    const size_t nHits = std::min({dQdx.size(), expecteddEdx.size(), efield.size(), resRange.size()});
+    for (size_t i = 0; i < nHits; i++) {
+      if (dQdx[i] == INV_DBL || efield[i] == INV_DBL || resRange[i] < _minResRange) continue;
+      const size_t bindEdx = GetBin(expecteddEdx[i], _mindEdx, _maxdEdx, _nBinsdEdx);
+      const size_t binEfield = GetBin(std::abs(efield[i]), _minEfield, _maxEfield, _nBinsEfield);
+      const size_t bindQdx = GetBin(dQdx[i], _mindQdx, _maxdQdx, _nBinsdQdx);
+      if (bindEdx == INV_SIZE || binEfield == INV_SIZE || bindQdx == INV_SIZE) continue;
+      modBoxCell &cell = _cells[bindEdx*_nBinsEfield+binEfield];
+      cell.nHits++;
+      cell.sumdEdx += expecteddEdx[i];
+      cell.sumEfield += std::abs(efield[i]);
+      cell.dQdxCounts[bindQdx]++;
+    }
+  }
+
+  // Most probable dQ/dx of a cell from a parabola fit to the log of the counts around the peak.
+  bool ModBoxFitter::FindMPV(const modBoxCell &cell, double &mpv, double &mpvError) const {
+    const std::vector<double> &counts = cell.dQdxCounts;
+    // Peak of the counts summed over three bins, against the fluctuations.
+    auto smoothed = [&counts](const size_t &k) {
+      return counts[k] + (k > 0 ? counts[k-1] : 0.) + (k+1 < counts.size() ? counts[k+1] : 0.);
+    };
+    size_t peak = 0;
+    for (size_t k = 1; k < counts.size(); k++)
+      if (smoothed(k) > smoothed(peak)) peak = k;
+    const double threshold = _peakFraction*smoothed(peak);
+    size_t first = peak, last = peak;
+    while (first > 0 && smoothed(first-1) >= threshold) first--;
+    while (last+1 < counts.size() && smoothed(last+1) >= threshold) last++;
+
+    // Weighted fit of log(counts) = a0 + a1 u + a2 u^2, u in bins from the peak. Var(log n) = 1/n.
+    matrix3 m = {};
+    std::array<double,3> v = {};
+    size_t nUsed = 0;
+    for (size_t k = first; k <= last; k++) {
+      if (counts[k] <= 0) continue;
+      const double u = (double)k - (double)peak;
+      const std::array<double,3> powers = {1., u, u*u};
+      const double y = std::log(counts[k]);
+      for (size_t a = 0; a < 3; a++) {
+        v[a] += counts[k]*powers[a]*y;
+        for (size_t b = 0; b < 3; b++) m[a][b] += counts[k]*powers[a]*powers[b];
+      }
+      nUsed++;
+    }
+    matrix3 cov;
+    if (nUsed < 3 || !Invert(m, cov)) return false;
+    std::array<double,3> a = {};
+    for (size_t i = 0; i < 3; i++)
+      for (size_t j = 0; j < 3; j++) a[i] += cov[i][j]*v[j];
+    // Not a peak, or a peak outside the fitted bins.
+    if (a[2] >= 0) return false;
+    const double uPeak = -a[1]/(2.*a[2]);
+    if (uPeak < (double)first-(double)peak-0.5 || uPeak > (double)last-(double)peak+0.5) return false;
+
+    const double binWidth = (_maxdQdx-_mindQdx)/_nBinsdQdx;
+    const std::array<double,3> jacobian = {0., -1./(2.*a[2]), a[1]/(2.*a[2]*a[2])};
+    double variance = 0.;
+    for (size_t i = 0; i < 3; i++)
+      for (size_t j = 0; j < 3; j++) variance += jacobian[i]*cov[i][j]*jacobian[j];
+    mpv = _mindQdx + (peak+0.5+uPeak)*binWidth;
+    mpvError = std::sqrt(std::max(variance, 0.))*binWidth;
+    return mpvError > 0;
+  }
+
+  // Model and its derivatives with respect to alpha, beta and calibConst.
+  double ModBoxFitter::Model(const std::array<double,3> &par, const double &dEdx, const double &efield, std::array<double,3> *gradient) const {
+    const double &alpha = par[0], &beta = par[1], &calibConst = par[2];
+    const double rhoE = _LArdensity*efield;
+    const double arg = alpha + beta*dEdx/rhoE;
+    if (beta <= 0 || arg <= 0) return INV_DBL;
+    const double logArg = std::log(arg);
+    const double value = calibConst/_Wion * rhoE * logArg/beta;
+    if (gradient) {
+      (*gradient)[0] = calibConst/_Wion * rhoE/(beta*arg);
+      (*gradient)[1] = calibConst/_Wion * rhoE * (dEdx/(rhoE*beta*arg) - logArg/(beta*beta));
+      (*gradient)[2] = value/calibConst;
+    }
+    return value;
+  }
+
+  // Chi2 of the points for some parameters.
+  double ModBoxFitter::Chi2(const std::array<double,3> &par) const {
+    double chi2 = 0.;
+    for (size_t i = 0; i < _pointMPV.size(); i++) {
+      const double model = Model(par, _pointdEdx[i], _pointEfield[i]);
+      if (model == INV_DBL) return std::numeric_limits<double>::max();
+      const double residual = (_pointMPV[i] - model)/_pointMPVError[i];
+      chi2 += residual*residual;
+    }
+    return chi2;
+  }
+
+  // Fit the model to the most probable dQ/dx of the cells.
+  const modBoxFitResult &ModBoxFitter::Fit() {
+    _result.Reset();
+    _pointdEdx.clear();
+    _pointEfield.clear();
+    _pointMPV.clear();
+    _pointMPVError.clear();
+    _pointCell.clear();
+    for (size_t c = 0; c < _cells.size(); c++) {
+      const modBoxCell &cell = _cells[c];
+      if (cell.nHits < _minEntries) continue;
+      double mpv, mpvError;
+      if (!FindMPV(cell, mpv, mpvError)) continue;
+      _pointdEdx.push_back(cell.sumdEdx/cell.nHits);
+      _pointEfield.push_back(cell.sumEfield/cell.nHits);
+      _pointMPV.push_back(mpv);
+      _pointMPVError.push_back(mpvError);
+      _pointCell.push_back(c);
+    }
+    const size_t nFree = std::count(_isFixed.begin(), _isFixed.end(), false);
+    const size_t nPoints = _pointMPV.size();
+    if (nPoints <= nFree) return _result;
+
+    // Calibration constant from the data if not given: weighted mean of MPV/model with C = 1.
+    std::array<double,3> par = _initialValues;
+    if (par[2] <= 0) {
+      par[2] = 1.;
+      double sumW = 0., sumWR = 0.;
+      for (size_t i = 0; i < nPoints; i++) {
+        const double model = Model(par, _pointdEdx[i], _pointEfield[i]);
+        if (model == INV_DBL || model <= 0) continue;
+        const double ratioError = _pointMPVError[i]/model;
+        sumW += 1./(ratioError*ratioError);
+        sumWR += _pointMPV[i]/model/(ratioError*ratioError);
+      }
+      if (sumW <= 0) return _result;
+      par[2] = sumWR/sumW;
+    }
+
+    // Levenberg-Marquardt. The fixed parameters have a unit row in the curvature and no gradient.
+    double chi2 = Chi2(par);
+    double lambda = 1e-3;
+    matrix3 curvature, cov;
+    for (size_t iteration = 0; iteration < _maxIterations; iteration++) {
+      matrix3 m = {};
+      std::array<double,3> g = {};
+      for (size_t i = 0; i < nPoints; i++) {
+        std::array<double,3> gradient;
+        const double model = Model(par, _pointdEdx[i], _pointEfield[i], &gradient);
+        const double w = 1./(_pointMPVError[i]*_pointMPVError[i]);
+        for (size_t a = 0; a < 3; a++) {
+          if (_isFixed[a]) continue;
+          g[a] += w*gradient[a]*(_pointMPV[i]-model);
+          for (size_t b = 0; b < 3; b++)
+            if (!_isFixed[b]) m[a][b] += w*gradient[a]*gradient[b];
+        }
+      }
+      for (size_t a = 0; a < 3; a++)
+        if (_isFixed[a]) m[a][a] = 1.;
+      curvature = m;
+
+      // Shrink the step until the chi2 decreases.
+      bool improved = false;
+      double newChi2 = chi2;
+      while (lambda < 1e10) {
+        matrix3 damped = m;
+        for (size_t a = 0; a < 3; a++) damped[a][a] *= 1.+lambda;
+        matrix3 inv;
+        if (!Invert(damped, inv)) break;
+        std::array<double,3> trial = par;
+        for (size_t a = 0; a < 3; a++)
+          for (size_t b = 0; b < 3; b++) trial[a] += inv[a][b]*g[b];
+        newChi2 = Chi2(trial);
+        if (newChi2 <= chi2) {
+          par = trial;
+          lambda = std::max(lambda/10., 1e-9);
+          improved = true;
+          break;
+        }
+        lambda *= 10.;
+      }
+      if (!improved) {
+        // No better point close by: a minimum if the gradient is small.
+        _result.converged = lambda >= 1e10;
+        break;
+      }
+      const double change = chi2 - newChi2;
+      chi2 = newChi2;
+      if (change < 1e-8*std::max(chi2, 1.)) {
+        _result.converged = true;
+        break;
+      }
+    }
+
+    // Errors from the curvature at the minimum.
+    if (!Invert(curvature, cov)) {
+      _result.converged = false;
+      return _result;
+    }
+    std::array<double,3> errors;
+    for (size_t a = 0; a < 3; a++)
+      errors[a] = _isFixed[a] ? 0. : std::sqrt(std::max(cov[a][a], 0.));
+    _result.alpha = par[0];
+    _result.alphaError = errors[0];
+    _result.beta = par[1];
+    _result.betaError = errors[1];
+    _result.calibConst = par[2];
+    _result.calibConstError = errors[2];
+    _result.correlationAlphaBeta = (errors[0] > 0 && errors[1] > 0) ? cov[0][1]/(errors[0]*errors[1]) : 0.;
+    _result.chi2 = chi2;
+    _result.ndf = nPoints - nFree;
+    return _result;
+  }
+
+  // Write the cells, the most probable dQ/dx and the fit result to the output file.
+  void ModBoxFitter::Write() {
+    // Keep the current directory (the TFileService one in an art job).
+    TDirectory::TContext directoryContext;
+    TFile file(_fileName.c_str(), "RECREATE");
+    if (file.IsZombie())
+      throw cet::exception("ModBoxFitter.cxx") << "Cannot create " << _fileName << ".";
+
+    int bindEdx, binEfield;
+    modBoxCell cell;
+    TTree *cellTree = new TTree(CELL_TREE_NAME, "hits per cell of expected dE/dx and field");
+    cellTree->Branch("bindEdx", &bindEdx);
+    cellTree->Branch("binEfield", &binEfield);
+    cellTree->Branch("nHits", &cell.nHits);
+    cellTree->Branch("sumdEdx", &cell.sumdEdx);
+    cellTree->Branch("sumEfield", &cell.sumEfield);
+    cellTree->Branch("dQdxCounts", &cell.dQdxCounts);
+    for (size_t c = 0; c < _cells.size(); c++) {
+      if (_cells[c].nHits == 0) continue;
+      cell = _cells[c];
+      bindEdx = c/_nBinsEfield;
+      binEfield = c%_nBinsEfield;
+      cellTree->Fill();
+    }
+
+    // Binning, to check the inputs of a merge, and the fit with its points.
+    unsigned int nBinsdEdx = _nBinsdEdx, nBinsEfield = _nBinsEfield, nBinsdQdx = _nBinsdQdx;
+    TTree *fitTree = new TTree(FIT_TREE_NAME, "modified box fit");
+    fitTree->Branch("nBinsdEdx", &nBinsdEdx, "nBinsdEdx/i");
+    fitTree->Branch("mindEdx", &_mindEdx, "mindEdx/D");
+    fitTree->Branch("maxdEdx", &_maxdEdx, "maxdEdx/D");
+    fitTree->Branch("nBinsEfield", &nBinsEfield, "nBinsEfield/i");
+    fitTree->Branch("minEfield", &_minEfield, "minEfield/D");
+    fitTree->Branch("maxEfield", &_maxEfield, "maxEfield/D");
+    fitTree->Branch("nBinsdQdx", &nBinsdQdx, "nBinsdQdx/i");
+    fitTree->Branch("mindQdx", &_mindQdx, "mindQdx/D");
+    fitTree->Branch("maxdQdx", &_maxdQdx, "maxdQdx/D");
+    fitTree->Branch("alpha", &_result.alpha, "alpha/D");
+    fitTree->Branch("alphaError", &_result.alphaError, "alphaError/D");
+    fitTree->Branch("beta", &_result.beta, "beta/D");
+    fitTree->Branch("betaError", &_result.betaError, "betaError/D");
+    fitTree->Branch("calibConst", &_result.calibConst, "calibConst/D");
+    fitTree->Branch("calibConstError", &_result.calibConstError, "calibConstError/D");
+    fitTree->Branch("correlationAlphaBeta", &_result.correlationAlphaBeta, "correlationAlphaBeta/D");
+    fitTree->Branch("chi2", &_result.chi2, "chi2/D");
+    fitTree->Branch("ndf", &_result.ndf, "ndf/I");
+    fitTree->Branch("converged", &_result.converged, "converged/O");
+    fitTree->Branch("pointdEdx", &_pointdEdx);
+    fitTree->Branch("pointEfield", &_pointEfield);
+    fitTree->Branch("pointMPV", &_pointMPV);
+    fitTree->Branch("pointMPVError", &_pointMPVError);
+    fitTree->Fill();
+
+    TH2D *h_mpv = new TH2D(MPV_HISTO_NAME, "most probable dQ/dx;expected dE/dx (MeV/cm);E field (kV/cm)",
+                           _nBinsdEdx, _mindEdx, _maxdEdx, _nBinsEfield, _minEfield, _maxEfield);
+    for (size_t i = 0; i < _pointCell.size(); i++) {
+      h_mpv->SetBinContent(_pointCell[i]/_nBinsEfield+1, _pointCell[i]%_nBinsEfield+1, _pointMPV[i]);
+      h_mpv->SetBinError(_pointCell[i]/_nBinsEfield+1, _pointCell[i]%_nBinsEfield+1, _pointMPVError[i]);
+    }
+    file.Write();
+    file.Close();
+  }
+
+  // Add the cells stored in a file written by Write.
+  void ModBoxFitter::Read(const std::string &filename) {
+    TDirectory::TContext directoryContext;
+    TFile file(filename.c_str());
+    if (file.IsZombie())
+      throw cet::exception("ModBoxFitter.cxx") << "Cannot open " << filename << ".";
+
+    // The cells are only meaningful with the same binning.
+    TTree *fitTree = (TTree*)file.Get(FIT_TREE_NAME);
+    if (!fitTree || fitTree->GetEntries() == 0)
+      throw cet::exception("ModBoxFitter.cxx") << filename << " has no " << FIT_TREE_NAME << " tree.";
+    unsigned int nBinsdEdx, nBinsEfield, nBinsdQdx;
+    double mindEdx, maxdEdx, minEfield, maxEfield, mindQdx, maxdQdx;
+    fitTree->SetBranchAddress("nBinsdEdx", &nBinsdEdx);
+    fitTree->SetBranchAddress("mindEdx", &mindEdx);
+    fitTree->SetBranchAddress("maxdEdx", &maxdEdx);
+    fitTree->SetBranchAddress("nBinsEfield", &nBinsEfield);
+    fitTree->SetBranchAddress("minEfield", &minEfield);
+    fitTree->SetBranchAddress("maxEfield", &maxEfield);
+    fitTree->SetBranchAddress("nBinsdQdx", &nBinsdQdx);
+    fitTree->SetBranchAddress("mindQdx", &mindQdx);
+    fitTree->SetBranchAddress("maxdQdx", &maxdQdx);
+    fitTree->GetEntry(0);
+    if (!IsSameAxis(nBinsdEdx, mindEdx, maxdEdx, _nBinsdEdx, _mindEdx, _maxdEdx) ||
+        !IsSameAxis(nBinsEfield, minEfield, maxEfield, _nBinsEfield, _minEfield, _maxEfield) ||
+        !IsSameAxis(nBinsdQdx, mindQdx, maxdQdx, _nBinsdQdx, _mindQdx, _maxdQdx))
+      throw cet::exception("ModBoxFitter.cxx") << filename << ": binning differs from the configuration.";
+
+    TTree *cellTree = (TTree*)file.Get(CELL_TREE_NAME);
+    if (!cellTree)
+      throw cet::exception("ModBoxFitter.cxx") << filename << " has no " << CELL_TREE_NAME << " tree.";
+    int bindEdx, binEfield;
+    double nHits, sumdEdx, sumEfield;
+    std::vector<double> *dQdxCounts = 0x0;
+    cellTree->SetBranchAddress("bindEdx", &bindEdx);
+    cellTree->SetBranchAddress("binEfield", &binEfield);
+    cellTree->SetBranchAddress("nHits", &nHits);
+    cellTree->SetBranchAddress("sumdEdx", &sumdEdx);
+    cellTree->SetBranchAddress("sumEfield", &sumEfield);
+    cellTree->SetBranchAddress("dQdxCounts", &dQdxCounts);
+    for (Long64_t entry = 0; entry < cellTree->GetEntries(); entry++) {
+      cellTree->GetEntry(entry);
+      if (bindEdx < 0 || (size_t)bindEdx >= _nBinsdEdx || binEfield < 0 || (size_t)binEfield >= _nBinsEfield || dQdxCounts->size() != _nBinsdQdx)
+        throw cet::exception("ModBoxFitter.cxx") << filename << ": cell " << bindEdx << ", " << binEfield << " out of range.";
+      modBoxCell &cell = _cells[bindEdx*_nBinsEfield+binEfield];
+      cell.nHits += nHits;
+      cell.sumdEdx += sumdEdx;
+      cell.sumEfield += sumEfield;
+      for (size_t k = 0; k < _nBinsdQdx; k++) cell.dQdxCounts[k] += (*dQdxCounts)[k];
+    }
+    delete dQdxCounts;
+  }
+
+  // Get the number of hits in the cells.
+  double ModBoxFitter::GetNumbHits() const {
+    double nHits = 0.;
+    for (auto const &cell : _cells) nHits += cell.nHits;
+    return nHits;
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
@@ -0,0 +1,139 @@
+/***
+  Class containing the in-job fit of the modified box recombination model.
+  The calibrated dQ/dx of the hits is accumulated in cells of expected
+  dE/dx and local electric field: each cell keeps the number of hits, the
+  sums of dE/dx and field, and a histogram of dQ/dx. These are plain sums,
+  so the cells of several jobs are merged by adding them (see
+  ModBoxFit/fit_modbox.cc). At the end, the most probable dQ/dx of each
+  cell is found from its histogram and
+    dQ/dx = C/W ln(alpha + beta' dE/dx)/beta',  beta' = beta/(rho E)
+  is fitted for alpha, beta and the calibration constant C (ADC/e).
+  It only depends on ROOT and FHiCL.
+
+*/
+#ifndef MOD_BOX_FITTER_H
+#define MOD_BOX_FITTER_H
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+#include "fhiclcpp/ParameterSet.h"
+
+#include "Constants.h"
+
+namespace stoppingcosmicmuonselection {
+
+  // Hits of one cell of expected dE/dx and field.
+  struct modBoxCell {
+    double nHits = 0.;
+    double sumdEdx = 0.;     // MeV/cm
+    double sumEfield = 0.;   // kV/cm
+    std::vector<double> dQdxCounts;
+
+    void Reset() {
+      nHits = 0.;
+      sumdEdx = 0.;
+      sumEfield = 0.;
+      std::fill(dQdxCounts.begin(), dQdxCounts.end(), 0.);
+    }
+  };
+
+  // Parameters of the modified box model fitted to the cells.
+  struct modBoxFitResult {
+    double alpha = INV_DBL;
+    double alphaError = INV_DBL;
+    double beta = INV_DBL;             // (kV/cm)(g/cm2)/MeV
+    double betaError = INV_DBL;
+    double calibConst = INV_DBL;       // ADC/e
+    double calibConstError = INV_DBL;
+    double correlationAlphaBeta = INV_DBL;
+    double chi2 = INV_DBL;
+    int ndf = INV_INT;
+    bool converged = false;
+
+    void Reset() {
+      alpha = INV_DBL;
+      alphaError = INV_DBL;
+      beta = INV_DBL;
+      betaError = INV_DBL;
+      calibConst = INV_DBL;
+      calibConstError = INV_DBL;
+      correlationAlphaBeta = INV_DBL;
+      chi2 = INV_DBL;
+      ndf = INV_INT;
+      converged = false;
+    }
+  };
+
+  class ModBoxFitter {
+
+  public:
+    ModBoxFitter();
+    ~ModBoxFitter();
+
+    // Read parameters from FHICL file
+    void reconfigure(fhicl::ParameterSet const &p);
+
+    // Expected dEdx from the MC (true) or from LandauVav (false), see CalorimetryHelper::FillExpecteddEdx.
+    bool UseMCdEdx() const { return _useMCdEdx; }
+
+    // LAr density in g/cm3.
+    double GetLArDensity() const { return _LArdensity; }
+
+    // Add the hits of a track. efield in kV/cm.
+    void Fill(const std::vector<double> &dQdx, const std::vector<double> &expecteddEdx,
+              const std::vector<double> &efield, const std::vector<double> &resRange);
+
+    // Add the cells stored in a file written by Write.
+    void Read(const std::string &filename);
+
+    // Fit the model to the most probable dQ/dx of the cells.
+    const modBoxFitResult &Fit();
+
+    // Write the cells, the most probable dQ/dx and the fit result to the output file.
+    void Write();
+
+    // Get the number of hits in the cells.
+    double GetNumbHits() const;
+
+  private:
+    // Parameters
+    size_t _nBinsdEdx, _nBinsEfield, _nBinsdQdx;
+    double _mindEdx, _maxdEdx;
+    double _minEfield, _maxEfield;
+    double _mindQdx, _maxdQdx;
+    double _minResRange;
+    double _minEntries;
+    double _peakFraction;
+    bool _useMCdEdx;
+    double _LArdensity;
+    double _Wion;
+    std::array<double,3> _initialValues;   // alpha, beta, calibConst
+    std::array<bool,3> _isFixed;
+    size_t _maxIterations;
+    std::string _fileName;
+
+    // Cells, dE/dx bin major.
+    std::vector<modBoxCell> _cells;
+
+    // Points of the last fit.
+    std::vector<double> _pointdEdx, _pointEfield, _pointMPV, _pointMPVError;
+    std::vector<int> _pointCell;
+    modBoxFitResult _result;
+
+    // Index of the bin of a value, INV_SIZE if outside.
+    size_t GetBin(const double &value, const double &min, const double &max, const size_t &nBins) const;
+
+    // Most probable dQ/dx of a cell from a parabola fit to the log of the counts around the peak.
+    bool FindMPV(const modBoxCell &cell, double &mpv, double &mpvError) const;
+
+    // Model and its derivatives with respect to alpha, beta and calibConst.
+    double Model(const std::array<double,3> &par, const double &dEdx, const double &efield, std::array<double,3> *gradient = 0x0) const;
+
+    // Chi2 of the points for some parameters.
+    double Chi2(const std::array<double,3> &par) const;
+  };
+}
+
+#endif
@@ -32,9 +32,24 @@
 #include "protoduneana/StoppingMuonSelection/StoppingMuonSelectionAlg.h"
 #include "protoduneana/StoppingMuonSelection/HitHelper.h"
 #include "protoduneana/StoppingMuonSelection/HitPlaneAlg.h"
+#include "protoduneana/StoppingMuonSelection/HitCache.h"
+#include "protoduneana/StoppingMuonSelection/TruthHitCache.h"
+#include "protoduneana/StoppingMuonSelection/TruthMatchTable.h"
+#include "protoduneana/StoppingMuonSelection/TrackIDIndex.h"
+#include "protoduneana/StoppingMuonSelection/CandidateTable.h"
+#include "protoduneana/StoppingMuonSelection/EventArena.h"
+#include "protoduneana/StoppingMuonSelection/EventContext.h"
+#include "protoduneana/StoppingMuonSelection/EventTablesGuard.h"
+#include "protoduneana/StoppingMuonSelection/TruthProvider.h"
+#include "protoduneana/StoppingMuonSelection/TrackHitTable.h"
+#include "protoduneana/StoppingMuonSelection/CNNScoreTable.h"
 #include "protoduneana/StoppingMuonSelection/CNNHelper.h"
 #include "protoduneana/StoppingMuonSelection/SceHelper.h"
 #include "protoduneana/StoppingMuonSelection/CalibrationHelper.h"
+#include "protoduneana/StoppingMuonSelection/CalibMapBuilder.h"
+#include "protoduneana/StoppingMuonSelection/ModBoxFitter.h"
+#include "protoduneana/StoppingMuonSelection/Instrumentation.h"
+#include "protoduneana/StoppingMuonSelection/Logging.h"
 #include "protoduneana/StoppingMuonSelection/FixCalo.h"
 
 namespace stoppingcosmicmuonselection {
@@ -74,8 +89,18 @@ private:
   StoppingMuonSelectionAlg selectorAlg;  // need configuration
   CalorimetryHelper        caloHelper;   // need configuration
   HitHelper                hitHelper;    // need configuration
+  HitCache                 hitCache;
+  TruthHitCache            truthCache;
+  TruthMatchTable          truthTable;
+  TrackIDIndex             trackIDIndex;
+  CandidateTable           candidateTable;
+  TrackHitTable            trackHitTable;
+  HitPlaneAlg              hitPlaneAlg;
+  CNNScoreTable            cnnScores;
   CNNHelper             cnnHelper;
   CalibrationHelper        calibHelper;
+  CalibMapBuilder          calibMapBuilder; // need configuration if buildCalibMaps
+  ModBoxFitter             modBoxFitter; // need configuration if fitModBox
   SceHelper                *sceHelper;
   FixCalo                 fixCalo;
 
@@ -86,9 +111,14 @@ private:
   size_t _numberNeighbors;
   double _michelScoreThreshold;
   double _michelScoreThresholdAvg;
+  bool _orderHitsByTrajectory;
   bool _selectAC, _selectCC;
+  bool _useCandidates;
+  bool _buildCalibMaps;
+  bool _fitModBox;
   std::string fPFParticleTag, fSpacePointTag, fTrackerTag;
-  std::string fNNetTag;
+  std::string fCandidateTag;
+  std::string fNNetTag, fHitTag, fSimChannelTag;
 
   // Utils
   protoana::ProtoDUNEPFParticleUtils   pfpUtil;
@@ -158,6 +188,9 @@ private:
   std::vector<double> fEfY;
   std::vector<double> fEfZ;
   std::vector<double> fEfield;
+  std::vector<double> fdQdxCalib;
+  std::vector<double> fExpecteddEdx;
+  calibColumns fCalibColumns;
 
   // Objects for TTree
   std::string filename;
@@ -243,6 +276,20 @@ void ModBoxModStudyAnode::beginJob()
   fTrackTree->Branch("EfY", &fEfY);
   fTrackTree->Branch("EfZ", &fEfZ);
   fTrackTree->Branch("Efield", &fEfield);
+  fTrackTree->Branch("dQdxCalib", &fdQdxCalib);
+
+  // Columns filled by the calibration helper, straight into the branches.
+  fCalibColumns.phis = &fPhis;
+  fCalibColumns.efX = &fEfX;
+  fCalibColumns.efY = &fEfY;
+  fCalibColumns.efZ = &fEfZ;
+  fCalibColumns.efield = &fEfield;
+  fCalibColumns.xCalibFactor = &fXcalibFactor;
+  fCalibColumns.yzCalibFactor = &fYZcalibFactor;
+  fCalibColumns.dQdxCalib = &fdQdxCalib;
+  fCalibColumns.AddLifetime(0., &fLifeTimeCorr);
+  fCalibColumns.AddLifetime(0.1, &fLifeTimeCorrP10);
+  fCalibColumns.AddLifetime(-0.1, &fLifeTimeCorrM10);
 
   // Histograms
   h_dQdxVsRR = tfs->make<TH2D>("h_dQdxVsRR","h_dQdxVsRR",200,0,200,800,0,800);
@@ -275,33 +322,69 @@ void ModBoxModStudyAnode::beginJob()
 
 void ModBoxModStudyAnode::endJob()
 {
-  mf::LogVerbatim("ModBoxModStudyAnode") << "ModBoxModStudyAnode finished job";
-  std::cout << "Total number of tracks: " << counter_total_number_tracks << std::endl;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "ModBoxModStudyAnode finished job";
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Total number of tracks: " << counter_total_number_tracks;
+  // Calibration maps of the selected hits, in the format read by CalibrationHelper.
+  if (_buildCalibMaps) {
+    calibMapBuilder.Write();
+    STOPPING_MUON_LOG_INFO(kLogModules) << "Calibration maps built from " << calibMapBuilder.GetNumbHits() << " hits.";
+  }
+  // Modified box parameters from the cells of this job (see ModBoxFit/fit_modbox.cc to merge jobs).
+  if (_fitModBox) {
+    const modBoxFitResult &modBox = modBoxFitter.Fit();
+    STOPPING_MUON_LOG_INFO(kLogModules) << "Modified box fit of " << modBoxFitter.GetNumbHits() << " hits: alpha " << modBox.alpha << " +- " << modBox.alphaError
+                                        << ", beta " << modBox.beta << " +- " << modBox.betaError << ", calibration constant " << modBox.calibConst
+                                        << " +- " << modBox.calibConstError << ", chi2/ndf " << modBox.chi2 << "/" << modBox.ndf;
+    modBoxFitter.Write();
+  }
+  // Time per stage, only filled when compiled with STOPPING_MUON_INSTRUMENTATION.
+  if (Instrumentation::IsEnabled()) {
+    // Written by the first module of the job only.
+    if (Instrumentation::Get().ClaimWrite()) {
+      art::ServiceHandle<art::TFileService> tfs;
+      Instrumentation::Get().Write(tfs->make<TTree>("Instrumentation","Instrumentation"));
+    }
+    Instrumentation::Get().Print();
+  }
 }
 
 void ModBoxModStudyAnode::respondToOpenInputFile(art::FileBlock const &inputFile) {
   filename = inputFile.fileName();
-  std::cout << "Analyzer on file: " << filename << std::endl;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Analyzer on file: " << filename;
 }
 
 void ModBoxModStudyAnode::reconfigure(fhicl::ParameterSet const& p)
 {
+  Logger::Get().reconfigure(p.get<fhicl::ParameterSet>("Logging", fhicl::ParameterSet()));
+  TruthProvider::Get().reconfigure(p);
   fTrackerTag = p.get<std::string>("TrackerTag");
   fPFParticleTag = p.get<std::string>("PFParticleTag");
   fNNetTag = p.get<std::string>("NNetTag");
+  fHitTag = p.get<std::string>("HitTag", "hitpdune");
+  fSimChannelTag = p.get<std::string>("SimChannelTag", "tpcrawdecoder:simpleSC");
   fSpacePointTag = p.get<std::string>("SpacePointTag");
+  // Candidates of StoppingMuonProducer. If empty, the selection is run here.
+  fCandidateTag = p.get<std::string>("CandidateTag", "");
+  _useCandidates = !fCandidateTag.empty();
   _minNumbMichelLikeHit = p.get<size_t>("minNumbMichelLikeHit", 2);
   _trackPitch = p.get<double>("trackPitch", 0.75);
   _trackPitchTolerance = p.get<double>("trackPitchTolerance", 0.1);
   _numberNeighbors = p.get<size_t>("numberNeighbors", 2);
   _michelScoreThreshold = p.get<double>("michelScoreThreshold", 0.7);
   _michelScoreThresholdAvg = p.get<double>("michelScoreThresholdAvg", 0.5);
+  _orderHitsByTrajectory = p.get<bool>("orderHitsByTrajectory", false);
   _selectAC = p.get<bool>("selectAC", true);
   _selectCC = p.get<bool>("selectCC", true);
+  _buildCalibMaps = p.get<bool>("buildCalibMaps", false);
+  _fitModBox = p.get<bool>("fitModBox", false);
   spAlg.reconfigure(p.get<fhicl::ParameterSet>("SpacePointAlg"));
   selectorAlg.reconfigure(p.get<fhicl::ParameterSet>("StoppingMuonSelectionAlg"));
   caloHelper.reconfigure(p.get<fhicl::ParameterSet>("CalorimetryHelper"));
   hitHelper.reconfigure(p.get<fhicl::ParameterSet>("HitHelper"));
+  if (_buildCalibMaps)
+    calibMapBuilder.reconfigure(p.get<fhicl::ParameterSet>("CalibMapBuilder"));
+  if (_fitModBox)
+    modBoxFitter.reconfigure(p.get<fhicl::ParameterSet>("ModBoxFitter"));
 }
 
 void ModBoxModStudyAnode::UpdateTTreeVariableWithTrackProperties(const trackProperties &trackInfo) {
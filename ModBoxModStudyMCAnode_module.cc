@@ -12,18 +12,21 @@ namespace stoppingcosmicmuonselection {
   {
     // increase counter and store event number
     fEvNumber = evt.id().event();
-    std::cout << "ModBoxModStudyAnode_module is on event: " << fEvNumber << std::endl;
-    mf::LogVerbatim("ModBoxModStudyAnode") << "ModBoxModStudyAnode module on event " << fEvNumber;
+    STOPPING_MUON_LOG_INFO(kLogModules) << "ModBoxModStudyAnode module on event " << fEvNumber;
     
+    // Free the temporaries of the previous event.
+    EventArena::NewEvent();
+    // Reject MC events in a data-only job, before any truth access.
+    TruthProvider::Get().CheckEvent(evt);
+    // Clock and detector properties of this event, for all the helpers.
+    const EventContext context(evt);
+
     if (evt.isRealData()) {
-      art::ServiceHandle<calib::LifetimeCalibService> lifetimecalibHandler;
-      calib::LifetimeCalibService & lifetimecalibService = *lifetimecalibHandler;
-      calib::LifetimeCalib *lifetimecalib = lifetimecalibService.provider();
-      fLifetime = lifetimecalib->GetLifetime()*1000.0; // [ms]*1000.0 -> [us]
+      fLifetime = context.GetCalibLifetime();
     }
     else
       fLifetime = 35000; // [ms]*1000.0 -> [us]
-    std::cout << "LIFETIME: " << fLifetime << std::endl;
+    STOPPING_MUON_LOG_DEBUG(kLogModules) << "LIFETIME: " << fLifetime;
     
     // Timing stuff
     const char * timestamp;
@@ -36,10 +39,10 @@ namespace stoppingcosmicmuonselection {
       TTimeStamp ts2(ts.timeHigh(), ts.timeLow());
       timestamp = ts2.AsString();
     }
-    std::cout << "TIMESTAMP: "  << timestamp << std::endl;
+    STOPPING_MUON_LOG_DEBUG(kLogModules) << "TIMESTAMP: "  << timestamp;
 
     // Set the calibration helper.
-    calibHelper.Set(evt);
+    calibHelper.Set(evt, context);
 
     // Get handles
     // trackHandle is art::ValidHandle<std::vector<recob::Track>>
@@ -49,28 +52,42 @@ namespace stoppingcosmicmuonselection {
     if (!pfparticleHandle.isValid()) return;
     auto const &recoParticles = *pfparticleHandle;
     auto const spacePointHandle = evt.getValidHandle<std::vector<recob::SpacePoint>>(fSpacePointTag);
-    const std::vector<recob::SpacePoint> spacePoints = *spacePointHandle;
-
-    auto const hitHandle = evt.getValidHandle<std::vector<recob::Hit>>("hitpdune");
-    auto const &allHits = *hitHandle;
-
-    // Add handle for clock and detector properties.
-    auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-    auto const detProp = art::ServiceHandle<detinfo::DetectorPropertiesService>()->DataFor(evt, clockData);
-    double driftVelocity = detProp.DriftVelocity()*1e-3;
-    std::cout << "Drift velocity: " << driftVelocity << std::endl;
+    spAlg.SetSpacePoints(*spacePointHandle);
+
+    // Fill the hit table for this event.
+    hitCache.Set(evt, fHitTag);
+    // Read the CNN Michel scores once for all the hits.
+    cnnScores.Set(evt, fNNetTag, hitCache);
+    // Fill the hit truth table and the PFParticle truth matching (MC only).
+    if (!evt.isRealData()) {
+      truthCache.Set(evt, fSimChannelTag, hitCache, context);
+      truthTable.Set(evt, fPFParticleTag, hitCache, truthCache);
+    }
+    selectorAlg.SetTruthMatchTable(&truthTable);
+    // Clear the pointers to the tables and context when the event ends, also on exceptions.
+    const EventTablesGuard<StoppingMuonSelectionAlg> tablesGuard(selectorAlg);
+    double driftVelocity = context.DriftVelocity();
+    STOPPING_MUON_LOG_DEBUG(kLogModules) << "Drift velocity: " << driftVelocity;
 
     // Get track handle.
     art::Handle<std::vector<recob::Track>> trackListHandle;
-    std::vector<art::Ptr<recob::Track>> tracklist;
-    if (evt.getByLabel(fTrackerTag,trackListHandle))
-      art::fill_ptr_vector(tracklist, trackListHandle);
+    evt.getByLabel(fTrackerTag,trackListHandle);
+    // Fill the track index for this event.
+    trackIDIndex.Set(evt, fTrackerTag);
+    selectorAlg.SetTrackIDIndex(&trackIDIndex);
+    selectorAlg.SetEventContext(&context);
+    const std::vector<art::Ptr<recob::Track>> &tracklist = trackIDIndex.GetTrackList();
     // Get association to metadata and hit.
     art::FindManyP<recob::Hit, recob::TrackHitMeta> fmthm(trackListHandle, evt, fTrackerTag);
     art::FindManyP<recob::Hit> fmht(trackListHandle, evt, fTrackerTag);
 
-    // Iterates over the vector of PFParticles
-    for (unsigned int p = 0; p < recoParticles.size(); ++p) {
+    // Read the candidates of StoppingMuonProducer, if its selection is used.
+    if (_useCandidates) candidateTable.Set(evt, fCandidateTag, fPFParticleTag);
+    const size_t nParticles = _useCandidates ? candidateTable.Size() : recoParticles.size();
+
+    // Iterates over the vector of PFParticles, or over the PFParticles of the candidates
+    for (unsigned int c = 0; c < nParticles; ++c) {
+      const unsigned int p = _useCandidates ? candidateTable.GetPFParticle(c).key() : c;
 
       fIsRecoSelectedCathodeCrosser = false;
       fIsRecoSelectedAnodeCrosser = false;
@@ -85,7 +102,15 @@ namespace stoppingcosmicmuonselection {
       fEfY.clear();
       fEfZ.clear();
       fEfield.clear();
-
+      // Only the anode crosser branches below fill the per-hit vectors.
+      fdQdx.clear();
+      fdEdx.clear();
+      fDriftTime.clear();
+      fResRange.clear();
+      fTrackPitch.clear();
+      fHitX.clear();
+      fHitY.clear();
+      fHitZ.clear();
 
       // Get the PFParticle
       const recob::PFParticle &thisParticle = recoParticles[p];
@@ -101,13 +126,23 @@ namespace stoppingcosmicmuonselection {
       //      Make Selection
       //
       // If this is MC we want that the PFParticle is matched to a cosmic MCParticle
-      if (!evt.isRealData() && !selectorAlg.IsTrackMatchedToTrueCosmicTrack(evt,thisParticle))
+      if (!evt.isRealData() && !(_useCandidates ? candidateTable.GetCandidate(c).HasBits(kTrueCosmic)
+                                                : selectorAlg.IsTrackMatchedToTrueCosmicTrack(evt,thisParticle)))
         continue;
 
       // Check if this PFParticle is a stopping muon.
       //      !!!SELECTION STEP!!!
       //
-      if (_selectCC && selectorAlg.IsStoppingCathodeCrosser(evt,thisParticle))
+      if (_useCandidates) {
+        // Already selected by StoppingMuonProducer: take the T0 and the corrected points of the candidate.
+        const StoppingMuonCandidate &candidate = candidateTable.GetCandidate(c);
+        if (!candidate.HasBits(kPassSelection | kGoodSpacePoints)) continue;
+        fIsRecoSelectedCathodeCrosser = _selectCC && candidate.type == kCathodeCrosser;
+        fIsRecoSelectedAnodeCrosser = _selectAC && candidate.type != kCathodeCrosser;
+        if (!fIsRecoSelectedCathodeCrosser && !fIsRecoSelectedAnodeCrosser) continue;
+        selectorAlg.SetTrackProperties(evt,candidate,*candidateTable.GetTrack(c));
+      }
+      else if (_selectCC && selectorAlg.IsStoppingCathodeCrosser(evt,thisParticle))
         fIsRecoSelectedCathodeCrosser = true;
       else if (_selectAC && selectorAlg.IsStoppingAnodeCrosser(evt,thisParticle))
         fIsRecoSelectedAnodeCrosser = true;
@@ -115,10 +150,10 @@ namespace stoppingcosmicmuonselection {
         continue;
       
       // Check if the track is missing some space points (need to get
-      // an handle on the track)
-      const recob::Track &track = selectorAlg.GetTrackFromPFParticle(evt,thisParticle);
-      if(!spAlg.IsGoodTrack(track,spacePoints,selectorAlg.GetTrackProperties())) {
-        std::cout << "Space point alg: " << "TrackID: " << track.ID() << " not accepted." << std::endl;
+      // an handle on the track). The candidates were checked by StoppingMuonProducer.
+      const recob::Track &track = _useCandidates ? *candidateTable.GetTrack(c) : selectorAlg.GetTrackFromPFParticle(evt,thisParticle);
+      if(!_useCandidates && !spAlg.IsGoodTrack(track,selectorAlg.GetTrackProperties())) {
+        STOPPING_MUON_LOG_DEBUG(kLogModules) << "Space point alg: " << "TrackID: " << track.ID() << " not accepted.";
         continue;
       }
       
@@ -128,36 +163,40 @@ namespace stoppingcosmicmuonselection {
       else if (!evt.isRealData() && fIsRecoSelectedAnodeCrosser)
         fIsTrueSelectedAnodeCrosser = selectorAlg.IsTrueParticleAnAnodeCrossingStoppingMuon(evt,thisParticle);
 
-      std::cout << "**************************" << std::endl;
-      std::cout << "Track accepted." << std::endl;
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "**************************";
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "Track accepted.";
       if (fIsRecoSelectedCathodeCrosser)
-        std::cout << "Track is a CATHODE crosser." << std::endl;
+        STOPPING_MUON_LOG_DEBUG(kLogModules) << "Track is a CATHODE crosser.";
       else if (fIsRecoSelectedAnodeCrosser) {
-        std::cout << "Track is an ANODE crosser. Selected by Pandora? " << selectorAlg.GetTrackProperties().isAnodeCrosserPandora << std::endl;
+        STOPPING_MUON_LOG_DEBUG(kLogModules) << "Track is an ANODE crosser. Selected by Pandora? " << selectorAlg.GetTrackProperties().isAnodeCrosserPandora;
       }
-      std::cout << "Event: " << selectorAlg.GetTrackProperties().evNumber << std::endl;
-      std::cout << "trackID: " << selectorAlg.GetTrackProperties().trackID << std::endl;
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "Event: " << selectorAlg.GetTrackProperties().evNumber;
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "trackID: " << selectorAlg.GetTrackProperties().trackID;
 
       // Updating variables to be stored in TTree
       UpdateTTreeVariableWithTrackProperties(selectorAlg.GetTrackProperties());
 
       // Look for and skip track with Michel attached.
-      // Get the CNN tagging results.
-      size_t trackIndex = hitHelper.GetTrackIndex(track,tracklist);
+      size_t trackIndex = trackIDIndex.GetIndex(track);
       auto const &trackHits = hitHelper.GetArtPtrToHitVect(fmht,trackIndex);
-      const artPtrHitVec &hitsOnCollection = hitHelper.GetHitsOnAPlane(2,trackHits);
+      const hitIndexVec &trackHitIndex = hitCache.GetIndexVec(trackHits);
+      const hitIndexVec &hitsOnCollection = hitCache.GetHitsOnAPlane(2,trackHitIndex);
       if (hitsOnCollection.size()==0) continue;
 
-      const size_t &hitIndex = hitHelper.GetIndexClosestHitToPoint(selectorAlg.GetTrackProperties().recoStartPoint,hitsOnCollection,fmthm,tracklist,trackIndex);
-      HitPlaneAlg hitPlaneAlg(trackHits,hitIndex,2,selectorAlg.GetTrackProperties().trackT0,clockData,detProp);
-      anab::MVAReader<recob::Hit,4> hitResults(evt, fNNetTag);
-      if (hitPlaneAlg.AreThereMichelHits(hitResults,0.7,0.5)) continue;
+      trackHitTable.Set(fmthm,trackIndex,*tracklist[trackIndex],hitCache);
+      const size_t &hitIndex = hitHelper.GetIndexClosestHitToPoint(selectorAlg.GetTrackProperties().recoStartPoint,hitsOnCollection,hitCache,trackHitTable);
+      hitPlaneAlg.Process(hitCache,trackHitIndex,hitIndex,2,selectorAlg.GetTrackProperties().trackT0,context,
+                          _orderHitsByTrajectory ? &trackHitTable : 0x0);
+      if (hitPlaneAlg.AreThereMichelHits(cnnScores,0.7,0.5)) continue;
 
       // Let's go to the Calorimetry. Need to set it for this track first.
-      caloHelper.Set(thisParticle,evt,2);
+      caloHelper.Set(thisParticle,evt,2,context);
       // Fill the histos
       //caloHelper.FillHisto_dQdxVsRR(h_dQdxVsRR);
       //caloHelper.FillHisto_dQdxVsRR(h_dQdxVsRR_TP075,_trackPitch-_trackPitchTolerance,_trackPitch+_trackPitchTolerance);
+      // The calorimetry from FixCalo still needs the lifetime correction.
+      bool isRightCalo = false;
+      bool areHitVectorsSet = false;
       if (fIsRecoSelectedAnodeCrosser && selectorAlg.GetTrackProperties().isAnodeCrosserPandora) {
         fdQdx = caloHelper.GetdQdx();
         fDriftTime = caloHelper.GetDriftTime();
@@ -166,12 +205,13 @@ namespace stoppingcosmicmuonselection {
         fHitX = caloHelper.GetHitX();
         fHitY = caloHelper.GetHitY();
         fHitZ = caloHelper.GetHitZ();
+        areHitVectorsSet = true;
       }
       else if (fIsRecoSelectedAnodeCrosser && selectorAlg.GetTrackProperties().isAnodeCrosserMine) {
         //calibHelper.CorrectXPosition(fHitX,selectorAlg.GetTrackProperties().recoStartPoint.X(),selectorAlg.GetTrackProperties().recoEndPoint.X(),selectorAlg.GetTrackProperties().trackT0);
-        const std::vector<std::vector<double>> &myCalo = fixCalo.GetRightCalo(evt,selectorAlg.GetTrackProperties().trackT0,track);
+        const std::vector<std::vector<double>> &myCalo = fixCalo.GetRightCalo(evt,context,selectorAlg.GetTrackProperties().trackT0,track,trackIDIndex);
         if (myCalo.size()!=7) {
-          std::cout << "Error: The size of the vector myCalo is wrong!" << std::endl;
+          STOPPING_MUON_LOG_ERROR(kLogModules) << "Error: The size of the vector myCalo is wrong!";
           continue;
         }
         fdQdx = myCalo.at(0);
@@ -181,16 +221,8 @@ namespace stoppingcosmicmuonselection {
         fHitY = myCalo.at(4);
         fHitZ = myCalo.at(5);
         fdEdx = myCalo.at(6);
-
-        // Apply lifetime correction
-        for (size_t j=0;j<fdQdx.size();j++) {
-          fdQdx[j] = fdQdx[j] * calibHelper.GetLifeTimeCorrFactor(fLifetime, fHitX[j], evt);
-          fLifeTimeCorr.push_back(calibHelper.GetLifeTimeCorrFactor(fLifetime, fHitX[j], evt));
-          double ltP10 = 0.1*fLifetime + fLifetime;
-          double ltM10 = -0.1*fLifetime + fLifetime;
-          fLifeTimeCorrP10.push_back(calibHelper.GetLifeTimeCorrFactor(ltP10, fHitX[j], evt));
-          fLifeTimeCorrM10.push_back(calibHelper.GetLifeTimeCorrFactor(ltM10, fHitX[j], evt));
-        }
+        isRightCalo = true;
+        areHitVectorsSet = true;
 
         // Order residual range
         std::vector<double> res_vect;
@@ -222,35 +254,41 @@ namespace stoppingcosmicmuonselection {
         fResRange = fResRange_ord;
       }
       // Fix lifetime
-      //caloHelper.LifeTimeCorrNew(fdQdx, fHitX, evt);
-      fPhis = calibHelper.PitchFieldAngle(fHitX, fHitY, fHitZ);
+      //caloHelper.LifeTimeCorrNew(fdQdx, fHitX, context);
+      // Angles, field, calibration and lifetime factors in one pass, straight into the branches.
+      calibHelper.FillCalibColumns(fHitX, fHitY, fHitZ, fdQdx, fLifetime, context, fCalibColumns);
+      if (_buildCalibMaps && areHitVectorsSet)
+        calibMapBuilder.Fill(fHitX, fHitY, fHitZ, fdQdx, fResRange, fYZcalibFactor);
+      // Calibrated dQdx against the expected dEdx and the local field, for the modified box fit.
+      // The hits of the FixCalo tracks are not those of the Pandora calorimetry, so use the module vectors.
+      if (_fitModBox && areHitVectorsSet) {
+        caloHelper.FillExpecteddEdx(fResRange, fTrackPitch, fExpecteddEdx, modBoxFitter.UseMCdEdx(), modBoxFitter.GetLArDensity());
+        if (fdQdxCalib.size() == fResRange.size() && fEfield.size() == fResRange.size() && fExpecteddEdx.size() == fResRange.size())
+          modBoxFitter.Fill(fdQdxCalib, fExpecteddEdx, fEfield, fResRange);
+        else
+          STOPPING_MUON_LOG_WARNING(kLogCalorimetry) << "ModBoxModStudyMCAnode_module.cc: hit vector sizes differ (dQdxCalib "
+                                                     << fdQdxCalib.size() << ", Efield " << fEfield.size() << ", ResRange "
+                                                     << fResRange.size() << "), track not used in the modified box fit.";
+      }
+      // Apply lifetime correction
+      if (isRightCalo) {
+        for (size_t j=0;j<fdQdx.size();j++)
+          fdQdx[j] = fdQdx[j] * fLifeTimeCorr[j];
+      }
       std::vector<size_t> hitIndeces = caloHelper.GetHitIndex();
       //double xxx = detprop->ConvertTicksToX(allHits[hitIndeces[4]].PeakTime(),allHits[hitIndeces[4]].WireID().Plane, allHits[hitIndeces[4]].WireID().TPC, allHits[hitIndeces[4]].WireID().Cryostat);
       //std::cout << "X: " << fHitX[4] << " Time: " << allHits[hitIndeces[4]].PeakTime() << " Converted: " << xxx << std::endl;
       for (size_t i=0; i<hitIndeces.size();i++) {
-        double hitAmpl = allHits[hitIndeces[i]].PeakAmplitude();
-        double hitRMS = allHits[hitIndeces[i]].RMS();
+        double hitAmpl = hitCache.Amplitude(hitIndeces[i]);
+        double hitRMS = hitCache.RMS(hitIndeces[i]);
         fHitAmpl.push_back(hitAmpl);
         fHitRMS.push_back(hitRMS);
       }
 
-      // Fill the bit for the electric field.
-      std::vector<TVector3> electric_field = calibHelper.GetHitPosField(fHitX, fHitY, fHitZ);
-      for (size_t i=0; i<electric_field.size(); i++) {
-        fEfX.push_back(electric_field.at(i).X());
-        fEfY.push_back(electric_field.at(i).Y());
-        fEfZ.push_back(electric_field.at(i).Z());
-        fEfield.push_back(electric_field.at(i).Mag());
-      }
-
-      // Get Calibration correction factors.
-      fYZcalibFactor = calibHelper.GetYZCorr_V(fHitX, fHitY, fHitZ);
-      fXcalibFactor = calibHelper.GetXCorr_V(fHitX);
-
       // Correct start and end point.
-      sceHelper = new SceHelper(detProp);
-      TVector3 recoStartPoint_corr = sceHelper->GetCorrectedPos(TVector3(fStartX, fStartY, fStartZ));
-      TVector3 recoEndPoint_corr = sceHelper->GetCorrectedPos(TVector3(fEndX, fEndY, fEndZ));
+      sceHelper = new SceHelper(context);
+      Point3 recoStartPoint_corr = sceHelper->GetCorrectedPos(Point3{fStartX, fStartY, fStartZ});
+      Point3 recoEndPoint_corr = sceHelper->GetCorrectedPos(Point3{fEndX, fEndY, fEndZ});
 
       fEndX_corr = recoEndPoint_corr.X();
       fEndY_corr = recoEndPoint_corr.Y();
@@ -260,7 +298,7 @@ namespace stoppingcosmicmuonselection {
       fStartZ_corr = recoStartPoint_corr.Z();
 
       // Fill TTree
-      std::cout << "*** Adding track..." << std::endl;
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "*** Adding track...";
       fTrackTree->Fill();
 
       // Get rid of tracks with weird stuff.
@@ -0,0 +1,84 @@
+/***
+  Class containing lightweight 3D points and vectors, used in place of
+  TVector3 through the helper APIs. They are trivially copyable and have
+  no vtable, so building them in the per-hit loops costs nothing. The
+  accessors follow TVector3. Convert with make_point3/point3_to only at
+  the ROOT/art boundary.
+
+*/
+#ifndef POINT3_H
+#define POINT3_H
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+namespace stoppingcosmicmuonselection {
+
+  template <class T>
+  struct Vector3 {
+    T x = 0, y = 0, z = 0;
+
+    constexpr T X() const { return x; }
+    constexpr T Y() const { return y; }
+    constexpr T Z() const { return z; }
+    constexpr T operator[](const size_t &i) const { return i == 0 ? x : (i == 1 ? y : z); }
+
+    constexpr void SetXYZ(const T &newX, const T &newY, const T &newZ) { x = newX; y = newY; z = newZ; }
+    constexpr void SetX(const T &newX) { x = newX; }
+    constexpr void SetY(const T &newY) { y = newY; }
+    constexpr void SetZ(const T &newZ) { z = newZ; }
+
+    constexpr T Dot(const Vector3 &v) const { return x*v.x + y*v.y + z*v.z; }
+    constexpr Vector3 Cross(const Vector3 &v) const { return {y*v.z - z*v.y, z*v.x - x*v.z, x*v.y - y*v.x}; }
+    constexpr T Mag2() const { return Dot(*this); }
+    T Mag() const { return std::sqrt(Mag2()); }
+
+    // Angle between two vectors, 0 if one of them is null (as TVector3::Angle).
+    T Angle(const Vector3 &v) const {
+      const T norm = std::sqrt(Mag2()*v.Mag2());
+      if (norm <= 0) return 0;
+      T cosine = Dot(v)/norm;
+      if (cosine > 1) cosine = 1;
+      if (cosine < -1) cosine = -1;
+      return std::acos(cosine);
+    }
+
+    // Unit vector, the vector itself if it is null.
+    Vector3 Unit() const {
+      const T mag = Mag();
+      return mag > 0 ? Vector3{x/mag, y/mag, z/mag} : *this;
+    }
+
+    constexpr Vector3 operator+(const Vector3 &v) const { return {x + v.x, y + v.y, z + v.z}; }
+    constexpr Vector3 operator-(const Vector3 &v) const { return {x - v.x, y - v.y, z - v.z}; }
+    constexpr Vector3 operator-() const { return {-x, -y, -z}; }
+    constexpr Vector3 operator*(const T &a) const { return {a*x, a*y, a*z}; }
+    constexpr Vector3 operator/(const T &a) const { return {x/a, y/a, z/a}; }
+    constexpr Vector3 &operator+=(const Vector3 &v) { x += v.x; y += v.y; z += v.z; return *this; }
+    constexpr Vector3 &operator-=(const Vector3 &v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+    constexpr Vector3 &operator*=(const T &a) { x *= a; y *= a; z *= a; return *this; }
+  };
+
+  template <class T>
+  constexpr Vector3<T> operator*(const T &a, const Vector3<T> &v) { return v*a; }
+
+  typedef Vector3<double> Point3;
+  typedef Vector3<double> Vec3;
+  typedef Vector3<float> Point3F;
+  typedef Vector3<float> Vec3F;
+
+  static_assert(std::is_trivially_copyable<Point3>::value, "Point3 must be trivially copyable.");
+  static_assert(std::is_trivially_copyable<Point3F>::value, "Point3F must be trivially copyable.");
+
+  // From anything with X(), Y() and Z(): TVector3, geo::Point_t, geo::Vector_t, ...
+  template <class V>
+  inline Point3 make_point3(const V &v) { return Point3{v.X(), v.Y(), v.Z()}; }
+
+  // To anything built from three coordinates: TVector3, geo::Point_t, ...
+  template <class V, class T>
+  inline V point3_to(const Vector3<T> &p) { return V(p.x, p.y, p.z); }
+
+}
+
+#endif
@@ -28,6 +28,7 @@
 #include "protoduneana/StoppingMuonSelection/DataTypes.h"
 #include "protoduneana/StoppingMuonSelection/GeometryHelper.h"
 #include "protoduneana/StoppingMuonSelection/CalibrationHelper.h"
+#include "protoduneana/StoppingMuonSelection/Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -69,39 +70,40 @@ PrintLifetime::PrintLifetime(fhicl::ParameterSet const & p)
 
 void PrintLifetime::beginJob()
 {
-  std::cout << "BEGIN JOB" << std::endl;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "BEGIN JOB";
   art::ServiceHandle<calib::LifetimeCalibService> lifetimecalibHandler;
   calib::LifetimeCalibService & lifetimecalibService = *lifetimecalibHandler;
   calib::LifetimeCalib *lifetimecalib = lifetimecalibService.provider();
   double fLifetime = lifetimecalib->GetLifetime()*1000.0; // [ms]*1000.0 -> [us]
-  std::cout << "LIFETIME BEGIN JOB: " << fLifetime << std::endl;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "LIFETIME BEGIN JOB: " << fLifetime;
 
 }
 
 void PrintLifetime::endJob()
 {
-  mf::LogVerbatim("PrintLifetime") << "PrintLifetime finished job";
+  STOPPING_MUON_LOG_INFO(kLogModules) << "PrintLifetime finished job";
 }
 
 void PrintLifetime::reconfigure(fhicl::ParameterSet const& p)
-{}
+{
+  Logger::Get().reconfigure(p.get<fhicl::ParameterSet>("Logging", fhicl::ParameterSet()));
+}
 
 void PrintLifetime::respondToOpenInputFile(art::FileBlock const &inputFile) {
   filename = inputFile.fileName();
-  std::cout << "Analyzer on file: " << filename << std::endl;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Analyzer on file: " << filename;
 }
 
 void PrintLifetime::analyze(art::Event const &evt)
 {
   // increase counter and store event number
   double fEvNumber = evt.id().event();
-  std::cout << "PrintLifetime_module is on event: " << fEvNumber << std::endl;
-  mf::LogVerbatim("PrintLifetime") << "PrintLifetime module on event " << fEvNumber;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "PrintLifetime module on event " << fEvNumber;
   art::ServiceHandle<calib::LifetimeCalibService> lifetimecalibHandler;
   calib::LifetimeCalibService & lifetimecalibService = *lifetimecalibHandler;
   calib::LifetimeCalib *lifetimecalib = lifetimecalibService.provider();
   double fLifetime = lifetimecalib->GetLifetime()*1000.0; // [ms]*1000.0 -> [us]
-  std::cout << "LIFETIME: " << fLifetime << std::endl;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "LIFETIME: " << fLifetime;
 
   // Timing stuff
   const char * timestamp;
@@ -114,7 +116,7 @@ void PrintLifetime::analyze(art::Event const &evt)
     TTimeStamp ts2(ts.timeHigh(), ts.timeLow());
     timestamp = ts2.AsString();
   }
-  std::cout << "TIMESTAMP: "  << timestamp << std::endl;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "TIMESTAMP: "  << timestamp;
 
 }
 
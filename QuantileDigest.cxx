@@ -0,0 +1,175 @@
+/***
+  Class containing a streaming quantile estimator (merging t-digest).
+
+*/
+#ifndef QUANTILE_DIGEST_CXX
+#define QUANTILE_DIGEST_CXX
+
+#include <algorithm>
+#include <cmath>
+
+#include "QuantileDigest.h"
+
+namespace stoppingcosmicmuonselection {
+
+  namespace {
+    // Number of buffered points per unit of compression before merging.
+    constexpr double BUFFER_FACTOR = 5.;
+
+    // Scale function: a centroid spans at most one unit of k.
+    double k_of_q(const double &q, const double &compression) {
+      return compression / (2.*M_PI) * std::asin(2.*q - 1.);
+    }
+
+    double q_of_k(const double &k, const double &compression) {
+      if (k >= compression/4.) return 1.;
+      return (std::sin(2.*M_PI*k/compression) + 1.) / 2.;
+    }
+  }
+
+  QuantileDigest::QuantileDigest(const double &compression) : _compression(compression) {
+  }
+
+  QuantileDigest::~QuantileDigest() {
+  }
+
+  // Add a point.
+  void QuantileDigest::Add(const double &x, const double &weight) {
+    if (_totalWeight == 0.) {
+      _min = x;
+      _max = x;
+    }
+    else {
+      _min = std::min(_min, x);
+      _max = std::max(_max, x);
+    }
+    _buffer.push_back(centroid{x, weight});
+    _totalWeight += weight;
+    if (_buffer.size() >= BUFFER_FACTOR*_compression) Compress();
+  }
+
+  // Add all the points of another digest.
+  void QuantileDigest::Merge(const QuantileDigest &other) {
+    if (other._totalWeight == 0.) return;
+    if (_totalWeight == 0.) {
+      _min = other._min;
+      _max = other._max;
+    }
+    else {
+      _min = std::min(_min, other._min);
+      _max = std::max(_max, other._max);
+    }
+    _buffer.insert(_buffer.end(), other._centroids.begin(), other._centroids.end());
+    _buffer.insert(_buffer.end(), other._buffer.begin(), other._buffer.end());
+    _totalWeight += other._totalWeight;
+    if (_buffer.size() >= BUFFER_FACTOR*_compression) Compress();
+  }
+
+  // Merge the buffer into the centroids.
+  void QuantileDigest::Compress() {
+    if (_buffer.empty()) return;
+    _buffer.insert(_buffer.end(), _centroids.begin(), _centroids.end());
+    std::sort(_buffer.begin(), _buffer.end(), [](const centroid &a, const centroid &b) { return a.mean < b.mean; });
+
+    // Group neighbouring centroids as long as the group stays within one unit of k.
+    _centroids.clear();
+    centroid current = _buffer[0];
+    double weightSoFar = 0.;
+    double qLimit = q_of_k(k_of_q(0., _compression) + 1., _compression);
+    for (size_t i = 1; i < _buffer.size(); i++) {
+      const centroid &next = _buffer[i];
+      if ((weightSoFar + current.weight + next.weight) / _totalWeight <= qLimit) {
+        current.weight += next.weight;
+        current.mean += (next.mean - current.mean) * next.weight / current.weight;
+      }
+      else {
+        _centroids.push_back(current);
+        weightSoFar += current.weight;
+        qLimit = q_of_k(k_of_q(weightSoFar/_totalWeight, _compression) + 1., _compression);
+        current = next;
+      }
+    }
+    _centroids.push_back(current);
+    _buffer.clear();
+  }
+
+  // Get the value below which a fraction q of the points is. INV_DBL if empty.
+  double QuantileDigest::Quantile(const double &q) {
+    Compress();
+    if (_centroids.empty()) return INV_DBL;
+    if (_centroids.size() == 1) return _centroids[0].mean;
+
+    // Interpolate between the centres of the centroids, and with min and max at the ends.
+    const double target = std::min(std::max(q, 0.), 1.) * _totalWeight;
+    const centroid &first = _centroids.front();
+    const centroid &last = _centroids.back();
+    if (target < first.weight/2.)
+      return _min + (first.mean - _min) * target / (first.weight/2.);
+    if (target > _totalWeight - last.weight/2.)
+      return _max - (_max - last.mean) * (_totalWeight - target) / (last.weight/2.);
+
+    double weightSoFar = first.weight/2.;
+    for (size_t i = 0; i+1 < _centroids.size(); i++) {
+      const double gap = (_centroids[i].weight + _centroids[i+1].weight) / 2.;
+      if (target <= weightSoFar + gap)
+        return _centroids[i].mean + (_centroids[i+1].mean - _centroids[i].mean) * (target - weightSoFar) / gap;
+      weightSoFar += gap;
+    }
+    return last.mean;
+  }
+
+  // Get the mean of the points between quantiles qLow and qHigh. INV_DBL if empty.
+  double QuantileDigest::TruncatedMean(const double &qLow, const double &qHigh) {
+    double sum = 0., sum2 = 0., weightIn = 0.;
+    SumInWindow(qLow, qHigh, sum, sum2, weightIn);
+    return weightIn > 0 ? sum/weightIn : INV_DBL;
+  }
+
+  // Get the RMS of the points between quantiles qLow and qHigh, from the centroids. INV_DBL if empty.
+  double QuantileDigest::TruncatedRMS(const double &qLow, const double &qHigh) {
+    double sum = 0., sum2 = 0., weightIn = 0.;
+    SumInWindow(qLow, qHigh, sum, sum2, weightIn);
+    if (weightIn <= 0) return INV_DBL;
+    const double mean = sum/weightIn;
+    return std::sqrt(std::max(sum2/weightIn - mean*mean, 0.));
+  }
+
+  // Sums of the centroid means and squared means between two quantiles.
+  void QuantileDigest::SumInWindow(const double &qLow, const double &qHigh, double &sum, double &sum2, double &weightIn) {
+    Compress();
+    const double low = std::max(qLow, 0.) * _totalWeight;
+    const double high = std::min(qHigh, 1.) * _totalWeight;
+    if (high <= low) return;
+
+    // Each centroid counts for the part of its weight inside the window.
+    double weightSoFar = 0.;
+    for (auto const &c : _centroids) {
+      const double overlap = std::min(weightSoFar + c.weight, high) - std::max(weightSoFar, low);
+      if (overlap > 0) {
+        sum += overlap * c.mean;
+        sum2 += overlap * c.mean * c.mean;
+        weightIn += overlap;
+      }
+      weightSoFar += c.weight;
+      if (weightSoFar >= high) break;
+    }
+  }
+
+  // Get the centroids, sorted by mean.
+  const std::vector<centroid> &QuantileDigest::GetCentroids() {
+    Compress();
+    return _centroids;
+  }
+
+  // Forget all the points.
+  void QuantileDigest::Reset() {
+    _centroids.clear();
+    _buffer.clear();
+    _totalWeight = 0.;
+    _min = INV_DBL;
+    _max = INV_DBL;
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
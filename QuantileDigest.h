@@ -0,0 +1,72 @@
+/***
+  Class containing a streaming quantile estimator (merging t-digest).
+  The points are grouped in centroids, small at the tails and larger at the
+  median, so the memory is bounded by the compression whatever the number
+  of points. Two digests are merged by adding their centroids.
+
+*/
+#ifndef QUANTILE_DIGEST_H
+#define QUANTILE_DIGEST_H
+
+#include <vector>
+
+#include "Constants.h"
+
+namespace stoppingcosmicmuonselection {
+
+  // Mean and weight of a group of points.
+  struct centroid {
+    double mean = INV_DBL;
+    double weight = 0.;
+  };
+
+  class QuantileDigest {
+
+  public:
+    QuantileDigest(const double &compression = 50.);
+    ~QuantileDigest();
+
+    // Add a point.
+    void Add(const double &x, const double &weight = 1.);
+
+    // Add all the points of another digest.
+    void Merge(const QuantileDigest &other);
+
+    // Get the value below which a fraction q of the points is. INV_DBL if empty.
+    double Quantile(const double &q);
+
+    // Get the median.
+    double Median() { return Quantile(0.5); }
+
+    // Get the mean of the points between quantiles qLow and qHigh. INV_DBL if empty.
+    double TruncatedMean(const double &qLow, const double &qHigh);
+
+    // Get the RMS of the points between quantiles qLow and qHigh, from the centroids. INV_DBL if empty.
+    double TruncatedRMS(const double &qLow, const double &qHigh);
+
+    // Get the sum of the weights of the points.
+    double GetTotalWeight() const { return _totalWeight; }
+
+    // Get the centroids, sorted by mean.
+    const std::vector<centroid> &GetCentroids();
+
+    // Forget all the points.
+    void Reset();
+
+  private:
+    double _compression;
+    std::vector<centroid> _centroids;  // sorted by mean
+    std::vector<centroid> _buffer;     // points not merged yet
+    double _totalWeight = 0.;
+    double _min = INV_DBL;
+    double _max = INV_DBL;
+
+    // Merge the buffer into the centroids.
+    void Compress();
+
+    // Sums of the centroid means and squared means between two quantiles.
+    void SumInWindow(const double &qLow, const double &qHigh, double &sum, double &sum2, double &weightIn);
+  };
+}
+
+#endif
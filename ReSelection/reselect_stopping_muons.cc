@@ -0,0 +1,196 @@
+////////////////////////////////////////////////////////////////////////
+// Program:     reselect_stopping_muons
+// File:        reselect_stopping_muons.cc
+//
+// Apply one or more sets of selection cuts to the feature records
+// written by SelectionStudyProd4 (dumpFeatures: true), without art.
+// It uses the same predicates as StoppingMuonSelectionAlg.
+////////////////////////////////////////////////////////////////////////
+#include "cetlib/filepath_maker.h"
+#include "cetlib_except/exception.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/make_ParameterSet.h"
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_reduce.h"
+#include "tbb/task_arena.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "protoduneana/StoppingMuonSelection/SelectionCuts.h"
+#include "protoduneana/StoppingMuonSelection/TrackFeatures.h"
+
+using namespace stoppingcosmicmuonselection;
+
+namespace {
+
+  // Counters for one cut configuration.
+  struct selectionCounts {
+    size_t nTracks = 0;
+    size_t nTrueCC = 0;
+    size_t nTrueAC = 0;
+    size_t nSelectedCC = 0;
+    size_t nSelectedAC = 0;
+    size_t nTrueSelectedCC = 0;
+    size_t nTrueSelectedAC = 0;
+    std::array<size_t,kNumbSelectionCuts> failedCutCC{};
+    std::array<size_t,kNumbSelectionCuts> failedCutAC{};
+
+    selectionCounts &operator+=(const selectionCounts &other) {
+      nTracks += other.nTracks;
+      nTrueCC += other.nTrueCC;
+      nTrueAC += other.nTrueAC;
+      nSelectedCC += other.nSelectedCC;
+      nSelectedAC += other.nSelectedAC;
+      nTrueSelectedCC += other.nTrueSelectedCC;
+      nTrueSelectedAC += other.nTrueSelectedAC;
+      for (size_t i = 0; i < kNumbSelectionCuts; i++) {
+        failedCutCC[i] += other.failedCutCC[i];
+        failedCutAC[i] += other.failedCutAC[i];
+      }
+      return *this;
+    }
+  };
+
+  // Options of the re-selection.
+  struct reselectionOptions {
+    bool selectCC;
+    bool selectAC;
+    bool requireTrueCosmic;
+  };
+
+  // Same decisions as the selection step of the analysis modules.
+  void select_track(const trackFeatures &f, const selectionCuts &cuts,
+                    const selectionConstants &constants, const reselectionOptions &options,
+                    selectionCounts &counts) {
+    if (!f.isRealData && options.requireTrueCosmic && !f.isTrueCosmic) return;
+    counts.nTracks++;
+    if (f.isTrueCathodeCrosser) counts.nTrueCC++;
+    if (f.isTrueAnodeCrosser) counts.nTrueAC++;
+
+    if (options.selectCC) {
+      const size_t failedCut = apply_cathode_crosser_cuts(f,cuts,constants);
+      counts.failedCutCC[failedCut]++;
+      if (failedCut == kPassedAllCuts) {
+        counts.nSelectedCC++;
+        if (f.isTrueCathodeCrosser) counts.nTrueSelectedCC++;
+        return;
+      }
+    }
+    if (options.selectAC) {
+      double t0 = INV_DBL, shiftX = 0.;
+      const size_t failedCut = apply_anode_crosser_cuts(f,cuts,constants,t0,shiftX);
+      counts.failedCutAC[failedCut]++;
+      if (failedCut == kPassedAllCuts) {
+        counts.nSelectedAC++;
+        if (f.isTrueAnodeCrosser) counts.nTrueSelectedAC++;
+      }
+    }
+  }
+
+  // Print the counters for one configuration.
+  void print_counts(const std::string &name, const selectionCounts &counts,
+                    const reselectionOptions &options) {
+    std::cout << "**************************" << std::endl;
+    std::cout << "Configuration: " << name << std::endl;
+    std::cout << "Number of tracks: " << counts.nTracks << std::endl;
+    if (options.selectCC) {
+      std::cout << "Selected cathode crossers: " << counts.nSelectedCC
+                << " (true: " << counts.nTrueSelectedCC << " of " << counts.nTrueCC << ")" << std::endl;
+      for (size_t cut = 1; cut < kNumbSelectionCuts; cut++) {
+        if (counts.failedCutCC[cut] == 0) continue;
+        std::cout << "  rejected, " << get_selection_cut_name(cut) << ": " << counts.failedCutCC[cut] << std::endl;
+      }
+    }
+    if (options.selectAC) {
+      std::cout << "Selected anode crossers: " << counts.nSelectedAC
+                << " (true: " << counts.nTrueSelectedAC << " of " << counts.nTrueAC << ")" << std::endl;
+      for (size_t cut = 1; cut < kNumbSelectionCuts; cut++) {
+        if (counts.failedCutAC[cut] == 0) continue;
+        std::cout << "  rejected, " << get_selection_cut_name(cut) << ": " << counts.failedCutAC[cut] << std::endl;
+      }
+    }
+  }
+
+  void print_usage() {
+    std::cout << "Usage: reselect_stopping_muons -c <config.fcl> <features.root> [<features.root> ...]" << std::endl;
+  }
+
+}
+
+int main(int argc, char **argv) {
+
+  // Read the command line.
+  std::string configFile;
+  std::vector<std::string> inputFiles;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      print_usage();
+      return 0;
+    }
+    if (arg == "-c" && i+1 < argc)
+      configFile = argv[++i];
+    else
+      inputFiles.push_back(arg);
+  }
+  if (configFile.empty() || inputFiles.empty()) {
+    print_usage();
+    return 1;
+  }
+
+  try {
+    // Read the configurations.
+    fhicl::ParameterSet pset;
+    cet::filepath_lookup maker("FHICL_FILE_PATH");
+    fhicl::make_ParameterSet(configFile, maker, pset);
+    const fhicl::ParameterSet p = pset.get<fhicl::ParameterSet>("reselection");
+    const std::string treeDirectory = p.get<std::string>("treeDirectory", "fabioana");
+    const size_t numberThreads = p.get<size_t>("numberThreads", 1);
+    reselectionOptions options;
+    options.selectCC = p.get<bool>("selectCC", true);
+    options.selectAC = p.get<bool>("selectAC", true);
+    options.requireTrueCosmic = p.get<bool>("requireTrueCosmic", true);
+    const std::vector<fhicl::ParameterSet> configurations = p.get<std::vector<fhicl::ParameterSet>>("configurations");
+
+    // Load all the records in memory: ROOT I/O stays on this thread.
+    selectionConstants constants;
+    std::vector<trackFeatures> records;
+    read_track_features(inputFiles, treeDirectory, constants, records);
+    std::cout << "Read " << records.size() << " records from " << inputFiles.size() << " files." << std::endl;
+
+    tbb::task_arena arena(numberThreads);
+    for (const fhicl::ParameterSet &configuration : configurations) {
+      const std::string name = configuration.get<std::string>("name", "unnamed");
+      const selectionCuts cuts = get_selection_cuts(configuration);
+
+      // Neighbours below the stored threshold were dropped when writing the records.
+      const double minCosAlpha = std::min({MIN_COS_ALPHA_CLOSE_TRACKS, cuts.cutCosAngleBrokenTracks_CC, cuts.cutCosAngleBrokenTracks_AC});
+      if (minCosAlpha < constants.minCosAlphaNeighbours)
+        std::cout << "Warning: configuration " << name << " has cutCosAngleBrokenTracks below "
+                  << constants.minCosAlphaNeighbours << ", the broken track cut is approximate." << std::endl;
+
+      const selectionCounts counts = arena.execute([&]() {
+        return tbb::parallel_reduce(
+          tbb::blocked_range<size_t>(0, records.size()), selectionCounts(),
+          [&](const tbb::blocked_range<size_t> &range, selectionCounts partial) {
+            for (size_t i = range.begin(); i != range.end(); i++)
+              select_track(records[i],cuts,constants,options,partial);
+            return partial;
+          },
+          [](selectionCounts a, const selectionCounts &b) { return a += b; });
+      });
+      print_counts(name, counts, options);
+    }
+  }
+  catch (cet::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -22,13 +22,13 @@
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Principal/Handle.h"
 #include "larevt/SpaceChargeServices/SpaceChargeService.h"
-#include "TVector3.h"
 #include "TH1D.h"
 #include "TH2D.h"
 #include "TFile.h"
 #include "TMath.h"
 
 #include "DataTypes.h"
+#include "EventContext.h"
 #include "GeometryHelper.h"
 
 namespace stoppingcosmicmuonselection {
@@ -37,14 +37,14 @@ namespace stoppingcosmicmuonselection {
 
   public:
     SceHelper();
-    SceHelper(detinfo::DetectorPropertiesData const& detprop);
+    SceHelper(const EventContext &context);
     ~SceHelper();
 
-    // Get corrected position given TVector3
-    TVector3 GetCorrectedPos(const TVector3 &pos);
+    // Get corrected position given a point
+    Point3 GetCorrectedPos(const Point3 &pos);
 
     // Get corrected field vector at point.
-    TVector3 GetFieldVector(const TVector3 &pos);
+    Vec3 GetFieldVector(const Point3 &pos);
 
   private:
 
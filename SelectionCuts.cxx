@@ -0,0 +1,221 @@
+/***
+  Functions containing the cuts of the stopping muon selection.
+  They only look at the track features, so the art selection and the
+  offline re-selection apply exactly the same predicates.
+
+*/
+#ifndef SELECTION_CUTS_CXX
+#define SELECTION_CUTS_CXX
+
+#include <cmath>
+#include "cetlib_except/exception.h"
+
+#include "SelectionCuts.h"
+
+namespace stoppingcosmicmuonselection {
+
+  namespace {
+
+    // Same as GeometryHelper::IsPointInVolume on the fiducial volume.
+    // The coordinates excluded by kExcludeEndPointX/Y/Z are not checked.
+    bool is_point_in_fiducial_volume(const double *activeBounds, const double &offset,
+                                     const double &x, const double &y, const double &z,
+                                     const uint32_t &excludedCuts) {
+      return ((excludedCuts & kExcludeEndPointX || (x >= activeBounds[0]+offset && x <= activeBounds[1]-offset))
+              && (excludedCuts & kExcludeEndPointY || (y >= activeBounds[2]+offset && y <= activeBounds[3]-offset))
+              && (excludedCuts & kExcludeEndPointZ || (z >= activeBounds[4]+offset && z <= activeBounds[5]-offset)));
+    }
+
+    // Same as GeometryHelper::IsPointInSlice.
+    bool is_point_in_slice(const double *activeBounds, const double &thickness,
+                           const double &x, const double &y, const double &z) {
+      return (   (y>=(activeBounds[3]-thickness) && y<=activeBounds[3])
+              || (x>=activeBounds[0] && x<=(activeBounds[0]+thickness))
+              || (x<=activeBounds[1] && x>=(activeBounds[1]-thickness))
+              || (z>=activeBounds[4] && z<=(activeBounds[4]+thickness))
+              || (z<=activeBounds[5] && z>=(activeBounds[5]-thickness)));
+    }
+
+    // Same as GeometryHelper::IsPointYZProjectionInArea.
+    // The coordinates excluded by kExcludeStartPointY/Z are not checked.
+    bool is_point_yz_projection_in_area(const double *activeBounds, const double &offsetY, const double &offsetZ,
+                                        const double &y, const double &z, const uint32_t &excludedCuts) {
+      return ( (excludedCuts & kExcludeStartPointY || ((y>=(activeBounds[2]+offsetY)) && (y<=(activeBounds[3]-offsetY)))) &&
+               (excludedCuts & kExcludeStartPointZ || ((z>=(activeBounds[4]+offsetZ)) && (z<=(activeBounds[5]-offsetZ)))));
+    }
+
+    // Same as GeometryHelper::GetAPABoundaries.
+    bool is_close_to_apa(const double *activeBounds, const double &contour, const double &z) {
+      return ((std::abs(z-activeBounds[5]/3.)<=contour) || (std::abs(z-activeBounds[5]*2/3.)<=contour));
+    }
+
+  }
+
+  // Read the cuts from a parameter set (same names and defaults as StoppingMuonSelectionAlg).
+  selectionCuts get_selection_cuts(fhicl::ParameterSet const &p) {
+    selectionCuts cuts;
+    // Set cuts for CC.
+    cuts.length_cutoff_CC               = p.get<double>("length_cutoff_CC",100);
+    cuts.offsetFiducialBounds_CC        = p.get<double>("offsetFiducialBounds_CC",50);
+    cuts.thicknessStartVolume_CC        = p.get<double>("thicknessStartVolume_CC",40);
+    cuts.cutMinHitPeakTime_CC           = p.get<double>("cutMinHitPeakTime_CC",500);
+    cuts.cutMaxHitPeakTime_CC           = p.get<double>("cutMaxHitPeakTime_CC",4800);
+    cuts.radiusBrokenTracksSearch_CC    = p.get<double>("radiusBrokenTracksSearch_CC",50);
+    cuts.cutCosAngleBrokenTracks_CC     = p.get<double>("cutCosAngleBrokenTracks_CC",0.995);
+    cuts.cutCosAngleAlignment_CC        = p.get<double>("cutCosAngleAlignment_CC",0.995);
+    cuts.cutContourAPA_CC               = p.get<double>("cutContourAPA_CC",10);
+    // Set cuts for AC.
+    cuts.length_cutoff_AC               = p.get<double>("length_cutoff_AC",100);
+    cuts.offsetYStartPoint_AC           = p.get<double>("offsetYStartPoint_AC", 30);
+    cuts.offsetZStartPoint_AC           = p.get<double>("offsetZStartPoint_AC", 50);
+    cuts.cutMinHitPeakTime_AC           = p.get<double>("cutMinHitPeakTime_AC", 700);
+    cuts.cutMaxHitPeakTime_AC           = p.get<double>("cutMaxHitPeakTime_AC", 4800);
+    cuts.radiusBrokenTracksSearch_AC    = p.get<double>("radiusBrokenTracksSearch_AC", 10);
+    cuts.cutCosAngleBrokenTracks_AC     = p.get<double>("cutCosAngleBrokenTracks_AC", 0.995);
+    cuts.cutCosAngleAlignment_AC        = p.get<double>("cutCosAngleAlignment_AC", 0.995);
+    cuts.cutContourAPA_AC               = p.get<double>("cutContourAPA_AC", 10);
+    cuts.offsetFiducialBounds_AC        = p.get<double>("offsetFiducialBounds_AC",50);
+    return cuts;
+  }
+
+  // Name of a cut.
+  std::string get_selection_cut_name(const size_t &cut) {
+    switch (cut) {
+      case kPassedAllCuts:     return "passed all cuts";
+      case kNoT0:              return "no T0";
+      case kTrackLength:       return "track too short";
+      case kNotCathodeCrosser: return "track not crossing the cathode";
+      case kStartPoint:        return "start point not accepted";
+      case kStartPointX:       return "start point too close to the cathode";
+      case kEndPoint:          return "end point not accepted";
+      case kMinHitPeakTime:    return "minHitPeakTime not accepted";
+      case kMaxHitPeakTime:    return "maxHitPeakTime not accepted";
+      case kContourAPA:        return "extreme points too close to APA";
+      case kBrokenTrack:       return "track is broken";
+      case kNoHitsOnCryoSide:  return "no hits on the cryostat side";
+      default:                 return "unknown cut";
+    }
+  }
+
+  // Cuts excluded by the N-1 study of a CutCheck parameter name. kExcludeNone for "complete".
+  uint32_t get_excluded_cuts(const std::string &excludeCut) {
+    if (excludeCut == "thicknessStartVolume")    return kExcludeStartPoint;
+    if (excludeCut == "offsetYStartPoint")       return kExcludeStartPointY;
+    if (excludeCut == "offsetZStartPoint")       return kExcludeStartPointZ;
+    if (excludeCut == "distanceFiducialVolumeX") return kExcludeEndPointX;
+    if (excludeCut == "distanceFiducialVolumeY") return kExcludeEndPointY;
+    if (excludeCut == "distanceFiducialVolumeZ") return kExcludeEndPointZ;
+    if (excludeCut == "cutMinHitPeakTime")       return kExcludeMinHitPeakTime;
+    if (excludeCut == "cutMaxHitPeakTime")       return kExcludeMaxHitPeakTime;
+    if (excludeCut == "cutContourAPA")           return kExcludeContourAPA;
+    if (excludeCut == "brokenTrack")             return kExcludeBrokenTrack;
+    if (excludeCut == "complete")                return kExcludeNone;
+    throw cet::exception("SelectionCuts.cxx") << "Unknown cut to exclude: " << excludeCut;
+  }
+
+  // Check if a neighbour makes the track a broken one.
+  bool is_broken_track(const brokenTrackNeighbour &neighbour,
+                       const double &cutCosAngleBrokenTracks,
+                       const double &cutCosAngleAlignment,
+                       const double &radiusBrokenTracksSearch) {
+    if ( (neighbour.absCosAlpha > cutCosAngleBrokenTracks) && (neighbour.cosBeta >= cutCosAngleAlignment) )
+      return true;
+    if (neighbour.distHigherLower < radiusBrokenTracksSearch && neighbour.absCosAlpha > MIN_COS_ALPHA_CLOSE_TRACKS)
+      return true;
+    return false;
+  }
+
+  // Work out t0 and the X shift of an anode crosser. INV_DBL if the start point is not on the anode side.
+  double get_anode_crosser_t0(const double &startX, const double &endX,
+                              const double &driftDistance, const double &driftVelocity,
+                              double &shiftX) {
+    double t0 = INV_DBL;
+    shiftX = 0.;
+    if (startX <= endX) {
+      if (startX <= 0) {
+        t0 = (driftDistance - std::abs(startX)) /driftVelocity;
+        shiftX = -(driftVelocity * t0);
+      }
+    }
+    else {
+      if (startX >= 0) {
+        t0 = (driftDistance - std::abs(startX)) /driftVelocity;
+        shiftX = (driftVelocity * t0);
+      }
+    }
+    return t0;
+  }
+
+  // Apply the cathode crosser cuts, but the excluded ones. Return the first failed cut.
+  // Without a loader the lazy features must already be filled.
+  size_t apply_cathode_crosser_cuts(const trackFeatures &f,
+                                    const selectionCuts &cuts,
+                                    const selectionConstants &constants,
+                                    const uint32_t &excludedCuts,
+                                    const lazyFeatureLoader &loadFeature) {
+    const double *av = constants.activeBounds;
+    if (f.pandoraT0 == INV_DBL) return kNoT0;
+    if (f.trackLength < cuts.length_cutoff_CC) return kTrackLength;
+    if (!(f.startX*f.endX<0)) return kNotCathodeCrosser;
+    if (!(excludedCuts & kExcludeStartPoint) && !is_point_in_slice(av,cuts.thicknessStartVolume_CC,f.startX,f.startY,f.startZ)) return kStartPoint;
+    if (!is_point_in_fiducial_volume(av,cuts.offsetFiducialBounds_CC,f.endX,f.endY,f.endZ,excludedCuts)) return kEndPoint;
+    // Additional cut for prod4.
+    if (!(excludedCuts & kExcludeStartPoint) && std::abs(f.startX)<MIN_ABS_START_X_CC) return kStartPointX;
+    if (!(excludedCuts & kExcludeMinHitPeakTime) && f.minHitPeakTime <= cuts.cutMinHitPeakTime_CC) return kMinHitPeakTime;
+    if (!(excludedCuts & kExcludeMaxHitPeakTime) && f.maxHitPeakTime >= cuts.cutMaxHitPeakTime_CC) return kMaxHitPeakTime;
+    if (!(excludedCuts & kExcludeContourAPA) && is_close_to_apa(av,cuts.cutContourAPA_CC,f.endZ)) return kContourAPA;
+    if (excludedCuts & kExcludeBrokenTrack) return kPassedAllCuts;
+    if (loadFeature) loadFeature(kNeighbours);
+    // Only the tracks below this one are looked at.
+    for (const brokenTrackNeighbour &neighbour : f.neighbours) {
+      if (!neighbour.isHigher) continue;
+      if (is_broken_track(neighbour,cuts.cutCosAngleBrokenTracks_CC,cuts.cutCosAngleAlignment_CC,cuts.radiusBrokenTracksSearch_CC))
+        return kBrokenTrack;
+    }
+    return kPassedAllCuts;
+  }
+
+  // Apply the anode crosser cuts, but the excluded ones. Return the first failed cut.
+  // t0 and shiftX are set once the cuts reach the T0 step.
+  // Without a loader the lazy features must already be filled.
+  size_t apply_anode_crosser_cuts(const trackFeatures &f,
+                                  const selectionCuts &cuts,
+                                  const selectionConstants &constants,
+                                  double &t0, double &shiftX,
+                                  const uint32_t &excludedCuts,
+                                  const lazyFeatureLoader &loadFeature) {
+    const double *av = constants.activeBounds;
+    t0 = INV_DBL;
+    shiftX = 0.;
+    if (f.trackLength < cuts.length_cutoff_AC) return kTrackLength;
+    if (!(excludedCuts & kExcludeStartPoint)
+        && !is_point_yz_projection_in_area(av,cuts.offsetYStartPoint_AC,cuts.offsetZStartPoint_AC,f.startY,f.startZ,excludedCuts)) return kStartPoint;
+    if (!(excludedCuts & kExcludeMinHitPeakTime) && f.minHitPeakTime <= cuts.cutMinHitPeakTime_AC) return kMinHitPeakTime;
+    if (!(excludedCuts & kExcludeMaxHitPeakTime) && f.maxHitPeakTime >= cuts.cutMaxHitPeakTime_AC) return kMaxHitPeakTime;
+    if (!(excludedCuts & kExcludeContourAPA)
+        && (is_close_to_apa(av,cuts.cutContourAPA_AC,f.startZ) || is_close_to_apa(av,cuts.cutContourAPA_AC,f.endZ))) return kContourAPA;
+    if (!(excludedCuts & kExcludeBrokenTrack)) {
+      if (loadFeature) loadFeature(kNeighbours);
+      for (const brokenTrackNeighbour &neighbour : f.neighbours) {
+        if (is_broken_track(neighbour,cuts.cutCosAngleBrokenTracks_AC,cuts.cutCosAngleAlignment_AC,cuts.radiusBrokenTracksSearch_AC))
+          return kBrokenTrack;
+      }
+    }
+    // Use the Pandora T0 if there is one, otherwise assume the track crosses the anode.
+    if (f.pandoraT0 == INV_DBL) {
+      t0 = get_anode_crosser_t0(f.startX,f.endX,constants.driftDistance,f.driftVelocity,shiftX);
+      if (t0 == INV_DBL) return kNoT0;
+    }
+    else {
+      t0 = f.pandoraT0;
+      // Tracks tagged by Pandora need hits on the cryostat side.
+      if (loadFeature) loadFeature(kHitsOnCryoSide);
+      if (!f.hasHitsOnCryoSide) return kNoHitsOnCryoSide;
+    }
+    if (!is_point_in_fiducial_volume(av,cuts.offsetFiducialBounds_AC,f.endX+shiftX,f.endY,f.endZ,excludedCuts)) return kEndPoint;
+    return kPassedAllCuts;
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
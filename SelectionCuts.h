@@ -0,0 +1,128 @@
+/***
+  Functions containing the cuts of the stopping muon selection.
+  They only look at the track features, so the art selection and the
+  offline re-selection apply exactly the same predicates.
+
+*/
+#ifndef SELECTION_CUTS_H
+#define SELECTION_CUTS_H
+
+#include <functional>
+#include <string>
+#include "fhiclcpp/ParameterSet.h"
+
+#include "TrackFeatures.h"
+
+namespace stoppingcosmicmuonselection {
+
+  // Thresholds of the selection.
+  struct selectionCuts {
+    // Cathode crossers
+    double length_cutoff_CC;
+    double offsetFiducialBounds_CC;
+    double thicknessStartVolume_CC;
+    double cutMinHitPeakTime_CC;
+    double cutMaxHitPeakTime_CC;
+    double radiusBrokenTracksSearch_CC;
+    double cutCosAngleBrokenTracks_CC;
+    double cutCosAngleAlignment_CC;
+    double cutContourAPA_CC;
+    // Anode crossers
+    double length_cutoff_AC;
+    double offsetYStartPoint_AC;
+    double offsetZStartPoint_AC;
+    double cutMinHitPeakTime_AC;
+    double cutMaxHitPeakTime_AC;
+    double radiusBrokenTracksSearch_AC;
+    double cutCosAngleBrokenTracks_AC;
+    double cutCosAngleAlignment_AC;
+    double cutContourAPA_AC;
+    double offsetFiducialBounds_AC;
+  };
+
+  // Cut that rejected a track, in no particular order.
+  enum selectionCut {
+    kPassedAllCuts = 0,
+    kNoT0,
+    kTrackLength,
+    kNotCathodeCrosser,
+    kStartPoint,
+    kStartPointX,
+    kEndPoint,
+    kMinHitPeakTime,
+    kMaxHitPeakTime,
+    kContourAPA,
+    kBrokenTrack,
+    kNoHitsOnCryoSide,
+    kNumbSelectionCuts
+  };
+
+  // Cuts left out of the selection by the N-1 studies, combined as a bit mask.
+  enum selectionCutExclusion {
+    kExcludeNone           = 0,
+    kExcludeStartPoint     = 1 << 0,  // whole start point cut
+    kExcludeStartPointY    = 1 << 1,  // Y of the start point (anode crossers)
+    kExcludeStartPointZ    = 1 << 2,  // Z of the start point (anode crossers)
+    kExcludeEndPointX      = 1 << 3,
+    kExcludeEndPointY      = 1 << 4,
+    kExcludeEndPointZ      = 1 << 5,
+    kExcludeMinHitPeakTime = 1 << 6,
+    kExcludeMaxHitPeakTime = 1 << 7,
+    kExcludeContourAPA     = 1 << 8,
+    kExcludeBrokenTrack    = 1 << 9
+  };
+
+  // Features that are only computed once a cut needs them.
+  enum lazyTrackFeature {
+    kNeighbours,
+    kHitsOnCryoSide
+  };
+
+  // Called before a cut looks at a lazy feature. It fills the features in place.
+  using lazyFeatureLoader = std::function<void(const lazyTrackFeature &)>;
+
+  // Fixed cuts, not configurable in StoppingMuonSelectionAlg.
+  constexpr double MIN_ABS_START_X_CC = 20.;
+  constexpr double MIN_COS_ALPHA_CLOSE_TRACKS = 0.96;
+
+  // Read the cuts from a parameter set (same names and defaults as StoppingMuonSelectionAlg).
+  selectionCuts get_selection_cuts(fhicl::ParameterSet const &p);
+
+  // Name of a cut.
+  std::string get_selection_cut_name(const size_t &cut);
+
+  // Cuts excluded by the N-1 study of a CutCheck parameter name. kExcludeNone for "complete".
+  uint32_t get_excluded_cuts(const std::string &excludeCut);
+
+  // Check if a neighbour makes the track a broken one.
+  bool is_broken_track(const brokenTrackNeighbour &neighbour,
+                       const double &cutCosAngleBrokenTracks,
+                       const double &cutCosAngleAlignment,
+                       const double &radiusBrokenTracksSearch);
+
+  // Work out t0 and the X shift of an anode crosser. INV_DBL if the start point is not on the anode side.
+  double get_anode_crosser_t0(const double &startX, const double &endX,
+                              const double &driftDistance, const double &driftVelocity,
+                              double &shiftX);
+
+  // Apply the cathode crosser cuts, but the excluded ones. Return the first failed cut.
+  // Without a loader the lazy features must already be filled.
+  size_t apply_cathode_crosser_cuts(const trackFeatures &features,
+                                    const selectionCuts &cuts,
+                                    const selectionConstants &constants,
+                                    const uint32_t &excludedCuts = kExcludeNone,
+                                    const lazyFeatureLoader &loadFeature = lazyFeatureLoader());
+
+  // Apply the anode crosser cuts, but the excluded ones. Return the first failed cut.
+  // t0 and shiftX are set once the cuts reach the T0 step.
+  // Without a loader the lazy features must already be filled.
+  size_t apply_anode_crosser_cuts(const trackFeatures &features,
+                                  const selectionCuts &cuts,
+                                  const selectionConstants &constants,
+                                  double &t0, double &shiftX,
+                                  const uint32_t &excludedCuts = kExcludeNone,
+                                  const lazyFeatureLoader &loadFeature = lazyFeatureLoader());
+
+}
+
+#endif
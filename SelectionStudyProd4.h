@@ -28,7 +28,22 @@
 #include "StoppingMuonSelectionAlg.h"
 #include "HitHelper.h"
 #include "HitPlaneAlg.h"
+#include "HitCache.h"
+#include "TruthHitCache.h"
+#include "TruthMatchTable.h"
+#include "TrackIDIndex.h"
+#include "CandidateTable.h"
+#include "EventArena.h"
+#include "EventContext.h"
+#include "EventTablesGuard.h"
+#include "TruthProvider.h"
+#include "TrackHitTable.h"
+#include "CNNScoreTable.h"
+#include "TrackPlanesAlg.h"
+#include "TrackFeatures.h"
 #include "CNNHelper.h"
+#include "Instrumentation.h"
+#include "Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -57,6 +72,7 @@ public:
 
   // Function called by the analyze function
   void UpdateTTreeVariableWithTrackProperties(const trackProperties &trackProp);
+  void UpdateTTreeVariableWithPlaneRecords();
 
 private:
 
@@ -64,12 +80,25 @@ private:
   int counter_T0_tagged_tracks = 0;
   int counter_total_number_events = 0;
   int counter_total_number_tracks = 0;
+  int counter_compared_hit_orderings = 0;
+  int counter_same_hit_orderings = 0;
+  double sum_hit_ordering_disagreement = 0.;
 
   GeometryHelper           geoHelper;
   SpacePointAlg            spAlg;        // need configuration
   StoppingMuonSelectionAlg selectorAlg;  // need configuration
   CalorimetryHelper        caloHelper;   // need configuration
   HitHelper                hitHelper;    // need configuration
+  HitCache                 hitCache;
+  TruthHitCache            truthCache;
+  TruthMatchTable          truthTable;
+  TrackIDIndex             trackIDIndex;
+  CandidateTable           candidateTable;
+  TrackHitTable            trackHitTable;
+  HitPlaneAlg              hitPlaneAlg;
+  HitPlaneAlg              otherHitPlaneAlg; // for the comparison of the hit orderings
+  CNNScoreTable            cnnScores;
+  TrackPlanesAlg           trackPlanesAlg; // need configuration
   CNNHelper             cnnHelper;
 
   // Parameters form FHICL File
@@ -79,15 +108,24 @@ private:
   size_t _numberNeighbors;
   double _michelScoreThreshold;
   double _michelScoreThresholdAvg;
+  bool _orderHitsByTrajectory;
+  bool _compareHitOrderings;
+  bool _processAllPlanes;
+  bool _dumpFeatures;
   bool _selectAC, _selectCC;
+  bool _useCandidates;
   std::string fPFParticleTag, fSpacePointTag, fTrackerTag;
-  std::string fNNetTag;
+  std::string fCandidateTag;
+  std::string fNNetTag, fHitTag, fSimChannelTag;
 
   // Utils
   protoana::ProtoDUNEPFParticleUtils   pfpUtil;
 
   // Track Tree stuff
   TTree *fTrackTree;
+  // Selection features, one entry per track-like PFParticle
+  TTree *fFeaturesTree = nullptr;
+  TrackFeaturesTree featuresTree;
   // Tree variables
   size_t fEvNumber;
   int    fPdgID = INV_INT;
@@ -115,6 +153,7 @@ private:
   double fMaxHitPeakTime = INV_DBL;
   double fDistEndPoint = INV_DBL;
   double fDistEndPointNoMichel = INV_DBL;
+  double fHitOrderingDisagreement = INV_DBL;
   bool fIsRecoSelectedCathodeCrosser = false;
   bool fIsRecoSelectedAnodeCrosser = false;
   bool fIsTrueSelectedCathodeCrosser = false;
@@ -123,6 +162,13 @@ private:
   bool fIsAnodeMine = false;
   std::vector<double> f_michelHitsMichelScore;
   std::vector<double> f_muonHitsMichelScore;
+  // One entry per plane
+  std::vector<int> f_planeNumbHits;
+  std::vector<int> f_planeNumbOrderedHits;
+  std::vector<std::vector<double>> f_planeDqds;
+  std::vector<std::vector<double>> f_planeLocalLin;
+  std::vector<std::vector<double>> f_planedQdx;
+  std::vector<std::vector<double>> f_planeResRange;
   // Objects for TTree
   std::string filename;
   // TH1s
@@ -189,6 +235,7 @@ void SelectionStudyProd4::beginJob()
   fTrackTree->Branch("theta_yz", &ftheta_yz, "ftheta_yz/d");
   fTrackTree->Branch("distEndPoint", &fDistEndPoint, "fDistEndPoint/d");
   fTrackTree->Branch("distEndPointNoMichel", &fDistEndPointNoMichel, "fDistEndPointNoMichel/d");
+  fTrackTree->Branch("hitOrderingDisagreement", &fHitOrderingDisagreement, "fHitOrderingDisagreement/d");
   fTrackTree->Branch("isRecoSelectedCathodeCrosser",&fIsRecoSelectedCathodeCrosser);
   fTrackTree->Branch("isTrueSelectedCathodeCrosser",&fIsTrueSelectedCathodeCrosser);
   fTrackTree->Branch("isRecoSelectedAnodeCrosser",&fIsRecoSelectedAnodeCrosser);
@@ -209,6 +256,21 @@ void SelectionStudyProd4::beginJob()
   fTrackTree->Branch("g_CnnScore", &fg_CnnScore);
   fTrackTree->Branch("michelHitsMichelScore", &f_michelHitsMichelScore);
   fTrackTree->Branch("muonHitsMichelScore", &f_muonHitsMichelScore);
+  if (_processAllPlanes) {
+    fTrackTree->Branch("planeNumbHits", &f_planeNumbHits);
+    fTrackTree->Branch("planeNumbOrderedHits", &f_planeNumbOrderedHits);
+    fTrackTree->Branch("planeDqds", &f_planeDqds);
+    fTrackTree->Branch("planeLocalLin", &f_planeLocalLin);
+    fTrackTree->Branch("planedQdx", &f_planedQdx);
+    fTrackTree->Branch("planeResRange", &f_planeResRange);
+  }
+
+  if (_dumpFeatures) {
+    fFeaturesTree = tfs->make<TTree>("FeaturesTree", "selection features by PFParticle");
+    featuresTree.SetUpForWriting(fFeaturesTree);
+    TTree *constantsTree = tfs->make<TTree>("SelectionConstants", "constants of the selection features");
+    featuresTree.WriteConstants(constantsTree, selectorAlg.GetSelectionConstants());
+  }
 
   // Init the graph for the hits
   fg_imageCollection = new TGraph2D();
@@ -243,29 +305,56 @@ void SelectionStudyProd4::beginJob()
 
 void SelectionStudyProd4::endJob()
 {
-  mf::LogVerbatim("SelectionStudyProd4") << "SelectionStudyProd4 finished job";
-  std::cout << "Total number of events: " << counter_total_number_events << std::endl;
-  std::cout << "Total number of tracks: " << counter_total_number_tracks << std::endl;
-  std::cout << "Number of T0-tagged tracks: " << counter_T0_tagged_tracks << std::endl;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "SelectionStudyProd4 finished job";
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Total number of events: " << counter_total_number_events;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Total number of tracks: " << counter_total_number_tracks;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Number of T0-tagged tracks: " << counter_T0_tagged_tracks;
+  if (_compareHitOrderings) {
+    STOPPING_MUON_LOG_INFO(kLogModules) << "Tracks with both hit orderings: " << counter_compared_hit_orderings;
+    STOPPING_MUON_LOG_INFO(kLogModules) << "Tracks with the same hit ordering: " << counter_same_hit_orderings;
+    if (counter_compared_hit_orderings > 0)
+      STOPPING_MUON_LOG_INFO(kLogModules) << "Mean hit ordering disagreement: " << sum_hit_ordering_disagreement/counter_compared_hit_orderings;
+  }
+  // Time per stage, only filled when compiled with STOPPING_MUON_INSTRUMENTATION.
+  if (Instrumentation::IsEnabled()) {
+    // Written by the first module of the job only.
+    if (Instrumentation::Get().ClaimWrite()) {
+      art::ServiceHandle<art::TFileService> tfs;
+      Instrumentation::Get().Write(tfs->make<TTree>("Instrumentation","Instrumentation"));
+    }
+    Instrumentation::Get().Print();
+  }
 }
 
 void SelectionStudyProd4::respondToOpenInputFile(art::FileBlock const &inputFile) {
   filename = inputFile.fileName();
-  std::cout << "Analyzer on file: " << filename << std::endl;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Analyzer on file: " << filename;
 }
 
 void SelectionStudyProd4::reconfigure(fhicl::ParameterSet const& p)
 {
+  Logger::Get().reconfigure(p.get<fhicl::ParameterSet>("Logging", fhicl::ParameterSet()));
+  TruthProvider::Get().reconfigure(p);
   fTrackerTag = p.get<std::string>("TrackerTag");
   fPFParticleTag = p.get<std::string>("PFParticleTag");
   fSpacePointTag = p.get<std::string>("SpacePointTag");
+  // Candidates of StoppingMuonProducer. If empty, the selection is run here.
+  fCandidateTag = p.get<std::string>("CandidateTag", "");
+  _useCandidates = !fCandidateTag.empty();
   fNNetTag = p.get<std::string>("NNetTag");
+  fHitTag = p.get<std::string>("HitTag", "hitpdune");
+  fSimChannelTag = p.get<std::string>("SimChannelTag", "tpcrawdecoder:simpleSC");
   _minNumbMichelLikeHit = p.get<size_t>("minNumbMichelLikeHit", 2);
   _trackPitch = p.get<double>("trackPitch", 0.75);
   _trackPitchTolerance = p.get<double>("trackPitchTolerance", 0.1);
   _numberNeighbors = p.get<size_t>("numberNeighbors", 2);
   _michelScoreThreshold = p.get<double>("michelScoreThreshold", 0.7);
   _michelScoreThresholdAvg = p.get<double>("michelScoreThresholdAvg", 0.5);
+  _orderHitsByTrajectory = p.get<bool>("orderHitsByTrajectory", false);
+  _compareHitOrderings = p.get<bool>("compareHitOrderings", false);
+  _processAllPlanes = p.get<bool>("processAllPlanes", false);
+  if (_processAllPlanes) trackPlanesAlg.reconfigure(p);
+  _dumpFeatures = p.get<bool>("dumpFeatures", false);
   _selectAC = p.get<bool>("selectAC", true);
   _selectCC = p.get<bool>("selectCC", true);
   spAlg.reconfigure(p.get<fhicl::ParameterSet>("SpacePointAlg"));
@@ -274,6 +363,24 @@ void SelectionStudyProd4::reconfigure(fhicl::ParameterSet const& p)
   hitHelper.reconfigure(p.get<fhicl::ParameterSet>("HitHelper"));
 }
 
+void SelectionStudyProd4::UpdateTTreeVariableWithPlaneRecords() {
+  f_planeNumbHits.clear();
+  f_planeNumbOrderedHits.clear();
+  f_planeDqds.clear();
+  f_planeLocalLin.clear();
+  f_planedQdx.clear();
+  f_planeResRange.clear();
+  for (size_t plane = 0; plane < trackPlanesAlg.GetNumbPlanes(); plane++) {
+    const planeRecord &record = trackPlanesAlg.GetPlaneRecord(plane);
+    f_planeNumbHits.push_back(record.nHits);
+    f_planeNumbOrderedHits.push_back(record.orderedHits.size());
+    f_planeDqds.push_back(record.Dqds);
+    f_planeLocalLin.push_back(record.localLinearity);
+    f_planedQdx.push_back(record.dQdx);
+    f_planeResRange.push_back(record.resRange);
+  }
+}
+
 void SelectionStudyProd4::UpdateTTreeVariableWithTrackProperties(const trackProperties &trackInfo) {
   fEvNumber       = trackInfo.evNumber;
   fT0_reco        = trackInfo.trackT0;
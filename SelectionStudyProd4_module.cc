@@ -13,8 +13,7 @@ namespace stoppingcosmicmuonselection {
     // increase counter and store event number
     counter_total_number_events++;
     fEvNumber = evt.id().event();
-    std::cout << "SelectionStudyProd4_module is on event: " << fEvNumber <<  " run: " << evt.id().run() << std::endl;
-    mf::LogVerbatim("SelectionStudyProd4") << "SelectionStudyProd4 module on event " << fEvNumber;
+    STOPPING_MUON_LOG_INFO(kLogModules) << "SelectionStudyProd4 module on event " << fEvNumber << " run: " << evt.id().run();
 
     // Get handles
     // trackHandle is art::ValidHandle<std::vector<recob::Track>>
@@ -24,23 +23,46 @@ namespace stoppingcosmicmuonselection {
     if (!pfparticleHandle.isValid()) return;
     auto const &recoParticles = *pfparticleHandle;
     auto const spacePointHandle = evt.getValidHandle<std::vector<recob::SpacePoint>>(fSpacePointTag);
-    const std::vector<recob::SpacePoint> spacePoints = *spacePointHandle;
+    spAlg.SetSpacePoints(*spacePointHandle);
     
-    // Add handle for clock and detector properties.
-    auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-    auto const detProp = art::ServiceHandle<detinfo::DetectorPropertiesService>()->DataFor(evt, clockData);
+    // Free the temporaries of the previous event.
+    EventArena::NewEvent();
+    // Reject MC events in a data-only job, before any truth access.
+    TruthProvider::Get().CheckEvent(evt);
+    // Clock and detector properties of this event, for all the helpers.
+    const EventContext context(evt);
     
     // Get track handle.
     art::Handle<std::vector<recob::Track>> trackListHandle;
-    std::vector<art::Ptr<recob::Track>> tracklist;
-    if (evt.getByLabel(fTrackerTag,trackListHandle))
-      art::fill_ptr_vector(tracklist, trackListHandle);
+    evt.getByLabel(fTrackerTag,trackListHandle);
+    // Fill the track index for this event.
+    trackIDIndex.Set(evt, fTrackerTag);
+    selectorAlg.SetTrackIDIndex(&trackIDIndex);
+    selectorAlg.SetEventContext(&context);
+    // Clear the pointers to the tables and context when the event ends, also on exceptions.
+    const EventTablesGuard<StoppingMuonSelectionAlg> tablesGuard(selectorAlg);
+    const std::vector<art::Ptr<recob::Track>> &tracklist = trackIDIndex.GetTrackList();
     // Get association to metadata and hit.
     art::FindManyP<recob::Hit, recob::TrackHitMeta> fmthm(trackListHandle, evt, fTrackerTag);
     art::FindManyP<recob::Hit> fmht(trackListHandle, evt, fTrackerTag);
+    // Fill the hit table for this event.
+    hitCache.Set(evt, fHitTag);
+    // Read the CNN Michel scores once for all the hits.
+    cnnScores.Set(evt, fNNetTag, hitCache);
+    // Fill the hit truth table and the PFParticle truth matching (MC only).
+    if (!evt.isRealData()) {
+      truthCache.Set(evt, fSimChannelTag, hitCache, context);
+      truthTable.Set(evt, fPFParticleTag, hitCache, truthCache);
+    }
+    selectorAlg.SetTruthMatchTable(&truthTable);
 
-    // Iterates over the vector of PFParticles
-    for (unsigned int p = 0; p < recoParticles.size(); ++p) {
+    // Read the candidates of StoppingMuonProducer, if its selection is used.
+    if (_useCandidates) candidateTable.Set(evt, fCandidateTag, fPFParticleTag);
+    const size_t nParticles = _useCandidates ? candidateTable.Size() : recoParticles.size();
+
+    // Iterates over the vector of PFParticles, or over the PFParticles of the candidates
+    for (unsigned int c = 0; c < nParticles; ++c) {
+      const unsigned int p = _useCandidates ? candidateTable.GetPFParticle(c).key() : c;
 
       fIsRecoSelectedCathodeCrosser = false;
       fIsRecoSelectedAnodeCrosser = false;
@@ -60,14 +82,39 @@ namespace stoppingcosmicmuonselection {
       if (!selectorAlg.IsPFParticleATrack(evt,thisParticle)) continue;
       counter_total_number_tracks++;
 
+      // Store what the cuts look at, to re-apply them without art.
+      if (_dumpFeatures) {
+        selectorAlg.SetTrackFeatures(evt,thisParticle,true);
+        trackFeatures features = selectorAlg.GetTrackFeatures();
+        if (!evt.isRealData()) {
+          features.isTrueCosmic = selectorAlg.IsTrackMatchedToTrueCosmicTrack(evt,thisParticle);
+          if (features.isTrueCosmic) {
+            features.isTrueCathodeCrosser = selectorAlg.IsTrueParticleACathodeCrossingStoppingMuon(evt,thisParticle);
+            features.isTrueAnodeCrosser = selectorAlg.IsTrueParticleAnAnodeCrossingStoppingMuon(evt,thisParticle);
+            features.pdg = selectorAlg.GetTrackProperties().pdg;
+          }
+        }
+        featuresTree.Fill(features);
+      }
+
       // If this is MC we want that the PFParticle is matched to a cosmic MCParticle
-      if (!evt.isRealData() && !selectorAlg.IsTrackMatchedToTrueCosmicTrack(evt,thisParticle))
+      if (!evt.isRealData() && !(_useCandidates ? candidateTable.GetCandidate(c).HasBits(kTrueCosmic)
+                                                : selectorAlg.IsTrackMatchedToTrueCosmicTrack(evt,thisParticle)))
         continue;
 
       // Check if this PFParticle is a stopping muon.
       //      !!!SELECTION STEP!!!
       //
-      if (_selectCC && selectorAlg.IsStoppingCathodeCrosser(evt,thisParticle))
+      if (_useCandidates) {
+        // Already selected by StoppingMuonProducer: take the T0 and the corrected points of the candidate.
+        const StoppingMuonCandidate &candidate = candidateTable.GetCandidate(c);
+        if (!candidate.HasBits(kPassSelection | kGoodSpacePoints)) continue;
+        fIsRecoSelectedCathodeCrosser = _selectCC && candidate.type == kCathodeCrosser;
+        fIsRecoSelectedAnodeCrosser = _selectAC && candidate.type != kCathodeCrosser;
+        if (!fIsRecoSelectedCathodeCrosser && !fIsRecoSelectedAnodeCrosser) continue;
+        selectorAlg.SetTrackProperties(evt,candidate,*candidateTable.GetTrack(c));
+      }
+      else if (_selectCC && selectorAlg.IsStoppingCathodeCrosser(evt,thisParticle))
         fIsRecoSelectedCathodeCrosser = true;
       else if (_selectAC && selectorAlg.IsStoppingAnodeCrosser(evt,thisParticle))
         fIsRecoSelectedAnodeCrosser = true;
@@ -75,10 +122,10 @@ namespace stoppingcosmicmuonselection {
         continue;
 
       // Check if the track is missing some space points (need to get
-      // an handle on the track)
-      const recob::Track &track = selectorAlg.GetTrackFromPFParticle(evt,thisParticle);
-      if(!spAlg.IsGoodTrack(track,spacePoints,selectorAlg.GetTrackProperties())) {
-        std::cout << "Space point alg: " << "TrackID: " << track.ID() << " not accepted." << std::endl;
+      // an handle on the track). The candidates were checked by StoppingMuonProducer.
+      const recob::Track &track = _useCandidates ? *candidateTable.GetTrack(c) : selectorAlg.GetTrackFromPFParticle(evt,thisParticle);
+      if(!_useCandidates && !spAlg.IsGoodTrack(track,selectorAlg.GetTrackProperties())) {
+        STOPPING_MUON_LOG_DEBUG(kLogModules) << "Space point alg: " << "TrackID: " << track.ID() << " not accepted.";
         continue;
       }
 
@@ -88,21 +135,23 @@ namespace stoppingcosmicmuonselection {
       else if (!evt.isRealData() && fIsRecoSelectedAnodeCrosser)
         fIsTrueSelectedAnodeCrosser = selectorAlg.IsTrueParticleAnAnodeCrossingStoppingMuon(evt,thisParticle);
 
-      std::cout << "**************************" << std::endl;
-      std::cout << "Track accepted." << std::endl;
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "**************************";
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "Track accepted.";
       if (fIsRecoSelectedCathodeCrosser)
-        std::cout << "Track is a CATHODE crosser." << std::endl;
+        STOPPING_MUON_LOG_DEBUG(kLogModules) << "Track is a CATHODE crosser.";
       else if (fIsRecoSelectedAnodeCrosser) {
-        std::cout << "Track is an ANODE crosser. Selected by Pandora? " << selectorAlg.GetTrackProperties().isAnodeCrosserPandora << std::endl;
+        STOPPING_MUON_LOG_DEBUG(kLogModules) << "Track is an ANODE crosser. Selected by Pandora? " << selectorAlg.GetTrackProperties().isAnodeCrosserPandora;
       }
-      std::cout << "Event: " << selectorAlg.GetTrackProperties().evNumber << std::endl;
-      std::cout << "trackID: " << selectorAlg.GetTrackProperties().trackID << std::endl;
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "Event: " << selectorAlg.GetTrackProperties().evNumber;
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "trackID: " << selectorAlg.GetTrackProperties().trackID;
 
       // Updating variables to be stored in TTree
       UpdateTTreeVariableWithTrackProperties(selectorAlg.GetTrackProperties());
 
       // Let's go to the Calorimetry. Need to set it for this track first.
-      caloHelper.Set(thisParticle,evt,2);
+      // Read it once, it is used for all the planes too.
+      const std::vector<anab::Calorimetry> trackCalos = caloHelper.GetTrackCalorimetry(thisParticle,evt);
+      caloHelper.Set(trackCalos,evt.isRealData(),2,context);
       // Fill the histos
       caloHelper.FillHisto_dQdxVsRR(h_dQdxVsRR);
       caloHelper.FillHisto_dQdxVsRR(h_dQdxVsRR_TP075,_trackPitch-_trackPitchTolerance,_trackPitch+_trackPitchTolerance);
@@ -111,15 +160,29 @@ namespace stoppingcosmicmuonselection {
       //caloHelper.FillHisto_dQdEVsRR_LTCorr_MC(h_dQdEVsRR_TP075_LTCorr_MC,_trackPitch-_trackPitchTolerance,_trackPitch+_trackPitchTolerance);
       //caloHelper.FillHisto_dQdEVsRR_LTCorr_LV(h_dQdEVsRR_TP075_LTCorr_LV,_trackPitch-_trackPitchTolerance,_trackPitch+_trackPitchTolerance);
 
-      size_t trackIndex = hitHelper.GetTrackIndex(track,tracklist);
+      size_t trackIndex = trackIDIndex.GetIndex(track);
       auto const &trackHits = hitHelper.GetArtPtrToHitVect(fmht,trackIndex);
       size_t numbMichelLikeHits = 0;
 
       // Init HitPlaneAlg.
-      const artPtrHitVec &hitsOnCollection = hitHelper.GetHitsOnAPlane(2,trackHits);
-      std::cout << "Hits on collection size: " << hitsOnCollection.size() << std::endl;
-      const size_t &hitIndex = hitHelper.GetIndexClosestHitToPoint(selectorAlg.GetTrackProperties().recoStartPoint,hitsOnCollection,fmthm,tracklist,trackIndex);
-      HitPlaneAlg hitPlaneAlg(trackHits,hitIndex,2,selectorAlg.GetTrackProperties().trackT0,clockData,detProp);
+      const hitIndexVec &trackHitIndex = hitCache.GetIndexVec(trackHits);
+      const hitIndexVec &hitsOnCollection = hitCache.GetHitsOnAPlane(2,trackHitIndex);
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "Hits on collection size: " << hitsOnCollection.size();
+      trackHitTable.Set(fmthm,trackIndex,*tracklist[trackIndex],hitCache);
+      const size_t &hitIndex = hitHelper.GetIndexClosestHitToPoint(selectorAlg.GetTrackProperties().recoStartPoint,hitsOnCollection,hitCache,trackHitTable);
+      hitPlaneAlg.Process(hitCache,trackHitIndex,hitIndex,2,selectorAlg.GetTrackProperties().trackT0,context,
+                          _orderHitsByTrajectory ? &trackHitTable : 0x0);
+      // Compare with the other hit ordering.
+      fHitOrderingDisagreement = INV_DBL;
+      if (_compareHitOrderings) {
+        otherHitPlaneAlg.Process(hitCache,trackHitIndex,hitIndex,2,selectorAlg.GetTrackProperties().trackT0,context,
+                                 _orderHitsByTrajectory ? 0x0 : &trackHitTable);
+        fHitOrderingDisagreement = get_ordering_disagreement(hitPlaneAlg.GetOrderedHitIndex(),otherHitPlaneAlg.GetOrderedHitIndex());
+        counter_compared_hit_orderings++;
+        if (fHitOrderingDisagreement == 0. && hitPlaneAlg.GetOrderedHitIndex().size() == otherHitPlaneAlg.GetOrderedHitIndex().size())
+          counter_same_hit_orderings++;
+        sum_hit_ordering_disagreement += fHitOrderingDisagreement;
+      }
       // Get the vectors.
       const std::vector<double> &WireIDs = hitPlaneAlg.GetOrderedWireNumb();
       const std::vector<double> &Qs = hitPlaneAlg.GetOrderedQ();
@@ -127,35 +190,41 @@ namespace stoppingcosmicmuonselection {
       const std::vector<double> &QsSmooth = hitPlaneAlg.Smoother(Qs,_numberNeighbors);
       const std::vector<double> &DqdsSmooth = hitPlaneAlg.Smoother(Dqds,_numberNeighbors);
       const std::vector<double> &LocalLin = hitPlaneAlg.CalculateLocalLinearity(_numberNeighbors);
-      std::cout << "Ordered hit size: " << hitPlaneAlg.GetOrderedHitVec().size() << std::endl;
+      STOPPING_MUON_LOG_DEBUG(kLogModules) << "Ordered hit size: " << hitPlaneAlg.GetOrderedHitVec().size();
+
+      // All the planes of the track, processed in parallel.
+      if (_processAllPlanes) {
+        trackPlanesAlg.Process(hitCache,trackHitIndex,trackHitTable,selectorAlg.GetTrackProperties().recoStartPoint,
+                               selectorAlg.GetTrackProperties().trackT0,trackCalos,
+                               evt.isRealData(),context);
+        UpdateTTreeVariableWithPlaneRecords();
+      }
 
-      for (const art::Ptr<recob::Hit> &hitp : trackHits) {
-        if (hitp->WireID().Plane != 2) continue;
+      for (const uint32_t &hit : trackHitIndex) {
+        if (hitCache.Plane(hit) != 2) continue;
         if (evt.isRealData()) continue;
-        if (hitHelper.IsHitMichelLike(hitp,selectorAlg.GetTrackProperties().recoEndPoint,fmthm,tracklist,trackIndex,clockData))
+        if (hitHelper.IsHitMichelLike(truthCache,trackHitTable,hit,selectorAlg.GetTrackProperties().recoEndPoint))
           numbMichelLikeHits++;
       }
 
-      // Get the CNN tagging results.
-      anab::MVAReader<recob::Hit,4> hitResults(evt, fNNetTag);
       // Store vector of ordered scores.
-      std::vector<double> scores = cnnHelper.GetScoreVector(hitResults,hitPlaneAlg.GetOrderedHitVec());
-      cnnHelper.FillHitScoreGraph2D(fg_imageScore, hitResults, hitPlaneAlg.GetOrderedHitVec());
+      std::vector<double> scores = cnnHelper.GetScoreVector(cnnScores,hitPlaneAlg.GetOrderedHitIndex());
+      cnnHelper.FillHitScoreGraph2D(fg_imageScore, cnnScores, hitCache, hitPlaneAlg.GetOrderedHitIndex());
       if (!evt.isRealData()) {
-        const artPtrHitVec &michelLikeHits = hitHelper.GetMichelLikeHits(hitPlaneAlg.GetOrderedHitVec(),selectorAlg.GetTrackProperties().recoEndPoint,fmthm,tracklist,trackIndex,clockData);
-        const artPtrHitVec &muonLikeHits = hitHelper.GetMuonLikeHits(hitPlaneAlg.GetOrderedHitVec(),selectorAlg.GetTrackProperties().recoEndPoint,fmthm,tracklist,trackIndex,clockData);
-        f_michelHitsMichelScore = cnnHelper.GetScoreVector(hitResults, michelLikeHits);
-        f_muonHitsMichelScore = cnnHelper.GetScoreVector(hitResults, muonLikeHits);
+        const hitIndexVec &michelLikeHits = hitHelper.GetMichelLikeHits(truthCache,trackHitTable,hitPlaneAlg.GetOrderedHitIndex(),selectorAlg.GetTrackProperties().recoEndPoint);
+        const hitIndexVec &muonLikeHits = hitHelper.GetMuonLikeHits(truthCache,trackHitTable,hitPlaneAlg.GetOrderedHitIndex(),selectorAlg.GetTrackProperties().recoEndPoint);
+        f_michelHitsMichelScore = cnnHelper.GetScoreVector(cnnScores, michelLikeHits);
+        f_muonHitsMichelScore = cnnHelper.GetScoreVector(cnnScores, muonLikeHits);
       }
-      const artPtrHitVec &hitsNoMichel = hitPlaneAlg.GetHitVecNoMichel(hitResults,_michelScoreThreshold,_michelScoreThresholdAvg);
+      const hitIndexVec &hitsNoMichel = hitPlaneAlg.GetHitIndexNoMichel(cnnScores,_michelScoreThreshold,_michelScoreThresholdAvg);
 
       if (numbMichelLikeHits > _minNumbMichelLikeHit && !evt.isRealData()) {
-        hitHelper.FillTrackGraph2D(fg_imageCollection,hitPlaneAlg.GetOrderedHitVec(),
+        hitHelper.FillTrackGraph2D(fg_imageCollection,hitCache,truthCache,hitPlaneAlg.GetOrderedHitIndex(),
                                    selectorAlg.GetTrackProperties().recoEndPoint,2,selectorAlg.GetTrackProperties().trackT0,
-                                   clockData,detProp);
-        hitHelper.FillTrackGraph2D(fg_imageCollectionNoMichel,hitsNoMichel,
+                                   context);
+        hitHelper.FillTrackGraph2D(fg_imageCollectionNoMichel,hitCache,truthCache,hitsNoMichel,
                                    selectorAlg.GetTrackProperties().recoEndPoint,2,selectorAlg.GetTrackProperties().trackT0,
-                                   clockData,detProp);
+                                   context);
           
         // std::cout << "Reco End Point: " << selectorAlg.GetTrackProperties().recoEndPoint.X() << " " << selectorAlg.GetTrackProperties().recoEndPoint.Y() << " " << selectorAlg.GetTrackProperties().recoEndPoint.Z() << std::endl;
         // std::cout << "True End Point: " << selectorAlg.GetTrackProperties().trueEndPoint.X() << " " << selectorAlg.GetTrackProperties().trueEndPoint.Y() << " " << selectorAlg.GetTrackProperties().trueEndPoint.Z() << std::endl;
@@ -169,7 +238,7 @@ namespace stoppingcosmicmuonselection {
 
       // Fill distance end points.
       fDistEndPoint = (selectorAlg.GetTrackProperties().recoEndPoint - selectorAlg.GetTrackProperties().trueEndPoint).Mag();
-      if (!hitPlaneAlg.AreThereMichelHits(hitResults,0.7,0.5)) {
+      if (!hitPlaneAlg.AreThereMichelHits(cnnScores,0.7,0.5)) {
         fDistEndPointNoMichel = (selectorAlg.GetTrackProperties().recoEndPoint - selectorAlg.GetTrackProperties().trueEndPoint).Mag();
         caloHelper.FillHisto_dQdxVsRR(h_dQdxVsRR_NoMichel);
         caloHelper.FillHisto_dQdxVsRR(h_dQdxVsRR_NoMichelTP,_trackPitch-_trackPitchTolerance,_trackPitch+_trackPitchTolerance);
@@ -6,6 +6,7 @@
 #define SPACEPOINT_ALG_CXX
 
 #include "SpacePointAlg.h"
+#include "Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -21,6 +22,12 @@ bool SpacePointAlg::IsValid() {
   return _isValid;
 }
 
+// Half size in Y and Z of the box around a track end where the space points are checked
+double SpacePointAlg::GetSearchDistance() const {
+  // The foot is within _cilinderAxis of the end and the point within _cilinderRadius of the foot.
+  return TMath::Sqrt(_cilinderAxis*_cilinderAxis + _cilinderRadius*_cilinderRadius) + 1.;
+}
+
 // Read parameters from FHICL file
 void SpacePointAlg::reconfigure(fhicl::ParameterSet const &p) {
   _cilinderAxis = p.get<double>("cilinderAxis", 50.);
@@ -28,9 +35,14 @@ void SpacePointAlg::reconfigure(fhicl::ParameterSet const &p) {
   _minNumberSpacePoints = p.get<int>("minNumberSpacePoints", 10);
 }
 
+// Fill the space point grid for this event.
+void SpacePointAlg::SetSpacePoints(const std::vector<recob::SpacePoint> &spacePoints) {
+  // A cell as large as the cilinder, so that each end only looks at few cells.
+  _spacePointGrid.Set(spacePoints, TMath::Sqrt(_cilinderAxis*_cilinderAxis + _cilinderRadius*_cilinderRadius));
+}
+
 // Check if the track correctly fit the space points around the end points
 bool SpacePointAlg::IsGoodTrack(const recob::Track &track,
-                                const std::vector<recob::SpacePoint> &spacePoints,
                                 const trackProperties &trackProp) {
   tP = trackProp;
   // Check if the track is valid
@@ -46,16 +58,16 @@ bool SpacePointAlg::IsGoodTrack(const recob::Track &track,
   if (isTrackValid && track.Length()>100.)
     _isValid = true;
 
-  TVector3 posLastValidPoint, pos20cmLastValidPoint, posFirstValidPoint, pos20cmFirstValidPoint;
+  Point3 posLastValidPoint, pos20cmLastValidPoint, posFirstValidPoint, pos20cmFirstValidPoint;
   if (_isValid) {
     // Initialise points
-    posLastValidPoint = track.LocationAtPoint<TVector3>(track.LastValidPoint());
-    posFirstValidPoint = track.LocationAtPoint<TVector3>(track.FirstValidPoint());
+    posLastValidPoint = make_point3(track.LocationAtPoint(track.LastValidPoint()));
+    posFirstValidPoint = make_point3(track.LocationAtPoint(track.FirstValidPoint()));
     bool found1 = false, found2 = false;
 
     for (size_t ii = 0; ii <= track.NumberTrajectoryPoints(); ii++)   {
       if (!track.HasValidPoint(ii)) continue;
-      pos20cmLastValidPoint = track.LocationAtPoint<TVector3>(ii);
+      pos20cmLastValidPoint = make_point3(track.LocationAtPoint(ii));
       if (TMath::Abs((pos20cmLastValidPoint-posLastValidPoint).Mag()-20.) < 5) {
         found1 = true;
         break;
@@ -63,7 +75,7 @@ bool SpacePointAlg::IsGoodTrack(const recob::Track &track,
     }
     for (size_t ii = 0; ii <= track.NumberTrajectoryPoints(); ii++)   {
       if (!track.HasValidPoint(ii)) continue;
-      pos20cmFirstValidPoint = track.LocationAtPoint<TVector3>(ii);
+      pos20cmFirstValidPoint = make_point3(track.LocationAtPoint(ii));
       if (TMath::Abs((pos20cmFirstValidPoint-posFirstValidPoint).Mag()-20.) < 5) {
         found2 = true;
         break;
@@ -77,10 +89,10 @@ bool SpacePointAlg::IsGoodTrack(const recob::Track &track,
 
     bool badTrack = true;
     if (tP.isAnodeCrosserMine)
-      badTrack = (IsTrackNotFittingSpacePoints(posLastValidPoint,pos20cmLastValidPoint,spacePoints,_bottom)
-           || IsTrackNotFittingSpacePoints(posFirstValidPoint,pos20cmFirstValidPoint,spacePoints,_top));
+      badTrack = (IsTrackNotFittingSpacePoints(posLastValidPoint,pos20cmLastValidPoint,_bottom)
+           || IsTrackNotFittingSpacePoints(posFirstValidPoint,pos20cmFirstValidPoint,_top));
     else if (tP.isAnodeCrosserPandora || tP.isCathodeCrosser)
-      badTrack = IsTrackNotFittingSpacePoints(posLastValidPoint,pos20cmLastValidPoint,spacePoints,_bottom);
+      badTrack = IsTrackNotFittingSpacePoints(posLastValidPoint,pos20cmLastValidPoint,_bottom);
 
     return !badTrack;
   } // if track is valid
@@ -89,8 +101,8 @@ bool SpacePointAlg::IsGoodTrack(const recob::Track &track,
 }
 
 // Given a point and a line find the projection of that point on the line in 2D
-TVector3 SpacePointAlg::FindFoot(double *coeffLine, const double &sp_Y, const double &sp_Z)  {
-  TVector3 foot;
+Point3 SpacePointAlg::FindFoot(double *coeffLine, const double &sp_Y, const double &sp_Z)  {
+  Point3 foot;
   double zz = (sp_Y + (sp_Z / coeffLine[1]) - coeffLine[0]) / ( ((coeffLine[1]*coeffLine[1])+1) / coeffLine[1] );
   double yy = (coeffLine[1] * zz) + coeffLine[0];
   foot.SetXYZ(INV_DBL,yy,zz);
@@ -98,8 +110,8 @@ TVector3 SpacePointAlg::FindFoot(double *coeffLine, const double &sp_Y, const do
 }
 
 // Check if the track is missing some space points for one end
-void SpacePointAlg::FillLineCoeff(TVector3 &posLastValidPoint,
-                                  TVector3 &pos20cmLastValidPoint,
+void SpacePointAlg::FillLineCoeff(Point3 &posLastValidPoint,
+                                  Point3 &pos20cmLastValidPoint,
                                   double *coeffLineYZ,
                                   double *coeffLineXZ) {
   coeffLineYZ[1] = (posLastValidPoint.Y()-pos20cmLastValidPoint.Y()) / (posLastValidPoint.Z()-pos20cmLastValidPoint.Z());
@@ -109,9 +121,8 @@ void SpacePointAlg::FillLineCoeff(TVector3 &posLastValidPoint,
 }
 
 // Check if the track is missing some space points for one end
-bool SpacePointAlg::IsTrackNotFittingSpacePoints(TVector3 &posExtremeValidPoint,
-                                                    TVector3 &pos20cmValidPoint,
-                                                    const std::vector<recob::SpacePoint> &spacePoints,
+bool SpacePointAlg::IsTrackNotFittingSpacePoints(Point3 &posExtremeValidPoint,
+                                                    Point3 &pos20cmValidPoint,
                                                     const std::string &whichEnd) {
   //std::cout << "Working with option ---> " << whichEnd << std::endl;
   double coeffLineYZ[2] = {INV_DBL,INV_DBL}, coeffLineXZ[2] = {INV_DBL,INV_DBL};
@@ -121,42 +132,49 @@ bool SpacePointAlg::IsTrackNotFittingSpacePoints(TVector3 &posExtremeValidPoint,
   //std::cout << pos20cmValidPoint.Y() << " " << pos20cmValidPoint.Z() << std::endl;
   size_t spCounter = 0; // count SP
 
+  // Only the space points close to the end can be in the cilinder.
+  const double maxDistanceYZ = GetSearchDistance();
+  _spacePointGrid.GetPointsInBox(posExtremeValidPoint.Y()-maxDistanceYZ,posExtremeValidPoint.Y()+maxDistanceYZ,
+                                 posExtremeValidPoint.Z()-maxDistanceYZ,posExtremeValidPoint.Z()+maxDistanceYZ,
+                                 _candidates);
+
   // Iterates on space points
-  for (auto const & sp : spacePoints) {
+  for (const uint32_t &i : _candidates) {
+    const double sp[3] = {_spacePointGrid.X(i),_spacePointGrid.Y(i),_spacePointGrid.Z(i)};
 
     // Now look at stuff in YZ plane
-    TVector3 footYZ = FindFoot(coeffLineYZ,sp.XYZ()[1],sp.XYZ()[2]);
+    Point3 footYZ = FindFoot(coeffLineYZ,sp[1],sp[2]);
     // Now look at stuff in XZ plane
-    TVector3 footXZ = FindFoot(coeffLineXZ,sp.XYZ()[0],sp.XYZ()[2]);
+    Point3 footXZ = FindFoot(coeffLineXZ,sp[0],sp[2]);
 
     // Check if the space point is within the designed geometry. NB: The coordinated for the vector foot**
     // are always such that Y(Z) for every plane
-    _distanceFootSpYZ = TMath::Sqrt(TMath::Power(footYZ.Y()-sp.XYZ()[1],2) + TMath::Power(footYZ.Z()-sp.XYZ()[2],2));
+    _distanceFootSpYZ = TMath::Sqrt(TMath::Power(footYZ.Y()-sp[1],2) + TMath::Power(footYZ.Z()-sp[2],2));
     _distanceFootEndYZ = TMath::Sqrt(TMath::Power(footYZ.Y()-posExtremeValidPoint.Y(),2) + TMath::Power(footYZ.Z()-posExtremeValidPoint.Z(),2));
-    _distanceFootSpXZ = TMath::Sqrt(TMath::Power(footXZ.Y()-sp.XYZ()[0],2) + TMath::Power(footXZ.Z()-sp.XYZ()[2],2));
+    _distanceFootSpXZ = TMath::Sqrt(TMath::Power(footXZ.Y()-sp[0],2) + TMath::Power(footXZ.Z()-sp[2],2));
     _distanceFootEndXZ = TMath::Sqrt(TMath::Power(footXZ.Y()-posExtremeValidPoint.X(),2) + TMath::Power(footXZ.Z()-posExtremeValidPoint.Z(),2));
 
     if (whichEnd == "bottom") { // option bottom includes cathode-crossing tracks as well
       // If track is T0 tagged the space points not fitted are not aligned in the XY place because they have
       // the wrong X while the T0-tagged track has been shifted.
       if (tP.isAnodeCrosserPandora || tP.isCathodeCrosser) {
-        if (_distanceFootSpYZ<_cilinderRadius && _distanceFootEndYZ<_cilinderAxis && posExtremeValidPoint.Y()>sp.XYZ()[1]) {
+        if (_distanceFootSpYZ<_cilinderRadius && _distanceFootEndYZ<_cilinderAxis && posExtremeValidPoint.Y()>sp[1]) {
           spCounter++;
         }
       }
       else if (tP.isAnodeCrosserMine) {
-        if (_distanceFootSpYZ<_cilinderRadius && _distanceFootEndYZ<_cilinderAxis && _distanceFootSpXZ<_cilinderRadius && _distanceFootEndXZ<_cilinderAxis && posExtremeValidPoint.Y()>sp.XYZ()[1]) {
+        if (_distanceFootSpYZ<_cilinderRadius && _distanceFootEndYZ<_cilinderAxis && _distanceFootSpXZ<_cilinderRadius && _distanceFootEndXZ<_cilinderAxis && posExtremeValidPoint.Y()>sp[1]) {
           spCounter++;
-          //std::cout << "X: " << sp.XYZ()[0] << " Y: " << sp.XYZ()[1] << " Z: " << sp.XYZ()[2] << std::endl;
+          //std::cout << "X: " << sp[0] << " Y: " << sp[1] << " Z: " << sp[2] << std::endl;
         }
       }
 
     }
     else if (whichEnd == "top") {
       if (tP.isAnodeCrosserMine) {
-        if (_distanceFootSpYZ<_cilinderRadius && _distanceFootEndYZ<_cilinderAxis && _distanceFootSpXZ<_cilinderRadius && _distanceFootEndXZ<_cilinderAxis && posExtremeValidPoint.Y()<sp.XYZ()[1]) {
+        if (_distanceFootSpYZ<_cilinderRadius && _distanceFootEndYZ<_cilinderAxis && _distanceFootSpXZ<_cilinderRadius && _distanceFootEndXZ<_cilinderAxis && posExtremeValidPoint.Y()<sp[1]) {
           spCounter++;
-          //std::cout << "X: " << sp.XYZ()[0] << " Y: " << sp.XYZ()[1] << " Z: " << sp.XYZ()[2] << std::endl;
+          //std::cout << "X: " << sp[0] << " Y: " << sp[1] << " Z: " << sp[2] << std::endl;
         }
       }
     }
@@ -167,7 +185,7 @@ bool SpacePointAlg::IsTrackNotFittingSpacePoints(TVector3 &posExtremeValidPoint,
 
   } // end loop over space points
 
-  std::cout << "\tSpacePointAlg.cxx: Number of SP in geometry: " << spCounter << "/" << _minNumberSpacePoints << " (" << whichEnd << ")" << std::endl;
+  STOPPING_MUON_LOG_DEBUG(kLogSpacePoints) << "\tSpacePointAlg.cxx: Number of SP in geometry: " << spCounter << "/" << _minNumberSpacePoints << " (" << whichEnd << ")";
   if (spCounter > _minNumberSpacePoints)
     return true;
   else
@@ -10,9 +10,9 @@
 #include "lardataobj/RecoBase/Track.h"
 #include "lardataobj/RecoBase/SpacePoint.h"
 #include "fhiclcpp/ParameterSet.h"
-#include "TVector3.h"
 #include "TMath.h"
 #include "DataTypes.h"
+#include "SpacePointGrid.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -28,8 +28,14 @@ namespace stoppingcosmicmuonselection {
     // Read parameters from FHICL file
     void reconfigure(fhicl::ParameterSet const &p);
 
+    // Fill the space point grid for this event.
+    void SetSpacePoints(const std::vector<recob::SpacePoint> &spacePoints);
+
     // Check if the track correctly fit the space points around the end points
-    bool IsGoodTrack(const recob::Track &track, const std::vector<recob::SpacePoint> &spacePoints, const trackProperties &trackProp);
+    bool IsGoodTrack(const recob::Track &track, const trackProperties &trackProp);
+
+    // Half size in Y and Z of the box around a track end where the space points are checked
+    double GetSearchDistance() const;
 
   private:
     // Strings for track orientation
@@ -41,19 +47,21 @@ namespace stoppingcosmicmuonselection {
     double _cilinderAxis; // cm
     double _cilinderRadius; // cm
     size_t _minNumberSpacePoints;
+    // Space points of the event and candidates for the current cilinder
+    SpacePointGrid _spacePointGrid;
+    std::vector<uint32_t> _candidates;
     
     double _distanceFootSpYZ, _distanceFootEndYZ, _distanceFootSpXZ, _distanceFootEndXZ;
     // Given a point and a line find the projection of that point on the line in 2D
-    TVector3 FindFoot(double *coeffLine, const double &sp_Y, const double &sp_Z);
+    Point3 FindFoot(double *coeffLine, const double &sp_Y, const double &sp_Z);
     // Fill the coefficients for the line interpolating the start and end of theALG
-    void FillLineCoeff(TVector3 &posLastValidPoint,
-                       TVector3 &pos20cmLastValidPoint,
+    void FillLineCoeff(Point3 &posLastValidPoint,
+                       Point3 &pos20cmLastValidPoint,
                        double *coeffLineYZ,
                        double *coeffLineXZ);
     // Check if the track is missing some space points for one end
-    bool IsTrackNotFittingSpacePoints(TVector3 &posExtremeValidPoint,
-                                      TVector3 &pos20cmValidPoint,
-                                      const std::vector<recob::SpacePoint> &spacePoints,
+    bool IsTrackNotFittingSpacePoints(Point3 &posExtremeValidPoint,
+                                      Point3 &pos20cmValidPoint,
                                       const std::string &whichEnd);
 
   };
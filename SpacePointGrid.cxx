@@ -0,0 +1,107 @@
+/***
+  Class containing a per-event uniform grid of the space points in the YZ plane.
+
+*/
+#ifndef SPACEPOINT_GRID_CXX
+#define SPACEPOINT_GRID_CXX
+
+#include "SpacePointGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace stoppingcosmicmuonselection {
+
+  SpacePointGrid::SpacePointGrid() {
+
+  }
+
+  SpacePointGrid::~SpacePointGrid() {
+
+  }
+
+  // Fill the grid with the space points of the event.
+  void SpacePointGrid::Set(const std::vector<recob::SpacePoint> &spacePoints, const double &cellSize) {
+    _x.clear();
+    _y.clear();
+    _z.clear();
+    _cellStart.clear();
+    _nCellsY = 0;
+    _nCellsZ = 0;
+    if (spacePoints.size() == 0) return;
+
+    // Bounding box in YZ.
+    double maxY = spacePoints[0].XYZ()[1], maxZ = spacePoints[0].XYZ()[2];
+    _minY = maxY;
+    _minZ = maxZ;
+    for (auto const &sp : spacePoints) {
+      _minY = std::min(_minY, sp.XYZ()[1]);
+      maxY = std::max(maxY, sp.XYZ()[1]);
+      _minZ = std::min(_minZ, sp.XYZ()[2]);
+      maxZ = std::max(maxZ, sp.XYZ()[2]);
+    }
+
+    // Enlarge the cells if the points are spread over a very large range.
+    _cellSizeY = std::max(cellSize, (maxY - _minY) / _maxCellsPerAxis);
+    _cellSizeZ = std::max(cellSize, (maxZ - _minZ) / _maxCellsPerAxis);
+    _nCellsY = static_cast<int>((maxY - _minY) / _cellSizeY) + 1;
+    _nCellsZ = static_cast<int>((maxZ - _minZ) / _cellSizeZ) + 1;
+
+    // Counting sort of the points by cell.
+    std::vector<uint32_t> cellOfPoint(spacePoints.size());
+    _cellStart.assign(_nCellsY * _nCellsZ + 1, 0);
+    for (size_t i = 0; i < spacePoints.size(); i++) {
+      const int cellY = GetCell(spacePoints[i].XYZ()[1], _minY, _cellSizeY, _nCellsY);
+      const int cellZ = GetCell(spacePoints[i].XYZ()[2], _minZ, _cellSizeZ, _nCellsZ);
+      cellOfPoint[i] = cellY * _nCellsZ + cellZ;
+      _cellStart[cellOfPoint[i] + 1]++;
+    }
+    for (size_t c = 1; c < _cellStart.size(); c++)
+      _cellStart[c] += _cellStart[c-1];
+
+    _x.resize(spacePoints.size());
+    _y.resize(spacePoints.size());
+    _z.resize(spacePoints.size());
+    std::vector<uint32_t> fill(_cellStart.begin(), _cellStart.end() - 1);
+    for (size_t i = 0; i < spacePoints.size(); i++) {
+      const uint32_t pos = fill[cellOfPoint[i]]++;
+      _x[pos] = spacePoints[i].XYZ()[0];
+      _y[pos] = spacePoints[i].XYZ()[1];
+      _z[pos] = spacePoints[i].XYZ()[2];
+    }
+  }
+
+  // Get the cell index along one axis, clamped to the grid.
+  int SpacePointGrid::GetCell(const double &value, const double &min, const double &cellSize, const int &nCells) const {
+    const double cell = std::floor((value - min) / cellSize);
+    if (!(cell >= 0.)) return 0;
+    if (cell >= nCells) return nCells - 1;
+    return static_cast<int>(cell);
+  }
+
+  // Get the indices of the space points in the cells overlapping a YZ box.
+  void SpacePointGrid::GetPointsInBox(const double &minY, const double &maxY,
+                                      const double &minZ, const double &maxZ,
+                                      std::vector<uint32_t> &result) const {
+    result.clear();
+    if (_x.size() == 0) return;
+    // Box not overlapping the grid, or not a number.
+    if (!(maxY >= _minY && minY <= _minY + _nCellsY * _cellSizeY)) return;
+    if (!(maxZ >= _minZ && minZ <= _minZ + _nCellsZ * _cellSizeZ)) return;
+
+    const int firstY = GetCell(minY, _minY, _cellSizeY, _nCellsY);
+    const int lastY = GetCell(maxY, _minY, _cellSizeY, _nCellsY);
+    const int firstZ = GetCell(minZ, _minZ, _cellSizeZ, _nCellsZ);
+    const int lastZ = GetCell(maxZ, _minZ, _cellSizeZ, _nCellsZ);
+    for (int cellY = firstY; cellY <= lastY; cellY++) {
+      // Cells adjacent in Z are contiguous in memory.
+      const uint32_t begin = _cellStart[cellY * _nCellsZ + firstZ];
+      const uint32_t end = _cellStart[cellY * _nCellsZ + lastZ + 1];
+      for (uint32_t i = begin; i < end; i++)
+        result.push_back(i);
+    }
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
@@ -0,0 +1,56 @@
+/***
+  Class containing a per-event uniform grid of the space points in the YZ plane.
+  Coordinates are stored in flat arrays ordered by grid cell.
+
+*/
+#ifndef SPACEPOINT_GRID_H
+#define SPACEPOINT_GRID_H
+
+#include "lardataobj/RecoBase/SpacePoint.h"
+
+#include "DataTypes.h"
+
+namespace stoppingcosmicmuonselection {
+
+  class SpacePointGrid {
+
+  public:
+    SpacePointGrid();
+    ~SpacePointGrid();
+
+    // Fill the grid with the space points of the event.
+    void Set(const std::vector<recob::SpacePoint> &spacePoints, const double &cellSize);
+
+    // Number of space points in the grid.
+    size_t Size() const { return _x.size(); }
+
+    // Get the indices of the space points in the cells overlapping a YZ box.
+    void GetPointsInBox(const double &minY, const double &maxY,
+                        const double &minZ, const double &maxZ,
+                        std::vector<uint32_t> &result) const;
+
+    // Coordinate accessors.
+    float X(const uint32_t &i) const { return _x[i]; }
+    float Y(const uint32_t &i) const { return _y[i]; }
+    float Z(const uint32_t &i) const { return _z[i]; }
+
+  private:
+    // Get the cell index along one axis, clamped to the grid.
+    int GetCell(const double &value, const double &min, const double &cellSize, const int &nCells) const;
+
+    std::vector<float> _x;
+    std::vector<float> _y;
+    std::vector<float> _z;
+    // Offset of the first point of each cell (nCellsY*nCellsZ+1 entries).
+    std::vector<uint32_t> _cellStart;
+
+    double _minY = 0., _minZ = 0.;
+    double _cellSizeY = 1., _cellSizeZ = 1.;
+    int _nCellsY = 0, _nCellsZ = 0;
+    // Maximum number of cells along one axis.
+    const int _maxCellsPerAxis = 1000;
+
+  };
+}
+
+#endif
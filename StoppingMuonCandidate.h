@@ -0,0 +1,47 @@
+/***
+  Class containing the compact record of a selected stopping muon candidate.
+  Written to the event by the StoppingMuonProducer module.
+
+*/
+#ifndef STOPPING_MUON_CANDIDATE_H
+#define STOPPING_MUON_CANDIDATE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace stoppingcosmicmuonselection {
+
+  // How the track crosses the detector.
+  enum candidateType {
+    kCathodeCrosser = 0,
+    kAnodeCrosserPandora = 1,
+    kAnodeCrosserMine = 2
+  };
+
+  // Bits of StoppingMuonCandidate::cutBits.
+  enum candidateCutBit {
+    kPassSelection   = 1 << 0, // passed StoppingMuonSelectionAlg
+    kGoodSpacePoints = 1 << 1, // passed SpacePointAlg::IsGoodTrack
+    kNoMichelHits    = 1 << 2, // no Michel hits tagged by the CNN on the collection plane
+    kTrueCosmic      = 1 << 3, // MC only: matched to a true cosmic particle
+    kTrueStopping    = 1 << 4  // MC only: the matched particle is a true stopping muon
+  };
+
+  struct StoppingMuonCandidate {
+    size_t pfparticleKey = 0;
+    size_t trackKey = 0;
+    int type = -1;
+    double t0 = -9999999;
+    float startX = -9999999, startY = -9999999, startZ = -9999999;
+    float endX = -9999999, endY = -9999999, endZ = -9999999;
+    float theta_xz = -9999999, theta_yz = -9999999;
+    float minHitPeakTime = -9999999, maxHitPeakTime = -9999999;
+    float trackLength = -9999999;
+    uint32_t cutBits = 0;
+
+    // Check that all the given bits are set.
+    bool HasBits(const uint32_t &bits) const { return (cutBits & bits) == bits; }
+  };
+}
+
+#endif
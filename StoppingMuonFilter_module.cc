@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////
+// Class:       StoppingMuonFilter
+// Plugin Type: filter
+// File:        StoppingMuonFilter_module.cc
+////////////////////////////////////////////////////////////////////////
+#include "art/Framework/Core/EDFilter.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include <string>
+
+#include "protoduneana/StoppingMuonSelection/StoppingMuonCandidate.h"
+#include "protoduneana/StoppingMuonSelection/Logging.h"
+
+namespace stoppingcosmicmuonselection {
+
+class StoppingMuonFilter;
+
+class StoppingMuonFilter : public art::EDFilter {
+public:
+  explicit StoppingMuonFilter(fhicl::ParameterSet const & p);
+  // The destructor generated by the compiler is fine for classes
+  // without bare pointers or other resource use.
+
+  // Plugins should not be copied or assigned.
+  StoppingMuonFilter(StoppingMuonFilter const &) = delete;
+  StoppingMuonFilter(StoppingMuonFilter &&) = delete;
+  StoppingMuonFilter & operator = (StoppingMuonFilter const &) = delete;
+  StoppingMuonFilter & operator = (StoppingMuonFilter &&) = delete;
+
+  // Required functions.
+  bool filter(art::Event &evt) override;
+
+  // Selected optional functions
+  void endJob() override;
+  void reconfigure(fhicl::ParameterSet const& p);
+
+private:
+
+  // Declare some counters for statistic purposes
+  int counter_total_number_events = 0;
+  int counter_passed_events = 0;
+
+  // Parameters form FHICL File
+  std::string fCandidateTag;
+  uint32_t _requiredCutBits;
+  size_t _minNumbCandidates;
+};
+
+StoppingMuonFilter::StoppingMuonFilter(fhicl::ParameterSet const & p)
+  :
+  EDFilter(p)
+{
+  reconfigure(p);
+}
+
+bool StoppingMuonFilter::filter(art::Event &evt)
+{
+  counter_total_number_events++;
+  auto const candidateHandle = evt.getValidHandle<std::vector<StoppingMuonCandidate>>(fCandidateTag);
+
+  // Count the candidates with all the required bits.
+  size_t numbCandidates = 0;
+  for (auto const &candidate : *candidateHandle) {
+    if (candidate.HasBits(_requiredCutBits)) numbCandidates++;
+  }
+
+  if (numbCandidates < _minNumbCandidates) return false;
+  counter_passed_events++;
+  return true;
+}
+
+void StoppingMuonFilter::endJob()
+{
+  STOPPING_MUON_LOG_INFO(kLogModules) << "StoppingMuonFilter finished job";
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Total number of events: " << counter_total_number_events;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Number of events passed: " << counter_passed_events;
+}
+
+void StoppingMuonFilter::reconfigure(fhicl::ParameterSet const& p)
+{
+  Logger::Get().reconfigure(p.get<fhicl::ParameterSet>("Logging", fhicl::ParameterSet()));
+  fCandidateTag = p.get<std::string>("CandidateTag", "stoppingmuon");
+  _requiredCutBits = p.get<uint32_t>("requiredCutBits", kPassSelection);
+  _minNumbCandidates = p.get<size_t>("minNumbCandidates", 1);
+}
+
+} // namespace
+
+DEFINE_ART_MODULE(stoppingcosmicmuonselection::StoppingMuonFilter)
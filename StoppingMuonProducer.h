@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////
+// Class:       StoppingMuonProducer
+// Plugin Type: producer
+// File:        StoppingMuonProducer.h
+////////////////////////////////////////////////////////////////////////
+#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Persistency/Common/PtrMaker.h"
+#include "canvas/Persistency/Common/Assns.h"
+#include "canvas/Persistency/Common/FindManyP.h"
+#include "lardata/DetectorInfoServices/DetectorClocksService.h"
+#include "lardata/DetectorInfoServices/DetectorPropertiesService.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include <memory>
+#include <string>
+
+#include "protoduneana/StoppingMuonSelection/DataTypes.h"
+#include "protoduneana/StoppingMuonSelection/StoppingMuonCandidate.h"
+#include "protoduneana/StoppingMuonSelection/SpacePointAlg.h"
+#include "protoduneana/StoppingMuonSelection/StoppingMuonSelectionAlg.h"
+#include "protoduneana/StoppingMuonSelection/HitHelper.h"
+#include "protoduneana/StoppingMuonSelection/HitPlaneAlg.h"
+#include "protoduneana/StoppingMuonSelection/HitCache.h"
+#include "protoduneana/StoppingMuonSelection/TruthHitCache.h"
+#include "protoduneana/StoppingMuonSelection/TruthMatchTable.h"
+#include "protoduneana/StoppingMuonSelection/TrackIDIndex.h"
+#include "protoduneana/StoppingMuonSelection/EventArena.h"
+#include "protoduneana/StoppingMuonSelection/EventContext.h"
+#include "protoduneana/StoppingMuonSelection/EventTablesGuard.h"
+#include "protoduneana/StoppingMuonSelection/TruthProvider.h"
+#include "protoduneana/StoppingMuonSelection/TrackHitTable.h"
+#include "protoduneana/StoppingMuonSelection/CNNScoreTable.h"
+#include "protoduneana/StoppingMuonSelection/Instrumentation.h"
+#include "protoduneana/StoppingMuonSelection/Logging.h"
+
+namespace stoppingcosmicmuonselection {
+
+class StoppingMuonProducer;
+
+class StoppingMuonProducer : public art::EDProducer {
+public:
+  explicit StoppingMuonProducer(fhicl::ParameterSet const & p);
+  // The destructor generated by the compiler is fine for classes
+  // without bare pointers or other resource use.
+
+  // Plugins should not be copied or assigned.
+  StoppingMuonProducer(StoppingMuonProducer const &) = delete;
+  StoppingMuonProducer(StoppingMuonProducer &&) = delete;
+  StoppingMuonProducer & operator = (StoppingMuonProducer const &) = delete;
+  StoppingMuonProducer & operator = (StoppingMuonProducer &&) = delete;
+
+  // Required functions.
+  void produce(art::Event &evt) override;
+
+  // Selected optional functions
+  void endJob() override;
+  void reconfigure(fhicl::ParameterSet const& p);
+
+  // Function called by the produce function
+  void FillCandidateWithTrackProperties(StoppingMuonCandidate &candidate, const trackProperties &trackInfo);
+
+private:
+
+  // Declare some counters for statistic purposes
+  int counter_total_number_events = 0;
+  int counter_total_number_candidates = 0;
+
+  SpacePointAlg            spAlg;        // need configuration
+  StoppingMuonSelectionAlg selectorAlg;  // need configuration
+  HitHelper                hitHelper;
+  HitCache                 hitCache;
+  TruthHitCache            truthCache;
+  TruthMatchTable          truthTable;
+  TrackIDIndex             trackIDIndex;
+  TrackHitTable            trackHitTable;
+  HitPlaneAlg              hitPlaneAlg;
+  CNNScoreTable            cnnScores;
+
+  // Parameters form FHICL File
+  double _michelScoreThreshold;
+  double _michelScoreThresholdAvg;
+  bool _orderHitsByTrajectory;
+  bool _checkMichelHits;
+  bool _requireTrueCosmic;
+  bool _selectAC, _selectCC;
+  std::string fPFParticleTag, fSpacePointTag, fTrackerTag;
+  std::string fNNetTag, fHitTag, fSimChannelTag;
+};
+
+StoppingMuonProducer::StoppingMuonProducer(fhicl::ParameterSet const & p)
+  :
+  EDProducer(p)
+{
+  reconfigure(p);
+  produces<std::vector<StoppingMuonCandidate>>();
+  produces<art::Assns<recob::PFParticle,StoppingMuonCandidate>>();
+  produces<art::Assns<recob::Track,StoppingMuonCandidate>>();
+}
+
+void StoppingMuonProducer::endJob()
+{
+  STOPPING_MUON_LOG_INFO(kLogModules) << "StoppingMuonProducer finished job";
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Total number of events: " << counter_total_number_events;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Total number of candidates: " << counter_total_number_candidates;
+  // Time per stage, only filled when compiled with STOPPING_MUON_INSTRUMENTATION.
+  if (Instrumentation::IsEnabled()) Instrumentation::Get().Print();
+}
+
+void StoppingMuonProducer::reconfigure(fhicl::ParameterSet const& p)
+{
+  Logger::Get().reconfigure(p.get<fhicl::ParameterSet>("Logging", fhicl::ParameterSet()));
+  TruthProvider::Get().reconfigure(p);
+  fTrackerTag = p.get<std::string>("TrackerTag");
+  fPFParticleTag = p.get<std::string>("PFParticleTag");
+  fSpacePointTag = p.get<std::string>("SpacePointTag");
+  fNNetTag = p.get<std::string>("NNetTag");
+  fHitTag = p.get<std::string>("HitTag", "hitpdune");
+  fSimChannelTag = p.get<std::string>("SimChannelTag", "tpcrawdecoder:simpleSC");
+  _michelScoreThreshold = p.get<double>("michelScoreThreshold", 0.7);
+  _michelScoreThresholdAvg = p.get<double>("michelScoreThresholdAvg", 0.5);
+  _orderHitsByTrajectory = p.get<bool>("orderHitsByTrajectory", false);
+  _checkMichelHits = p.get<bool>("checkMichelHits", true);
+  _requireTrueCosmic = p.get<bool>("requireTrueCosmic", true);
+  _selectAC = p.get<bool>("selectAC", true);
+  _selectCC = p.get<bool>("selectCC", true);
+  spAlg.reconfigure(p.get<fhicl::ParameterSet>("SpacePointAlg"));
+  selectorAlg.reconfigure(p.get<fhicl::ParameterSet>("StoppingMuonSelectionAlg"));
+  hitHelper.reconfigure(p.get<fhicl::ParameterSet>("HitHelper"));
+}
+
+void StoppingMuonProducer::FillCandidateWithTrackProperties(StoppingMuonCandidate &candidate, const trackProperties &trackInfo) {
+  candidate.t0             = trackInfo.trackT0;
+  candidate.startX         = trackInfo.recoStartPoint.X();
+  candidate.startY         = trackInfo.recoStartPoint.Y();
+  candidate.startZ         = trackInfo.recoStartPoint.Z();
+  candidate.endX           = trackInfo.recoEndPoint.X();
+  candidate.endY           = trackInfo.recoEndPoint.Y();
+  candidate.endZ           = trackInfo.recoEndPoint.Z();
+  candidate.theta_xz       = trackInfo.theta_xz;
+  candidate.theta_yz       = trackInfo.theta_yz;
+  candidate.minHitPeakTime = trackInfo.minHitPeakTime;
+  candidate.maxHitPeakTime = trackInfo.maxHitPeakTime;
+  candidate.trackLength    = trackInfo.trackLength;
+  if (trackInfo.isCathodeCrosser)
+    candidate.type = kCathodeCrosser;
+  else if (trackInfo.isAnodeCrosserMine)
+    candidate.type = kAnodeCrosserMine;
+  else if (trackInfo.isAnodeCrosserPandora)
+    candidate.type = kAnodeCrosserPandora;
+}
+
+} // namespace
@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////
+// Class:       StoppingMuonProducer
+// Plugin Type: producer
+// File:        StoppingMuonProducer_module.cc
+////////////////////////////////////////////////////////////////////////
+
+#include "StoppingMuonProducer.h"
+
+namespace stoppingcosmicmuonselection {
+
+  void StoppingMuonProducer::produce(art::Event &evt)
+  {
+    counter_total_number_events++;
+    STOPPING_MUON_LOG_INFO(kLogModules) << "StoppingMuonProducer module on event " << evt.id().event();
+
+    // Products, written also when the event has no candidates.
+    auto candidates = std::make_unique<std::vector<StoppingMuonCandidate>>();
+    auto pfparticleAssns = std::make_unique<art::Assns<recob::PFParticle,StoppingMuonCandidate>>();
+    auto trackAssns = std::make_unique<art::Assns<recob::Track,StoppingMuonCandidate>>();
+    art::PtrMaker<StoppingMuonCandidate> makeCandidatePtr(evt);
+
+    // Get handles
+    art::Handle<std::vector<recob::PFParticle>> pfparticleHandle; // to use with getByLabel to check it's valid
+    evt.getByLabel(fPFParticleTag, pfparticleHandle);
+    if (!pfparticleHandle.isValid()) {
+      evt.put(std::move(candidates));
+      evt.put(std::move(pfparticleAssns));
+      evt.put(std::move(trackAssns));
+      return;
+    }
+    auto const &recoParticles = *pfparticleHandle;
+    auto const spacePointHandle = evt.getValidHandle<std::vector<recob::SpacePoint>>(fSpacePointTag);
+    spAlg.SetSpacePoints(*spacePointHandle);
+
+    // Free the temporaries of the previous event.
+    EventArena::NewEvent();
+    // Reject MC events in a data-only job, before any truth access.
+    TruthProvider::Get().CheckEvent(evt);
+    // Clock and detector properties of this event, for all the helpers.
+    const EventContext context(evt);
+
+    // Fill the hit table for this event.
+    hitCache.Set(evt, fHitTag);
+    // Read the CNN Michel scores once for all the hits.
+    if (_checkMichelHits) cnnScores.Set(evt, fNNetTag, hitCache);
+    // Fill the hit truth table and the PFParticle truth matching (MC only).
+    if (!evt.isRealData()) {
+      truthCache.Set(evt, fSimChannelTag, hitCache, context);
+      truthTable.Set(evt, fPFParticleTag, hitCache, truthCache);
+    }
+    selectorAlg.SetTruthMatchTable(&truthTable);
+    // Clear the pointers to the tables and context when the event ends, also on exceptions.
+    const EventTablesGuard<StoppingMuonSelectionAlg> tablesGuard(selectorAlg);
+
+    // Get track handle.
+    art::Handle<std::vector<recob::Track>> trackListHandle;
+    evt.getByLabel(fTrackerTag,trackListHandle);
+    // Fill the track index for this event.
+    trackIDIndex.Set(evt, fTrackerTag);
+    selectorAlg.SetTrackIDIndex(&trackIDIndex);
+    selectorAlg.SetEventContext(&context);
+    const std::vector<art::Ptr<recob::Track>> &tracklist = trackIDIndex.GetTrackList();
+    // Get association to metadata and hit.
+    art::FindManyP<recob::Hit, recob::TrackHitMeta> fmthm(trackListHandle, evt, fTrackerTag);
+    art::FindManyP<recob::Hit> fmht(trackListHandle, evt, fTrackerTag);
+
+    // Iterates over the vector of PFParticles
+    for (unsigned int p = 0; p < recoParticles.size(); ++p) {
+
+      // Prepare the selector to digest a new PFParticle
+      selectorAlg.Reset();
+
+      // Get the PFParticle
+      const recob::PFParticle &thisParticle = recoParticles[p];
+
+      // Only consider primary particles
+      if (!thisParticle.IsPrimary()) continue;
+
+      // Skip if the PFParticle is not track-like
+      if (!selectorAlg.IsPFParticleATrack(evt,thisParticle)) continue;
+
+      StoppingMuonCandidate candidate;
+
+      // If this is MC we want that the PFParticle is matched to a cosmic MCParticle
+      if (!evt.isRealData()) {
+        if (selectorAlg.IsTrackMatchedToTrueCosmicTrack(evt,thisParticle))
+          candidate.cutBits |= kTrueCosmic;
+        else if (_requireTrueCosmic)
+          continue;
+      }
+
+      // Check if this PFParticle is a stopping muon.
+      bool isCathodeCrosser = false;
+      if (_selectCC && selectorAlg.IsStoppingCathodeCrosser(evt,thisParticle))
+        isCathodeCrosser = true;
+      else if (!(_selectAC && selectorAlg.IsStoppingAnodeCrosser(evt,thisParticle)))
+        continue;
+      candidate.cutBits |= kPassSelection;
+      FillCandidateWithTrackProperties(candidate,selectorAlg.GetTrackProperties());
+
+      const recob::Track &track = selectorAlg.GetTrackFromPFParticle(evt,thisParticle);
+      const size_t trackIndex = trackIDIndex.GetIndex(track);
+      if (trackIndex >= tracklist.size()) continue;
+
+      // Check if the track is missing some space points.
+      if (spAlg.IsGoodTrack(track,selectorAlg.GetTrackProperties()))
+        candidate.cutBits |= kGoodSpacePoints;
+
+      // Check if the matched PFParticle is a true stopping muon
+      if (!evt.isRealData()) {
+        bool isTrueStopping = isCathodeCrosser ?
+          selectorAlg.IsTrueParticleACathodeCrossingStoppingMuon(evt,thisParticle) :
+          selectorAlg.IsTrueParticleAnAnodeCrossingStoppingMuon(evt,thisParticle);
+        if (isTrueStopping) candidate.cutBits |= kTrueStopping;
+      }
+
+      // Look for Michel hits on the collection plane.
+      if (_checkMichelHits) {
+        const hitIndexVec &trackHitIndex = hitCache.GetIndexVec(hitHelper.GetArtPtrToHitVect(fmht,trackIndex));
+        const hitIndexVec &hitsOnCollection = hitCache.GetHitsOnAPlane(2,trackHitIndex);
+        if (hitsOnCollection.size() != 0) {
+          trackHitTable.Set(fmthm,trackIndex,*tracklist[trackIndex],hitCache);
+          const size_t &hitIndex = hitHelper.GetIndexClosestHitToPoint(selectorAlg.GetTrackProperties().recoStartPoint,hitsOnCollection,hitCache,trackHitTable);
+          hitPlaneAlg.Process(hitCache,trackHitIndex,hitIndex,2,selectorAlg.GetTrackProperties().trackT0,context,
+                              _orderHitsByTrajectory ? &trackHitTable : 0x0);
+          if (!hitPlaneAlg.AreThereMichelHits(cnnScores,_michelScoreThreshold,_michelScoreThresholdAvg))
+            candidate.cutBits |= kNoMichelHits;
+        }
+      }
+
+      candidate.pfparticleKey = p;
+      candidate.trackKey = tracklist[trackIndex].key();
+      candidates->push_back(candidate);
+      counter_total_number_candidates++;
+
+      // Associate the candidate to its PFParticle and track.
+      const art::Ptr<StoppingMuonCandidate> candidatePtr = makeCandidatePtr(candidates->size()-1);
+      pfparticleAssns->addSingle(art::Ptr<recob::PFParticle>(pfparticleHandle,p),candidatePtr);
+      trackAssns->addSingle(tracklist[trackIndex],candidatePtr);
+
+    } // end of loop over PFParticles
+
+    STOPPING_MUON_LOG_DEBUG(kLogModules) << "StoppingMuonProducer: " << candidates->size() << " candidates in event " << evt.id().event();
+    evt.put(std::move(candidates));
+    evt.put(std::move(pfparticleAssns));
+    evt.put(std::move(trackAssns));
+
+  } // end of producer
+
+} // namespace
+
+DEFINE_ART_MODULE(stoppingcosmicmuonselection::StoppingMuonProducer)
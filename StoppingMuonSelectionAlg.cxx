@@ -5,12 +5,16 @@
 #ifndef STOPPING_MUON_SELECTION_ALG_CXX
 #define STOPPING_MUON_SELECTION_ALG_CXX
 
+#include <algorithm>
+#include "cetlib_except/exception.h"
+
 #include "StoppingMuonSelectionAlg.h"
+#include "Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
   StoppingMuonSelectionAlg::StoppingMuonSelectionAlg() {
-
+    _features.Reset();
   }
 
   StoppingMuonSelectionAlg::~StoppingMuonSelectionAlg() {
@@ -33,192 +37,165 @@ namespace stoppingcosmicmuonselection {
   void StoppingMuonSelectionAlg::reconfigure(fhicl::ParameterSet const &p) {
     fTrackerTag = p.get<std::string>("TrackerTag", "pandoraTrack");
     fPFParticleTag = p.get<std::string>("PFParticleTag", "pandora");
-    // Set cuts for CC.
-    length_cutoff_CC               = p.get<double>("length_cutoff_CC",100);
-    offsetFiducialBounds_CC        = p.get<double>("offsetFiducialBounds_CC",50);
-    thicknessStartVolume_CC        = p.get<double>("thicknessStartVolume_CC",40);
-    cutMinHitPeakTime_CC           = p.get<double>("cutMinHitPeakTime_CC",500);
-    cutMaxHitPeakTime_CC           = p.get<double>("cutMaxHitPeakTime_CC",4800);
-    radiusBrokenTracksSearch_CC    = p.get<double>("radiusBrokenTracksSearch_CC",50);
-    cutCosAngleBrokenTracks_CC     = p.get<double>("cutCosAngleBrokenTracks_CC",0.995);
-    cutCosAngleAlignment_CC        = p.get<double>("cutCosAngleAlignment_CC",0.995);
-    cutContourAPA_CC               = p.get<double>("cutContourAPA_CC",10);
-    // Set cuts for AC.
-    length_cutoff_AC               = p.get<double>("length_cutoff_AC",100);
-    offsetYStartPoint_AC           = p.get<double>("offsetYStartPoint_AC", 30);
-    offsetZStartPoint_AC           = p.get<double>("offsetZStartPoint_AC", 50);
-    cutMinHitPeakTime_AC           = p.get<double>("cutMinHitPeakTime_AC", 700);
-    cutMaxHitPeakTime_AC           = p.get<double>("cutMaxHitPeakTime_AC", 4800);
-    radiusBrokenTracksSearch_AC    = p.get<double>("radiusBrokenTracksSearch_AC", 10);
-    cutCosAngleBrokenTracks_AC     = p.get<double>("cutCosAngleBrokenTracks_AC", 0.995);
-    cutCosAngleAlignment_AC        = p.get<double>("cutCosAngleAlignment_AC", 0.995);
-    cutContourAPA_AC               = p.get<double>("cutContourAPA_AC", 10);
-    offsetFiducialBounds_AC        = p.get<double>("offsetFiducialBounds_AC",50);
+    // Set cuts for CC and AC.
+    _cuts = get_selection_cuts(p);
     // Prepare geometry helper
     geoHelper.InitActiveVolumeBounds();
+    for (size_t i = 0; i < 6; i++)
+      _selectionConstants.activeBounds[i] = geoHelper.GetActiveVolumeBounds()[i];
+    _selectionConstants.driftDistance = geoHelper.GetAbsolutePlaneCoordinate(0); // First induction plane coordinate.
+    // Less aligned tracks can not make a track broken with these cuts: they are not stored.
+    _selectionConstants.minCosAlphaNeighbours = std::min({p.get<double>("minCosAlphaNeighbours", 0.9),
+                                                          MIN_COS_ALPHA_CLOSE_TRACKS,
+                                                          _cuts.cutCosAngleBrokenTracks_CC,
+                                                          _cuts.cutCosAngleBrokenTracks_AC});
   }
 
-  // Determine if the PFParticle is a selected cathode crosser
-  bool StoppingMuonSelectionAlg::IsStoppingAnodeCrosser(art::Event const &evt,
-                                                        recob::PFParticle const &thisParticle) {
-    bool DEBUG = true;
+  // Compute the quantities used by the cuts (once per PFParticle).
+  // The lazy ones are left for the cuts that need them, unless loadLazyFeatures is true.
+  void StoppingMuonSelectionAlg::SetTrackFeatures(art::Event const &evt,
+                                                  recob::PFParticle const &thisParticle,
+                                                  const bool &loadLazyFeatures) {
+    STOPPING_MUON_SCOPED_TIMER("StoppingMuonSelectionAlg::SetTrackFeatures");
     Reset();
     _evNumber = evt.id().event();
 
-    // Declare handle for detector properties
-    auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-    auto const detprop = art::ServiceHandle<detinfo::DetectorPropertiesService>()->DataFor(evt, clockData);
-    _driftVelocity = detprop.DriftVelocity()*1e-3;
+    // The cathode and anode selections look at the same PFParticle: reuse the features.
+    if (_featuresEventID == evt.id() && _features.pfparticleIndex == (int)thisParticle.Self()) {
+      _driftVelocity = _features.driftVelocity;
+      _recoStartPoint.SetXYZ(_features.startX, _features.startY, _features.startZ);
+      _recoEndPoint.SetXYZ(_features.endX, _features.endY, _features.endZ);
+      _theta_xz = _features.theta_xz;
+      _theta_yz = _features.theta_yz;
+      _minHitPeakTime = _features.minHitPeakTime;
+      _maxHitPeakTime = _features.maxHitPeakTime;
+      _trackLength = _features.trackLength;
+      _trackID = _features.trackID;
+      if (loadLazyFeatures) {
+        LoadTrackFeature(kNeighbours,evt,thisParticle);
+        LoadTrackFeature(kHitsOnCryoSide,evt,thisParticle);
+      }
+      return;
+    }
+    _features.Reset();
+    _featuresEventID = evt.id();
+    _areNeighboursSet = false;
+    _areHitsOnCryoSideSet = false;
 
-    // Set the correct boundaries for cathode crossers.
-    geoHelper.SetFiducialBoundOffset(offsetFiducialBounds_AC);
-    geoHelper.InitFiducialVolumeBounds();
+    _driftVelocity = GetEventContext(evt).DriftVelocity();
 
     // Get recob::Track from PFParticle
     const recob::Track &track = GetTrackFromPFParticle(evt,thisParticle);
-    _recoEndPoint = track.End<TVector3>();
-    _recoStartPoint.SetXYZ(track.LocationAtPoint(track.FirstValidPoint()).X(), track.LocationAtPoint(track.FirstValidPoint()).Y(), track.LocationAtPoint(track.FirstValidPoint()).Z());
+    SetRecoTrackPoints(track);
     OrderRecoStartEnd(_recoStartPoint, _recoEndPoint);
-    _trackLength = track.Length();
     _trackID = track.ID();
 
-    std::cout << "Track ID: " << _trackID << std::endl;
-
     // using the ordered start and end points calculate the angles _theta_xz and _theta_yz
     _theta_xz = TMath::RadToDeg() * TMath::ATan2(_recoStartPoint.X()-_recoEndPoint.X(), _recoStartPoint.Z()-_recoEndPoint.Z());
     _theta_yz = TMath::RadToDeg() * TMath::ATan2(_recoStartPoint.Y()-_recoEndPoint.Y(), _recoStartPoint.Z()-_recoEndPoint.Z());
 
     SetMinAndMaxHitPeakTime(evt,thisParticle,_minHitPeakTime,_maxHitPeakTime);
 
-    if (_trackLength < length_cutoff_AC) {
-      if (DEBUG) std::cout << "Track too short." << std::endl;
-      return false;
-    }
+    _features.run = evt.id().run();
+    _features.event = evt.id().event();
+    _features.pfparticleIndex = thisParticle.Self();
+    _features.isRealData = evt.isRealData();
+    _features.trackID = _trackID;
+    _features.startX = _recoStartPoint.X();
+    _features.startY = _recoStartPoint.Y();
+    _features.startZ = _recoStartPoint.Z();
+    _features.endX = _recoEndPoint.X();
+    _features.endY = _recoEndPoint.Y();
+    _features.endZ = _recoEndPoint.Z();
+    _features.theta_xz = _theta_xz;
+    _features.theta_yz = _theta_yz;
+    _features.minHitPeakTime = _minHitPeakTime;
+    _features.maxHitPeakTime = _maxHitPeakTime;
+    _features.trackLength = _trackLength;
+    _features.driftVelocity = _driftVelocity;
 
-    if (TMath::Abs(_theta_yz-90)<10 || TMath::Abs(_theta_yz+90)<10 || TMath::Abs(_theta_xz-90)<10 || TMath::Abs(_theta_xz+90)<10) {
-      if(DEBUG) std::cout << "Track's angle not accepted." << std::endl;
-      //return false;
-    }
-
-    bool goodTrack = geoHelper.IsPointYZProjectionInArea(_recoStartPoint,offsetYStartPoint_AC,offsetZStartPoint_AC);
-    if (!goodTrack) {
-      if(DEBUG) std::cout << "Track's start point not accepted." << std::endl;
-      return false;
-    }
-
-    if (_minHitPeakTime <= cutMinHitPeakTime_AC) {
-      if(DEBUG) std::cout << "Track's minHitPeakTime not accepted." << std::endl;
-      return false;
-    }
-    if (_maxHitPeakTime >= cutMaxHitPeakTime_AC) {
-      if(DEBUG) std::cout << "Track's maxHitPeakTime not accepted." << std::endl;
-      return false;
-    }
+    // Get the T0
+    std::vector<anab::T0> pfparticleT0s = pfpUtil.GetPFParticleT0(thisParticle,evt,fPFParticleTag);
+    if (pfparticleT0s.size() != 0)
+      _features.pandoraT0 = pfparticleT0s[0].Time();
 
-    if ((TMath::Abs(_recoStartPoint.Z()-geoHelper.GetAPABoundaries()[0])<=cutContourAPA_AC) ||
-       (TMath::Abs(_recoStartPoint.Z()-geoHelper.GetAPABoundaries()[1])<=cutContourAPA_AC) ||
-       (TMath::Abs(_recoEndPoint.Z()-geoHelper.GetAPABoundaries()[0])<=cutContourAPA_AC)   ||
-       (TMath::Abs(_recoEndPoint.Z()-geoHelper.GetAPABoundaries()[1])<=cutContourAPA_AC)
-     ) {
-      if(DEBUG) std::cout << "Track's extreme points too close to APA." << std::endl;
-      return false;
+    if (loadLazyFeatures) {
+      LoadTrackFeature(kNeighbours,evt,thisParticle);
+      LoadTrackFeature(kHitsOnCryoSide,evt,thisParticle);
     }
+  }
 
-    TVector3 dirFirstTrack = _recoEndPoint - _recoStartPoint;
-    bool isBrokenTrack = false;
-    const std::vector<recob::PFParticle> & pfparticles = *(evt.getValidHandle<std::vector<recob::PFParticle>>(fPFParticleTag));
-    for (size_t p=0;p<pfparticles.size();p++) {
-      // Get track
-      const recob::Track *newTrack = pfpUtil.GetPFParticleTrack(pfparticles[p],evt,fPFParticleTag,fTrackerTag);
-      if (newTrack==nullptr) continue;
-      if (newTrack->ID()==_trackID) continue;
-      size_t fp = newTrack->FirstValidPoint();
-      TVector3 recoStartPointSecond(newTrack->LocationAtPoint(fp).X(),newTrack->LocationAtPoint(fp).Y(),newTrack->LocationAtPoint(fp).Z());
-      TVector3 recoEndPointSecond = newTrack->End<TVector3>();
-      OrderRecoStartEnd(recoStartPointSecond,recoEndPointSecond);
-      TVector3 dirSecondTrack = recoEndPointSecond-recoStartPointSecond;
-      TVector3 dirHigherTrack, dirLowerTrack, endPointHigherTrack, startPointLowerTrack, endPointLowerTrack;
-
-      if (_recoStartPoint.Y() > recoStartPointSecond.Y()) {
-        dirHigherTrack = dirFirstTrack;
-        dirLowerTrack = dirSecondTrack;
-        startPointLowerTrack = recoStartPointSecond;
-        endPointLowerTrack = recoEndPointSecond;
-        endPointHigherTrack = _recoEndPoint;
-      }
-      else {
-        dirHigherTrack = dirSecondTrack;
-        dirLowerTrack = dirFirstTrack;
-        startPointLowerTrack = _recoStartPoint;
-        endPointLowerTrack = _recoEndPoint;
-        endPointHigherTrack = recoEndPointSecond;
+  // Compute a lazy feature of the current PFParticle, if not done yet.
+  void StoppingMuonSelectionAlg::LoadTrackFeature(const lazyTrackFeature &feature,
+                                                  art::Event const &evt,
+                                                  recob::PFParticle const &thisParticle) {
+    if (feature == kHitsOnCryoSide && !_areHitsOnCryoSideSet) {
+      _areHitsOnCryoSideSet = true;
+      // Hits on the cryostat side are only needed for the tracks with a T0.
+      if (_features.pandoraT0 == INV_DBL) return;
+      STOPPING_MUON_SCOPED_TIMER("StoppingMuonSelectionAlg::HitsOnCryoSide");
+      auto const &trackHits = pfpUtil.GetPFParticleHits(thisParticle,evt,fPFParticleTag);
+      _features.hasHitsOnCryoSide = hitHelper.AreThereHitsOnCryoSide(trackHits);
+    }
+    else if (feature == kNeighbours && !_areNeighboursSet) {
+      _areNeighboursSet = true;
+      // Look for broken tracks
+      STOPPING_MUON_SCOPED_TIMER("StoppingMuonSelectionAlg::BrokenTrackNeighbours");
+      const std::vector<std::pair<Point3,Point3>> otherTracks = GetOtherTrackPoints(evt);
+      for (size_t p=0;p<otherTracks.size();p++) {
+        const brokenTrackNeighbour neighbour = GetBrokenTrackNeighbour(otherTracks[p].first,otherTracks[p].second);
+        if (neighbour.absCosAlpha > _selectionConstants.minCosAlphaNeighbours)
+          _features.neighbours.push_back(neighbour);
       }
+    }
+  }
 
-      TVector3 middlePointLowerTrack = (startPointLowerTrack + endPointLowerTrack) * 0.5;
-      TVector3 dirHigherTrack_YZ(0., dirHigherTrack.Y(), dirHigherTrack.Z());
-      TVector3 dirJoiningSegment(0., middlePointLowerTrack.Y()-endPointHigherTrack.Y(), middlePointLowerTrack.Z()-endPointHigherTrack.Z());
-      double cosBeta = TMath::Cos(dirHigherTrack_YZ.Angle(dirJoiningSegment));
-      double absCosAlpha = TMath::Abs(TMath::Cos(dirFirstTrack.Angle(dirSecondTrack)));
-
-      if ( (absCosAlpha > cutCosAngleBrokenTracks_AC) && (cosBeta >= cutCosAngleAlignment_AC) )
-        isBrokenTrack = true;
+  // Determine if the PFParticle is a selected anode crosser
+  bool StoppingMuonSelectionAlg::IsStoppingAnodeCrosser(art::Event const &evt,
+                                                        recob::PFParticle const &thisParticle) {
+    return SelectAnodeCrosser(evt,thisParticle,kExcludeNone);
+  }
 
-      double distHigherLower = TMath::Sqrt(TMath::Power(endPointHigherTrack.Y()-startPointLowerTrack.Y(),2) + TMath::Power(endPointHigherTrack.Z()-startPointLowerTrack.Z(),2));
-      if (distHigherLower < radiusBrokenTracksSearch_AC) {
-        if ( TMath::Abs(TMath::Cos(dirFirstTrack.Angle(dirSecondTrack))) > 0.96)
-        isBrokenTrack = true;
-      }
-      // Stop searching if found one
-      if (isBrokenTrack) break;
-    }
-    if (isBrokenTrack) {
-      if(DEBUG) std::cout << "Track is broken." << std::endl;
-      return false;
-    }
+  // Apply the anode crosser cuts, but the excluded ones.
+  bool StoppingMuonSelectionAlg::SelectAnodeCrosser(art::Event const &evt,
+                                                    recob::PFParticle const &thisParticle,
+                                                    const uint32_t &excludedCuts) {
+    SetTrackFeatures(evt,thisParticle);
 
-    // Get the T0
-    std::vector<anab::T0> pfparticleT0s = pfpUtil.GetPFParticleT0(thisParticle,evt,fPFParticleTag);
-    if (pfparticleT0s.size() == 0) {
-      _trackT0 = INV_DBL;
-    }
-    else
-      _trackT0 = pfparticleT0s[0].Time();
+    STOPPING_MUON_LOG_DEBUG(kLogSelection) << "Track ID: " << _trackID;
 
-    if (_trackT0 == INV_DBL) {
-      if (CorrectPosAndGetT0(_recoStartPoint,_recoEndPoint) == INV_DBL) return false;
-      trackInfo.isAnodeCrosserPandora = false;
-      trackInfo.isAnodeCrosserMine = true;
-    }
-    else {
-      std::cout << "Track tagged by Pandora." << std::endl;
-      trackInfo.isAnodeCrosserPandora = true;
-      trackInfo.isAnodeCrosserMine = false;
+    double t0 = INV_DBL, shiftX = 0.;
+    size_t failedCut = kPassedAllCuts;
+    {
+      STOPPING_MUON_SCOPED_TIMER("StoppingMuonSelectionAlg::AnodeCrosserCuts");
+      failedCut = apply_anode_crosser_cuts(_features,_cuts,_selectionConstants,t0,shiftX,excludedCuts,
+                                           [&](const lazyTrackFeature &feature) { LoadTrackFeature(feature,evt,thisParticle); });
     }
+    STOPPING_MUON_COUNT("StoppingMuonSelectionAlg::AnodeCrosserCuts: " + get_selection_cut_name(failedCut), 1);
 
-    // Check if there are hits on the cryostat side if the track is selected by Pandora.
-    if (trackInfo.isAnodeCrosserPandora) {
-      // Get hit vector.
-      auto const &trackHits = pfpUtil.GetPFParticleHits(thisParticle,evt,fPFParticleTag);
-      if (!hitHelper.AreThereHitsOnCryoSide(trackHits)) {
-        if(DEBUG) std::cout << "There are no hits in the cryostat sides." << std::endl;
-        return false;
-      }
+    // The T0 step was reached: use the T0 and correct the positions.
+    if (t0 != INV_DBL) {
+      _trackT0 = t0;
+      _recoStartPoint.SetX(_recoStartPoint.X() + shiftX);
+      _recoEndPoint.SetX(_recoEndPoint.X() + shiftX);
+      trackInfo.isAnodeCrosserPandora = (_features.pandoraT0 != INV_DBL);
+      trackInfo.isAnodeCrosserMine = !trackInfo.isAnodeCrosserPandora;
+      if (trackInfo.isAnodeCrosserPandora) STOPPING_MUON_LOG_DEBUG(kLogSelection) << "Track tagged by Pandora.";
     }
 
-    bool goodEndPoint = geoHelper.IsPointInVolume(geoHelper.GetFiducialVolumeBounds(),_recoEndPoint);
-    if (!goodEndPoint) {
-      if(DEBUG) std::cout << "Track's end point not accepted." << std::endl;
+    if (failedCut != kPassedAllCuts) {
+      STOPPING_MUON_LOG_DEBUG(kLogSelection) << "Track rejected: " << get_selection_cut_name(failedCut) << ".";
       return false;
     }
 
     // All cuts passed, this is likely an anode-crossing stopping muon.
     _isAnAnodeCrosser = true;
-    if (DEBUG) std::cout << "Track passed all selection cuts." << std::endl;
+    STOPPING_MUON_LOG_DEBUG(kLogSelection) << "Track passed all selection cuts.";
     return true;
   }
 
   // Correct position of the end point using the minimum hit peak time.
-  void StoppingMuonSelectionAlg::CorrectPosEnd(TVector3 &_recoStartPoint, TVector3 &_recoEndPoint, const double &minHitPeakTime, const double &maxHitPeakTime) {
+  void StoppingMuonSelectionAlg::CorrectPosEnd(Point3 &_recoStartPoint, Point3 &_recoEndPoint, const double &minHitPeakTime, const double &maxHitPeakTime) {
 
     // To do: make this independent from protoDUNE run 1 setup.
     //double t0 = (minHitPeakTime - 500) / 2. * 1000.; // in ns.
@@ -241,27 +218,15 @@ namespace stoppingcosmicmuonselection {
   }
 
   // Work out t0 for anode crossers.
-  double StoppingMuonSelectionAlg::CorrectPosAndGetT0(TVector3 &_recoStartPoint, TVector3 &_recoEndPoint) {
+  double StoppingMuonSelectionAlg::CorrectPosAndGetT0(Point3 &_recoStartPoint, Point3 &_recoEndPoint) {
 
-    double drift_velocity = _driftVelocity; // in cm/ns.
-    //std::cout << "StoppingMuonSelectionAlg::CorrectPosAndGetT0: " << "drift velocity = " << drift_velocity << std::endl;
-    double drift_distance = geoHelper.GetAbsolutePlaneCoordinate(0); // First induction plane coordinate.
-    //std::cout << "StoppingMuonSelectionAlg::CorrectPosAndGetT0: " << "drift distance = " << drift_distance << std::endl;
-  std::cout << "DRIFT DISTANCE: " << drift_distance << std::endl;
-    if (_recoStartPoint.X() <= _recoEndPoint.X()) {
-      if (_recoStartPoint.X() <= 0) {
-        _trackT0 = (drift_distance - TMath::Abs(_recoStartPoint.X())) /drift_velocity;
-        _recoStartPoint.SetX(_recoStartPoint.X() - (drift_velocity * _trackT0));
-        _recoEndPoint.SetX(_recoEndPoint.X() - (drift_velocity * _trackT0));
-      }
-    }
-    else {
-      if (_recoStartPoint.X() >= 0) {
-        _trackT0 = (drift_distance - TMath::Abs(_recoStartPoint.X())) /drift_velocity;
-        _recoStartPoint.SetX(_recoStartPoint.X() + (drift_velocity * _trackT0));
-        _recoEndPoint.SetX(_recoEndPoint.X() + (drift_velocity * _trackT0));
-      }
-    }
+    double shiftX = 0.;
+    const double t0 = get_anode_crosser_t0(_recoStartPoint.X(), _recoEndPoint.X(),
+                                           _selectionConstants.driftDistance, _driftVelocity, shiftX);
+    if (t0 == INV_DBL) return _trackT0;
+    _trackT0 = t0;
+    _recoStartPoint.SetX(_recoStartPoint.X() + shiftX);
+    _recoEndPoint.SetX(_recoEndPoint.X() + shiftX);
 
     return _trackT0;
   }
@@ -269,105 +234,25 @@ namespace stoppingcosmicmuonselection {
   // Determine if the PFParticle is a selected cathode crosser
   bool StoppingMuonSelectionAlg::IsStoppingCathodeCrosser(art::Event const &evt,
                                                           recob::PFParticle const &thisParticle) {
-    Reset();
-    _evNumber = evt.id().event();
-
-    // Declare handle for detector properties
-    auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-    auto const detprop = art::ServiceHandle<detinfo::DetectorPropertiesService>()->DataFor(evt, clockData);
-    _driftVelocity = detprop.DriftVelocity()*1e-3;
+    return SelectCathodeCrosser(evt,thisParticle,kExcludeNone);
+  }
 
-    // Set the correct boundaries for cathode crossers.
-    geoHelper.SetFiducialBoundOffset(offsetFiducialBounds_CC);
-    geoHelper.SetThicknessStartVolume(thicknessStartVolume_CC);
-    geoHelper.InitFiducialVolumeBounds();
+  // Apply the cathode crosser cuts, but the excluded ones.
+  bool StoppingMuonSelectionAlg::SelectCathodeCrosser(art::Event const &evt,
+                                                      recob::PFParticle const &thisParticle,
+                                                      const uint32_t &excludedCuts) {
+    SetTrackFeatures(evt,thisParticle);
+    _trackT0 = _features.pandoraT0;
 
-    // Get recob::Track from PFParticle
-    const recob::Track &track = GetTrackFromPFParticle(evt,thisParticle);
-    _recoEndPoint = track.End<TVector3>();
-    _recoStartPoint.SetXYZ(track.LocationAtPoint(track.FirstValidPoint()).X(), track.LocationAtPoint(track.FirstValidPoint()).Y(), track.LocationAtPoint(track.FirstValidPoint()).Z());
-    OrderRecoStartEnd(_recoStartPoint, _recoEndPoint);
-    _trackLength = track.Length();
-    _trackID = track.ID();
-    // using the ordered start and end points calculate the angles _theta_xz and _theta_yz
-    _theta_xz = TMath::RadToDeg() * TMath::ATan2(_recoStartPoint.X()-_recoEndPoint.X(), _recoStartPoint.Z()-_recoEndPoint.Z());
-    _theta_yz = TMath::RadToDeg() * TMath::ATan2(_recoStartPoint.Y()-_recoEndPoint.Y(), _recoStartPoint.Z()-_recoEndPoint.Z());
-    // Determine min and max hit peak time for this track
-    //std::cout << "theta xz :"  << _theta_xz << std::endl;
-    //std::cout << "theta yz :"  << _theta_yz << std::endl;
-    SetMinAndMaxHitPeakTime(evt,thisParticle,_minHitPeakTime,_maxHitPeakTime);
-    //std::cout << "_minHitPeakTime :"  << _minHitPeakTime << std::endl;
-    //std::cout << "_maxHitPeakTime :"  << _maxHitPeakTime << std::endl;
     // Apply cuts with selection with progressive cuts
-    //std::cout << "Length: " << _trackLength << std::endl;
-
-    // Get the T0
-    std::vector<anab::T0> pfparticleT0s = pfpUtil.GetPFParticleT0(thisParticle,evt,fPFParticleTag);
-    if (pfparticleT0s.size() == 0) {
-      _trackT0 = INV_DBL;
-      return false;
+    size_t failedCut = kPassedAllCuts;
+    {
+      STOPPING_MUON_SCOPED_TIMER("StoppingMuonSelectionAlg::CathodeCrosserCuts");
+      failedCut = apply_cathode_crosser_cuts(_features,_cuts,_selectionConstants,excludedCuts,
+                                             [&](const lazyTrackFeature &feature) { LoadTrackFeature(feature,evt,thisParticle); });
     }
-    else
-      _trackT0 = pfparticleT0s[0].Time();
-
-    if (_trackLength < length_cutoff_CC) return false;
-    //if (TMath::Abs(_theta_yz-90)<10 || TMath::Abs(_theta_yz+90)<10 || TMath::Abs(_theta_xz-90)<10 || TMath::Abs(_theta_xz+90)<10) return false;
-    bool goodTrack = ((_recoStartPoint.X()*_recoEndPoint.X()<0)
-                     && geoHelper.IsPointInSlice(_recoStartPoint)
-                     && geoHelper.IsPointInVolume(geoHelper.GetFiducialVolumeBounds(),_recoEndPoint));
-    //std::cout << "start*end: " << _recoStartPoint.X()*_recoEndPoint.X() << std::endl;
-    //std::cout << "start point in slice: " << geoHelper.IsPointInSlice(_recoStartPoint) << std::endl;
-    //std::cout << "End point in volume: " << geoHelper.IsPointInVolume(geoHelper.GetFiducialVolumeBounds(),_recoEndPoint) << std::endl;
-    //std::cout << "End point (XYZ): " << _recoEndPoint.X() << " " << _recoEndPoint.Y() << " " << _recoEndPoint.Z() << std::endl;
-    if (!goodTrack) return false;
-    // Additional cut for prod4:
-    if (TMath::Abs(_recoStartPoint.X())<20) return false;
-    if (_minHitPeakTime <= cutMinHitPeakTime_CC) return false;
-    if (_maxHitPeakTime >= cutMaxHitPeakTime_CC) return false;
-    if ((TMath::Abs(_recoEndPoint.Z()-geoHelper.GetAPABoundaries()[0])<=cutContourAPA_CC) || (TMath::Abs(_recoEndPoint.Z()-geoHelper.GetAPABoundaries()[1])<=cutContourAPA_CC)) return false;
-    //std::cout << "End Point Z: " << _recoEndPoint.Z() << std::endl;
-    // Look for broken tracks
-    TVector3 dirFirstTrack = _recoEndPoint - _recoStartPoint;
-    bool isBrokenTrack = false;
-    const std::vector<recob::PFParticle> & pfparticles = *(evt.getValidHandle<std::vector<recob::PFParticle>>(fPFParticleTag));
-    for (size_t p=0;p<pfparticles.size();p++) {
-      // Get track
-      const recob::Track *newTrack = pfpUtil.GetPFParticleTrack(pfparticles[p],evt,fPFParticleTag,fTrackerTag);
-      if (newTrack==nullptr) continue;
-      if (newTrack->ID()==_trackID) continue;
-      size_t fp = newTrack->FirstValidPoint();
-      TVector3 recoStartPointSecond(newTrack->LocationAtPoint(fp).X(),newTrack->LocationAtPoint(fp).Y(),newTrack->LocationAtPoint(fp).Z());
-      TVector3 recoEndPointSecond = newTrack->End<TVector3>();
-      OrderRecoStartEnd(recoStartPointSecond,recoEndPointSecond);
-      TVector3 dirSecondTrack = recoEndPointSecond-recoStartPointSecond;
-      TVector3 dirHigherTrack, dirLowerTrack, endPointHigherTrack, startPointLowerTrack, endPointLowerTrack;
-      if (_recoStartPoint.Y() > recoStartPointSecond.Y()) {
-        dirHigherTrack = dirFirstTrack;
-        dirLowerTrack = dirSecondTrack;
-        startPointLowerTrack = recoStartPointSecond;
-        endPointLowerTrack = recoEndPointSecond;
-        endPointHigherTrack = _recoEndPoint;
-      }
-      else
-        continue;
-      TVector3 middlePointLowerTrack = (startPointLowerTrack + endPointLowerTrack) * 0.5;
-      TVector3 dirHigherTrack_YZ(0., dirHigherTrack.Y(), dirHigherTrack.Z());
-      TVector3 dirJoiningSegment(0., middlePointLowerTrack.Y()-endPointHigherTrack.Y(), middlePointLowerTrack.Z()-endPointHigherTrack.Z());
-      double cosBeta = TMath::Cos(dirHigherTrack_YZ.Angle(dirJoiningSegment));
-      double absCosAlpha = TMath::Abs(TMath::Cos(dirFirstTrack.Angle(dirSecondTrack)));
-
-      if ( (absCosAlpha > cutCosAngleBrokenTracks_CC) && (cosBeta >= cutCosAngleAlignment_CC) )
-        isBrokenTrack = true;
-
-      double distHigherLower = TMath::Sqrt(TMath::Power(endPointHigherTrack.Y()-startPointLowerTrack.Y(),2) + TMath::Power(endPointHigherTrack.Z()-startPointLowerTrack.Z(),2));
-      if (distHigherLower < radiusBrokenTracksSearch_CC) {
-        if ( TMath::Abs(TMath::Cos(dirFirstTrack.Angle(dirSecondTrack))) > 0.96)
-          isBrokenTrack = true;
-      }
-      // Stop searching if found one
-      if (isBrokenTrack) break;
-    }
-    if (isBrokenTrack) return false;
+    STOPPING_MUON_COUNT("StoppingMuonSelectionAlg::CathodeCrosserCuts: " + get_selection_cut_name(failedCut), 1);
+    if (failedCut != kPassedAllCuts) return false;
 
     // All cuts passed, this is likely a cathode-crossing stopping muon.
     _isACathodeCrosser = true;
@@ -376,18 +261,25 @@ namespace stoppingcosmicmuonselection {
 
   }
 
+  // Use a per-event truth matching table instead of backtracking each PFParticle.
+  void StoppingMuonSelectionAlg::SetTruthMatchTable(const TruthMatchTable *truthTable) {
+    _truthTable = truthTable;
+  }
+
   // For MC events, check if the track is associated to a cosmic track
   bool StoppingMuonSelectionAlg::IsTrackMatchedToTrueCosmicTrack(art::Event const &evt,
                                                                  recob::PFParticle const &thisParticle) {
+    STOPPING_MUON_SCOPED_TIMER("StoppingMuonSelectionAlg::IsTrackMatchedToTrueCosmicTrack");
     const simb::MCParticle *particleP = 0x0;
-    if (!evt.isRealData()) {
-      // Declare handle for detector properties
-      auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-      particleP = truthUtil.GetMCParticleFromPFParticle(clockData,thisParticle,evt,fPFParticleTag);
+    if (!evt.isRealData() && _truthTable && _truthTable->IsSet())
+      return _truthTable->IsMatchedToCosmic(thisParticle);
+    // Without the cheater services there is no backtracking.
+    if (!evt.isRealData() && TruthProvider::IsCompiledIn()) {
+      particleP = truthUtil.GetMCParticleFromPFParticle(GetEventContext(evt).ClockData(),thisParticle,evt,fPFParticleTag);
       if (particleP == 0x0) return false;
-      if ((pi_serv->TrackIdToMCTruth_P(particleP->TrackId())->Origin()) == simb::kCosmicRay) {
+      if (TruthProvider::Get().TrackIdToOrigin(particleP->TrackId()) == simb::kCosmicRay) {
         //std::cout << "Particle ID: " << particleP->TrackId() << " Pdg: " << particleP->PdgCode() << std::endl;
-        //int pdg_mother = pi_serv->TrackIdToMotherParticle_P(particleP->TrackId())->PdgCode();
+        //int pdg_mother = TruthProvider::Get().TrackIdToMotherParticle_P(particleP->TrackId())->PdgCode();
         //std::cout << "StoppingMuonSelectionAlg::IsTrackMatchedToTrueCosmicTrack: " << "pdg of mother particle: " << pdg_mother << std::endl;
         //std::cout << "process: " << particleP->Process() << std::endl;
         return true;
@@ -399,9 +291,103 @@ namespace stoppingcosmicmuonselection {
       return false;
   }
 
+  // Use a per-event track index instead of scanning the tracks.
+  void StoppingMuonSelectionAlg::SetTrackIDIndex(const TrackIDIndex *trackIDIndex) {
+    _trackIDIndex = trackIDIndex;
+  }
+
+  // Use the per-event context of the module instead of calling the services.
+  void StoppingMuonSelectionAlg::SetEventContext(const EventContext *eventContext) {
+    _eventContext = eventContext;
+  }
+
+  // Get the context of the event: the one set by the module, or one built here.
+  const EventContext &StoppingMuonSelectionAlg::GetEventContext(art::Event const &evt) {
+    if (_eventContext && _eventContext->IsFor(evt)) return *_eventContext;
+    if (!_ownEventContext || !_ownEventContext->IsFor(evt))
+      _ownEventContext.reset(new EventContext(evt));
+    return *_ownEventContext;
+  }
+
+  // Set reco start point, end point and length of the track.
+  void StoppingMuonSelectionAlg::SetRecoTrackPoints(const recob::Track &track) {
+    const size_t index = _trackIDIndex ? _trackIDIndex->GetIndex(track) : INV_SIZE;
+    if (_trackIDIndex && index < _trackIDIndex->Size()) {
+      _recoStartPoint = _trackIDIndex->FirstValidPoint(index);
+      _recoEndPoint = _trackIDIndex->EndPoint(index);
+      _trackLength = _trackIDIndex->Length(index);
+      return;
+    }
+    _recoEndPoint = make_point3(track.End());
+    _recoStartPoint = make_point3(track.LocationAtPoint(track.FirstValidPoint()));
+    _trackLength = track.Length();
+  }
+
+  // Get start and end points of all the other tracks in the event.
+  const std::vector<std::pair<Point3,Point3>> StoppingMuonSelectionAlg::GetOtherTrackPoints(art::Event const &evt) {
+    std::vector<std::pair<Point3,Point3>> otherTracks;
+    if (_trackIDIndex) {
+      otherTracks.reserve(_trackIDIndex->Size());
+      for (size_t i = 0; i < _trackIDIndex->Size(); i++) {
+        if (_trackIDIndex->ID(i)==_trackID) continue;
+        otherTracks.emplace_back(_trackIDIndex->FirstValidPoint(i), _trackIDIndex->EndPoint(i));
+      }
+      return otherTracks;
+    }
+    const std::vector<recob::PFParticle> & pfparticles = *(evt.getValidHandle<std::vector<recob::PFParticle>>(fPFParticleTag));
+    for (size_t p=0;p<pfparticles.size();p++) {
+      // Get track
+      const recob::Track *newTrack = pfpUtil.GetPFParticleTrack(pfparticles[p],evt,fPFParticleTag,fTrackerTag);
+      if (newTrack==nullptr) continue;
+      if (newTrack->ID()==_trackID) continue;
+      size_t fp = newTrack->FirstValidPoint();
+      Point3 recoStartPointSecond = make_point3(newTrack->LocationAtPoint(fp));
+      otherTracks.emplace_back(recoStartPointSecond, make_point3(newTrack->End()));
+    }
+    return otherTracks;
+  }
+
+  // Broken track quantities of another track with respect to this one.
+  brokenTrackNeighbour StoppingMuonSelectionAlg::GetBrokenTrackNeighbour(const Point3 &startPointSecond,
+                                                                         const Point3 &endPointSecond) {
+    // Points of the features: the selection may have shifted the current ones in X since.
+    const Point3 recoStartPointFirst{_features.startX, _features.startY, _features.startZ};
+    const Point3 recoEndPointFirst{_features.endX, _features.endY, _features.endZ};
+    Point3 recoStartPointSecond = startPointSecond;
+    Point3 recoEndPointSecond = endPointSecond;
+    OrderRecoStartEnd(recoStartPointSecond,recoEndPointSecond);
+    Vec3 dirFirstTrack = recoEndPointFirst - recoStartPointFirst;
+    Vec3 dirSecondTrack = recoEndPointSecond-recoStartPointSecond;
+    Vec3 dirHigherTrack;
+    Point3 endPointHigherTrack, startPointLowerTrack, endPointLowerTrack;
+
+    brokenTrackNeighbour neighbour;
+    neighbour.isHigher = (recoStartPointFirst.Y() > recoStartPointSecond.Y());
+    if (neighbour.isHigher) {
+      dirHigherTrack = dirFirstTrack;
+      startPointLowerTrack = recoStartPointSecond;
+      endPointLowerTrack = recoEndPointSecond;
+      endPointHigherTrack = recoEndPointFirst;
+    }
+    else {
+      dirHigherTrack = dirSecondTrack;
+      startPointLowerTrack = recoStartPointFirst;
+      endPointLowerTrack = recoEndPointFirst;
+      endPointHigherTrack = recoEndPointSecond;
+    }
+
+    Point3 middlePointLowerTrack = (startPointLowerTrack + endPointLowerTrack) * 0.5;
+    Vec3 dirHigherTrack_YZ{0., dirHigherTrack.Y(), dirHigherTrack.Z()};
+    Vec3 dirJoiningSegment{0., middlePointLowerTrack.Y()-endPointHigherTrack.Y(), middlePointLowerTrack.Z()-endPointHigherTrack.Z()};
+    neighbour.cosBeta = TMath::Cos(dirHigherTrack_YZ.Angle(dirJoiningSegment));
+    neighbour.absCosAlpha = TMath::Abs(TMath::Cos(dirFirstTrack.Angle(dirSecondTrack)));
+    neighbour.distHigherLower = TMath::Sqrt(TMath::Power(endPointHigherTrack.Y()-startPointLowerTrack.Y(),2) + TMath::Power(endPointHigherTrack.Z()-startPointLowerTrack.Z(),2));
+    return neighbour;
+  }
+
   // Order reco start and end point based on Y position
-  void StoppingMuonSelectionAlg::OrderRecoStartEnd(TVector3 &start, TVector3 &end) {
-    TVector3 prov;
+  void StoppingMuonSelectionAlg::OrderRecoStartEnd(Point3 &start, Point3 &end) {
+    Point3 prov;
     if (end.Y() > start.Y()) {
       prov = start;
       start = end;
@@ -422,28 +408,42 @@ namespace stoppingcosmicmuonselection {
                                                          recob::PFParticle const &thisParticle,
                                                          double &minHitPeakTime,
                                                          double &maxHitPeakTime) {
+    STOPPING_MUON_SCOPED_TIMER("StoppingMuonSelectionAlg::SetMinAndMaxHitPeakTime");
     // Get Hits associated with PFParticle
     const std::vector<const recob::Hit*> Hits = pfpUtil.GetPFParticleHits(thisParticle,evt,fPFParticleTag);
-    std::vector<double> HitPeakTimes;
-    for (unsigned int hitIndex = 0; hitIndex < Hits.size(); ++hitIndex)   {
-      HitPeakTimes.push_back(Hits[hitIndex]->PeakTime());
-    }
-    minHitPeakTime = *(std::min_element(HitPeakTimes.begin(), HitPeakTimes.end()));
-    maxHitPeakTime = *(std::max_element(HitPeakTimes.begin(), HitPeakTimes.end()));
+    // No need to copy the peak times.
+    const auto minMaxHit = std::minmax_element(Hits.begin(), Hits.end(),
+                                               [](const recob::Hit *a, const recob::Hit *b) {
+                                                 return a->PeakTime() < b->PeakTime();
+                                               });
+    minHitPeakTime = (*minMaxHit.first)->PeakTime();
+    maxHitPeakTime = (*minMaxHit.second)->PeakTime();
   }
 
   // Set MCParticle properties
   void StoppingMuonSelectionAlg::SetMCParticleProperties(art::Event const &evt, recob::PFParticle const &thisParticle) {
-    // Declare handle for detector properties
-    auto const clockData = art::ServiceHandle<detinfo::DetectorClocksService>()->DataFor(evt);
-    const simb::MCParticle *particleP = truthUtil.GetMCParticleFromPFParticle(clockData, thisParticle,evt,fPFParticleTag);
+    STOPPING_MUON_SCOPED_TIMER("StoppingMuonSelectionAlg::SetMCParticleProperties");
+    if (_truthTable && _truthTable->IsSet()) {
+      const truthMatch &match = _truthTable->GetMatch(thisParticle);
+      _pdg = match.pdg;
+      _trueStartPoint = match.startPoint;
+      _trueEndPoint = match.endPoint;
+      _trueStartT = match.startT;
+      _trueEndT = match.endT;
+      _trueTrackID = match.trackID;
+      _areMCParticlePropertiesSet = true;
+      return;
+    }
+    if (!TruthProvider::IsCompiledIn())
+      throw cet::exception("StoppingMuonSelectionAlg.cxx") << "MC truth requested in a build with STOPPING_MUON_DATA_ONLY.";
+    const simb::MCParticle *particleP = truthUtil.GetMCParticleFromPFParticle(GetEventContext(evt).ClockData(), thisParticle,evt,fPFParticleTag);
     _pdg = particleP->PdgCode();
     // Not valid in prod4 as there are only 2 trajectory points in the
     // simb::MCParticle object.
     //int firstPoint = truthUtil.GetFirstTrajectoryPointInTPCActiveVolume(*particleP,av[0],av[1],av[2],av[3],av[4],av[5]);
     int firstPoint = 0;
     _trueStartPoint.SetXYZ(particleP->Vx(firstPoint),particleP->Vy(firstPoint),particleP->Vz(firstPoint));
-    _trueEndPoint = particleP->EndPosition().Vect();
+    _trueEndPoint = make_point3(particleP->EndPosition());
     _trueStartT = particleP->T(firstPoint);
     _trueEndT = particleP->EndPosition().T();
     _trueTrackID = particleP->TrackId();
@@ -487,373 +487,42 @@ namespace stoppingcosmicmuonselection {
 
   // N-1 cuts for Cathode crossers
   bool StoppingMuonSelectionAlg::NMinus1Cathode(const std::string &excludeCut, art::Event const &evt, const recob::PFParticle &thisParticle) {
-
-    Reset();
-    _evNumber = evt.id().event();
-
-    // Set the correct boundaries for cathode crossers.
-    geoHelper.SetFiducialBoundOffset(offsetFiducialBounds_CC);
-    geoHelper.SetThicknessStartVolume(thicknessStartVolume_CC);
-    geoHelper.InitFiducialVolumeBounds();
-
-    // Get the T0
-    std::vector<anab::T0> pfparticleT0s = pfpUtil.GetPFParticleT0(thisParticle,evt,fPFParticleTag);
-    if (pfparticleT0s.size() == 0) {
-      _trackT0 = INV_DBL;
-      return false;
-    }
-    else
-      _trackT0 = pfparticleT0s[0].Time();
-    // Get recob::Track from PFParticle
-    const recob::Track &track = GetTrackFromPFParticle(evt,thisParticle);
-    _recoEndPoint = track.End<TVector3>();
-    _recoStartPoint.SetXYZ(track.LocationAtPoint(track.FirstValidPoint()).X(), track.LocationAtPoint(track.FirstValidPoint()).Y(), track.LocationAtPoint(track.FirstValidPoint()).Z());
-    OrderRecoStartEnd(_recoStartPoint, _recoEndPoint);
-    _trackLength = track.Length();
-    _trackID = track.ID();
-    // using the ordered start and end points calculate the angles _theta_xz and _theta_yz
-    _theta_xz = TMath::RadToDeg() * TMath::ATan2(_recoStartPoint.X()-_recoEndPoint.X(), _recoStartPoint.Z()-_recoEndPoint.Z());
-    _theta_yz = TMath::RadToDeg() * TMath::ATan2(_recoStartPoint.Y()-_recoEndPoint.Y(), _recoStartPoint.Z()-_recoEndPoint.Z());
-    // Determine min and max hit peak time for this track
-    SetMinAndMaxHitPeakTime(evt,thisParticle,_minHitPeakTime,_maxHitPeakTime);
-    // Apply cuts with selection with progressive cuts
-    if (_trackLength < length_cutoff_CC) return false;
-
-    // Apply cuts for good track separately.
-    if (!(_recoStartPoint.X()*_recoEndPoint.X()<0)) return false;
-
-    if (excludeCut!="thicknessStartVolume") {
-      bool goodStart = geoHelper.IsPointInSlice(_recoStartPoint);
-      if (!goodStart) return false;
-    }
-    double *fidBounds = geoHelper.GetFiducialVolumeBounds();
-    if (excludeCut != "distanceFiducialVolumeX" && excludeCut != "distanceFiducialVolumeY" && excludeCut != "distanceFiducialVolumeZ")   {
-      bool goodEndPoint = geoHelper.IsPointInVolume(geoHelper.GetFiducialVolumeBounds(), _recoEndPoint);
-      if (!goodEndPoint) return false;
-    }
-    else if (excludeCut == "distanceFiducialVolumeX") {
-      bool goodEndPoint = (_recoEndPoint.Y() >= fidBounds[2] && _recoEndPoint.Y() <= fidBounds[3] && _recoEndPoint.Z() >= fidBounds[4] && _recoEndPoint.Z() <= fidBounds[5]);
-      if (!goodEndPoint) return false;
-    }
-    else if (excludeCut == "distanceFiducialVolumeY") {
-      bool goodEndPoint = (_recoEndPoint.X() >= fidBounds[0] && _recoEndPoint.X() <= fidBounds[1] && _recoEndPoint.Z() >= fidBounds[4] && _recoEndPoint.Z() <= fidBounds[5]);
-      if (!goodEndPoint) return false;
-    }
-    else if (excludeCut == "distanceFiducialVolumeZ") {
-      bool goodEndPoint = (_recoEndPoint.X() >= fidBounds[0] && _recoEndPoint.X() <= fidBounds[1] && _recoEndPoint.Y() >= fidBounds[2] && _recoEndPoint.Y() <= fidBounds[3]);
-      if (!goodEndPoint) return false;
-    }
-
-    if (excludeCut!="cutMinHitPeakTime") {
-      if (_minHitPeakTime <= cutMinHitPeakTime_CC) return false;
-    }
-    if (excludeCut!="cutMaxHitPeakTime") {
-      if (_maxHitPeakTime >= cutMaxHitPeakTime_CC) return false;
-    }
-
-    if ((TMath::Abs(_recoEndPoint.Z()-geoHelper.GetAPABoundaries()[0])<=cutContourAPA_CC) || (TMath::Abs(_recoEndPoint.Z()-geoHelper.GetAPABoundaries()[1])<=cutContourAPA_CC)) return false;
-
-    // Look for broken tracks
-    TVector3 dirFirstTrack = _recoEndPoint - _recoStartPoint;
-    bool isBrokenTrack = false;
-    const std::vector<recob::PFParticle> & pfparticles = *(evt.getValidHandle<std::vector<recob::PFParticle>>(fPFParticleTag));
-    for (size_t p=0;p<pfparticles.size();p++) {
-      // Get track
-      const recob::Track *newTrack = pfpUtil.GetPFParticleTrack(pfparticles[p],evt,fPFParticleTag,fTrackerTag);
-      if (newTrack==nullptr) continue;
-      if (newTrack->ID()==_trackID) continue;
-      size_t fp = newTrack->FirstValidPoint();
-      TVector3 recoStartPointSecond(newTrack->LocationAtPoint(fp).X(),newTrack->LocationAtPoint(fp).Y(),newTrack->LocationAtPoint(fp).Z());
-      TVector3 recoEndPointSecond = newTrack->End<TVector3>();
-      OrderRecoStartEnd(recoStartPointSecond,recoEndPointSecond);
-      TVector3 dirSecondTrack = recoEndPointSecond-recoStartPointSecond;
-      TVector3 dirHigherTrack, dirLowerTrack, endPointHigherTrack, startPointLowerTrack, endPointLowerTrack;
-      if (_recoStartPoint.Y() > recoStartPointSecond.Y()) {
-        dirHigherTrack = dirFirstTrack;
-        dirLowerTrack = dirSecondTrack;
-        startPointLowerTrack = recoStartPointSecond;
-        endPointLowerTrack = recoEndPointSecond;
-        endPointHigherTrack = _recoEndPoint;
-      }
-      else
-        continue;
-      TVector3 middlePointLowerTrack = (startPointLowerTrack + endPointLowerTrack) * 0.5;
-      TVector3 dirHigherTrack_YZ(0., dirHigherTrack.Y(), dirHigherTrack.Z());
-      TVector3 dirJoiningSegment(0., middlePointLowerTrack.Y()-endPointHigherTrack.Y(), middlePointLowerTrack.Z()-endPointHigherTrack.Z());
-      double cosBeta = TMath::Cos(dirHigherTrack_YZ.Angle(dirJoiningSegment));
-      double absCosAlpha = TMath::Abs(TMath::Cos(dirFirstTrack.Angle(dirSecondTrack)));
-
-      if ( (absCosAlpha > cutCosAngleBrokenTracks_CC) && (cosBeta >= cutCosAngleAlignment_CC) )
-        isBrokenTrack = true;
-
-      double distHigherLower = TMath::Sqrt(TMath::Power(endPointHigherTrack.Y()-startPointLowerTrack.Y(),2) + TMath::Power(endPointHigherTrack.Z()-startPointLowerTrack.Z(),2));
-      if (distHigherLower < radiusBrokenTracksSearch_CC) {
-        if ( TMath::Abs(TMath::Cos(dirFirstTrack.Angle(dirSecondTrack))) > 0.96)
-          isBrokenTrack = true;
-      }
-      // Stop searching if found one
-      if (isBrokenTrack) break;
-    }
-    if (isBrokenTrack) return false;
-
-    // All cuts passed, this is likely a cathode-crossing stopping muon.
-    _isACathodeCrosser = true;
-    trackInfo.isCathodeCrosser = true;
-    return true;
+    return SelectCathodeCrosser(evt,thisParticle,get_excluded_cuts(excludeCut));
   }
 
   // N-1 cuts for Anode crossers
   bool StoppingMuonSelectionAlg::NMinus1Anode(const std::string &excludeCut, art::Event const &evt, const recob::PFParticle &thisParticle) {
-
-    bool DEBUG = false;
-    Reset();
-    _evNumber = evt.id().event();
-
-    // Set the correct boundaries for cathode crossers.
-    geoHelper.SetFiducialBoundOffset(offsetFiducialBounds_AC);
-    geoHelper.InitFiducialVolumeBounds();
-
-    // Get recob::Track from PFParticle
-    const recob::Track &track = GetTrackFromPFParticle(evt,thisParticle);
-    _recoEndPoint = track.End<TVector3>();
-    _recoStartPoint.SetXYZ(track.LocationAtPoint(track.FirstValidPoint()).X(), track.LocationAtPoint(track.FirstValidPoint()).Y(), track.LocationAtPoint(track.FirstValidPoint()).Z());
-    OrderRecoStartEnd(_recoStartPoint, _recoEndPoint);
-    _trackLength = track.Length();
-    _trackID = track.ID();
-
-    // using the ordered start and end points calculate the angles _theta_xz and _theta_yz
-    _theta_xz = TMath::RadToDeg() * TMath::ATan2(_recoStartPoint.X()-_recoEndPoint.X(), _recoStartPoint.Z()-_recoEndPoint.Z());
-    _theta_yz = TMath::RadToDeg() * TMath::ATan2(_recoStartPoint.Y()-_recoEndPoint.Y(), _recoStartPoint.Z()-_recoEndPoint.Z());
-
-    SetMinAndMaxHitPeakTime(evt,thisParticle,_minHitPeakTime,_maxHitPeakTime);
-
-    if (_trackLength < length_cutoff_AC) {
-      if (DEBUG) std::cout << "Track too short." << std::endl;
-      return false;
-    }
-
-    if (TMath::Abs(_theta_yz-90)<10 || TMath::Abs(_theta_yz+90)<10 || TMath::Abs(_theta_xz-90)<10 || TMath::Abs(_theta_xz+90)<10) {
-      if(DEBUG) std::cout << "Track's angle not accepted." << std::endl;
-      return false;
-    }
-
-    bool goodTrack = false;
-    double *actBounds = geoHelper.GetActiveVolumeBounds();
-    if (excludeCut != "offsetYStartPoint" && excludeCut != "offsetZStartPoint")
-      goodTrack = geoHelper.IsPointYZProjectionInArea(_recoStartPoint,offsetYStartPoint_AC,offsetZStartPoint_AC);
-    else if (excludeCut == "offsetYStartPoint")
-      goodTrack = (_recoStartPoint.Z()>=(actBounds[4]+offsetZStartPoint_AC) && _recoStartPoint.Z()<=(actBounds[5]-offsetZStartPoint_AC));
-    else if (excludeCut == "offsetZStartPoint")
-      goodTrack = (_recoStartPoint.Y()>=(actBounds[2]+offsetYStartPoint_AC) && _recoStartPoint.Y()<=(actBounds[3]-offsetYStartPoint_AC));
-    if (!goodTrack) {
-      if(DEBUG) std::cout << "Track's start point not accepted." << std::endl;
-      return false;
-    }
-
-    if (excludeCut != "cutMinHitPeakTime") {
-      if (_minHitPeakTime <= cutMinHitPeakTime_AC) {
-        if(DEBUG) std::cout << "Track's minHitPeakTime not accepted." << std::endl;
-        return false;
-      }
-    }
-
-    if (excludeCut != "cutMaxHitPeakTime") {
-      if (_maxHitPeakTime >= cutMaxHitPeakTime_AC) {
-        if(DEBUG) std::cout << "Track's maxHitPeakTime not accepted." << std::endl;
-        return false;
-      }
-    }
-
-    if ((TMath::Abs(_recoStartPoint.Z()-geoHelper.GetAPABoundaries()[0])<=cutContourAPA_AC) ||
-       (TMath::Abs(_recoStartPoint.Z()-geoHelper.GetAPABoundaries()[1])<=cutContourAPA_AC) ||
-       (TMath::Abs(_recoEndPoint.Z()-geoHelper.GetAPABoundaries()[0])<=cutContourAPA_AC)   ||
-       (TMath::Abs(_recoEndPoint.Z()-geoHelper.GetAPABoundaries()[1])<=cutContourAPA_AC)
-     ) {
-      if(DEBUG) std::cout << "Track's extreme points too close to APA." << std::endl;
-      return false;
-    }
-
-    TVector3 dirFirstTrack = _recoEndPoint - _recoStartPoint;
-    bool isBrokenTrack = false;
-    const std::vector<recob::PFParticle> & pfparticles = *(evt.getValidHandle<std::vector<recob::PFParticle>>(fPFParticleTag));
-    for (size_t p=0;p<pfparticles.size();p++) {
-      // Get track
-      const recob::Track *newTrack = pfpUtil.GetPFParticleTrack(pfparticles[p],evt,fPFParticleTag,fTrackerTag);
-      if (newTrack==nullptr) continue;
-      if (newTrack->ID()==_trackID) continue;
-      size_t fp = newTrack->FirstValidPoint();
-      TVector3 recoStartPointSecond(newTrack->LocationAtPoint(fp).X(),newTrack->LocationAtPoint(fp).Y(),newTrack->LocationAtPoint(fp).Z());
-      TVector3 recoEndPointSecond = newTrack->End<TVector3>();
-      OrderRecoStartEnd(recoStartPointSecond,recoEndPointSecond);
-      TVector3 dirSecondTrack = recoEndPointSecond-recoStartPointSecond;
-      TVector3 dirHigherTrack, dirLowerTrack, endPointHigherTrack, startPointLowerTrack, endPointLowerTrack;
-
-      if (_recoStartPoint.Y() > recoStartPointSecond.Y()) {
-        dirHigherTrack = dirFirstTrack;
-        dirLowerTrack = dirSecondTrack;
-        startPointLowerTrack = recoStartPointSecond;
-        endPointLowerTrack = recoEndPointSecond;
-        endPointHigherTrack = _recoEndPoint;
-      }
-      else {
-        dirHigherTrack = dirSecondTrack;
-        dirLowerTrack = dirFirstTrack;
-        startPointLowerTrack = _recoStartPoint;
-        endPointLowerTrack = _recoEndPoint;
-        endPointHigherTrack = recoEndPointSecond;
-      }
-
-      TVector3 middlePointLowerTrack = (startPointLowerTrack + endPointLowerTrack) * 0.5;
-      TVector3 dirHigherTrack_YZ(0., dirHigherTrack.Y(), dirHigherTrack.Z());
-      TVector3 dirJoiningSegment(0., middlePointLowerTrack.Y()-endPointHigherTrack.Y(), middlePointLowerTrack.Z()-endPointHigherTrack.Z());
-      double cosBeta = TMath::Cos(dirHigherTrack_YZ.Angle(dirJoiningSegment));
-      double absCosAlpha = TMath::Abs(TMath::Cos(dirFirstTrack.Angle(dirSecondTrack)));
-
-      if ( (absCosAlpha > cutCosAngleBrokenTracks_AC) && (cosBeta >= cutCosAngleAlignment_AC) )
-        isBrokenTrack = true;
-
-      double distHigherLower = TMath::Sqrt(TMath::Power(endPointHigherTrack.Y()-startPointLowerTrack.Y(),2) + TMath::Power(endPointHigherTrack.Z()-startPointLowerTrack.Z(),2));
-      if (distHigherLower < radiusBrokenTracksSearch_AC) {
-        if ( TMath::Abs(TMath::Cos(dirFirstTrack.Angle(dirSecondTrack))) > 0.96)
-        isBrokenTrack = true;
-      }
-      // Stop searching if found one
-      if (isBrokenTrack) break;
-    }
-    if (isBrokenTrack) {
-      if(DEBUG) std::cout << "Track is broken." << std::endl;
-      return false;
-    }
-
-    // Get the T0
-    std::vector<anab::T0> pfparticleT0s = pfpUtil.GetPFParticleT0(thisParticle,evt,fPFParticleTag);
-    if (pfparticleT0s.size() == 0) {
-      _trackT0 = INV_DBL;
-    }
-    else
-      _trackT0 = pfparticleT0s[0].Time();
-
-    if (_trackT0 == INV_DBL) {
-      if (CorrectPosAndGetT0(_recoStartPoint,_recoEndPoint) == INV_DBL) return false;
-      CorrectPosEnd(_recoStartPoint, _recoEndPoint, _minHitPeakTime, _maxHitPeakTime);
-      trackInfo.isAnodeCrosserPandora = false;
-      trackInfo.isAnodeCrosserMine = true;
-    }
-    else {
-      if (DEBUG) std::cout << "Track tagged by Pandora." << std::endl;
-      //CorrectPosEnd(_recoStartPoint, _recoEndPoint, _minHitPeakTime, _maxHitPeakTime);
-      trackInfo.isAnodeCrosserPandora = true;
-      trackInfo.isAnodeCrosserMine = false;
-    }
-
-    // Check if there are hits on the cryostat side if the track is selected by Pandora.
-    if (trackInfo.isAnodeCrosserPandora) {
-      // Get hit vector.
-      auto const &trackHits = pfpUtil.GetPFParticleHits(thisParticle,evt,fPFParticleTag);
-      if (!hitHelper.AreThereHitsOnCryoSide(trackHits)) {
-        if(DEBUG) std::cout << "There are no hits in the cryostat sides." << std::endl;
-        return false;
-      }
-    }
-
-    double *fidBounds = geoHelper.GetFiducialVolumeBounds();
-    if (excludeCut != "distanceFiducialVolumeX" && excludeCut != "distanceFiducialVolumeY" && excludeCut != "distanceFiducialVolumeZ")   {
-      bool goodEndPoint = geoHelper.IsPointInVolume(geoHelper.GetFiducialVolumeBounds(), _recoEndPoint);
-      if (!goodEndPoint) return false;
-    }
-    else if (excludeCut == "distanceFiducialVolumeX") {
-      bool goodEndPoint = (_recoEndPoint.Y() >= fidBounds[2] && _recoEndPoint.Y() <= fidBounds[3] && _recoEndPoint.Z() >= fidBounds[4] && _recoEndPoint.Z() <= fidBounds[5]);
-      if (!goodEndPoint) return false;
-    }
-    else if (excludeCut == "distanceFiducialVolumeY") {
-      bool goodEndPoint = (_recoEndPoint.X() >= fidBounds[0] && _recoEndPoint.X() <= fidBounds[1] && _recoEndPoint.Z() >= fidBounds[4] && _recoEndPoint.Z() <= fidBounds[5]);
-      if (!goodEndPoint) return false;
-    }
-    else if (excludeCut == "distanceFiducialVolumeZ") {
-      bool goodEndPoint = (_recoEndPoint.X() >= fidBounds[0] && _recoEndPoint.X() <= fidBounds[1] && _recoEndPoint.Y() >= fidBounds[2] && _recoEndPoint.Y() <= fidBounds[3]);
-      if (!goodEndPoint) return false;
-    }
-
-    // All cuts passed, this is likely an anode-crossing stopping muon.
-    _isAnAnodeCrosser = true;
-    if (DEBUG) std::cout << "Track passed all selection cuts." << std::endl;
-    return true;
-
+    return SelectAnodeCrosser(evt,thisParticle,get_excluded_cuts(excludeCut));
   }
 
-  // N-1 cuts for Cathode crossers, simple version
+  // N-1 cuts for Cathode crossers, simple version: no APA contour and broken track cuts.
   bool StoppingMuonSelectionAlg::NMinus1CathodeSimple(const std::string &excludeCut, art::Event const &evt, const recob::PFParticle &thisParticle) {
+    return SelectCathodeCrosser(evt,thisParticle,get_excluded_cuts(excludeCut) | kExcludeContourAPA | kExcludeBrokenTrack);
+  }
 
+  // Get the property for this track. Only if its selected.
+  // Set the properties of a track selected by StoppingMuonProducer, instead of selecting it again.
+  void StoppingMuonSelectionAlg::SetTrackProperties(art::Event const &evt, const StoppingMuonCandidate &candidate, const recob::Track &track) {
     Reset();
     _evNumber = evt.id().event();
-
-    // Set the correct boundaries for cathode crossers.
-    geoHelper.SetFiducialBoundOffset(offsetFiducialBounds_CC);
-    geoHelper.SetThicknessStartVolume(thicknessStartVolume_CC);
-    geoHelper.InitFiducialVolumeBounds();
-
-    // Get the T0
-    std::vector<anab::T0> pfparticleT0s = pfpUtil.GetPFParticleT0(thisParticle,evt,fPFParticleTag);
-    if (pfparticleT0s.size() == 0) {
-      _trackT0 = INV_DBL;
-      return false;
-    }
-    else
-      _trackT0 = pfparticleT0s[0].Time();
-    // Get recob::Track from PFParticle
-    const recob::Track &track = GetTrackFromPFParticle(evt,thisParticle);
-    _recoEndPoint = track.End<TVector3>();
-    _recoStartPoint.SetXYZ(track.LocationAtPoint(track.FirstValidPoint()).X(), track.LocationAtPoint(track.FirstValidPoint()).Y(), track.LocationAtPoint(track.FirstValidPoint()).Z());
-    OrderRecoStartEnd(_recoStartPoint, _recoEndPoint);
-    _trackLength = track.Length();
+    _driftVelocity = GetEventContext(evt).DriftVelocity();
+    // The candidate has the points after the T0 correction of the selection.
+    _trackT0 = candidate.t0;
+    _recoStartPoint.SetXYZ(candidate.startX, candidate.startY, candidate.startZ);
+    _recoEndPoint.SetXYZ(candidate.endX, candidate.endY, candidate.endZ);
+    _theta_xz = candidate.theta_xz;
+    _theta_yz = candidate.theta_yz;
+    _minHitPeakTime = candidate.minHitPeakTime;
+    _maxHitPeakTime = candidate.maxHitPeakTime;
+    _trackLength = candidate.trackLength;
     _trackID = track.ID();
-    // using the ordered start and end points calculate the angles _theta_xz and _theta_yz
-    _theta_xz = TMath::RadToDeg() * TMath::ATan2(_recoStartPoint.X()-_recoEndPoint.X(), _recoStartPoint.Z()-_recoEndPoint.Z());
-    _theta_yz = TMath::RadToDeg() * TMath::ATan2(_recoStartPoint.Y()-_recoEndPoint.Y(), _recoStartPoint.Z()-_recoEndPoint.Z());
-    // Determine min and max hit peak time for this track
-    SetMinAndMaxHitPeakTime(evt,thisParticle,_minHitPeakTime,_maxHitPeakTime);
-    // Apply cuts with selection with progressive cuts
-    if (_trackLength < length_cutoff_CC) return false;
-
-    // Apply cuts for good track separately.
-    if (!(_recoStartPoint.X()*_recoEndPoint.X()<0)) return false;
-
-    if (excludeCut!="thicknessStartVolume") {
-      bool goodStart = geoHelper.IsPointInSlice(_recoStartPoint);
-      if (!goodStart) return false;
-    }
-    double *fidBounds = geoHelper.GetFiducialVolumeBounds();
-    if (excludeCut != "distanceFiducialVolumeX" && excludeCut != "distanceFiducialVolumeY" && excludeCut != "distanceFiducialVolumeZ")   {
-      bool goodEndPoint = geoHelper.IsPointInVolume(geoHelper.GetFiducialVolumeBounds(), _recoEndPoint);
-      if (!goodEndPoint) return false;
-    }
-    else if (excludeCut == "distanceFiducialVolumeX") {
-      bool goodEndPoint = (_recoEndPoint.Y() >= fidBounds[2] && _recoEndPoint.Y() <= fidBounds[3] && _recoEndPoint.Z() >= fidBounds[4] && _recoEndPoint.Z() <= fidBounds[5]);
-      if (!goodEndPoint) return false;
-    }
-    else if (excludeCut == "distanceFiducialVolumeY") {
-      bool goodEndPoint = (_recoEndPoint.X() >= fidBounds[0] && _recoEndPoint.X() <= fidBounds[1] && _recoEndPoint.Z() >= fidBounds[4] && _recoEndPoint.Z() <= fidBounds[5]);
-      if (!goodEndPoint) return false;
-    }
-    else if (excludeCut == "distanceFiducialVolumeZ") {
-      bool goodEndPoint = (_recoEndPoint.X() >= fidBounds[0] && _recoEndPoint.X() <= fidBounds[1] && _recoEndPoint.Y() >= fidBounds[2] && _recoEndPoint.Y() <= fidBounds[3]);
-      if (!goodEndPoint) return false;
-    }
-
-    if (excludeCut!="cutMinHitPeakTime") {
-      if (_minHitPeakTime <= cutMinHitPeakTime_CC) return false;
-    }
-    if (excludeCut!="cutMaxHitPeakTime") {
-      if (_maxHitPeakTime >= cutMaxHitPeakTime_CC) return false;
-    }
-
-    // All cuts passed, this is likely a cathode-crossing stopping muon.
-    _isACathodeCrosser = true;
-    trackInfo.isCathodeCrosser = true;
-    return true;
+    _isACathodeCrosser = (candidate.type == kCathodeCrosser);
+    _isAnAnodeCrosser = (candidate.type == kAnodeCrosserPandora || candidate.type == kAnodeCrosserMine);
+    trackInfo.isCathodeCrosser = _isACathodeCrosser;
+    trackInfo.isAnodeCrosserPandora = (candidate.type == kAnodeCrosserPandora);
+    trackInfo.isAnodeCrosserMine = (candidate.type == kAnodeCrosserMine);
   }
 
-  // Get the property for this track. Only if its selected.
   const trackProperties StoppingMuonSelectionAlg::GetTrackProperties() {
     trackInfo.evNumber = _evNumber;
     trackInfo.trackT0 = _trackT0;
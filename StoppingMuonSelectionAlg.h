@@ -20,17 +20,25 @@
 #include "larsim/Simulation/LArVoxelData.h"
 #include "larsim/Simulation/LArVoxelList.h"
 #include "larsim/Simulation/SimListUtils.h"
-#include "larsim/MCCheater/BackTrackerService.h"
-#include "larsim/MCCheater/ParticleInventoryService.h"
 #include "nusimdata/SimulationBase/MCParticle.h"
 #include "nusimdata/SimulationBase/MCTruth.h"
 #include "lardata/DetectorInfoServices/DetectorClocksService.h"
 #include "lardata/DetectorInfoServices/DetectorPropertiesService.h"
 
+#include <memory>
+
 #include "GeometryHelper.h"
 #include "HitHelper.h"
 #include "SpacePointAlg.h"
+#include "TruthMatchTable.h"
+#include "TruthProvider.h"
+#include "TrackIDIndex.h"
+#include "TrackFeatures.h"
+#include "SelectionCuts.h"
+#include "StoppingMuonCandidate.h"
 #include "DataTypes.h"
+#include "EventContext.h"
+#include "Instrumentation.h"
 
 namespace stoppingcosmicmuonselection {
 
@@ -46,23 +54,54 @@ namespace stoppingcosmicmuonselection {
     // Read parameters from FHICL file
     void reconfigure(fhicl::ParameterSet const &p);
 
+    // Compute the quantities used by the cuts (once per PFParticle).
+    // The lazy ones are left for the cuts that need them, unless loadLazyFeatures is true.
+    void SetTrackFeatures(art::Event const &evt, recob::PFParticle const &thisParticle, const bool &loadLazyFeatures = false);
+
+    // Get the quantities used by the cuts for the last PFParticle.
+    const trackFeatures &GetTrackFeatures() const { return _features; }
+
+    // Get the constants used by the cuts.
+    const selectionConstants &GetSelectionConstants() const { return _selectionConstants; }
+
     // Determine if the PFParticle is a selected anode crosser
     bool IsStoppingAnodeCrosser(art::Event const &evt, recob::PFParticle const &thisParticle);
 
     // Work out t0 for anode crossers.
-    double CorrectPosAndGetT0(TVector3 &_recoStartPoint, TVector3 &_recoEndPoint);
+    double CorrectPosAndGetT0(Point3 &_recoStartPoint, Point3 &_recoEndPoint);
 
     // Correct position of the end point using the minimum hit peak time.
-    void CorrectPosEnd(TVector3 &_recoStartPoint, TVector3 &_recoEndPoint, const double &minHitPeakTime, const double &maxHitPeakTime);
+    void CorrectPosEnd(Point3 &_recoStartPoint, Point3 &_recoEndPoint, const double &minHitPeakTime, const double &maxHitPeakTime);
 
     // Determine if the PFParticle is a selected cathode crosser
     bool IsStoppingCathodeCrosser(art::Event const &evt, recob::PFParticle const &thisParticle);
 
+    // Use a per-event truth matching table instead of backtracking each PFParticle.
+    void SetTruthMatchTable(const TruthMatchTable *truthTable);
+
     // For MC events, check if the track is associated to a cosmic track
     bool IsTrackMatchedToTrueCosmicTrack(art::Event const &evt, recob::PFParticle const &thisParticle);
 
+    // Use a per-event track index instead of scanning the tracks.
+    void SetTrackIDIndex(const TrackIDIndex *trackIDIndex);
+
+    // Use the per-event context of the module instead of calling the services.
+    void SetEventContext(const EventContext *eventContext);
+
+    // Get the context of the event: the one set by the module, or one built here.
+    const EventContext &GetEventContext(art::Event const &evt);
+
+    // Set reco start point, end point and length of the track.
+    void SetRecoTrackPoints(const recob::Track &track);
+
+    // Get start and end points of all the other tracks in the event.
+    const std::vector<std::pair<Point3,Point3>> GetOtherTrackPoints(art::Event const &evt);
+
+    // Broken track quantities of another track with respect to this one.
+    brokenTrackNeighbour GetBrokenTrackNeighbour(const Point3 &startPointSecond, const Point3 &endPointSecond);
+
     // Order reco start and end point based on Y position
-    void OrderRecoStartEnd(TVector3 &start, TVector3 &end);
+    void OrderRecoStartEnd(Point3 &start, Point3 &end);
 
     // Get track from PFParticle
     const recob::Track GetTrackFromPFParticle(art::Event const &evt, recob::PFParticle const &thisParticle);
@@ -88,6 +127,9 @@ namespace stoppingcosmicmuonselection {
     // N-1 cuts for Cathode crossers (simple version)
     bool NMinus1CathodeSimple(const std::string &excludeCut, art::Event const &evt, const recob::PFParticle &thisParticle);
 
+    // Set the properties of a track selected by StoppingMuonProducer, instead of selecting it again.
+    void SetTrackProperties(art::Event const &evt, const StoppingMuonCandidate &candidate, const recob::Track &track);
+
     // Get the property for this track.
     const trackProperties GetTrackProperties();
 
@@ -95,6 +137,15 @@ namespace stoppingcosmicmuonselection {
     void Reset();
 
   private:
+    // Compute a lazy feature of the current PFParticle, if not done yet.
+    void LoadTrackFeature(const lazyTrackFeature &feature, art::Event const &evt, recob::PFParticle const &thisParticle);
+
+    // Apply the cathode crosser cuts, but the excluded ones.
+    bool SelectCathodeCrosser(art::Event const &evt, recob::PFParticle const &thisParticle, const uint32_t &excludedCuts);
+
+    // Apply the anode crosser cuts, but the excluded ones.
+    bool SelectAnodeCrosser(art::Event const &evt, recob::PFParticle const &thisParticle, const uint32_t &excludedCuts);
+
     bool _isACathodeCrosser = false;
     bool _isAnAnodeCrosser = false;
     bool _isPFParticleATrack = false;
@@ -103,7 +154,7 @@ namespace stoppingcosmicmuonselection {
     // Reconstructed information
     size_t _evNumber;
     double _trackT0;
-    TVector3 _recoStartPoint, _recoEndPoint;
+    Point3 _recoStartPoint, _recoEndPoint;
     double _theta_xz, _theta_yz;
     double _minHitPeakTime, _maxHitPeakTime;
     double _trackLength;
@@ -112,7 +163,7 @@ namespace stoppingcosmicmuonselection {
 
     // Truth information
     int _pdg;
-    TVector3 _trueStartPoint, _trueEndPoint;
+    Point3 _trueStartPoint, _trueEndPoint;
     double _trueStartT, _trueEndT;
     double _trueTrackID;
 
@@ -122,8 +173,13 @@ namespace stoppingcosmicmuonselection {
     GeometryHelper geoHelper;
     HitHelper      hitHelper;
 
-    // Declare handle for particle inventory service
-    art::ServiceHandle<cheat::ParticleInventoryService> pi_serv;
+    // Per-event truth matching (not owned).
+    const TruthMatchTable *_truthTable = 0x0;
+    // Per-event track index (not owned).
+    const TrackIDIndex *_trackIDIndex = 0x0;
+    // Per-event context (not owned), and the one built when it is not set.
+    const EventContext *_eventContext = 0x0;
+    std::unique_ptr<EventContext> _ownEventContext;
 
     // Declare analysis utils
     protoana::ProtoDUNETruthUtils        truthUtil;
@@ -133,26 +189,14 @@ namespace stoppingcosmicmuonselection {
     // Parameters from FHICL
     std::string fTrackerTag;
     std::string fPFParticleTag;
-    // Define cuts
-    double length_cutoff_CC;
-    double offsetFiducialBounds_CC;
-    double thicknessStartVolume_CC;
-    double cutMinHitPeakTime_CC;
-    double cutMaxHitPeakTime_CC;
-    double radiusBrokenTracksSearch_CC;
-    double cutCosAngleBrokenTracks_CC;
-    double cutCosAngleAlignment_CC;
-    double cutContourAPA_CC;
-    double length_cutoff_AC;
-    double offsetYStartPoint_AC;
-    double offsetZStartPoint_AC;
-    double cutMinHitPeakTime_AC;
-    double cutMaxHitPeakTime_AC;
-    double radiusBrokenTracksSearch_AC;
-    double cutCosAngleBrokenTracks_AC;
-    double cutCosAngleAlignment_AC;
-    double cutContourAPA_AC;
-    double offsetFiducialBounds_AC;
+    // Cuts, shared with the offline re-selection
+    selectionCuts _cuts;
+    selectionConstants _selectionConstants;
+    trackFeatures _features;
+    // Event of the features, and the lazy features already computed.
+    art::EventID _featuresEventID;
+    bool _areNeighboursSet = false;
+    bool _areHitsOnCryoSideSet = false;
 
   };
 }
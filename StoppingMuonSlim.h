@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////
+// Class:       StoppingMuonSlim
+// Plugin Type: producer
+// File:        StoppingMuonSlim.h
+////////////////////////////////////////////////////////////////////////
+#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Persistency/Common/PtrMaker.h"
+#include "canvas/Persistency/Common/Assns.h"
+#include "canvas/Persistency/Common/FindManyP.h"
+#include "canvas/Persistency/Common/FindOneP.h"
+#include "cetlib_except/exception.h"
+#include "lardata/ArtDataHelper/MVAReader.h"
+#include "lardata/ArtDataHelper/MVAWriter.h"
+#include "lardataobj/AnalysisBase/Calorimetry.h"
+#include "lardataobj/AnalysisBase/T0.h"
+#include "lardataobj/RecoBase/Cluster.h"
+#include "lardataobj/RecoBase/Hit.h"
+#include "lardataobj/RecoBase/PFParticle.h"
+#include "lardataobj/RecoBase/SpacePoint.h"
+#include "lardataobj/RecoBase/Track.h"
+#include "lardataobj/RecoBase/TrackHitMeta.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <map>
+#include <vector>
+
+#include "protoduneana/StoppingMuonSelection/DataTypes.h"
+#include "protoduneana/StoppingMuonSelection/StoppingMuonCandidate.h"
+#include "protoduneana/StoppingMuonSelection/SpacePointAlg.h"
+#include "protoduneana/StoppingMuonSelection/Logging.h"
+
+namespace stoppingcosmicmuonselection {
+
+class StoppingMuonSlim;
+
+class StoppingMuonSlim : public art::EDProducer {
+public:
+  explicit StoppingMuonSlim(fhicl::ParameterSet const & p);
+  // The destructor generated by the compiler is fine for classes
+  // without bare pointers or other resource use.
+
+  // Plugins should not be copied or assigned.
+  StoppingMuonSlim(StoppingMuonSlim const &) = delete;
+  StoppingMuonSlim(StoppingMuonSlim &&) = delete;
+  StoppingMuonSlim & operator = (StoppingMuonSlim const &) = delete;
+  StoppingMuonSlim & operator = (StoppingMuonSlim &&) = delete;
+
+  // Required functions.
+  void produce(art::Event &evt) override;
+
+  // Selected optional functions
+  void endJob() override;
+  void reconfigure(fhicl::ParameterSet const& p);
+
+private:
+
+  // Declare some counters for statistic purposes
+  int counter_total_number_events = 0;
+  int counter_total_number_tracks = 0;
+  int counter_total_number_hits = 0;
+
+  // Parameters form FHICL File
+  uint32_t _requiredCutBits;
+  std::string fCandidateTag;
+  std::string fPFParticleTag, fSpacePointTag, fTrackerTag, fCalorimetryTag, fNNetTag;
+
+  // Only used for the size of the region around the track ends it checks.
+  SpacePointAlg spAlg; // need configuration
+
+  // CNN scores of the kept hits, for the Michel check on the slim file.
+  anab::MVAWriter<4> fMVAWriter;
+};
+
+StoppingMuonSlim::StoppingMuonSlim(fhicl::ParameterSet const & p)
+  :
+  EDProducer(p),
+  fMVAWriter(producesCollector(), "emtrkmichel")
+{
+  reconfigure(p);
+  // Everything goes out under the module label, so the selection and the
+  // helpers can read the slim file by setting all their tags to this module,
+  // with SpacePointTag "<label>:trackend" and NNetTag "<label>:emtrkmichel".
+  fMVAWriter.produces_using<recob::Hit>();
+  produces<std::vector<StoppingMuonCandidate>>();
+  produces<std::vector<recob::PFParticle>>();
+  produces<std::vector<recob::Track>>();
+  produces<std::vector<recob::Cluster>>();
+  produces<std::vector<recob::Hit>>();
+  produces<std::vector<recob::SpacePoint>>();
+  produces<std::vector<recob::SpacePoint>>("trackend");
+  produces<std::vector<anab::Calorimetry>>();
+  produces<std::vector<anab::T0>>();
+  produces<art::Assns<recob::PFParticle,StoppingMuonCandidate>>();
+  produces<art::Assns<recob::Track,StoppingMuonCandidate>>();
+  produces<art::Assns<recob::PFParticle,recob::Track>>();
+  produces<art::Assns<recob::PFParticle,recob::Cluster>>();
+  produces<art::Assns<recob::PFParticle,recob::SpacePoint>>();
+  produces<art::Assns<recob::PFParticle,anab::T0>>();
+  produces<art::Assns<recob::Cluster,recob::Hit>>();
+  produces<art::Assns<recob::Track,recob::Hit>>();
+  produces<art::Assns<recob::Track,recob::Hit,recob::TrackHitMeta>>();
+  produces<art::Assns<recob::Track,anab::Calorimetry>>();
+}
+
+void StoppingMuonSlim::endJob()
+{
+  STOPPING_MUON_LOG_INFO(kLogModules) << "StoppingMuonSlim finished job";
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Total number of events: " << counter_total_number_events;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Total number of tracks kept: " << counter_total_number_tracks;
+  STOPPING_MUON_LOG_INFO(kLogModules) << "Total number of hits kept: " << counter_total_number_hits;
+}
+
+void StoppingMuonSlim::reconfigure(fhicl::ParameterSet const& p)
+{
+  Logger::Get().reconfigure(p.get<fhicl::ParameterSet>("Logging", fhicl::ParameterSet()));
+  fCandidateTag = p.get<std::string>("CandidateTag", "stoppingmuon");
+  fTrackerTag = p.get<std::string>("TrackerTag");
+  fPFParticleTag = p.get<std::string>("PFParticleTag");
+  fSpacePointTag = p.get<std::string>("SpacePointTag");
+  fCalorimetryTag = p.get<std::string>("CalorimetryTag");
+  fNNetTag = p.get<std::string>("NNetTag");
+  _requiredCutBits = p.get<uint32_t>("requiredCutBits", kPassSelection);
+  spAlg.reconfigure(p.get<fhicl::ParameterSet>("SpacePointAlg"));
+}
+
+} // namespace
@@ -0,0 +1,195 @@
+///////////////////////////////////////////////////////////////////////
+// Class:       StoppingMuonSlim
+// Plugin Type: producer
+// File:        StoppingMuonSlim_module.cc
+////////////////////////////////////////////////////////////////////////
+
+#include "StoppingMuonSlim.h"
+
+namespace stoppingcosmicmuonselection {
+
+  void StoppingMuonSlim::produce(art::Event &evt)
+  {
+    counter_total_number_events++;
+    STOPPING_MUON_LOG_INFO(kLogModules) << "StoppingMuonSlim module on event " << evt.id().event();
+
+    // Slim products
+    auto candidates = std::make_unique<std::vector<StoppingMuonCandidate>>();
+    auto pfparticles = std::make_unique<std::vector<recob::PFParticle>>();
+    auto tracks = std::make_unique<std::vector<recob::Track>>();
+    auto clusters = std::make_unique<std::vector<recob::Cluster>>();
+    auto hits = std::make_unique<std::vector<recob::Hit>>();
+    auto spacePoints = std::make_unique<std::vector<recob::SpacePoint>>();
+    auto trackEndSpacePoints = std::make_unique<std::vector<recob::SpacePoint>>();
+    auto calos = std::make_unique<std::vector<anab::Calorimetry>>();
+    auto t0s = std::make_unique<std::vector<anab::T0>>();
+    auto pfpCandidateAssns = std::make_unique<art::Assns<recob::PFParticle,StoppingMuonCandidate>>();
+    auto trackCandidateAssns = std::make_unique<art::Assns<recob::Track,StoppingMuonCandidate>>();
+    auto pfpTrackAssns = std::make_unique<art::Assns<recob::PFParticle,recob::Track>>();
+    auto pfpClusterAssns = std::make_unique<art::Assns<recob::PFParticle,recob::Cluster>>();
+    auto pfpSpacePointAssns = std::make_unique<art::Assns<recob::PFParticle,recob::SpacePoint>>();
+    auto pfpT0Assns = std::make_unique<art::Assns<recob::PFParticle,anab::T0>>();
+    auto clusterHitAssns = std::make_unique<art::Assns<recob::Cluster,recob::Hit>>();
+    auto trackHitAssns = std::make_unique<art::Assns<recob::Track,recob::Hit>>();
+    auto trackHitMetaAssns = std::make_unique<art::Assns<recob::Track,recob::Hit,recob::TrackHitMeta>>();
+    auto trackCaloAssns = std::make_unique<art::Assns<recob::Track,anab::Calorimetry>>();
+
+    art::PtrMaker<StoppingMuonCandidate> makeCandidatePtr(evt);
+    art::PtrMaker<recob::PFParticle> makePFParticlePtr(evt);
+    art::PtrMaker<recob::Track> makeTrackPtr(evt);
+    art::PtrMaker<recob::Cluster> makeClusterPtr(evt);
+    art::PtrMaker<recob::Hit> makeHitPtr(evt);
+    art::PtrMaker<recob::SpacePoint> makeSpacePointPtr(evt);
+    art::PtrMaker<anab::Calorimetry> makeCaloPtr(evt);
+    art::PtrMaker<anab::T0> makeT0Ptr(evt);
+
+    // Input products and associations
+    auto const candidateHandle = evt.getValidHandle<std::vector<StoppingMuonCandidate>>(fCandidateTag);
+    const art::FindOneP<recob::PFParticle> findPFParticle(candidateHandle, evt, fCandidateTag);
+    const art::FindOneP<recob::Track> findTrack(candidateHandle, evt, fCandidateTag);
+    auto const pfparticleHandle = evt.getValidHandle<std::vector<recob::PFParticle>>(fPFParticleTag);
+    const art::FindManyP<recob::Cluster> findClusters(pfparticleHandle, evt, fPFParticleTag);
+    const art::FindManyP<recob::SpacePoint> findSpacePoints(pfparticleHandle, evt, fPFParticleTag);
+    const art::FindManyP<anab::T0> findT0s(pfparticleHandle, evt, fPFParticleTag);
+    auto const trackHandle = evt.getValidHandle<std::vector<recob::Track>>(fTrackerTag);
+    const art::FindManyP<recob::Hit,recob::TrackHitMeta> findTrackHits(trackHandle, evt, fTrackerTag);
+    const art::FindManyP<anab::Calorimetry> findCalos(trackHandle, evt, fCalorimetryTag);
+    auto const spacePointHandle = evt.getValidHandle<std::vector<recob::SpacePoint>>(fSpacePointTag);
+    const anab::MVAReader<recob::Hit,4> hitResults(evt, fNNetTag);
+
+    // A hit can be reached from both the clusters and the track: copy it once.
+    std::map<art::Ptr<recob::Hit>,size_t> hitNewIndex;
+    std::vector<art::Ptr<recob::Hit>> keptHits;
+    auto keepHit = [&](const art::Ptr<recob::Hit> &hitp) {
+      auto const it = hitNewIndex.find(hitp);
+      if (it != hitNewIndex.end()) return makeHitPtr(it->second);
+      hits->push_back(*hitp);
+      keptHits.push_back(hitp);
+      hitNewIndex[hitp] = hits->size()-1;
+      return makeHitPtr(hits->size()-1);
+    };
+    std::vector<bool> isTrackEndSpacePointKept(spacePointHandle->size(), false);
+
+    for (size_t c = 0; c < candidateHandle->size(); c++) {
+      StoppingMuonCandidate candidate = (*candidateHandle)[c];
+      if (!candidate.HasBits(_requiredCutBits)) continue;
+      const art::Ptr<recob::PFParticle> &pfparticlep = findPFParticle.at(c);
+      const art::Ptr<recob::Track> &trackp = findTrack.at(c);
+      if (pfparticlep.isNull() || trackp.isNull()) continue;
+
+      // Only the primary is kept, so the hierarchy is dropped.
+      const size_t pfpIndex = pfparticles->size();
+      pfparticles->emplace_back(pfparticlep->PdgCode(), pfpIndex, recob::PFParticle::kPFParticlePrimary, std::vector<size_t>());
+      const art::Ptr<recob::PFParticle> newPFParticlep = makePFParticlePtr(pfpIndex);
+
+      // The track ID is set to its new index: the calorimetry lookup assumes they match.
+      const size_t trackIndex = tracks->size();
+      tracks->emplace_back(trackp->Trajectory(), trackp->ParticleId(), trackp->Chi2(), trackp->Ndof(),
+                           trackp->VertexCovarianceLocal5D(), trackp->EndCovarianceLocal5D(), trackIndex);
+      const art::Ptr<recob::Track> newTrackp = makeTrackPtr(trackIndex);
+      pfpTrackAssns->addSingle(newPFParticlep, newTrackp);
+
+      candidate.pfparticleKey = pfpIndex;
+      candidate.trackKey = trackIndex;
+      candidates->push_back(candidate);
+      const art::Ptr<StoppingMuonCandidate> newCandidatep = makeCandidatePtr(candidates->size()-1);
+      pfpCandidateAssns->addSingle(newPFParticlep, newCandidatep);
+      trackCandidateAssns->addSingle(newTrackp, newCandidatep);
+
+      // Clusters and their hits.
+      auto const &pfpClusters = findClusters.at(pfparticlep.key());
+      const art::FindManyP<recob::Hit> findClusterHits(pfpClusters, evt, fPFParticleTag);
+      for (size_t cl = 0; cl < pfpClusters.size(); cl++) {
+        clusters->push_back(*pfpClusters[cl]);
+        const art::Ptr<recob::Cluster> newClusterp = makeClusterPtr(clusters->size()-1);
+        pfpClusterAssns->addSingle(newPFParticlep, newClusterp);
+        for (auto const &hitp : findClusterHits.at(cl))
+          clusterHitAssns->addSingle(newClusterp, keepHit(hitp));
+      }
+
+      // Space points and T0 of the PFParticle.
+      for (auto const &spp : findSpacePoints.at(pfparticlep.key())) {
+        spacePoints->push_back(*spp);
+        pfpSpacePointAssns->addSingle(newPFParticlep, makeSpacePointPtr(spacePoints->size()-1));
+      }
+      for (auto const &t0p : findT0s.at(pfparticlep.key())) {
+        t0s->push_back(*t0p);
+        pfpT0Assns->addSingle(newPFParticlep, makeT0Ptr(t0s->size()-1));
+      }
+
+      // Track hits with their metadata, and calorimetry.
+      auto const &trackHits = findTrackHits.at(trackp.key());
+      auto const &trackHitMetas = findTrackHits.data(trackp.key());
+      std::map<size_t,size_t> trackHitNewKey;
+      for (size_t h = 0; h < trackHits.size(); h++) {
+        const art::Ptr<recob::Hit> newHitp = keepHit(trackHits[h]);
+        trackHitNewKey[trackHits[h].key()] = newHitp.key();
+        trackHitAssns->addSingle(newTrackp, newHitp);
+        trackHitMetaAssns->addSingle(newTrackp, newHitp, *trackHitMetas[h]);
+      }
+      // The calorimetry points at the hits by key: move them to the slim hits.
+      for (auto const &calop : findCalos.at(trackp.key())) {
+        std::vector<size_t> tpIndices;
+        tpIndices.reserve(calop->TpIndices().size());
+        for (auto const &hitKey : calop->TpIndices()) {
+          auto const it = trackHitNewKey.find(hitKey);
+          if (it == trackHitNewKey.end())
+            throw cet::exception("StoppingMuonSlim_module.cc") << "Calorimetry hit " << hitKey << " is not a hit of track "
+                                                               << trackp.key() << " in event " << evt.id().event();
+          tpIndices.push_back(it->second);
+        }
+        calos->emplace_back(calop->KineticEnergy(), calop->dEdx(), calop->dQdx(), calop->ResidualRange(), calop->DeadWireResRC(),
+                            calop->Range(), calop->TrkPitchVec(), calop->XYZ(), tpIndices, calop->PlaneID());
+        trackCaloAssns->addSingle(newTrackp, makeCaloPtr(calos->size()-1));
+      }
+
+      // Event space points in the boxes SpacePointAlg checks around the track ends.
+      const double maxDistanceYZ = spAlg.GetSearchDistance();
+      auto isInBox = [&maxDistanceYZ](const double *xyz, const double &y, const double &z) {
+        return std::abs(xyz[1]-y) <= maxDistanceYZ && std::abs(xyz[2]-z) <= maxDistanceYZ;
+      };
+      for (size_t s = 0; s < spacePointHandle->size(); s++) {
+        if (isTrackEndSpacePointKept[s]) continue;
+        const double *xyz = (*spacePointHandle)[s].XYZ();
+        if (isInBox(xyz, candidate.startY, candidate.startZ) || isInBox(xyz, candidate.endY, candidate.endZ))
+          isTrackEndSpacePointKept[s] = true;
+      }
+      counter_total_number_tracks++;
+    } // end of loop over candidates
+
+    for (size_t s = 0; s < spacePointHandle->size(); s++) {
+      if (isTrackEndSpacePointKept[s]) trackEndSpacePoints->push_back((*spacePointHandle)[s]);
+    }
+    counter_total_number_hits += hits->size();
+
+    // CNN scores of the kept hits, in the order of the slim hits.
+    auto const hitResultsID = fMVAWriter.initOutputs<recob::Hit>(moduleDescription().moduleLabel(), hits->size(), hitResults.outputNames());
+    for (size_t h = 0; h < keptHits.size(); h++)
+      fMVAWriter.setOutput(hitResultsID, h, hitResults.getOutput(keptHits[h]));
+
+    evt.put(std::move(candidates));
+    evt.put(std::move(pfparticles));
+    evt.put(std::move(tracks));
+    evt.put(std::move(clusters));
+    evt.put(std::move(hits));
+    evt.put(std::move(spacePoints));
+    evt.put(std::move(trackEndSpacePoints), "trackend");
+    evt.put(std::move(calos));
+    evt.put(std::move(t0s));
+    evt.put(std::move(pfpCandidateAssns));
+    evt.put(std::move(trackCandidateAssns));
+    evt.put(std::move(pfpTrackAssns));
+    evt.put(std::move(pfpClusterAssns));
+    evt.put(std::move(pfpSpacePointAssns));
+    evt.put(std::move(pfpT0Assns));
+    evt.put(std::move(clusterHitAssns));
+    evt.put(std::move(trackHitAssns));
+    evt.put(std::move(trackHitMetaAssns));
+    evt.put(std::move(trackCaloAssns));
+    fMVAWriter.saveOutputs(evt);
+
+  } // end of producer
+
+} // namespace
+
+DEFINE_ART_MODULE(stoppingcosmicmuonselection::StoppingMuonSlim)
@@ -5,30 +5,39 @@
 #include <vector>
 #include <string>
 #include <algorithm>
-#include "TVector3.h"
 #include "TGraphErrors.h"
 
 #include "DataTypes.h"
+#include "EventArena.h"
+#include "Logging.h"
 
 namespace stoppingcosmicmuonselection {
 
-  template<typename T>
-  std::vector<std::vector<T>> get_neighbors(const std::vector<T> &object,
-                                            const size_t &numbNeighbors);
+  // Get the neighbors of each element. The result lives in the event arena.
+  template<typename C>
+  arenaVector<arenaVector<typename C::value_type>> get_neighbors(const C &object,
+                                                                 const size_t &numbNeighbors);
 
   // Get the median without the max and min value.
-  double get_smooth_trunc_median(std::vector<double> data);
+  template<typename C>
+  double get_smooth_trunc_median(const C &data);
 
   // Get the mean.
-  double mean(const std::vector<double> &data);
+  template<typename C>
+  double mean(const C &data);
 
 
   // Get the covariance.
-  double cov (const std::vector<double> &data1,
-              const std::vector<double> &data2);
+  template<typename C>
+  double cov (const C &data1,
+              const C &data2);
 
   // Get the standard deviation.
-  double stdev(const std::vector<double> &data);
+  template<typename C>
+  double stdev(const C &data);
+
+  // Fraction of consecutive hits in the first ordering that are not next to each other in the second.
+  double get_ordering_disagreement(const hitIndexVec &order1, const hitIndexVec &order2);
 
   // Print content of a vector.
   void printVec(const std::vector<double> &data);
@@ -0,0 +1,162 @@
+/***
+  Class containing the compact record of the quantities used by the selection cuts.
+  It only depends on ROOT, so the records can be read back without art.
+
+*/
+#ifndef TRACK_FEATURES_CXX
+#define TRACK_FEATURES_CXX
+
+#include "cetlib_except/exception.h"
+#include "TChain.h"
+#include "TFile.h"
+
+#include "TrackFeatures.h"
+
+namespace stoppingcosmicmuonselection {
+
+  TrackFeaturesTree::TrackFeaturesTree() {
+
+  }
+
+  TrackFeaturesTree::~TrackFeaturesTree() {
+
+  }
+
+  // Create the branches on a new tree.
+  void TrackFeaturesTree::SetUpForWriting(TTree *tree) {
+    _tree = tree;
+    _tree->Branch("run", &_features.run, "run/I");
+    _tree->Branch("event", &_features.event, "event/I");
+    _tree->Branch("pfparticleIndex", &_features.pfparticleIndex, "pfparticleIndex/I");
+    _tree->Branch("trackID", &_features.trackID, "trackID/D");
+    _tree->Branch("startX", &_features.startX, "startX/D");
+    _tree->Branch("startY", &_features.startY, "startY/D");
+    _tree->Branch("startZ", &_features.startZ, "startZ/D");
+    _tree->Branch("endX", &_features.endX, "endX/D");
+    _tree->Branch("endY", &_features.endY, "endY/D");
+    _tree->Branch("endZ", &_features.endZ, "endZ/D");
+    _tree->Branch("theta_xz", &_features.theta_xz, "theta_xz/D");
+    _tree->Branch("theta_yz", &_features.theta_yz, "theta_yz/D");
+    _tree->Branch("minHitPeakTime", &_features.minHitPeakTime, "minHitPeakTime/D");
+    _tree->Branch("maxHitPeakTime", &_features.maxHitPeakTime, "maxHitPeakTime/D");
+    _tree->Branch("trackLength", &_features.trackLength, "trackLength/D");
+    _tree->Branch("pandoraT0", &_features.pandoraT0, "pandoraT0/D");
+    _tree->Branch("driftVelocity", &_features.driftVelocity, "driftVelocity/D");
+    _tree->Branch("hasHitsOnCryoSide", &_features.hasHitsOnCryoSide, "hasHitsOnCryoSide/O");
+    _tree->Branch("neighbourIsHigher", &_neighbourIsHigher);
+    _tree->Branch("neighbourAbsCosAlpha", &_neighbourAbsCosAlpha);
+    _tree->Branch("neighbourCosBeta", &_neighbourCosBeta);
+    _tree->Branch("neighbourDistHigherLower", &_neighbourDistHigherLower);
+    _tree->Branch("isRealData", &_features.isRealData, "isRealData/O");
+    _tree->Branch("isTrueCosmic", &_features.isTrueCosmic, "isTrueCosmic/O");
+    _tree->Branch("isTrueCathodeCrosser", &_features.isTrueCathodeCrosser, "isTrueCathodeCrosser/O");
+    _tree->Branch("isTrueAnodeCrosser", &_features.isTrueAnodeCrosser, "isTrueAnodeCrosser/O");
+    _tree->Branch("pdg", &_features.pdg, "pdg/I");
+  }
+
+  // Point the branches of an existing tree to this object.
+  void TrackFeaturesTree::SetUpForReading(TTree *tree) {
+    _tree = tree;
+    _tree->SetBranchAddress("run", &_features.run);
+    _tree->SetBranchAddress("event", &_features.event);
+    _tree->SetBranchAddress("pfparticleIndex", &_features.pfparticleIndex);
+    _tree->SetBranchAddress("trackID", &_features.trackID);
+    _tree->SetBranchAddress("startX", &_features.startX);
+    _tree->SetBranchAddress("startY", &_features.startY);
+    _tree->SetBranchAddress("startZ", &_features.startZ);
+    _tree->SetBranchAddress("endX", &_features.endX);
+    _tree->SetBranchAddress("endY", &_features.endY);
+    _tree->SetBranchAddress("endZ", &_features.endZ);
+    _tree->SetBranchAddress("theta_xz", &_features.theta_xz);
+    _tree->SetBranchAddress("theta_yz", &_features.theta_yz);
+    _tree->SetBranchAddress("minHitPeakTime", &_features.minHitPeakTime);
+    _tree->SetBranchAddress("maxHitPeakTime", &_features.maxHitPeakTime);
+    _tree->SetBranchAddress("trackLength", &_features.trackLength);
+    _tree->SetBranchAddress("pandoraT0", &_features.pandoraT0);
+    _tree->SetBranchAddress("driftVelocity", &_features.driftVelocity);
+    _tree->SetBranchAddress("hasHitsOnCryoSide", &_features.hasHitsOnCryoSide);
+    _tree->SetBranchAddress("neighbourIsHigher", &_neighbourIsHigherP);
+    _tree->SetBranchAddress("neighbourAbsCosAlpha", &_neighbourAbsCosAlphaP);
+    _tree->SetBranchAddress("neighbourCosBeta", &_neighbourCosBetaP);
+    _tree->SetBranchAddress("neighbourDistHigherLower", &_neighbourDistHigherLowerP);
+    _tree->SetBranchAddress("isRealData", &_features.isRealData);
+    _tree->SetBranchAddress("isTrueCosmic", &_features.isTrueCosmic);
+    _tree->SetBranchAddress("isTrueCathodeCrosser", &_features.isTrueCathodeCrosser);
+    _tree->SetBranchAddress("isTrueAnodeCrosser", &_features.isTrueAnodeCrosser);
+    _tree->SetBranchAddress("pdg", &_features.pdg);
+  }
+
+  // Fill the tree with a record.
+  void TrackFeaturesTree::Fill(const trackFeatures &features) {
+    _features = features;
+    _neighbourIsHigher.clear();
+    _neighbourAbsCosAlpha.clear();
+    _neighbourCosBeta.clear();
+    _neighbourDistHigherLower.clear();
+    for (const brokenTrackNeighbour &neighbour : features.neighbours) {
+      _neighbourIsHigher.push_back(neighbour.isHigher);
+      _neighbourAbsCosAlpha.push_back(neighbour.absCosAlpha);
+      _neighbourCosBeta.push_back(neighbour.cosBeta);
+      _neighbourDistHigherLower.push_back(neighbour.distHigherLower);
+    }
+    _tree->Fill();
+  }
+
+  // Read an entry of the tree into a record.
+  void TrackFeaturesTree::GetEntry(const Long64_t &entry, trackFeatures &features) {
+    _tree->GetEntry(entry);
+    features = _features;
+    features.neighbours.resize(_neighbourIsHigher.size());
+    for (size_t i = 0; i < _neighbourIsHigher.size(); i++) {
+      features.neighbours[i].isHigher = _neighbourIsHigher[i];
+      features.neighbours[i].absCosAlpha = _neighbourAbsCosAlpha[i];
+      features.neighbours[i].cosBeta = _neighbourCosBeta[i];
+      features.neighbours[i].distHigherLower = _neighbourDistHigherLower[i];
+    }
+  }
+
+  // Write the constants of the records in their own tree (one entry).
+  void TrackFeaturesTree::WriteConstants(TTree *tree, const selectionConstants &constants) {
+    selectionConstants toWrite = constants;
+    tree->Branch("activeBounds", toWrite.activeBounds, "activeBounds[6]/D");
+    tree->Branch("driftDistance", &toWrite.driftDistance, "driftDistance/D");
+    tree->Branch("minCosAlphaNeighbours", &toWrite.minCosAlphaNeighbours, "minCosAlphaNeighbours/D");
+    tree->Fill();
+    tree->ResetBranchAddresses();
+  }
+
+  // Read the constants back. Return false if the tree is empty.
+  bool TrackFeaturesTree::ReadConstants(TTree *tree, selectionConstants &constants) {
+    if (tree == 0x0 || tree->GetEntries() == 0) return false;
+    tree->SetBranchAddress("activeBounds", constants.activeBounds);
+    tree->SetBranchAddress("driftDistance", &constants.driftDistance);
+    tree->SetBranchAddress("minCosAlphaNeighbours", &constants.minCosAlphaNeighbours);
+    tree->GetEntry(0);
+    tree->ResetBranchAddresses();
+    return true;
+  }
+
+  // Read the constants of the first file and all the records of the files in memory.
+  void read_track_features(const std::vector<std::string> &inputFiles,
+                           const std::string &treeDirectory,
+                           selectionConstants &constants,
+                           std::vector<trackFeatures> &records) {
+    TrackFeaturesTree featuresTree;
+    {
+      TFile file(inputFiles[0].c_str(), "READ");
+      TTree *constantsTree = dynamic_cast<TTree*>(file.Get((treeDirectory+"/SelectionConstants").c_str()));
+      if (!featuresTree.ReadConstants(constantsTree, constants))
+        throw cet::exception("TrackFeatures.cxx") << "No SelectionConstants tree in " << inputFiles[0];
+    }
+    TChain chain((treeDirectory+"/FeaturesTree").c_str());
+    for (const std::string &inputFile : inputFiles) chain.Add(inputFile.c_str());
+    featuresTree.SetUpForReading(&chain);
+    const Long64_t nEntries = chain.GetEntries();
+    records.resize(nEntries);
+    for (Long64_t entry = 0; entry < nEntries; entry++)
+      featuresTree.GetEntry(entry, records[entry]);
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
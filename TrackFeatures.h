@@ -0,0 +1,128 @@
+/***
+  Class containing the compact record of the quantities used by the selection cuts.
+  It only depends on ROOT, so the records can be read back without art.
+
+*/
+#ifndef TRACK_FEATURES_H
+#define TRACK_FEATURES_H
+
+#include <string>
+#include <vector>
+#include "TTree.h"
+
+#include "Constants.h"
+
+namespace stoppingcosmicmuonselection {
+
+  // Another track of the event, as seen by the broken track search.
+  struct brokenTrackNeighbour {
+    bool isHigher;           // true if the start point of this track is higher
+    double absCosAlpha;      // |cos| of the angle between the two tracks
+    double cosBeta;          // alignment of the higher track with the lower one (YZ)
+    double distHigherLower;  // YZ distance between higher end point and lower start point
+  };
+
+  // Constants shared by all the records.
+  struct selectionConstants {
+    double activeBounds[6];
+    double driftDistance;          // X of the first induction plane
+    double minCosAlphaNeighbours;  // less aligned neighbours are not stored
+  };
+
+  // Quantities used by the cuts for one PFParticle.
+  struct trackFeatures {
+    // Identification
+    int run;
+    int event;
+    int pfparticleIndex;
+    double trackID;
+
+    // Reconstructed information, start and end ordered in Y before any T0 correction
+    double startX, startY, startZ;
+    double endX, endY, endZ;
+    double theta_xz, theta_yz;
+    double minHitPeakTime, maxHitPeakTime;
+    double trackLength;
+    double pandoraT0;        // INV_DBL if the PFParticle has no T0
+    double driftVelocity;    // cm/ns
+    bool hasHitsOnCryoSide;  // only filled for PFParticles with a T0
+    std::vector<brokenTrackNeighbour> neighbours;
+
+    // Truth information
+    bool isRealData;
+    bool isTrueCosmic;
+    bool isTrueCathodeCrosser;
+    bool isTrueAnodeCrosser;
+    int pdg;
+
+    void Reset() {
+      run = INV_INT;
+      event = INV_INT;
+      pfparticleIndex = INV_INT;
+      trackID = INV_DBL;
+      startX = startY = startZ = INV_DBL;
+      endX = endY = endZ = INV_DBL;
+      theta_xz = theta_yz = INV_DBL;
+      minHitPeakTime = maxHitPeakTime = INV_DBL;
+      trackLength = INV_DBL;
+      pandoraT0 = INV_DBL;
+      driftVelocity = INV_DBL;
+      hasHitsOnCryoSide = false;
+      neighbours.clear();
+      isRealData = false;
+      isTrueCosmic = false;
+      isTrueCathodeCrosser = false;
+      isTrueAnodeCrosser = false;
+      pdg = INV_INT;
+    }
+  };
+
+  class TrackFeaturesTree {
+
+  public:
+    TrackFeaturesTree();
+    ~TrackFeaturesTree();
+
+    // Create the branches on a new tree.
+    void SetUpForWriting(TTree *tree);
+
+    // Point the branches of an existing tree to this object.
+    void SetUpForReading(TTree *tree);
+
+    // Fill the tree with a record.
+    void Fill(const trackFeatures &features);
+
+    // Read an entry of the tree into a record.
+    void GetEntry(const Long64_t &entry, trackFeatures &features);
+
+    // Write the constants of the records in their own tree (one entry).
+    void WriteConstants(TTree *tree, const selectionConstants &constants);
+
+    // Read the constants back. Return false if the tree is empty.
+    bool ReadConstants(TTree *tree, selectionConstants &constants);
+
+  private:
+    TTree *_tree = 0x0;
+    trackFeatures _features;
+
+    // The neighbours are stored as one vector per quantity.
+    std::vector<int> _neighbourIsHigher;
+    std::vector<double> _neighbourAbsCosAlpha;
+    std::vector<double> _neighbourCosBeta;
+    std::vector<double> _neighbourDistHigherLower;
+    std::vector<int> *_neighbourIsHigherP = &_neighbourIsHigher;
+    std::vector<double> *_neighbourAbsCosAlphaP = &_neighbourAbsCosAlpha;
+    std::vector<double> *_neighbourCosBetaP = &_neighbourCosBeta;
+    std::vector<double> *_neighbourDistHigherLowerP = &_neighbourDistHigherLower;
+
+  };
+
+  // Read the constants of the first file and all the records of the files in memory.
+  // Throw if the constants are missing.
+  void read_track_features(const std::vector<std::string> &inputFiles,
+                           const std::string &treeDirectory,
+                           selectionConstants &constants,
+                           std::vector<trackFeatures> &records);
+}
+
+#endif
@@ -0,0 +1,129 @@
+/***
+  Class containing the 3D position of the hits of a track.
+
+*/
+#ifndef TRACK_HIT_TABLE_CXX
+#define TRACK_HIT_TABLE_CXX
+
+#include "TrackHitTable.h"
+#include "Logging.h"
+
+namespace stoppingcosmicmuonselection {
+
+  TrackHitTable::TrackHitTable() {
+
+  }
+
+  TrackHitTable::~TrackHitTable() {
+
+  }
+
+  // Fill the table for a track in one pass over its TrackHitMeta.
+  void TrackHitTable::Set(art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
+                          const size_t &trackIndex,
+                          const recob::Track &track,
+                          const HitCache &hitCache) {
+    _entryOfHit.clear();
+    _trajIndex.clear();
+    _x.clear();
+    _y.clear();
+    _z.clear();
+
+    if (!fmthm.isValid()) {
+      STOPPING_MUON_LOG_WARNING(kLogHits) << "TrackHitTable.cxx: " << "The association to TrackHitMeta is invalid, hit positions are not available.";
+      return;
+    }
+
+    const artPtrHitVec &vhit = fmthm.at(trackIndex);
+    const std::vector<const recob::TrackHitMeta*> &vmeta = fmthm.data(trackIndex);
+    _entryOfHit.reserve(vhit.size());
+    _trajIndex.reserve(vhit.size());
+    _x.reserve(vhit.size());
+    _y.reserve(vhit.size());
+    _z.reserve(vhit.size());
+
+    // iterate on meta data
+    for (size_t ii=0;ii<vhit.size();++ii) {
+      if (vmeta[ii]->Index() == std::numeric_limits<int>::max()) {
+        continue;
+      }
+      if (vmeta[ii]->Index()>=track.NumberTrajectoryPoints()){
+        throw cet::exception("TrackHitTable.cxx") << "Requested track trajectory index "<<vmeta[ii]->Index()<<" exceeds the total number of trajectory points "<<track.NumberTrajectoryPoints()<<" for track index "<<trackIndex<<". Something is wrong";
+      }
+      if (!track.HasValidPoint(vmeta[ii]->Index())){
+        STOPPING_MUON_LOG_WARNING(kLogHits) << "TrackHitTable.cxx -> TrackHitTable::Set(): Track doesn't have a valid point.";
+        continue;
+      }
+      const uint32_t hit = hitCache.GetIndex(vhit[ii]);
+      const auto &loc = track.LocationAtPoint(vmeta[ii]->Index());
+      // The last valid entry for a hit wins, as in the previous lookup.
+      auto it = _entryOfHit.find(hit);
+      if (it == _entryOfHit.end()) {
+        _entryOfHit[hit] = _trajIndex.size();
+        _trajIndex.push_back(vmeta[ii]->Index());
+        _x.push_back(loc.X());
+        _y.push_back(loc.Y());
+        _z.push_back(loc.Z());
+      }
+      else {
+        _trajIndex[it->second] = vmeta[ii]->Index();
+        _x[it->second] = loc.X();
+        _y[it->second] = loc.Y();
+        _z[it->second] = loc.Z();
+      }
+    } // iteration on metadata
+  }
+
+  // Get the table entry for a hit (-1 if not available).
+  int TrackHitTable::GetEntry(const uint32_t &hit) const {
+    auto it = _entryOfHit.find(hit);
+    if (it == _entryOfHit.end()) return -1;
+    return it->second;
+  }
+
+  // Check if the hit has a valid 3D position on the track.
+  bool TrackHitTable::HasPosition(const uint32_t &hit) const {
+    return GetEntry(hit) >= 0;
+  }
+
+  // Get the 3D position of a hit (INV_DBL if not available).
+  Point3 TrackHitTable::GetHitXYZ(const uint32_t &hit) const {
+    const int entry = GetEntry(hit);
+    if (entry < 0) return Point3{INV_DBL,INV_DBL,INV_DBL};
+    return Point3{_x[entry],_y[entry],_z[entry]};
+  }
+
+  // Get the trajectory point index of a hit (INV_INT if not available).
+  int TrackHitTable::GetTrajectoryIndex(const uint32_t &hit) const {
+    const int entry = GetEntry(hit);
+    if (entry < 0) return INV_INT;
+    return _trajIndex[entry];
+  }
+
+  // Get the distance of a hit from a point (DBL_MAX if not available).
+  double TrackHitTable::GetDistanceToPoint(const uint32_t &hit, const Point3 &point) const {
+    const int entry = GetEntry(hit);
+    if (entry < 0) return DBL_MAX;
+    const double dx = _x[entry] - point.X();
+    const double dy = _y[entry] - point.Y();
+    const double dz = _z[entry] - point.Z();
+    return std::sqrt(dx*dx + dy*dy + dz*dz);
+  }
+
+  // Get index in the vector of the closest hit to a given point.
+  size_t TrackHitTable::GetIndexClosestHitToPoint(const Point3 &point, const hitIndexVec &hits) const {
+    size_t closest = 0;
+    double minDist = DBL_MAX;
+    for (size_t i = 0; i < hits.size(); i++) {
+      const double dist = GetDistanceToPoint(hits[i], point);
+      if (dist < minDist) {
+        minDist = dist;
+        closest = i;
+      }
+    }
+    return closest;
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
@@ -0,0 +1,64 @@
+/***
+  Class containing the 3D position of the hits of a track.
+  Built once per track from the TrackHitMeta association.
+
+*/
+#ifndef TRACK_HIT_TABLE_H
+#define TRACK_HIT_TABLE_H
+
+#include "canvas/Persistency/Common/FindManyP.h"
+#include "cetlib_except/exception.h"
+#include "lardataobj/RecoBase/Hit.h"
+#include "lardataobj/RecoBase/Track.h"
+#include "lardataobj/RecoBase/TrackHitMeta.h"
+
+#include <cfloat>
+#include <limits>
+#include <unordered_map>
+
+#include "DataTypes.h"
+#include "HitCache.h"
+
+namespace stoppingcosmicmuonselection {
+
+  class TrackHitTable {
+
+  public:
+    TrackHitTable();
+    ~TrackHitTable();
+
+    // Fill the table for a track in one pass over its TrackHitMeta.
+    void Set(art::FindManyP<recob::Hit,recob::TrackHitMeta> &fmthm,
+             const size_t &trackIndex,
+             const recob::Track &track,
+             const HitCache &hitCache);
+
+    // Check if the hit has a valid 3D position on the track.
+    bool HasPosition(const uint32_t &hit) const;
+
+    // Get the 3D position of a hit (INV_DBL if not available).
+    Point3 GetHitXYZ(const uint32_t &hit) const;
+
+    // Get the trajectory point index of a hit (INV_INT if not available).
+    int GetTrajectoryIndex(const uint32_t &hit) const;
+
+    // Get the distance of a hit from a point (DBL_MAX if not available).
+    double GetDistanceToPoint(const uint32_t &hit, const Point3 &point) const;
+
+    // Get index in the vector of the closest hit to a given point.
+    size_t GetIndexClosestHitToPoint(const Point3 &point, const hitIndexVec &hits) const;
+
+  private:
+    // Get the table entry for a hit (-1 if not available).
+    int GetEntry(const uint32_t &hit) const;
+
+    std::unordered_map<uint32_t,uint32_t> _entryOfHit;
+    std::vector<int>   _trajIndex;
+    std::vector<float> _x;
+    std::vector<float> _y;
+    std::vector<float> _z;
+
+  };
+}
+
+#endif
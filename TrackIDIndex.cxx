@@ -0,0 +1,61 @@
+/***
+  Class containing a per-event index of the reconstructed tracks.
+
+*/
+#ifndef TRACK_ID_INDEX_CXX
+#define TRACK_ID_INDEX_CXX
+
+#include "TrackIDIndex.h"
+
+namespace stoppingcosmicmuonselection {
+
+  TrackIDIndex::TrackIDIndex() {
+
+  }
+
+  TrackIDIndex::~TrackIDIndex() {
+
+  }
+
+  // Fill the index with the tracks of the event.
+  void TrackIDIndex::Set(art::Event const &evt, const std::string &trackerTag) {
+    _tracklist.clear();
+    _indexOfTrackID.clear();
+    _firstValidPoint.clear();
+    _endPoint.clear();
+    _startDirection.clear();
+    _length.clear();
+
+    art::Handle<std::vector<recob::Track>> trackListHandle;
+    if (!evt.getByLabel(trackerTag,trackListHandle)) return;
+    art::fill_ptr_vector(_tracklist, trackListHandle);
+
+    const size_t nTracks = _tracklist.size();
+    _indexOfTrackID.reserve(nTracks);
+    _firstValidPoint.reserve(nTracks);
+    _endPoint.reserve(nTracks);
+    _startDirection.reserve(nTracks);
+    _length.reserve(nTracks);
+
+    for (size_t i = 0; i < nTracks; i++) {
+      const recob::Track &track = *_tracklist[i];
+      // Keep the first occurrence, as the linear search did.
+      _indexOfTrackID.emplace(track.ID(), i);
+      const size_t fp = track.FirstValidPoint();
+      _firstValidPoint.push_back(make_point3(track.LocationAtPoint(fp)));
+      _endPoint.push_back(make_point3(track.End()));
+      _startDirection.push_back(make_point3(track.StartDirection()));
+      _length.push_back(track.Length());
+    }
+  }
+
+  // Get the collection index for a track ID (INV_INT if not found).
+  size_t TrackIDIndex::GetIndex(const int &trackID) const {
+    auto it = _indexOfTrackID.find(trackID);
+    if (it == _indexOfTrackID.end()) return INV_INT;
+    return it->second;
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
@@ -0,0 +1,61 @@
+/***
+  Class containing a per-event index of the reconstructed tracks.
+  Maps the track ID to the position in the track collection and keeps
+  the trajectory quantities used by the selection.
+
+*/
+#ifndef TRACK_ID_INDEX_H
+#define TRACK_ID_INDEX_H
+
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "canvas/Persistency/Common/Ptr.h"
+#include "lardataobj/RecoBase/Track.h"
+
+#include <unordered_map>
+
+#include "DataTypes.h"
+
+namespace stoppingcosmicmuonselection {
+
+  class TrackIDIndex {
+
+  public:
+    TrackIDIndex();
+    ~TrackIDIndex();
+
+    // Fill the index with the tracks of the event.
+    void Set(art::Event const &evt, const std::string &trackerTag);
+
+    // Number of tracks in the event.
+    size_t Size() const { return _tracklist.size(); }
+
+    // Get the collection index for a track ID (INV_INT if not found).
+    size_t GetIndex(const int &trackID) const;
+
+    // Get the collection index of a track object (INV_INT if not found).
+    size_t GetIndex(const recob::Track &track) const { return GetIndex(track.ID()); }
+
+    // Get the vector of art::Ptr to the tracks.
+    const std::vector<art::Ptr<recob::Track>> &GetTrackList() const { return _tracklist; }
+
+    // Cached trajectory quantities for a given collection index.
+    int ID(const size_t &index)                         const { return _tracklist[index]->ID(); }
+    const Point3 &FirstValidPoint(const size_t &index)   const { return _firstValidPoint[index]; }
+    const Point3 &EndPoint(const size_t &index)          const { return _endPoint[index]; }
+    const Vec3 &StartDirection(const size_t &index)      const { return _startDirection[index]; }
+    double Length(const size_t &index)                   const { return _length[index]; }
+
+  private:
+    std::vector<art::Ptr<recob::Track>> _tracklist;
+    std::unordered_map<int,size_t> _indexOfTrackID;
+
+    std::vector<Point3> _firstValidPoint;
+    std::vector<Point3> _endPoint;
+    std::vector<Vec3> _startDirection;
+    std::vector<double> _length;
+
+  };
+}
+
+#endif
@@ -0,0 +1,98 @@
+/***
+  Class containing the per-plane processing of a track.
+
+*/
+#ifndef TRACK_PLANES_ALG_CXX
+#define TRACK_PLANES_ALG_CXX
+
+#include "TrackPlanesAlg.h"
+
+namespace stoppingcosmicmuonselection {
+
+  TrackPlanesAlg::TrackPlanesAlg() {
+
+  }
+
+  TrackPlanesAlg::~TrackPlanesAlg() {
+
+  }
+
+  // Process all the planes of a track.
+  void TrackPlanesAlg::Process(HitCache &hitCache,
+                               const hitIndexVec &trackHits,
+                               const TrackHitTable &trackHitTable,
+                               const Point3 &recoStartPoint,
+                               const double &t0,
+                               const std::vector<anab::Calorimetry> &calos,
+                               const bool &isData,
+                               const EventContext &context) {
+    // Split the hits by plane in one pass.
+    for (auto &hits : _planeHits) hits.clear();
+    for (const uint32_t &hit : trackHits) {
+      if (!hitCache.IsValid(hit)) continue;
+      const size_t plane = hitCache.Plane(hit);
+      if (plane >= _nPlanes) continue;
+      _planeHits[plane].push_back(hit);
+    }
+
+    // The planes share no hits, so the tasks write to different entries of the hit table.
+    tbb::task_arena arena(_numberThreads);
+    arena.execute([&]() {
+      tbb::parallel_for(size_t(0), _nPlanes, [&](const size_t &plane) {
+        ProcessPlane(plane,hitCache,trackHitTable,recoStartPoint,t0,calos,isData,context);
+      });
+    });
+  }
+
+  // Process a single plane. Only touches the data of this plane.
+  void TrackPlanesAlg::ProcessPlane(const size_t &plane,
+                                    HitCache &hitCache,
+                                    const TrackHitTable &trackHitTable,
+                                    const Point3 &recoStartPoint,
+                                    const double &t0,
+                                    const std::vector<anab::Calorimetry> &calos,
+                                    const bool &isData,
+                                    const EventContext &context) {
+    planeRecord &record = _records[plane];
+    record.Reset();
+    record.plane = plane;
+
+    // Hits: ordering, smoothing and linearity.
+    const hitIndexVec &hits = _planeHits[plane];
+    record.nHits = hits.size();
+    if (hits.size() != 0) {
+      const size_t startIndex = trackHitTable.GetIndexClosestHitToPoint(recoStartPoint,hits);
+      HitPlaneAlg &hitPlaneAlg = _hitPlaneAlgs[plane];
+      record.orderedHits = hitPlaneAlg.Process(hitCache,hits,startIndex,plane,t0,context,
+                                               _orderHitsByTrajectory ? &trackHitTable : 0x0);
+      record.wireIDs = hitPlaneAlg.GetOrderedWireNumb();
+      record.Qs = hitPlaneAlg.GetOrderedQ();
+      record.Dqds = hitPlaneAlg.GetOrderedDqds();
+      record.QsSmooth = hitPlaneAlg.Smoother(record.Qs,_numberNeighbors);
+      record.DqdsSmooth = hitPlaneAlg.Smoother(record.Dqds,_numberNeighbors);
+      record.localLinearity = hitPlaneAlg.CalculateLocalLinearity(_numberNeighbors);
+    }
+
+    // Calorimetry.
+    CalorimetryHelper &caloHelper = _caloHelpers[plane];
+    caloHelper.Set(calos,isData,plane,context);
+    record.isCaloValid = caloHelper.IsValid();
+    if (record.isCaloValid) {
+      record.dQdx = caloHelper.GetdQdx();
+      record.resRange = caloHelper.GetResRangeOrdered();
+      record.trackPitch = caloHelper.GetTrackPitch();
+    }
+  }
+
+  // Set the parameters from the FHICL file
+  void TrackPlanesAlg::reconfigure(fhicl::ParameterSet const &p) {
+    _numberNeighbors = p.get<size_t>("numberNeighbors", 2);
+    _numberThreads = p.get<int>("numberPlaneThreads", _nPlanes);
+    _orderHitsByTrajectory = p.get<bool>("orderHitsByTrajectory", false);
+    for (auto &caloHelper : _caloHelpers)
+      caloHelper.reconfigure(p.get<fhicl::ParameterSet>("CalorimetryHelper"));
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
@@ -0,0 +1,76 @@
+/***
+  Class containing the per-plane processing of a track.
+  The hits are split by plane in one pass and each plane is processed as
+  an independent task.
+
+*/
+#ifndef TRACK_PLANES_ALG_H
+#define TRACK_PLANES_ALG_H
+
+#include "fhiclcpp/ParameterSet.h"
+#include "lardataobj/AnalysisBase/Calorimetry.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+#include <array>
+
+#include "DataTypes.h"
+#include "HitCache.h"
+#include "TrackHitTable.h"
+#include "HitPlaneAlg.h"
+#include "CalorimetryHelper.h"
+
+namespace stoppingcosmicmuonselection {
+
+  class TrackPlanesAlg {
+
+  public:
+    TrackPlanesAlg();
+    ~TrackPlanesAlg();
+
+    // Process all the planes of a track.
+    void Process(HitCache &hitCache,
+                 const hitIndexVec &trackHits,
+                 const TrackHitTable &trackHitTable,
+                 const Point3 &recoStartPoint,
+                 const double &t0,
+                 const std::vector<anab::Calorimetry> &calos,
+                 const bool &isData,
+                 const EventContext &context);
+
+    // Get the results for a plane.
+    const planeRecord &GetPlaneRecord(const size_t &plane) const { return _records.at(plane); }
+
+    // Number of planes.
+    size_t GetNumbPlanes() const { return _records.size(); }
+
+    // Set the parameters from the FHICL file
+    void reconfigure(fhicl::ParameterSet const &p);
+
+  private:
+    // Process a single plane. Only touches the data of this plane.
+    void ProcessPlane(const size_t &plane,
+                      HitCache &hitCache,
+                      const TrackHitTable &trackHitTable,
+                      const Point3 &recoStartPoint,
+                      const double &t0,
+                      const std::vector<anab::Calorimetry> &calos,
+                      const bool &isData,
+                      const EventContext &context);
+
+    static constexpr size_t _nPlanes = 3;
+    std::array<hitIndexVec,_nPlanes> _planeHits;
+    std::array<planeRecord,_nPlanes> _records;
+    // One helper per plane, so that the tasks do not share state.
+    std::array<HitPlaneAlg,_nPlanes> _hitPlaneAlgs;
+    std::array<CalorimetryHelper,_nPlanes> _caloHelpers;
+
+    // Fhicl parameters
+    size_t _numberNeighbors;
+    int _numberThreads;
+    bool _orderHitsByTrajectory;
+
+  };
+}
+
+#endif
@@ -0,0 +1,119 @@
+/***
+  Class containing a per-event table of truth information for hits.
+
+*/
+#ifndef TRUTH_HIT_CACHE_CXX
+#define TRUTH_HIT_CACHE_CXX
+
+#include <algorithm>
+
+#include "TruthHitCache.h"
+#include "Logging.h"
+
+namespace stoppingcosmicmuonselection {
+
+  TruthHitCache::TruthHitCache() {
+
+  }
+
+  TruthHitCache::~TruthHitCache() {
+
+  }
+
+  // Fill the table for all the hits in the hit cache.
+  void TruthHitCache::Set(art::Event const &evt,
+                          const std::string &simChannelTag,
+                          const HitCache &hitCache,
+                          const EventContext &context) {
+    STOPPING_MUON_SCOPED_TIMER("TruthHitCache::Set");
+    const size_t nHits = hitCache.Size();
+    _trackID.assign(nHits, INV_INT);
+    _energyFrac.assign(nHits, 0.);
+    _pdg.assign(nHits, 0);
+    _electronFrac.assign(nHits, 0.);
+    _maxElectronFrac.assign(nHits, 0.);
+    _ideOffset.assign(nHits+1, 0);
+    _ideTrackID.clear();
+    _ideEnergy.clear();
+    _pdgOfTrackID.clear();
+    _isSet = false;
+
+    if (evt.isRealData()) return;
+
+    art::Handle<std::vector<sim::SimChannel>> simChannelHandle;
+    if (!evt.getByLabel(simChannelTag, simChannelHandle)) {
+      STOPPING_MUON_LOG_WARNING(kLogTruth) << "TruthHitCache.cxx: " << "No sim::SimChannel with label " << simChannelTag << ". Truth table left empty.";
+      return;
+    }
+
+    // Channel -> SimChannel lookup.
+    std::unordered_map<raw::ChannelID_t, const sim::SimChannel*> simChannelOf;
+    simChannelOf.reserve(simChannelHandle->size());
+    for (const sim::SimChannel &simChannel : *simChannelHandle)
+      simChannelOf[simChannel.Channel()] = &simChannel;
+
+    // Energy per track ID for the current hit.
+    std::unordered_map<int,double> energyOfTrackID;
+
+    for (uint32_t i = 0; i < nHits; i++) {
+      _ideOffset[i] = _ideTrackID.size();
+      auto it = simChannelOf.find(hitCache.Channel(i));
+      if (it == simChannelOf.end()) continue;
+
+      // Same time window as BackTracker::HitToTrackIDEs.
+      const double peakTime = hitCache.PeakTime(i);
+      const double rms = _hitTimeRMS*hitCache.RMS(i);
+      int startTDC = context.ClockData().TPCTick2TDC(peakTime - rms);
+      int endTDC = context.ClockData().TPCTick2TDC(peakTime + rms);
+      if (startTDC < 0) startTDC = 0;
+      if (endTDC < 0) endTDC = 0;
+
+      energyOfTrackID.clear();
+      double totalE = 0.;
+      for (const sim::IDE &ide : it->second->TrackIDsAndEnergies(startTDC, endTDC)) {
+        energyOfTrackID[std::abs(ide.trackID)] += ide.energy;
+        totalE += ide.energy;
+      }
+      if (energyOfTrackID.empty()) continue;
+      if (totalE < 1.e-5) totalE = 1.;
+
+      double maxE = -1.;
+      for (auto const &el : energyOfTrackID) {
+        _ideTrackID.push_back(el.first);
+        _ideEnergy.push_back(el.second);
+        const int pdg = GetPDG(el.first);
+        if (std::abs(pdg) == 11) {
+          _electronFrac[i] += el.second / totalE;
+          _maxElectronFrac[i] = std::max(_maxElectronFrac[i], (float)(el.second / totalE));
+        }
+        if (el.second > maxE) {
+          maxE = el.second;
+          _trackID[i] = el.first;
+          _pdg[i] = pdg;
+        }
+      }
+      _energyFrac[i] = maxE / totalE;
+    }
+    _ideOffset[nHits] = _ideTrackID.size();
+
+    _isSet = true;
+  }
+
+  // Check if an electron deposited more than a fraction of the hit energy.
+  bool TruthHitCache::HasElectronAboveFraction(const uint32_t &i, const double &minEnergyFrac) const {
+    return _maxElectronFrac[i] > minEnergyFrac;
+  }
+
+  // Get the PDG code for a track ID, cached per event.
+  int TruthHitCache::GetPDG(const int &trackID) {
+    auto it = _pdgOfTrackID.find(trackID);
+    if (it != _pdgOfTrackID.end()) return it->second;
+    const simb::MCParticle *particle = TruthProvider::Get().TrackIdToParticle(trackID);
+    const int pdg = particle ? particle->PdgCode() : 0;
+    _pdgOfTrackID[trackID] = pdg;
+    return pdg;
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
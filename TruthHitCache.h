@@ -0,0 +1,78 @@
+/***
+  Class containing a per-event table of truth information for hits.
+  Filled in one pass over the sim::SimChannels, indexed like HitCache.
+
+*/
+#ifndef TRUTH_HIT_CACHE_H
+#define TRUTH_HIT_CACHE_H
+
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "lardataobj/Simulation/SimChannel.h"
+
+#include <unordered_map>
+
+#include "DataTypes.h"
+#include "Instrumentation.h"
+#include "HitCache.h"
+#include "TruthProvider.h"
+
+namespace stoppingcosmicmuonselection {
+
+  class TruthHitCache {
+
+  public:
+    TruthHitCache();
+    ~TruthHitCache();
+
+    // Fill the table for all the hits in the hit cache.
+    void Set(art::Event const &evt,
+             const std::string &simChannelTag,
+             const HitCache &hitCache,
+             const EventContext &context);
+
+    // Check if the table was filled for this event.
+    bool IsSet() const { return _isSet; }
+
+    // Column accessors.
+    int   TrackID(const uint32_t &i)          const { return _trackID[i]; }
+    float EnergyFraction(const uint32_t &i)   const { return _energyFrac[i]; }
+    int   PDG(const uint32_t &i)              const { return _pdg[i]; }
+    float ElectronFraction(const uint32_t &i) const { return _electronFrac[i]; }
+    float MaxElectronFraction(const uint32_t &i) const { return _maxElectronFrac[i]; }
+
+    // Check if an electron deposited more than a fraction of the hit energy.
+    bool HasElectronAboveFraction(const uint32_t &i, const double &minEnergyFrac) const;
+
+    // Range [IDEBegin, IDEEnd) of the (track ID, energy) entries of a hit.
+    uint32_t IDEBegin(const uint32_t &i)  const { return _ideOffset[i]; }
+    uint32_t IDEEnd(const uint32_t &i)    const { return _ideOffset[i+1]; }
+    int   IDETrackID(const uint32_t &k)   const { return _ideTrackID[k]; }
+    float IDEEnergy(const uint32_t &k)    const { return _ideEnergy[k]; }
+
+  private:
+    // Get the PDG code for a track ID, cached per event.
+    int GetPDG(const int &trackID);
+
+    bool _isSet = false;
+
+    std::vector<int>   _trackID;
+    std::vector<float> _energyFrac;
+    std::vector<int>   _pdg;
+    std::vector<float> _electronFrac;
+    std::vector<float> _maxElectronFrac;
+
+    // Energy deposited by each track ID in each hit, flattened.
+    std::vector<uint32_t> _ideOffset;
+    std::vector<int>      _ideTrackID;
+    std::vector<float>    _ideEnergy;
+
+    std::unordered_map<int,int> _pdgOfTrackID;
+
+    // Number of RMS around the peak time used by the backtracker.
+    const double _hitTimeRMS = 1.;
+
+  };
+}
+
+#endif
@@ -0,0 +1,95 @@
+/***
+  Class containing the per-event truth matching of the PFParticles.
+
+*/
+#ifndef TRUTH_MATCH_TABLE_CXX
+#define TRUTH_MATCH_TABLE_CXX
+
+#include "TruthMatchTable.h"
+
+namespace stoppingcosmicmuonselection {
+
+  TruthMatchTable::TruthMatchTable() {
+
+  }
+
+  TruthMatchTable::~TruthMatchTable() {
+
+  }
+
+  // Match all the PFParticles of the event.
+  void TruthMatchTable::Set(art::Event const &evt,
+                            const std::string &pfparticleTag,
+                            const HitCache &hitCache,
+                            const TruthHitCache &truthCache) {
+    STOPPING_MUON_SCOPED_TIMER("TruthMatchTable::Set");
+    _matches.clear();
+    _isSet = false;
+    if (evt.isRealData() || !truthCache.IsSet()) return;
+
+    art::Handle<std::vector<recob::PFParticle>> pfparticleHandle;
+    if (!evt.getByLabel(pfparticleTag, pfparticleHandle)) return;
+    auto const clusterHandle = evt.getValidHandle<std::vector<recob::Cluster>>(pfparticleTag);
+    const art::FindManyP<recob::Cluster> findClusters(pfparticleHandle, evt, pfparticleTag);
+    const art::FindManyP<recob::Hit> findHits(clusterHandle, evt, pfparticleTag);
+
+    _matches.resize(pfparticleHandle->size());
+
+    // Energy per track ID for the current PFParticle.
+    std::unordered_map<int,double> energyOfTrackID;
+
+    for (const recob::PFParticle &thisParticle : *pfparticleHandle) {
+      energyOfTrackID.clear();
+      for (auto const &cluster : findClusters.at(thisParticle.Self())) {
+        for (auto const &hitp : findHits.at(cluster.key())) {
+          const uint32_t hit = hitCache.GetIndex(hitp);
+          for (uint32_t k = truthCache.IDEBegin(hit); k < truthCache.IDEEnd(hit); k++)
+            energyOfTrackID[truthCache.IDETrackID(k)] += truthCache.IDEEnergy(k);
+        }
+      }
+      if (energyOfTrackID.empty()) continue;
+
+      // The MCParticle depositing most of the energy.
+      int bestTrackID = INV_INT;
+      double maxE = -1.;
+      for (auto const &el : energyOfTrackID) {
+        if (el.second > maxE) {
+          maxE = el.second;
+          bestTrackID = el.first;
+        }
+      }
+      const simb::MCParticle *particleP = TruthProvider::Get().TrackIdToParticle(bestTrackID);
+      if (particleP == 0x0) continue;
+
+      truthMatch &match = _matches[thisParticle.Self()];
+      match.isMatched = true;
+      match.trackID = particleP->TrackId();
+      match.origin = TruthProvider::Get().TrackIdToOrigin(particleP->TrackId());
+      match.pdg = particleP->PdgCode();
+      // Not valid in prod4 as there are only 2 trajectory points in the
+      // simb::MCParticle object.
+      int firstPoint = 0;
+      match.startPoint.SetXYZ(particleP->Vx(firstPoint),particleP->Vy(firstPoint),particleP->Vz(firstPoint));
+      match.endPoint = make_point3(particleP->EndPosition());
+      match.startT = particleP->T(firstPoint);
+      match.endT = particleP->EndPosition().T();
+    }
+
+    _isSet = true;
+  }
+
+  // Get the match for a PFParticle.
+  const truthMatch &TruthMatchTable::GetMatch(const recob::PFParticle &thisParticle) const {
+    if (thisParticle.Self() >= _matches.size()) return _noMatch;
+    return _matches[thisParticle.Self()];
+  }
+
+  // Check if the PFParticle is matched to a cosmic MCParticle.
+  bool TruthMatchTable::IsMatchedToCosmic(const recob::PFParticle &thisParticle) const {
+    const truthMatch &match = GetMatch(thisParticle);
+    return match.isMatched && match.origin == simb::kCosmicRay;
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
@@ -0,0 +1,69 @@
+/***
+  Class containing the per-event truth matching of the PFParticles.
+  All the PFParticles are matched in one sweep over their hits.
+
+*/
+#ifndef TRUTH_MATCH_TABLE_H
+#define TRUTH_MATCH_TABLE_H
+
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "canvas/Persistency/Common/FindManyP.h"
+#include "lardataobj/RecoBase/PFParticle.h"
+#include "lardataobj/RecoBase/Cluster.h"
+#include "lardataobj/RecoBase/Hit.h"
+#include "nusimdata/SimulationBase/MCParticle.h"
+#include "nusimdata/SimulationBase/MCTruth.h"
+
+#include <unordered_map>
+
+#include "DataTypes.h"
+#include "Instrumentation.h"
+#include "HitCache.h"
+#include "TruthHitCache.h"
+#include "TruthProvider.h"
+
+namespace stoppingcosmicmuonselection {
+
+  // Truth information matched to a PFParticle.
+  struct truthMatch {
+    bool isMatched = false;
+    int trackID = INV_INT;
+    int origin = simb::kUnknown;
+    int pdg = INV_INT;
+    Point3 startPoint = Point3{INV_DBL,INV_DBL,INV_DBL};
+    Point3 endPoint = Point3{INV_DBL,INV_DBL,INV_DBL};
+    double startT = INV_DBL;
+    double endT = INV_DBL;
+  };
+
+  class TruthMatchTable {
+
+  public:
+    TruthMatchTable();
+    ~TruthMatchTable();
+
+    // Match all the PFParticles of the event.
+    void Set(art::Event const &evt,
+             const std::string &pfparticleTag,
+             const HitCache &hitCache,
+             const TruthHitCache &truthCache);
+
+    // Check if the table was filled for this event.
+    bool IsSet() const { return _isSet; }
+
+    // Get the match for a PFParticle.
+    const truthMatch &GetMatch(const recob::PFParticle &thisParticle) const;
+
+    // Check if the PFParticle is matched to a cosmic MCParticle.
+    bool IsMatchedToCosmic(const recob::PFParticle &thisParticle) const;
+
+  private:
+    bool _isSet = false;
+    std::vector<truthMatch> _matches;
+    const truthMatch _noMatch;
+
+  };
+}
+
+#endif
@@ -0,0 +1,79 @@
+/***
+  Class containing the access to the MC truth services.
+
+*/
+#ifndef TRUTH_PROVIDER_CXX
+#define TRUTH_PROVIDER_CXX
+
+#include "art/Framework/Services/Registry/ServiceHandle.h"
+#include "cetlib_except/exception.h"
+#ifndef STOPPING_MUON_DATA_ONLY
+#include "larsim/MCCheater/ParticleInventoryService.h"
+#endif
+
+#include "TruthProvider.h"
+#include "Logging.h"
+
+namespace stoppingcosmicmuonselection {
+
+  TruthProvider &TruthProvider::Get() {
+    static TruthProvider truthProvider;
+    return truthProvider;
+  }
+
+  // Set from FHiCL.
+  void TruthProvider::reconfigure(fhicl::ParameterSet const &p) {
+    _isDataOnly = p.get<bool>("DataOnly", false);
+    if (IsDataOnly())
+      STOPPING_MUON_LOG_INFO(kLogTruth) << "TruthProvider.cxx: data-only job, the MC truth services are not used.";
+  }
+
+  // Check that the event can be processed.
+  void TruthProvider::CheckEvent(art::Event const &evt) const {
+    if (!evt.isRealData() && IsDataOnly())
+      throw cet::exception("TruthProvider.cxx") << "MC event " << evt.id().event()
+                                                << " in a data-only job: set DataOnly to false"
+                                                << (IsCompiledIn() ? "." : " and build without STOPPING_MUON_DATA_ONLY.");
+  }
+
+  // Bind the particle inventory on first use.
+  cheat::ParticleInventoryService *TruthProvider::GetParticleInventory() {
+    cheat::ParticleInventoryService *particleInventory = _particleInventory;
+    if (particleInventory) return particleInventory;
+    if (IsDataOnly())
+      throw cet::exception("TruthProvider.cxx") << "MC truth requested in a data-only job.";
+#ifndef STOPPING_MUON_DATA_ONLY
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_particleInventory) {
+      STOPPING_MUON_LOG_DEBUG(kLogTruth) << "TruthProvider.cxx: binding the particle inventory.";
+      _particleInventory = art::ServiceHandle<cheat::ParticleInventoryService>().get();
+    }
+    return _particleInventory;
+#else
+    return 0x0;
+#endif
+  }
+
+  // Get the MCParticle of a track ID.
+  const simb::MCParticle *TruthProvider::TrackIdToParticle(const int &trackID) {
+#ifndef STOPPING_MUON_DATA_ONLY
+    return GetParticleInventory()->TrackIdToParticle_P(trackID);
+#else
+    GetParticleInventory();
+    return 0x0;
+#endif
+  }
+
+  // Get the origin of the MCTruth of a track ID.
+  simb::Origin_t TruthProvider::TrackIdToOrigin(const int &trackID) {
+#ifndef STOPPING_MUON_DATA_ONLY
+    return GetParticleInventory()->TrackIdToMCTruth_P(trackID)->Origin();
+#else
+    GetParticleInventory();
+    return simb::kUnknown;
+#endif
+  }
+
+} // end of namespace stoppingcosmicmuonselection
+
+#endif
@@ -0,0 +1,67 @@
+/***
+  Class containing the access to the MC truth services. The particle
+  inventory is only bound on first use, on MC events: data jobs never
+  construct the cheater services and do not need them in the configuration.
+  With STOPPING_MUON_DATA_ONLY (cmake option of the same name) the cheater
+  services are not compiled in and MC events are rejected.
+
+*/
+#ifndef TRUTH_PROVIDER_H
+#define TRUTH_PROVIDER_H
+
+#include <atomic>
+#include <mutex>
+#include "art/Framework/Principal/Event.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "nusimdata/SimulationBase/MCParticle.h"
+#include "nusimdata/SimulationBase/MCTruth.h"
+
+namespace cheat {
+  class ParticleInventoryService;
+}
+
+namespace stoppingcosmicmuonselection {
+
+  class TruthProvider {
+
+  public:
+    static TruthProvider &Get();
+
+    // Check if the cheater services are compiled in.
+    static constexpr bool IsCompiledIn() {
+#ifdef STOPPING_MUON_DATA_ONLY
+      return false;
+#else
+      return true;
+#endif
+    }
+
+    // Set from FHiCL: DataOnly rejects the MC events.
+    void reconfigure(fhicl::ParameterSet const &p);
+
+    // Check that the event can be processed. Throws for MC events in a data-only job.
+    void CheckEvent(art::Event const &evt) const;
+
+    // Check if the job only takes data.
+    bool IsDataOnly() const { return _isDataOnly || !IsCompiledIn(); }
+
+    // Get the MCParticle of a track ID (0x0 if not found).
+    const simb::MCParticle *TrackIdToParticle(const int &trackID);
+
+    // Get the origin of the MCTruth of a track ID.
+    simb::Origin_t TrackIdToOrigin(const int &trackID);
+
+  private:
+    TruthProvider() : _isDataOnly(false), _particleInventory(0x0) {}
+
+    // Bind the particle inventory on first use.
+    cheat::ParticleInventoryService *GetParticleInventory();
+
+    std::atomic<bool> _isDataOnly;
+    std::mutex _mutex;
+    std::atomic<cheat::ParticleInventoryService*> _particleInventory;
+
+  };
+}
+
+#endif
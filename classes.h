@@ -0,0 +1,6 @@
+#include "canvas/Persistency/Common/Assns.h"
+#include "canvas/Persistency/Common/Wrapper.h"
+#include "lardataobj/RecoBase/PFParticle.h"
+#include "lardataobj/RecoBase/Track.h"
+
+#include "StoppingMuonCandidate.h"